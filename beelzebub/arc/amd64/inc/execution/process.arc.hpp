@@ -39,6 +39,7 @@
 
 #pragma once
 
+#include "memory/tlb.hpp"
 #include <beel/sync/smp.lock.hpp>
 #include <beel/sync/atomic.hpp>
 
@@ -55,6 +56,14 @@ namespace Beelzebub { namespace Execution
 
         inline ProcessArchitecturalBase()
             : PagingTable( nullpaddr)
+            , ActiveCores()
+            , TlbGeneration(0)
+            , TlbQueue()
+            , ContextId(__atomic_add_fetch(&NextContextId, 1, __ATOMIC_RELAXED))
+            , CollapseState(CollapseIdle)
+            , CollapseSpan(0)
+            , CollapseOldEntry(0)
+            , CollapseNewEntry(0)
         {
 
         }
@@ -70,5 +79,46 @@ namespace Beelzebub { namespace Execution
 
         paddr_t PagingTable;
         void SetPagingTable(paddr_t pt);
+
+        /*  TLB Shootdowns  */
+
+        static constexpr size_t const ActiveCoresWords = 4;
+        //  Processes active on cores beyond these bits are shot down by broadcast.
+
+        uint64_t ActiveCores[ActiveCoresWords];
+        //  Cores which may cache translations of this process.
+
+        Synchronization::Atomic<uint64_t> TlbGeneration;
+        //  Bumped by every shootdown, so cores which switch to this process
+        //  later can tell whether they need to catch up.
+
+        Memory::TlbShootdownQueue TlbQueue;
+
+        /*  Address Space Identifiers  */
+
+        static uint64_t NextContextId;
+
+        uint64_t const ContextId;
+        //  Never reused, so a PCID still tagged with the context of a dead
+        //  process cannot be mistaken for a new one's.
+
+        /*  Large Pages  */
+
+        static constexpr uint64_t const CollapseIdle       = 0;
+        static constexpr uint64_t const CollapseCopying    = 1;
+        static constexpr uint64_t const CollapseCommitting = 2;
+        static constexpr uint64_t const CollapsePhaseMask  = 3;
+        static constexpr uint64_t const CollapseSequence   = 4;
+
+        uint64_t CollapseState;
+        //  The low bits hold the phase of a merge of small pages into a large
+        //  one, done by an idle core; the rest count the merges, so an old phase
+        //  is never mistaken for a newer one. Cores switching to the process
+        //  abandon merges which are still copying and help finish those which
+        //  are committing, so they never wait.
+
+        vaddr_inner_t CollapseSpan;
+        uint64_t CollapseOldEntry, CollapseNewEntry;
+        //  The PML2 entry swap which a committing merge performs.
     };
 }}
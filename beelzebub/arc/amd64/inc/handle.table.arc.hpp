@@ -52,7 +52,18 @@ namespace Beelzebub
 
     struct HandleTableEntryArc : HandleTableEntry
     {
-        HandleReferenceNode * ReferenceList;
+        union
+        {
+            HandleReferenceNode * ReferenceList;
+            //  While allocated.
+
+            struct
+            {
+                handle_inner_t NextBatch;
+                uint32_t BatchSize;
+            };
+            //  While free, at the head of a batch on the global free stack.
+        };
 
         inline HandleTableEntryArc(uint16_t refcnt, uint16_t pcid, handle_t lind)
             : HandleTableEntry { refcnt, pcid, lind }
@@ -70,12 +81,16 @@ namespace Beelzebub
     public:
         /*  Statics  */
 
+        static constexpr size_t const MaximumFreeListThreshold = 0xFFFF;
+
         static HandleTableEntryArc * Table;
-        static handle_t GlobalFreeIndex;
+        static uint64_t GlobalFreeHead;
+        //  The index of the first batch in the lower half, and a generation
+        //  counter in the upper half, bumped on every change to avoid ABA.
         static handle_t Maximum, Cursor;
 
-        static handle_t FreeListThreshold;
-        static handle_t FreeListRemovalCount;
+        static size_t FreeListThreshold;
+        static size_t FreeListRemovalCount;
 
     protected:
         /*  Constructor(s)  */
@@ -86,8 +101,12 @@ namespace Beelzebub
         HandleTableArc(HandleTableArc const &) = delete;
         HandleTableArc & operator =(HandleTableArc const &) = delete;
 
+        /*  Parameters  */
+
+        static bool SetFreeListLimits(size_t threshold, size_t removalCount);
+
         /*  Garbage Collection  */
 
-        static __startup void CollectLocalFreeList(handle_t count = FreeListRemovalCount);
+        static __hot void CollectLocalFreeList(size_t count = FreeListRemovalCount);
     };
 }
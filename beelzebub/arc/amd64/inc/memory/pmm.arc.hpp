@@ -91,8 +91,9 @@ namespace Beelzebub { namespace Memory
 
         __forceinline uint32_t AdjustReferenceCount(int32_t diff)
         {
-            return this->ReferenceCount += diff;
+            return __atomic_add_fetch(&(this->ReferenceCount), diff, __ATOMIC_ACQ_REL);
         }
+        //  Atomic because frames cached per-CPU are adjusted without locks.
 
         /*  Status  */
 
@@ -347,7 +348,7 @@ namespace Beelzebub { namespace Memory
 
         /*  Constructors    */
 
-        FrameAllocationSpace(paddr_t phys_start, paddr_t phys_end);
+        FrameAllocationSpace(paddr_t phys_start, paddr_t phys_end, uint32_t node = 0);
 
         FrameAllocationSpace(FrameAllocationSpace const &) = delete;
         FrameAllocationSpace & operator =(FrameAllocationSpace const &) = delete;
@@ -367,13 +368,30 @@ namespace Beelzebub { namespace Memory
                 && ((start + size) <= this->AllocationEnd);
         }
 
+        /*  Batched operations  */
+
+        //  Frames allocated in batches are used, with a reference count of 0.
+        __hot size_t AllocateFrames(FrameSize size, paddr_inner_t * frames, size_t count);
+        //  Frames freed in batches must be used and belong to this space.
+        __hot void FreeFrames(FrameSize size, paddr_inner_t const * frames, size_t count);
+
+        //  Looks up the descriptor of a used frame without locking, so the caller
+        //  must own a reference to it. Returns null if the frame isn't used.
+        __hot FrameDescriptor * PeekUsedFrame(paddr_t addr, FrameSize & size);
+
+    private:
+        __hot paddr_t PopSmallFrame(uint32_t refCnt);
+        __hot bool PushSmallFrame(LargeFrameDescriptor * lDesc, uint32_t lIndex, uint16_t sIndex);
+
+    public:
+
         /*  Fields  */
 
         LargeFrameDescriptor * Map;
         //  Pointers to the allocation map within the space.
 
-        Synchronization::SmpLockUni LargeLocker;
-        Synchronization::SmpLockUni SplitLocker;
+        Synchronization::SmpQueuedLockUni LargeLocker;
+        Synchronization::SmpQueuedLockUni SplitLocker;
 
         uint32_t LargeFree;
         uint32_t SplitFree;
@@ -381,6 +399,9 @@ namespace Beelzebub { namespace Memory
         FrameAllocationSpace * Next;
         FrameAllocationSpace * Previous;
 
+        uint32_t Node;
+        //  The NUMA node to which all of this space's memory belongs.
+
         /*  Debug  */
 
     #ifdef __BEELZEBUB__CONF_DEBUG
@@ -419,7 +440,9 @@ namespace Beelzebub { namespace Memory
 
         /*  Page Manipulation  */
 
-        __hot paddr_t AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt);
+        //  Spaces are tried in the order of their node's distance from the given
+        //  one.
+        __hot paddr_t AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt, uint32_t node);
 
         __hot Handle Mingle(paddr_t addr, uint32_t & newCnt, int32_t diff, bool ignoreRefCnt);
         __cold Handle ReserveRange(paddr_t start, psize_t size, bool includeBusy);
@@ -429,6 +452,11 @@ namespace Beelzebub { namespace Memory
         bool ContainsRange(paddr_t start, psize_t size);
         __hot FrameAllocationSpace * GetSpace(paddr_t paddr);
 
+        /*  Batched operations  */
+
+        __hot size_t AllocateFrames(FrameSize size, paddr_inner_t * frames, size_t count, uint32_t node);
+        __hot void FreeFrames(FrameSize size, paddr_inner_t const * frames, size_t count);
+
         /*  Synchronization  */
 
         //  Used for mutual exclusion over the linking pointers of the
@@ -459,9 +487,23 @@ namespace Beelzebub { namespace Memory
         static FrameAllocationSpace * AllocationSpace;
         static FrameAllocator * MainAllocator;
 
+        /*  Per-CPU Caches  */
+
+        static constexpr size_t const SmallCacheCapacity = 512;
+        static constexpr size_t const LargeCacheCapacity = 8;
+        static constexpr size_t const LargeCacheLow = 2;
+
+        //  A cache is refilled up to the low watermark when empty, and drained
+        //  down to it once it reaches the high watermark. A high watermark of 0
+        //  disables caching.
+        static size_t SmallCacheHigh;
+        static size_t SmallCacheLow;
+
+        static __cold Handle SetCacheWatermarks(size_t high, size_t low);
+
         /*  Initialization  */
 
-        static __cold Handle CreateAllocationSpace(paddr_t start, paddr_t end);
+        static __cold Handle CreateAllocationSpace(paddr_t start, paddr_t end, uint32_t node = 0);
 
         /*  Relocation  */
 
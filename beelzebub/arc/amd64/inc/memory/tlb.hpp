@@ -0,0 +1,110 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#include <beel/sync/smp.lock.hpp>
+
+namespace Beelzebub { namespace Memory
+{
+    /**
+     *  A page whose invalidation was deferred, with the frame whose reference
+     *  can only be dropped once no TLB may hold the page anymore.
+     */
+    struct TlbPendingEntry
+    {
+        vaddr_t Address;
+        paddr_t Frame;
+        //  Null when no reference is to be dropped.
+    };
+
+    /**
+     *  An address space tagged in a core's TLB, identified by its PCID.
+     */
+    struct TlbContext
+    {
+        uint64_t Owner;
+        //  Context identifier of the process; 0 when the PCID is free.
+        uint64_t Generation;
+        //  TLB generation of the process when this core last switched to it.
+    };
+
+    /**
+     *  Invalidations queued by unmapping operations within batches, to be shot
+     *  down together when a batch ends or the queue fills.
+     */
+    struct TlbShootdownQueue
+    {
+        /*  Constants  */
+
+        static constexpr size_t const Capacity = 64;
+
+        /*  Constructors  */
+
+        inline TlbShootdownQueue()
+            : Lock()
+            , Count(0)
+            , Entries()
+        {
+
+        }
+
+        TlbShootdownQueue(TlbShootdownQueue const &) = delete;
+        TlbShootdownQueue & operator =(TlbShootdownQueue const &) = delete;
+
+        /*  Fields  */
+
+        Synchronization::SmpLock Lock;
+
+        size_t Count;
+
+        TlbPendingEntry Entries[Capacity];
+    };
+
+    /**
+     *  The invalidation batches opened by a thread over one address space.
+     */
+    struct TlbBatch
+    {
+        TlbShootdownQueue * Queue;
+        //  Queue of the address space covered by the outermost batch.
+        size_t Depth;
+        //  Number of nested batches open.
+    };
+}}
@@ -44,9 +44,15 @@
 #pragma once
 
 #include "memory/paging.hpp"
+#include "memory/tlb.hpp"
 #include <beel/sync/smp.lock.hpp>
 #include <beel/handles.h>
 
+namespace Beelzebub { namespace Execution
+{
+    class Process;
+}}
+
 namespace Beelzebub { namespace Memory
 {
     /**
@@ -66,7 +72,7 @@ namespace Beelzebub { namespace Memory
         static constexpr size_t    const KernelHeapLength    = KernelHeapEnd - KernelHeapStart;
         static constexpr size_t    const KernelHeapPageCount = KernelHeapLength >> 12;
 
-        static bool Page1GB, NX, PCID;
+        static bool Page1GB, NX, PCID, INVPCID;
 
         static __thread paddr_t LastAlienPml4;
 
@@ -105,6 +111,15 @@ namespace Beelzebub { namespace Memory
 
         static constexpr size_t const RecursiveUnmapDepth = 32;
 
+        //  Shootdowns of more pages than this flush the entire TLB instead.
+        static constexpr size_t const FullFlushThreshold = 32;
+
+        //  Number of address spaces each core keeps tagged in its TLB.
+        static constexpr size_t const ContextCount = 6;
+
+        static __thread TlbContext Contexts[ContextCount];
+        static __thread size_t NextContext;
+
         /*  Constructor(s)  */
 
     protected:
@@ -114,6 +129,11 @@ namespace Beelzebub { namespace Memory
         VmmArc(VmmArc const &) = delete;
         VmmArc & operator =(VmmArc const &) = delete;
 
+        /*  TLB Shootdowns  */
+
+        //  Marks whether this core may cache translations of the given process.
+        static __hot void SetActiveCore(Execution::Process * proc, bool active);
+
         /*  Static Translation Methods  */
 
         static __forceinline uint16_t GetPml4Index(vaddr_t const addr)
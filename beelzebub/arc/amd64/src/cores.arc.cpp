@@ -40,6 +40,8 @@
 #include "cores.hpp"
 #include "memory/vmm.hpp"
 #include "system/cpu.hpp"
+#include "system/cpuid.hpp"
+#include "system/numa.hpp"
 #include "kernel.image.hpp"
 #include "kernel.hpp"
 #include <beel/sync/atomic.hpp>
@@ -65,6 +67,7 @@ static Atomic<size_t> RegistrationCounter {0};
 Atomic<uint16_t> TssSegmentCounter {(uint16_t)(8 * 8)};
 
 static __startup void CreateStacks(CpuData * const data);
+static __startup uint32_t GetInitialApicId();
 
 #ifdef __BEELZEBUB_SETTINGS_KRNDYNALLOC_STREAMFLOW
     //  TODO: Unhax this thing.
@@ -183,6 +186,8 @@ void Cores::Register()
 
     data->LastExtendedStateThread = nullptr;
 
+    data->Node = Numa::GetProcessorNode(GetInitialApicId());
+
     //  And the stack.
 
     CreateStacks(data);
@@ -235,6 +240,26 @@ CpuData * Cores::Get(size_t const index)
     Internals
 ****************/
 
+uint32_t GetInitialApicId()
+{
+    uint32_t a, b, c, d;
+
+    CpuId::Execute(0x00000000U, a, b, c, d);
+
+    if (a >= 0x0000000BU)
+    {
+        CpuId::Execute(0x0000000BU, 0U, a, b, c, d);
+
+        if (b != 0)
+            return d;
+        //  The x2APIC ID is given only if the leaf is actually implemented.
+    }
+
+    CpuId::Execute(0x00000001U, a, b, c, d);
+
+    return b >> 24;
+}
+
 void CreateStacks(CpuData * const data)
 {
     //  NOTE:
@@ -280,4 +305,24 @@ void CreateStacks(CpuData * const data)
         , res)XEND;
 
     data->EmbeddedTss.Ist[1] = vaddr.Value + PageFaultStackSize;
+
+    //  And finally, the stack on which threads yield, so their own stacks are
+    //  free as soon as their state is saved.
+
+    vaddr = nullvaddr;
+
+    res = Vmm::AllocatePages(nullptr
+        , vsize_t(SchedulerStackSize)
+        , MemoryAllocationOptions::Commit   | MemoryAllocationOptions::VirtualKernelHeap
+        | MemoryAllocationOptions::GuardLow | MemoryAllocationOptions::GuardHigh
+        , MemoryFlags::Global | MemoryFlags::Writable
+        , MemoryContent::ThreadStack
+        , vaddr);
+
+    ASSERTX(res.IsOkayResult()
+        , "Failed to allocate scheduler stack of CPU #%us: %H."
+        , data->Index
+        , res)XEND;
+
+    data->EmbeddedTss.Ist[2] = vaddr.Value + SchedulerStackSize;
 }
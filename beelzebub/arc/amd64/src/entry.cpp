@@ -57,6 +57,7 @@
 #include "system/timers/pit.hpp"
 #include "system/cpu.hpp"
 #include "system/fpu.hpp"
+#include "system/numa.hpp"
 
 #include "initrd.hpp"
 #include "kernel.image.hpp"
@@ -191,6 +192,28 @@ Handle Beelzebub::ParseKernelArguments()
     PHYSICAL MEMORY
 **********************/
 
+/**
+ *  <summary>
+ *  Creates allocation spaces over the given range, split wherever the NUMA node
+ *  of the memory changes.
+ *  </summary>
+ */
+static __startup void CreateNodeAllocationSpaces(paddr_t start, paddr_t const end)
+{
+    while (start < end)
+    {
+        paddr_t rangeEnd;
+        uint32_t const node = Numa::GetAddressNode(start, rangeEnd);
+
+        if (rangeEnd > end)
+            rangeEnd = end;
+
+        PmmArc::CreateAllocationSpace(start, rangeEnd, node);
+
+        start = rangeEnd;
+    }
+}
+
 /**
  *  <summary>
  *  Sanitizes the memory map and initializes the page allocator over the local
@@ -273,10 +296,10 @@ __startup Handle InitializePhysicalAllocator(jg_info_mmap_t * map // TODO: Don't
             if (m->address < start.Value && (m->address + m->length) > start.Value)
                 //  Means this entry crosses the start of free memory.
                 //CreateAllocationSpace(start, m->address + m->length, domain);
-                PmmArc::CreateAllocationSpace(start, paddr_t(m->address + m->length));
+                CreateNodeAllocationSpaces(start, paddr_t(m->address + m->length));
             else
                 //CreateAllocationSpace(m->address, m->address + m->length, domain);
-                PmmArc::CreateAllocationSpace(paddr_t(m->address), paddr_t(m->address + m->length));
+                CreateNodeAllocationSpaces(paddr_t(m->address), paddr_t(m->address + m->length));
         }
 
     //  PAGE RESERVATION
@@ -310,6 +333,20 @@ Handle Beelzebub::InitializePhysicalMemory()
         , "Failed to initialize the physical memory allocator for domain 0: %H.%n"
         , res);
 
+    if (CMDO_FrameCacheHigh.ParsingResult.IsValid() || CMDO_FrameCacheLow.ParsingResult.IsValid())
+    {
+        size_t const high = CMDO_FrameCacheHigh.ParsingResult.IsValid()
+            ? CMDO_FrameCacheHigh.UnsignedIntegerValue : PmmArc::SmallCacheHigh;
+        size_t const low = CMDO_FrameCacheLow.ParsingResult.IsValid()
+            ? CMDO_FrameCacheLow.UnsignedIntegerValue : PmmArc::SmallCacheLow;
+
+        res = PmmArc::SetCacheWatermarks(high, low);
+
+        ASSERT(res.IsOkayResult()
+            , "Invalid frame cache watermarks: high %us, low %us: %H.%n"
+            , high, low, res);
+    }
+
     return HandleResult::Okay;
 }
 
@@ -386,6 +423,10 @@ Handle Beelzebub::InitializeVirtualMemory()
     VmmArc::Page1GB = BootstrapCpuid.CheckFeature(CpuFeature::Page1GB);
     VmmArc::NX      = BootstrapCpuid.CheckFeature(CpuFeature::NX     );
 
+    VmmArc::PCID    = BootstrapCpuid.CheckFeature(CpuFeature::PCID   ) && Cpu::GetCr4().GetPge();
+    //  Kernel translations must be global to be shared by all PCIDs.
+    VmmArc::INVPCID = BootstrapCpuid.CheckFeature(CpuFeature::INVPCID) && VmmArc::PCID;
+
     Vmm::Bootstrap(&BootstrapProcess);
     ++BootstrapProcess.ActiveCoreCount;
 
@@ -405,6 +446,23 @@ Handle Beelzebub::InitializeVirtualMemory()
 
     //  TODO: Management for ISA DMA.
 
+    if (CMDO_FaultAround.ParsingResult.IsValid() || CMDO_ZeroedFrames.ParsingResult.IsValid())
+    {
+        size_t const pages = CMDO_FaultAround.ParsingResult.IsValid()
+            ? CMDO_FaultAround.UnsignedIntegerValue : Vmm::FaultAroundPages;
+        size_t const zeroed = CMDO_ZeroedFrames.ParsingResult.IsValid()
+            ? CMDO_ZeroedFrames.UnsignedIntegerValue : Vmm::ZeroedFrameTarget;
+
+        res = Vmm::SetFaultAround(pages, zeroed);
+
+        ASSERT(res.IsOkayResult()
+            , "Invalid fault-around settings: %us pages, %us zeroed frames: %H.%n"
+            , pages, zeroed, res);
+    }
+
+    if (CMDO_LargePages.ParsingResult.IsValid())
+        Vmm::TransparentLargePages = CMDO_LargePages.BooleanValue;
+
     Cpu::SetCr0(Cpu::GetCr0().SetWriteProtect(true));
 
     BootstrapProcess.SetActive();
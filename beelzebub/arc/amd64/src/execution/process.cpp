@@ -47,6 +47,10 @@ using namespace Beelzebub::Execution;
     ProcessArchitecturalBase class
 *************************************/
 
+/*  Statics  */
+
+uint64_t ProcessArchitecturalBase::NextContextId = 0;
+
 /*  Operations  */
 
 void ProcessArchitecturalBase::PreSetActive()
@@ -39,6 +39,8 @@
 
 #include "handle.table.arc.hpp"
 #include "memory/vmm.hpp"
+#include <beel/interrupt.state.hpp>
+#include <global_options.hpp>
 
 using namespace Beelzebub;
 using namespace Beelzebub::Memory;
@@ -46,6 +48,16 @@ using namespace Beelzebub::Memory;
 __thread handle_t LocalFreeIndex = HandleTable::InvalidHandle;
 __thread size_t LocalFreeCount = 0;
 
+static __forceinline handle_t GetHeadIndex(uint64_t head)
+{
+    return handle_t((handle_inner_t)head);
+}
+
+static __forceinline uint64_t MakeHead(handle_t ind, uint64_t oldHead)
+{
+    return ((oldHead >> 32) + 1) << 32 | ind.Value;
+}
+
 /***************************
     HandleTableArc class
 ***************************/
@@ -53,12 +65,62 @@ __thread size_t LocalFreeCount = 0;
 /*  Statics  */
 
 HandleTableEntryArc * HandleTableArc::Table;
-handle_t HandleTableArc::GlobalFreeIndex;
+uint64_t HandleTableArc::GlobalFreeHead = HandleTable::InvalidHandle.Value;
 handle_t HandleTableArc::Maximum;
 handle_t HandleTableArc::Cursor {0};
 
-handle_t HandleTableArc::FreeListThreshold { 100 };
-handle_t HandleTableArc::FreeListRemovalCount { 90 };
+size_t HandleTableArc::FreeListThreshold = 100;
+size_t HandleTableArc::FreeListRemovalCount = 90;
+
+/*  Parameters  */
+
+bool HandleTableArc::SetFreeListLimits(size_t threshold, size_t removalCount)
+{
+    if unlikely(removalCount == 0 || removalCount > threshold
+        || threshold > MaximumFreeListThreshold)
+        return false;
+
+    FreeListThreshold = threshold;
+    FreeListRemovalCount = removalCount;
+
+    return true;
+}
+
+/*  Garbage Collection  */
+
+void HandleTableArc::CollectLocalFreeList(size_t count)
+{
+    //  Moves a batch off the top of the current core's free list onto the
+    //  global stack, in a single operation. Assumes interrupts are disabled.
+
+    if unlikely(count > LocalFreeCount)
+        count = LocalFreeCount;
+
+    if unlikely(count == 0)
+        return;
+
+    handle_t const first = LocalFreeIndex;
+    HandleTableEntryArc * last = Table + first.Value;
+
+    for (size_t i = 1; i < count; ++i)
+        last = Table + last->LocalIndex.Value;
+
+    LocalFreeIndex = last->LocalIndex;
+    LocalFreeCount -= count;
+
+    last->LocalIndex = HandleTable::InvalidHandle;
+
+    HandleTableEntryArc * const head = Table + first.Value;
+    uint64_t top = __atomic_load_n(&GlobalFreeHead, __ATOMIC_RELAXED);
+
+    head->BatchSize = (uint32_t)count;
+
+    do
+    {
+        __atomic_store_n(&(head->NextBatch), GetHeadIndex(top).Value, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&GlobalFreeHead, &top, MakeHead(first, top)
+        , false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
 
 /************************
     HandleTable class
@@ -73,7 +135,16 @@ HandleTableInitializationResult HandleTable::Initialize(handle_t limit)
     vsize_t const size = RoundUp((size_t)limit.Value * SizeOf<HandleTableEntryArc>, PageSize);
     vaddr_t vaddr = nullvaddr;
 
-    //  TODO: Read parameters for FreeList(Threshold|RemovalCount)
+    if (CMDO_HandleFreeListHigh.ParsingResult.IsValid() || CMDO_HandleFreeListBatch.ParsingResult.IsValid())
+    {
+        size_t const threshold = CMDO_HandleFreeListHigh.ParsingResult.IsValid()
+            ? CMDO_HandleFreeListHigh.UnsignedIntegerValue : HandleTableArc::FreeListThreshold;
+        size_t const removalCount = CMDO_HandleFreeListBatch.ParsingResult.IsValid()
+            ? CMDO_HandleFreeListBatch.UnsignedIntegerValue : HandleTableArc::FreeListRemovalCount;
+
+        if unlikely(!HandleTableArc::SetFreeListLimits(threshold, removalCount))
+            return HandleTableInitializationResult::InvalidParameters;
+    }
 
     Handle res = Vmm::AllocatePages(nullptr
         , size
@@ -101,32 +172,41 @@ Result<HandleAllocationResult, handle_t> HandleTable::Allocate(uint16_t pcid)
 
     handle_t res;
 
-    if ((res = LocalFreeIndex) != InvalidHandle)
-    {
-        LocalFreeIndex = HandleTableArc::Table[res.Value].LocalIndex;
-        --LocalFreeCount;
-
-        goto return_entry;
-    }
-
-    do
-    {
-        res = handle_t(__atomic_load_n(&HandleTableArc::GlobalFreeIndex.Value, __ATOMIC_ACQUIRE));
+    {   //  Scope to contain the guard.
+        InterruptGuard<> intGuard;
+        //  The free list belongs to the core, not the thread.
 
-        if (res == InvalidHandle)
-            break;
-
-        handle_t next = HandleTableArc::Table[res.Value].LocalIndex;
+        if likely((res = LocalFreeIndex) != InvalidHandle)
+        {
+            LocalFreeIndex = HandleTableArc::Table[res.Value].LocalIndex;
+            --LocalFreeCount;
 
-        if (__atomic_compare_exchange_n(&HandleTableArc::GlobalFreeIndex.Value, &next.Value, res.Value, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
             goto return_entry;
+        }
+
+        uint64_t top = __atomic_load_n(&HandleTableArc::GlobalFreeHead, __ATOMIC_ACQUIRE);
 
-        /*  Note: This is indeed vulnerable to the ABA problem, when the `next` value of the stack top entry changes
-            after it has been read. This is extremely unlikely to occur in practice because of the use of local free
-            lists. This entry would have to have been popped from the stack, deallocated, triggered a garbage
-            collection, and end up in the right spot to make it global stack top again.
-        */
-    } while (true);
+        while ((res = GetHeadIndex(top)) != InvalidHandle)
+        {
+            HandleTableEntryArc const * const head = HandleTableArc::Table + res.Value;
+            handle_t const next { __atomic_load_n(&(head->NextBatch), __ATOMIC_RELAXED) };
+
+            if (__atomic_compare_exchange_n(&HandleTableArc::GlobalFreeHead, &top, MakeHead(next, top)
+                , false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            {
+                LocalFreeIndex = head->LocalIndex;
+                LocalFreeCount = head->BatchSize - 1;
+                //  The rest of the batch becomes this core's free list, which
+                //  was empty.
+
+                goto return_entry;
+            }
+
+            //  The generation in the head changes with every push and pop, so
+            //  a stale `next` cannot make it through even if the same batch
+            //  made it back on top meanwhile.
+        }
+    }
 
     //  Reaching this point means the cursor needs to be increased.
 
@@ -149,7 +229,7 @@ return_entry:
 
 bool HandleTable::Deallocate(handle_t ind)
 {
-    if unlikely(ind.Value < HandleTableArc::Cursor.Value)
+    if unlikely(ind.Value >= __atomic_load_n(&HandleTableArc::Cursor.Value, __ATOMIC_RELAXED))
         return false;
 
     HandleTableEntryArc * entry = HandleTableArc::Table + ind.Value;
@@ -160,28 +240,17 @@ bool HandleTable::Deallocate(handle_t ind)
 
     //  TODO: Mark invalidation, somehow, in the process maps.
 
+    InterruptGuard<> intGuard;
+
     entry->ReferenceCount -= 1;
     entry->ProcessId = 0xFFFF;
     entry->LocalIndex = LocalFreeIndex;
 
     LocalFreeIndex = ind;
 
-    if unlikely(++LocalFreeCount >= HandleTableArc::FreeListThreshold.Value)
-    {
-        size_t i;
-
-        for (i = 1; entry->LocalIndex != InvalidHandle && i < HandleTableArc::FreeListRemovalCount.Value; ++i)
-            entry = HandleTableArc::Table + entry->LocalIndex.Value;
-
-        LocalFreeIndex = entry->LocalIndex;
-        LocalFreeCount -= i;
-
-        do
-        {
-            entry->LocalIndex = handle_t(__atomic_load_n(&HandleTableArc::GlobalFreeIndex.Value, __ATOMIC_ACQUIRE));
-        } while(!__atomic_compare_exchange_n(&HandleTableArc::GlobalFreeIndex.Value, &entry->LocalIndex, ind, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
-        //  Splices some of the current core's free list entries into the global free list.
-    }
+    if unlikely(++LocalFreeCount >= HandleTableArc::FreeListThreshold)
+        HandleTableArc::CollectLocalFreeList(HandleTableArc::FreeListRemovalCount);
+    //  A bounded list keeps freed handles from piling up on a single core.
 
     return true;
 }
@@ -40,9 +40,13 @@
 #include <memory/pmm.hpp>
 #include <memory/pmm.arc.hpp>
 #include <system/cpu.hpp>
+#include <system/numa.hpp>
 #include <kernel.hpp>
 
+#include <beel/interrupt.state.hpp>
+
 #include <math.h>
+#include <string.h>
 #include <debug.hpp>
 
 using namespace Beelzebub;
@@ -94,21 +98,160 @@ paddr_t PmmArc::TempSpaceLimit = nullpaddr;
 FrameAllocationSpace * PmmArc::AllocationSpace = nullptr;
 FrameAllocator * PmmArc::MainAllocator = nullptr;
 
+size_t PmmArc::SmallCacheHigh = 256;
+size_t PmmArc::SmallCacheLow = 64;
+
+/*  Per-CPU Caches  */
+
+namespace
+{
+    struct FrameCache
+    {
+        size_t SmallCount, LargeCount;
+
+        paddr_inner_t Small[PmmArc::SmallCacheCapacity];
+        paddr_inner_t Large[PmmArc::LargeCacheCapacity];
+    };
+
+    __thread FrameCache MyFrameCache;
+
+    __forceinline bool CachesUsable(FrameSize const size)
+    {
+        return likely(CpuDataSetUp && PmmArc::SmallCacheHigh != 0)
+            && (size == FrameSize::_4KiB || size == FrameSize::_2MiB);
+    }
+
+    paddr_t AllocateCachedFrame(FrameSize const size, uint32_t const refCnt)
+    {
+        //  Caches only hold frames from the node of their core, barring shortages
+        //  of local memory.
+
+        InterruptGuard<> intGuard;
+
+        bool const small = size == FrameSize::_4KiB;
+        size_t & count = small ? MyFrameCache.SmallCount : MyFrameCache.LargeCount;
+        paddr_inner_t * const frames = small ? MyFrameCache.Small : MyFrameCache.Large;
+
+        if unlikely(count == 0)
+            count = PmmArc::MainAllocator->AllocateFrames(size, frames
+                , small ? PmmArc::SmallCacheLow : PmmArc::LargeCacheLow
+                , Cpu::GetData()->Node);
+        //  Refilled in one batch, under a single lock acquisition.
+
+        if unlikely(count == 0)
+            return nullpaddr;
+
+        paddr_t const res { frames[--count] };
+
+        if (refCnt != 0)
+        {
+            FrameSize dummy;
+
+            PmmArc::MainAllocator->GetSpace(res)->PeekUsedFrame(res, dummy)->Use(refCnt);
+        }
+        //  Cached frames are already used, with no references.
+
+        return res;
+    }
+
+    Handle ReleaseCachedFrame(paddr_t addr, FrameSize const size, FrameAllocationSpace * const space)
+    {
+        //  The frame must be used and unreferenced.
+
+        if (size == FrameSize::_2MiB)
+            addr = RoundDown(addr, LargePageSize);
+        //  Split large pages are released through their last 4 KiB entry, which
+        //  points inside the frame. Caching that address would hand out a
+        //  misaligned large page later.
+
+        InterruptGuard<> intGuard;
+
+        if unlikely(space->Node != Cpu::GetData()->Node)
+        {
+            space->FreeFrames(size, &(addr.Value), 1);
+
+            return HandleResult::Okay;
+        }
+        //  Remote frames go straight back to their space, so other cores don't
+        //  end up with them.
+
+        bool const small = size == FrameSize::_4KiB;
+        size_t & count = small ? MyFrameCache.SmallCount : MyFrameCache.LargeCount;
+        paddr_inner_t * const frames = small ? MyFrameCache.Small : MyFrameCache.Large;
+        size_t const high = small ? PmmArc::SmallCacheHigh : PmmArc::LargeCacheCapacity;
+        size_t const low  = small ? PmmArc::SmallCacheLow  : PmmArc::LargeCacheLow;
+
+        if unlikely(count >= high)
+        {
+            PmmArc::MainAllocator->FreeFrames(size, frames, count - low);
+            memmove(frames, frames + (count - low), low * sizeof(paddr_inner_t));
+
+            count = low;
+        }
+        //  The oldest frames are drained, as the most recently freed ones are the
+        //  most likely to still be in this processor's caches.
+
+        frames[count++] = addr.Value;
+
+        return HandleResult::Okay;
+    }
+
+    __forceinline FrameDescriptor * PeekUsedFrame(paddr_t const addr, FrameSize & size, FrameAllocationSpace * & space)
+    {
+        space = PmmArc::MainAllocator->GetSpace(addr);
+
+        return likely(space != nullptr) ? space->PeekUsedFrame(addr, size) : nullptr;
+    }
+}
+
+Handle PmmArc::SetCacheWatermarks(size_t high, size_t low)
+{
+    if unlikely(high > SmallCacheCapacity || (high != 0 && (low == 0 || low >= high)))
+        return HandleResult::ArgumentOutOfRange;
+
+    SmallCacheHigh = high;
+    SmallCacheLow = low;
+
+    return HandleResult::Okay;
+}
+
 /****************
     Pmm class
 ****************/
 
 /*  Frame operations  */
 
-paddr_t Pmm::AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt)
+paddr_t Pmm::AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt, uint32_t node)
 {
-    //  TODO: NUMA selection of some sorts, maybe based on process?
+    uint32_t const local = likely(CpuDataSetUp) ? Cpu::GetData()->Node : 0;
 
-    return PmmArc::MainAllocator->AllocateFrame(size, magn, refCnt);
+    if (node >= Numa::NodeCount)
+        node = local;
+    //  This also covers the local node hint.
+
+    if (node == local && (magn == AddressMagnitude::Any || magn == AddressMagnitude::_48bit) && CachesUsable(size))
+        if (paddr_t const res = AllocateCachedFrame(size, refCnt); likely(res != nullpaddr))
+            return res;
+
+    return PmmArc::MainAllocator->AllocateFrame(size, magn, refCnt, node);
 }
 
 Handle Pmm::FreeFrame(paddr_t addr, bool ignoreRefCnt)
 {
+    if (CpuDataSetUp && PmmArc::SmallCacheHigh != 0)
+    {
+        FrameSize size;
+        FrameAllocationSpace * space;
+        FrameDescriptor * const desc = PeekUsedFrame(addr, size, space);
+
+        if likely(desc != nullptr && (ignoreRefCnt || desc->ReferenceCount <= 1))
+        {
+            desc->ResetReferenceCount();
+
+            return ReleaseCachedFrame(addr, size, space);
+        }
+    }
+
     uint32_t dummy;
 
     return PmmArc::MainAllocator->Mingle(addr, dummy, 0, ignoreRefCnt);
@@ -124,6 +267,22 @@ Handle Pmm::AdjustReferenceCount(paddr_t addr, uint32_t & newCnt, int32_t diff)
     if unlikely(addr == nullpaddr || diff == 0)
         return HandleResult::ArgumentOutOfRange;
 
+    if (CpuDataSetUp && PmmArc::SmallCacheHigh != 0)
+    {
+        FrameSize size;
+        FrameAllocationSpace * space;
+
+        if (FrameDescriptor * const desc = PeekUsedFrame(addr, size, space); likely(desc != nullptr))
+        {
+            if ((newCnt = desc->AdjustReferenceCount(diff)) != 0)
+                return HandleResult::Okay;
+
+            return ReleaseCachedFrame(addr, size, space);
+        }
+    }
+    //  With caching enabled, used frames are adjusted without any lock, and
+    //  unreferenced ones go to this core's cache.
+
     return PmmArc::MainAllocator->Mingle(addr, newCnt, diff, false);
 }
 
@@ -141,7 +300,7 @@ Handle Pmm::GetFrameInfo(paddr_t addr, FrameSize & size, uint32_t & refCnt)
 
 /*  Initialization  */
 
-Handle PmmArc::CreateAllocationSpace(paddr_t start, paddr_t end)
+Handle PmmArc::CreateAllocationSpace(paddr_t start, paddr_t end, uint32_t node)
 {
     // MSG_("&& Space %XP-%XP (%XS) ", start, end, end - start);
 
@@ -172,7 +331,7 @@ Handle PmmArc::CreateAllocationSpace(paddr_t start, paddr_t end)
         else
             ++PmmArc::AllocationSpace;
 
-        PmmArc::MainAllocator->AppendAllocationSpace(new (PmmArc::AllocationSpace) FrameAllocationSpace(start, end));
+        PmmArc::MainAllocator->AppendAllocationSpace(new (PmmArc::AllocationSpace) FrameAllocationSpace(start, end, node));
 
         return HandleResult::Okay;
     }
@@ -187,7 +346,7 @@ Handle PmmArc::CreateAllocationSpace(paddr_t start, paddr_t end)
 
         PmmArc::TempSpaceLimit = start + PageSize;
 
-        new (PmmArc::MainAllocator) FrameAllocator(new (PmmArc::AllocationSpace) FrameAllocationSpace(start + PageSize, end));
+        new (PmmArc::MainAllocator) FrameAllocator(new (PmmArc::AllocationSpace) FrameAllocationSpace(start + PageSize, end, node));
 
         return HandleResult::Okay;
     }
@@ -239,7 +398,7 @@ void PmmArc::Remap(FrameAllocator * & alloc, vaddr_t const oldVaddr, vaddr_t con
 
 /*  Constructor(s)  */
 
-FrameAllocationSpace::FrameAllocationSpace(paddr_t phys_start, paddr_t phys_end)
+FrameAllocationSpace::FrameAllocationSpace(paddr_t phys_start, paddr_t phys_end, uint32_t node)
     : MemoryStart( phys_start)
     , MemoryEnd(phys_end)
     , Size(phys_end - phys_start)
@@ -251,6 +410,7 @@ FrameAllocationSpace::FrameAllocationSpace(paddr_t phys_start, paddr_t phys_end)
     , SplitFree(LargeFrameDescriptor::NullIndex)
     , Next(nullptr)
     , Previous(nullptr)
+    , Node(node)
 {
     paddr_t const algn_end { RoundDown(phys_end.Value, 2 << 20) };
     //  Round down the end to a two-megabyte address.
@@ -369,65 +529,14 @@ paddr_t FrameAllocationSpace::AllocateFrame(FrameSize size, uint32_t refCnt)
     if (size == FrameSize::_4KiB)
     {
         withLock (this->SplitLocker)
-        {
-            //  No large frame was pre-selected.
-
-            lIndex = this->SplitFree;
-
-            if (lIndex == LargeFrameDescriptor::NullIndex)
-                goto grab_large_page;
-
-            // MSG_("   Split free: %u4%n", lIndex);
-
-            //  Reaching this point means a non-full split frame exists!
+            paddr = this->PopSmallFrame(refCnt);
 
-            lDesc = this->Map + lIndex;
-            sIndex = lDesc->GetExtras()->NextFree;
-            SmallFrameDescriptor * const sDesc = lDesc->SubDescriptors + sIndex;
-
-            assert_or(sIndex != SmallFrameDescriptor::NullIndex
-                , "Invalid split frame state!")
-            {
-                //  This should *not* happen, ever.
-
-                goto split_frame_full;
-            }
-
-            // MSG_("   Small frame index: %u2 (-> %u2)%n", sIndex, sDesc->NextIndex);
-
-            sDesc->Use(refCnt);
-
-            lDesc->GetExtras()->NextFree = sDesc->NextIndex;
-            lDesc->GetExtras()->FreeCount -= 1;
-
-            if unlikely(sDesc->NextIndex == SmallFrameDescriptor::NullIndex)
-            {
-                //  This was the last small frame in the split frame.
-
-            split_frame_full:
-                lDesc->Status = FrameStatus::Full;
-
-                uint32_t next = lDesc->NextIndex;
-                this->SplitFree = next;
-
-                if likely(next != LargeFrameDescriptor::NullIndex)
-                    this->Map[next].GetExtras()->PrevIndex = LargeFrameDescriptor::NullIndex;
-                //  No more previous frame for the next frame.
-
-                // MSG_("   Split frame depleted; Next: %u4%n", this->SplitFree);
-
-                onRelease if (sIndex == SmallFrameDescriptor::NullIndex)
-                    goto grab_large_page;
-                //  In release mode, this rather odd situation is tolerated.
-            }
-        }
-
-        // MSG_("   Returning address %XP **%n", this->AllocationStart + (lIndex << 21) + (sIndex << 12));
+        if likely(paddr != nullpaddr)
+            return paddr;
 
-        return this->AllocationStart + psize_t(lIndex << 21) + psize_t(sIndex << 12);
+        //  No split frame with free small frames remains, so a large one is split.
     }
 
-grab_large_page:
     withLock (this->LargeLocker)
     {
         lIndex = this->LargeFree;
@@ -478,6 +587,116 @@ grab_large_page:
     return this->AllocationStart + psize_t(lIndex << 21) + psize_t(sIndex << 12);
 }
 
+paddr_t FrameAllocationSpace::PopSmallFrame(uint32_t refCnt)
+{
+    //  Assumes the split frame lock is held.
+
+    uint32_t const lIndex = this->SplitFree;
+
+    if (lIndex == LargeFrameDescriptor::NullIndex)
+        return nullpaddr;
+
+    // MSG_("   Split free: %u4%n", lIndex);
+
+    //  Reaching this point means a non-full split frame exists!
+
+    LargeFrameDescriptor * const lDesc = this->Map + lIndex;
+    uint16_t const sIndex = lDesc->GetExtras()->NextFree;
+    SmallFrameDescriptor * const sDesc = lDesc->SubDescriptors + sIndex;
+
+    assert_or(sIndex != SmallFrameDescriptor::NullIndex
+        , "Invalid split frame state!")
+    {
+        //  This should *not* happen, ever.
+
+        goto split_frame_full;
+    }
+
+    // MSG_("   Small frame index: %u2 (-> %u2)%n", sIndex, sDesc->NextIndex);
+
+    sDesc->Use(refCnt);
+
+    lDesc->GetExtras()->NextFree = sDesc->NextIndex;
+    lDesc->GetExtras()->FreeCount -= 1;
+
+    if unlikely(sDesc->NextIndex == SmallFrameDescriptor::NullIndex)
+    {
+        //  This was the last small frame in the split frame.
+
+    split_frame_full:
+        lDesc->Status = FrameStatus::Full;
+
+        uint32_t next = lDesc->NextIndex;
+        this->SplitFree = next;
+
+        if likely(next != LargeFrameDescriptor::NullIndex)
+            this->Map[next].GetExtras()->PrevIndex = LargeFrameDescriptor::NullIndex;
+        //  No more previous frame for the next frame.
+
+        // MSG_("   Split frame depleted; Next: %u4%n", this->SplitFree);
+
+        onRelease if (sIndex == SmallFrameDescriptor::NullIndex)
+            return this->PopSmallFrame(refCnt);
+        //  In release mode, this rather odd situation is tolerated.
+    }
+
+    // MSG_("   Returning address %XP **%n", this->AllocationStart + (lIndex << 21) + (sIndex << 12));
+
+    return this->AllocationStart + psize_t(lIndex << 21) + psize_t(sIndex << 12);
+}
+
+bool FrameAllocationSpace::PushSmallFrame(LargeFrameDescriptor * lDesc, uint32_t lIndex, uint16_t sIndex)
+{
+    //  Assumes the split frame lock is held. Returns true if the large frame
+    //  became completely free, in which case it is unlinked from the stack of
+    //  split frames and needs to be reclaimed.
+
+    SmallFrameDescriptor * const sDesc = lDesc->SubDescriptors + sIndex;
+
+    sDesc->Free();
+
+    sDesc->NextIndex = lDesc->GetExtras()->NextFree;
+    lDesc->GetExtras()->NextFree = sIndex;
+    uint16_t subDescCnt = lDesc->GetExtras()->FreeCount += 1;
+
+    if unlikely(lDesc->Status == FrameStatus::Full)
+    {
+        //  Split frame used to be full, but not anymore. So it can
+        //  be added to the stack of non-full split frames.
+
+        lDesc->Status = FrameStatus::Split;
+
+        uint32_t next = this->SplitFree;
+
+        lDesc->NextIndex = next;
+        this->SplitFree = lIndex;
+
+        if likely(next != LargeFrameDescriptor::NullIndex)
+            this->Map[next].GetExtras()->PrevIndex = lIndex;
+
+        lDesc->GetExtras()->PrevIndex = LargeFrameDescriptor::NullIndex;
+    }
+    else if unlikely(subDescCnt == LargeFrameDescriptor::SubDescriptorsCount)
+    {
+        //  All small frames within the split frame are free, so it
+        //  can be freed completely.
+
+        uint32_t next = lDesc->NextIndex, prev = lDesc->GetExtras()->PrevIndex;
+
+        if (next != LargeFrameDescriptor::NullIndex)
+            this->Map[next].GetExtras()->PrevIndex = prev;
+        if (prev != LargeFrameDescriptor::NullIndex)
+            this->Map[prev].NextIndex = next;
+
+        if (this->SplitFree == lIndex)
+            this->SplitFree = next;
+
+        return true;
+    }
+
+    return false;
+}
+
 Handle FrameAllocationSpace::Mingle(paddr_t addr, uint32_t & newCnt, int32_t diff, bool ignoreRefCnt)
 {
     if (addr < this->AllocationStart || addr >= this->AllocationEnd)
@@ -622,46 +841,8 @@ do_small_frame:
         case FrameStatus::Used:
             if likely(test(sDesc))
             {
-                sDesc->Free();
-
-                sDesc->NextIndex = lDesc->GetExtras()->NextFree;
-                lDesc->GetExtras()->NextFree = sIndex;
-                uint16_t subDescCnt = lDesc->GetExtras()->FreeCount += 1;
-
-                if unlikely(lDesc->Status == FrameStatus::Full)
-                {
-                    //  Split frame used to be full, but not anymore. So it can
-                    //  be added to the stack of non-full split frames.
-
-                    lDesc->Status = FrameStatus::Split;
-
-                    uint32_t next = this->SplitFree;
-
-                    lDesc->NextIndex = next;
-                    this->SplitFree = lIndex;
-
-                    if likely(next != LargeFrameDescriptor::NullIndex)
-                        this->Map[next].GetExtras()->PrevIndex = lIndex;
-
-                    lDesc->GetExtras()->PrevIndex = LargeFrameDescriptor::NullIndex;
-                }
-                else if unlikely(subDescCnt == LargeFrameDescriptor::SubDescriptorsCount)
-                {
-                    //  All small frames within the split frame are free, so it
-                    //  can be freed completely.
-
-                    uint32_t next = lDesc->NextIndex, prev = lDesc->GetExtras()->PrevIndex;
-
-                    if (next != LargeFrameDescriptor::NullIndex)
-                        this->Map[next].GetExtras()->PrevIndex = prev;
-                    if (prev != LargeFrameDescriptor::NullIndex)
-                        this->Map[prev].NextIndex = next;
-
-                    if (this->SplitFree == lIndex)
-                        this->SplitFree = next;
-
+                if unlikely(this->PushSmallFrame(lDesc, lIndex, sIndex))
                     goto reclaim_large_frame;
-                }
 
                 return HandleResult::Okay;
             }
@@ -889,54 +1070,160 @@ do_small_frame:
     return HandleResult::IntegrityFailure;
 }
 
-/***************************
-    FrameAllocator class
-***************************/
-
-/*  Page Manipulation  */
+/*  Batched operations  */
 
-paddr_t FrameAllocator::AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt)
+size_t FrameAllocationSpace::AllocateFrames(FrameSize size, paddr_inner_t * frames, size_t count)
 {
-    paddr_t ret = nullpaddr;
-    FrameAllocationSpace * space;
+    size_t n = 0;
 
-    if (magn == AddressMagnitude::Any || magn == AddressMagnitude::_48bit)
+    if (size == FrameSize::_2MiB)
     {
-        //  Any space is alright.
+        withLock (this->LargeLocker)
+            for (/* nothing */; n < count; ++n)
+            {
+                uint32_t const lIndex = this->LargeFree;
 
-        space = this->LastSpace;
+                if (lIndex == LargeFrameDescriptor::NullIndex)
+                    break;
 
-        while (space != nullptr)
-        {
-            ret = space->AllocateFrame(size, refCnt);
+                LargeFrameDescriptor * const lDesc = this->Map + lIndex;
 
-            if (ret != nullpaddr)
-                return ret;
+                this->LargeFree = lDesc->NextIndex;
+                lDesc->Use(0);
 
-            space = space->Previous;
-        }
+                frames[n] = (this->AllocationStart + psize_t(lIndex << 21)).Value;
+            }
+
+        return n;
     }
-    else if (magn == AddressMagnitude::_32bit)
+
+    assert(size == FrameSize::_4KiB);
+
+    while (n < count)
     {
-        space = this->LastSpace;
+        withLock (this->SplitLocker)
+            for (/* nothing */; n < count; ++n)
+            {
+                paddr_t const paddr = this->PopSmallFrame(0);
 
-        while (space != nullptr)
-        {
-            if (space->GetAllocationEnd() <= (1ULL << 32))
+                if (paddr == nullpaddr)
+                    break;
+
+                frames[n] = paddr.Value;
+            }
+
+        if (n == count)
+            break;
+
+        paddr_t const paddr = this->AllocateFrame(FrameSize::_4KiB, 0);
+        //  This splits a large frame, so the next round can continue with its
+        //  siblings.
+
+        if (paddr == nullpaddr)
+            break;
+
+        frames[n++] = paddr.Value;
+    }
+
+    return n;
+}
+
+void FrameAllocationSpace::FreeFrames(FrameSize size, paddr_inner_t const * frames, size_t count)
+{
+    if (size == FrameSize::_2MiB)
+    {
+        withLock (this->LargeLocker)
+            for (size_t i = 0; i < count; ++i)
             {
-                //  The condition checks that the allocation space ends
-                //  at a 32-bit address. (all the other addresses are less,
-                //  thus have to be 32-bit if the end is)
+                uint32_t const lIndex = (uint32_t)((paddr_t(frames[i]) - this->AllocationStart).Value >> 21UL);
+                LargeFrameDescriptor * const lDesc = this->Map + lIndex;
 
-                ret = space->AllocateFrame(size, refCnt);
+                assert(lDesc->Status == FrameStatus::Used)(frames[i])((uint16_t)lDesc->Status);
 
-                if (ret != nullpaddr)
-                    return ret;
+                lDesc->Free();
+
+                lDesc->NextIndex = this->LargeFree;
+                this->LargeFree = lIndex;
             }
 
-            space = space->Previous;
+        return;
+    }
+
+    assert(size == FrameSize::_4KiB);
+
+    withLock (this->SplitLocker)
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t const lIndex = (uint32_t)((paddr_t(frames[i]) - this->AllocationStart).Value >> 21UL);
+            LargeFrameDescriptor * const lDesc = this->Map + lIndex;
+            uint16_t const sIndex = (uint16_t)((frames[i] & 0x1FF000) >> 12);
+
+            assert(lDesc->IsSplit() && lDesc->SubDescriptors[sIndex].Status == FrameStatus::Used)
+                (frames[i])((uint16_t)lDesc->Status);
+
+            if unlikely(this->PushSmallFrame(lDesc, lIndex, sIndex))
+            {
+                lDesc->Free();
+
+                withLock (this->LargeLocker)
+                {
+                    lDesc->NextIndex = this->LargeFree;
+                    this->LargeFree = lIndex;
+                }
+                //  The large frame lock is only ever taken inside the split
+                //  frame lock, never the other way around.
+            }
         }
+}
+
+FrameDescriptor * FrameAllocationSpace::PeekUsedFrame(paddr_t addr, FrameSize & size)
+{
+    uint32_t const lIndex = (uint32_t)((addr - this->AllocationStart).Value >> 21UL);
+    LargeFrameDescriptor * const lDesc = this->Map + lIndex;
+
+    switch (lDesc->Status)
+    {
+    case FrameStatus::Used:
+        size = FrameSize::_2MiB;
+
+        return lDesc;
+
+    case FrameStatus::Split:
+    case FrameStatus::Full:
+        if (uint16_t const sIndex = (uint16_t)((addr.Value & 0x1FF000) >> 12); sIndex != 0)
+            if (SmallFrameDescriptor * const sDesc = lDesc->SubDescriptors + sIndex; sDesc->Status == FrameStatus::Used)
+            {
+                size = FrameSize::_4KiB;
+
+                return sDesc;
+            }
+
+        return nullptr;
+
+    default:
+        return nullptr;
     }
+    //  The status of a frame to which the caller holds a reference cannot change
+    //  concurrently, so no lock is needed.
+}
+
+/***************************
+    FrameAllocator class
+***************************/
+
+/*  Page Manipulation  */
+
+paddr_t FrameAllocator::AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt, uint32_t node)
+{
+    paddr_t limit;
+
+    if (magn == AddressMagnitude::Any || magn == AddressMagnitude::_48bit)
+        limit = paddr_t(~(paddr_inner_t)0);
+        //  Any space is alright.
+    else if (magn == AddressMagnitude::_32bit)
+        limit = paddr_t(1ULL << 32);
+        //  The allocation space must end at a 32-bit address. (all the other
+        //  addresses are less, thus have to be 32-bit if the end is)
     else
     {
         //  TODO: 24-bit and 16-bit addresses, maybeh?
@@ -945,6 +1232,23 @@ paddr_t FrameAllocator::AllocateFrame(FrameSize size, AddressMagnitude magn, uin
             , (magn == AddressMagnitude::_24bit) ? "24-bit" : "16-bit");
     }
 
+    uint32_t const nodeCount = Numa::NodeCount;
+    uint32_t const * const order = Numa::GetFallbackOrder(node < nodeCount ? node : 0);
+
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        for (FrameAllocationSpace * space = this->LastSpace; space != nullptr; space = space->Previous)
+        {
+            if ((nodeCount > 1 && space->Node != order[i]) || space->GetAllocationEnd() > limit)
+                continue;
+
+            paddr_t const ret = space->AllocateFrame(size, refCnt);
+
+            if (ret != nullpaddr)
+                return ret;
+        }
+    }
+
     return nullpaddr;
 }
 
@@ -1032,6 +1336,38 @@ FrameAllocationSpace * FrameAllocator::GetSpace(paddr_t paddr)
     return nullptr;
 }
 
+/*  Batched operations  */
+
+size_t FrameAllocator::AllocateFrames(FrameSize size, paddr_inner_t * frames, size_t count, uint32_t node)
+{
+    size_t n = 0;
+
+    uint32_t const nodeCount = Numa::NodeCount;
+    uint32_t const * const order = Numa::GetFallbackOrder(node < nodeCount ? node : 0);
+
+    for (uint32_t i = 0; i < nodeCount && n < count; ++i)
+        for (FrameAllocationSpace * space = this->LastSpace; space != nullptr && n < count; space = space->Previous)
+            if (nodeCount == 1 || space->Node == order[i])
+                n += space->AllocateFrames(size, frames + n, count - n);
+
+    return n;
+}
+
+void FrameAllocator::FreeFrames(FrameSize size, paddr_inner_t const * frames, size_t count)
+{
+    for (size_t i = 0, j; i < count; i = j)
+    {
+        FrameAllocationSpace * const space = this->GetSpace(paddr_t(frames[i]));
+
+        assert(space != nullptr)(frames[i]);
+
+        for (j = i + 1; j < count && space->ContainsRange(paddr_t(frames[j]), psize_t(1)); ++j) { }
+        //  Consecutive frames from the same space are freed under a single lock.
+
+        space->FreeFrames(size, frames + i, j - i);
+    }
+}
+
 /*  Space Chaining  */
 
 void FrameAllocator::PreppendAllocationSpace(FrameAllocationSpace * space)
@@ -77,7 +77,10 @@ static __forceinline bool Is2MiBAligned(TInt val) { return (val.Value & (LargePa
 bool VmmArc::Page1GB = false;
 bool VmmArc::NX = false;
 bool VmmArc::PCID = false;
+bool VmmArc::INVPCID = false;
 __thread paddr_t VmmArc::LastAlienPml4;
+__thread TlbContext VmmArc::Contexts[VmmArc::ContextCount];
+__thread size_t VmmArc::NextContext;
 
 
 // vaddr_t const VmmArc::LowerHalfEnd    { 0x0000800000000000ULL };
@@ -353,18 +356,135 @@ Handle Vmm::Initialize(Process * proc)
     }
 
     return proc->Vas.Initialize(UserlandStart, UserlandEnd
-        , &AcquirePoolInKernelHeap, &EnlargePoolInKernelHeap, &ReleasePoolFromKernelHeap);
+        , &AcquireAlignedPoolInKernelHeap, nullptr, &ReleaseAlignedPoolFromKernelHeap
+        , PoolReleaseOptions::NoRelease, SIZE_MAX, AlignedPoolSize);
+    //  Aligned pools make freeing a region's node a matter of masking its address.
+    //  The pools are kept until the VAS dies, because page faults walk the tree
+    //  without taking its lock.
+}
+
+/*  Address Space Identifiers  */
+
+static __forceinline size_t FindContext(Process const * const proc)
+{
+    for (size_t i = 0; i < VmmArc::ContextCount; ++i)
+        if (VmmArc::Contexts[i].Owner == proc->ContextId)
+            return i;
+
+    return VmmArc::ContextCount;
+}
+
+static __hot uint64_t AcquireContext(Process const * const proc, uint64_t const gen, bool & flush)
+{
+    size_t ctx = FindContext(proc);
+
+    if (ctx == VmmArc::ContextCount)
+    {
+        ctx = VmmArc::NextContext;
+        VmmArc::NextContext = (ctx + 1) % VmmArc::ContextCount;
+        //  Round-robin eviction.
+
+        VmmArc::Contexts[ctx].Owner = proc->ContextId;
+
+        flush = true;
+        //  The PCID may still tag translations of its previous owner.
+    }
+    else
+        flush = VmmArc::Contexts[ctx].Generation != gen;
+    //  Translations tagged while the process was last active here are only
+    //  valid if no shootdown was issued for it since.
+
+    VmmArc::Contexts[ctx].Generation = gen;
+
+    return ctx + 1;
+    //  PCID 0 is used by boot-time activations.
 }
 
 /*  Activation and Status  */
 
+static void FinishCollapse(Process * const proc, uint64_t state)
+{
+    //  Swaps the PML2 entry of a committing merge through the local fractal
+    //  mapping, before any userland code of the process runs on this core. The
+    //  idle core performs the same swap, so whoever is first wins.
+
+    vaddr_t const span { proc->CollapseSpan };
+    uint64_t expected = proc->CollapseOldEntry;
+
+    __atomic_compare_exchange_n(&(VmmArc::GetLocalPml2Entry(span).Value), &expected
+        , proc->CollapseNewEntry, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+
+    CpuInstructions::InvalidateTlb(span);
+
+    __atomic_compare_exchange_n(&(proc->CollapseState), &state
+        , state & ~Process::CollapsePhaseMask
+        , false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
 Handle Vmm::Switch(Process * const oldProc, Process * const newProc)
 {
-    (void)oldProc;
+    //  Boot-time activations have no old process, and happen before the cores
+    //  are registered.
+
+    if (oldProc != nullptr)
+        VmmArc::SetActiveCore(newProc, true);
+    //  Joining the mask before the tables are loaded means no shootdown can
+    //  skip this core while it may cache their translations.
 
-    Cr3 const newVal = Cr3(newProc->PagingTable, false, false);
+    uint64_t collapse = __atomic_load_n(&(newProc->CollapseState), __ATOMIC_SEQ_CST);
+
+    if unlikely((collapse & Process::CollapsePhaseMask) == Process::CollapseCopying)
+        __atomic_compare_exchange_n(&(newProc->CollapseState), &collapse
+            , collapse & ~Process::CollapsePhaseMask
+            , false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    //  An idle core is merging small pages, which it only does while the process
+    //  is active nowhere. If it is still copying, the merge is abandoned; if it
+    //  got to commit meanwhile, the new state is loaded into the variable and
+    //  this core helps below. The TLB generation is bumped before committing,
+    //  so it is read afterwards.
+
+    uint64_t const gen = newProc->TlbGeneration.Load();
+
+    Cr3 newVal = Cr3(newProc->PagingTable, false, false);
+
+    if (VmmArc::PCID && oldProc != nullptr)
+    {
+        bool flush;
+
+        newVal.SetPcid(AcquireContext(newProc, gen, flush));
+        newVal.SetNoFlush(!flush);
+
+        VmmArc::LastAlienPml4 = nullpaddr;
+        //  The alien fractal mapping may be tagged with a different process.
+    }
 
     Cpu::SetCr3(newVal);
+    //  Without the no-flush bit, this flushes all the non-global translations
+    //  of the PCID, which catches this core up with all the shootdowns that
+    //  skipped it.
+
+    if unlikely((collapse & Process::CollapsePhaseMask) == Process::CollapseCommitting)
+        FinishCollapse(newProc, collapse);
+
+    if (oldProc != nullptr)
+    {
+        VmmArc::SetActiveCore(oldProc, false);
+
+        Cpu::GetData()->TlbGeneration = gen;
+    }
+    else if (VmmArc::PCID)
+    {
+        Cr4 const cr4 = Cpu::GetCr4();
+
+        if (!cr4.GetPcide())
+        {
+            Cr4 tmp = cr4;
+
+            Cpu::SetCr4(tmp.SetPcide(true));
+        }
+        //  This is only allowed while CR3 holds PCID 0, which boot-time
+        //  activations guarantee.
+    }
 
     return HandleResult::Okay;
 }
@@ -395,7 +515,8 @@ static __hot __noinline Handle TranslateInternal(Process * proc
 {
     Pml4 * pml4p; Pml3 * pml3p; Pml2 * pml2p; Pml1 * pml1p;
 
-    SmpLock * alienLock = nullptr, * heapLock = nullptr;
+    SmpLock * alienLock = nullptr;
+    SmpQueuedLock * heapLock = nullptr;
 
     if (lockAlien && nonLocal && CpuDataSetUp)
         alienLock = &(Cpu::GetProcess()->AlienPagingTablesLock);
@@ -435,7 +556,7 @@ static __hot __noinline Handle TranslateInternal(Process * proc
     if (lockHeap)
         heapLock = vaddr < VmmArc::LowerHalfEnd ? &proc->LocalTablesLock : &Vmm::KernelHeapLock;
 
-    LockGuardFlexible<SmpLock > heapLg {heapLock};
+    LockGuardFlexible<SmpQueuedLock> heapLg {heapLock};
 
     if unlikely(!pml4p->operator[](VmmArc::GetPml4Index(vaddr)).GetPresent())
         return HandleResult::PageUnmapped;
@@ -493,7 +614,8 @@ static __hot Handle MapPageInternal(Process * const proc
 
     Pml4 * pml4p; Pml3 * pml3p; Pml2 * pml2p; Pml1 * pml1p;
 
-    SmpLock * alienLock = nullptr, * heapLock = nullptr;
+    SmpLock * alienLock = nullptr;
+    SmpQueuedLock * heapLock = nullptr;
 
     if (lockAlien && nonLocal && CpuDataSetUp)
         alienLock = &(Cpu::GetProcess()->AlienPagingTablesLock);
@@ -535,7 +657,7 @@ static __hot Handle MapPageInternal(Process * const proc
             ? &(proc->LocalTablesLock)
             : &(Vmm::KernelHeapLock));
 
-    LockGuardFlexible<SmpLock > heapLg {heapLock};
+    LockGuardFlexible<SmpQueuedLock> heapLg {heapLock};
 
     ind = VmmArc::GetPml4Index(vaddr);
 
@@ -625,6 +747,10 @@ do_pml2e:
         }
     }
     
+    if unlikely(pml2p->operator[](ind).GetPageSize())
+        return HandleResult::PageMapped;
+    //  A 2-MiB page covers this address, and its entry references no table.
+
     ind = VmmArc::GetPml1Index(vaddr);
 
     if unlikely(pml1p->operator[](ind).GetPresent())
@@ -732,7 +858,8 @@ Handle Vmm::MapRange(Process * proc
 
     bool const nonLocal = (vaddr < VmmArc::LowerHalfEnd) && !Vmm::IsActive(proc);
 
-    SmpLock * alienLock = nullptr, * heapLock = nullptr;
+    SmpLock * alienLock = nullptr;
+    SmpQueuedLock * heapLock = nullptr;
 
     if (nonLocal && CpuDataSetUp)
         alienLock = &(Cpu::GetProcess()->AlienPagingTablesLock);
@@ -747,7 +874,7 @@ Handle Vmm::MapRange(Process * proc
         //  THE SCOPE IS OPTIONALLY LOCK-GUARDED AS WELL!
 
         LockGuardFlexible<SmpLock > pml4Lg {alienLock};
-        LockGuardFlexible<SmpLock > heapLg {heapLock};
+        LockGuardFlexible<SmpQueuedLock> heapLg {heapLock};
 
         if ((vaddr.Value & (LargePageSize.Value - 1)) == (paddr.Value & (LargePageSize.Value - 1)))
         {
@@ -797,6 +924,217 @@ Handle Vmm::MapRange(Process * proc
     return HandleResult::Okay;
 }
 
+/**********************
+    Scratch Windows    >--------------------------------------------------------
+**********************/
+
+static constexpr size_t const ScratchWindowCount = 2;
+
+static __thread vaddr_t ScratchWindows;
+//  Kernel heap pages through which this core sees frames that aren't mapped
+//  anywhere it can reach. No other core ever touches them, so retargeting them
+//  only needs a local flush.
+
+static Handle AcquireScratchWindows(paddr_t const paddr)
+{
+    //  Must be called with no paging locks held, before the windows are first
+    //  needed.
+
+    if likely(ScratchWindows != nullvaddr)
+        return HandleResult::Okay;
+
+    vaddr_t windows = nullvaddr;
+
+    Handle res = Vmm::AllocatePages(nullptr, vsize_t(ScratchWindowCount * PageSize.Value)
+        , MemoryAllocationOptions::VirtualKernelHeap
+        , MemoryFlags::Global | MemoryFlags::Writable
+        , MemoryContent::Generic
+        , windows);
+
+    if unlikely(res != HandleResult::Okay)
+        return res;
+
+    for (size_t i = 0; i < ScratchWindowCount; ++i)
+    {
+        res = Vmm::MapPage(nullptr, windows + vsize_t(i * PageSize.Value), paddr
+            , MemoryFlags::Global | MemoryFlags::Writable
+            , MemoryMapOptions::NoReferenceCounting);
+
+        if unlikely(res != HandleResult::Okay)
+            return res;
+    }
+
+    ScratchWindows = windows;
+
+    return HandleResult::Okay;
+}
+
+static __forceinline void * RetargetScratchWindow(size_t const index, paddr_t const paddr)
+{
+    //  Interrupts must be disabled for as long as the window is used.
+
+    vaddr_t const window = ScratchWindows + vsize_t(index * PageSize.Value);
+
+    VmmArc::GetLocalPml1Entry(window).SetAddress(paddr);
+    CpuInstructions::InvalidateTlb(window);
+
+    return reinterpret_cast<void *>(window.Value);
+}
+
+/********************
+    Frame Zeroing    >----------------------------------------------------------
+********************/
+
+Handle Vmm::ZeroFrame(paddr_t const paddr)
+{
+    if unlikely(!Is4KiBAligned(paddr))
+        return HandleResult::AlignmentFailure;
+
+    Handle res = AcquireScratchWindows(paddr);
+
+    if unlikely(res != HandleResult::Okay)
+        return res;
+
+    withInterrupts (false)
+    {
+        memclrnt(RetargetScratchWindow(0, paddr), PageSize.Value);
+        //  The frame will likely be touched much later, so the zeroes should
+        //  not evict anything useful from the caches.
+    }
+
+    return HandleResult::Okay;
+}
+
+/*****************************
+    TLB Shootdown Queues    >---------------------------------------------------
+*****************************/
+
+static TlbShootdownQueue KernelTlbQueue;
+
+static __forceinline bool IsUserland(vaddr_t const vaddr)
+{
+    return vaddr >= Vmm::UserlandStart && vaddr < Vmm::UserlandEnd;
+}
+
+static __hot bool InvalidateForeign(Process const * const proc, vaddr_t const vaddr
+    , vaddr_t const * addresses, size_t const count, size_t const stride)
+{
+    //  Invalidates the userland translations of a process tagged with a PCID
+    //  other than the current one, which invlpg does not affect. Returns false
+    //  if the process is active on this core, so the current ones still need
+    //  invalidating.
+
+    if (!IsUserland(vaddr))
+        return false;
+
+    Cr3 const cr3 = Cpu::GetCr3();
+    size_t const ctx = FindContext(proc);
+
+    if (ctx != VmmArc::ContextCount && ctx + 1 != cr3.GetPcid())
+    {
+        if (!VmmArc::INVPCID)
+            VmmArc::Contexts[ctx].Owner = 0;
+        //  Freeing the PCID guarantees a flush when the process is switched to.
+        else if (addresses == nullptr || count > VmmArc::FullFlushThreshold)
+            CpuInstructions::InvalidatePcid(CpuInstructions::InvalidatePcidContext, ctx + 1);
+        else for (size_t i = 0; i < count; ++i, PTR_INC(addresses, stride))
+            CpuInstructions::InvalidatePcid(CpuInstructions::InvalidatePcidAddress, ctx + 1, *addresses);
+    }
+
+    return cr3.GetAddress() != proc->PagingTable;
+}
+
+static __forceinline TlbShootdownQueue & GetQueue(Process * const proc, bool const kernel)
+{
+    return kernel ? KernelTlbQueue : proc->TlbQueue;
+}
+
+static __forceinline TlbShootdownQueue & GetQueue(Process * const proc, vaddr_t const vaddr)
+{
+    return GetQueue(proc, !IsUserland(vaddr));
+}
+
+struct ThreadTlbBatches
+{
+    TlbBatch Slots[2];
+    //  Indexed by whether the batches cover the kernel's address space.
+};
+
+DEFINE_THREAD_DATA(ThreadTlbBatches, TlbBatches)
+static ThreadTlbBatches BootstrapTlbBatches;
+//  Used while the core has no thread yet, which is before other cores start.
+
+static __forceinline TlbBatch & GetBatch(bool const kernel)
+{
+    //  Batches belong to the thread which opens them, so other threads which
+    //  unmap pages from the same address space are not held back by them.
+
+    Thread * const thread = likely(CpuDataSetUp) ? Cpu::GetThread() : nullptr;
+
+    return (likely(thread != nullptr) ? TlbBatches(thread) : BootstrapTlbBatches).Slots[kernel];
+}
+
+static __forceinline bool IsBatched(TlbShootdownQueue const & queue, bool const kernel)
+{
+    TlbBatch const & batch = GetBatch(kernel);
+
+    return batch.Depth != 0 && batch.Queue == &queue;
+}
+
+static __hot Handle FlushQueue(Process * const proc, TlbShootdownQueue & queue)
+{
+    TlbPendingEntry entries[TlbShootdownQueue::Capacity];
+    size_t count;
+
+    {   //  Scope to contain the guard.
+        InterruptGuard<> intGuard;
+
+        withLock (queue.Lock)
+        {
+            count = queue.Count;
+            queue.Count = 0;
+
+            memcpy(entries, queue.Entries, count * sizeof(TlbPendingEntry));
+        }
+    }
+
+    if (count == 0)
+        return HandleResult::Okay;
+
+    Handle res = Vmm::InvalidateRange(proc, &(entries[0].Address), count, sizeof(TlbPendingEntry));
+
+    for (size_t i = 0; i < count; ++i)
+        if (entries[i].Frame != nullpaddr)
+            Pmm::AdjustReferenceCount(entries[i].Frame, -1);
+
+    return res;
+}
+
+static __hot Handle DeferInvalidation(Process * const proc, TlbShootdownQueue & queue
+    , vaddr_t const vaddr, paddr_t const frame)
+{
+    while (true)
+    {
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            withLock (queue.Lock)
+                if likely(queue.Count < TlbShootdownQueue::Capacity)
+                {
+                    queue.Entries[queue.Count++] = TlbPendingEntry { vaddr, frame };
+
+                    return HandleResult::Okay;
+                }
+        }
+
+        Handle res = FlushQueue(proc, queue);
+
+        if unlikely(res != HandleResult::Okay)
+            return res;
+        //  A full queue is shot down and the entry is queued again.
+    }
+}
+
 Handle Vmm::UnmapPage(Process * proc, vaddr_t const vaddr
     , paddr_t & paddr, FrameSize & size, MemoryMapOptions opts)
 {
@@ -818,14 +1156,501 @@ Handle Vmm::UnmapPage(Process * proc, vaddr_t const vaddr
 
     //  The rest is done outside of the lambda because locks are unnecessary.
 
+    bool const countReferences = 0 == (opts & MemoryMapOptions::NoReferenceCounting);
+    bool const kernel = !IsUserland(vaddr);
+    TlbShootdownQueue & queue = GetQueue(proc, kernel);
+
+    if (IsBatched(queue, kernel))
+        return DeferInvalidation(proc, queue, vaddr, countReferences ? paddr : nullpaddr);
+
     Vmm::InvalidatePage(proc, vaddr, true);
 
-    if (0 == (opts & MemoryMapOptions::NoReferenceCounting))
+    if (countReferences)
         Pmm::AdjustReferenceCount(paddr, -1);
 
     return HandleResult::Okay;
 }
 
+/******************
+    Large Pages    >------------------------------------------------------------
+******************/
+
+static Handle SplitLargePage(Process * const proc, vaddr_t const vaddr, bool const lock)
+{
+    //  Replaces the 2-MiB page which covers the given address, if any, with a
+    //  table of 4-KiB pages spanning the same frame. Every one of them holds a
+    //  reference to the large frame, which is thus freed along with the last.
+
+    vaddr_t const span = RoundDown(vaddr, LargePageSize);
+    PmlCommonEntry large;
+
+    Handle res = TryTranslate(proc, span, [&large](PmlCommonEntry * pE, int level)
+    {
+        if (level == 2)
+            large = *pE;
+
+        return HandleResult::Okay;
+    }, lock);
+
+    if (res != HandleResult::Okay || !large.GetPresent())
+        return res == HandleResult::PageUnmapped ? HandleResult::Okay : res;
+    //  Nothing to split.
+
+    paddr_t const table = Pmm::AllocateFrame(1);
+
+    if unlikely(table == nullpaddr)
+        return HandleResult::OutOfMemory;
+
+    res = AcquireScratchWindows(table);
+
+    if unlikely(res != HandleResult::Okay)
+    {
+        Pmm::FreeFrame(table);
+
+        return res;
+    }
+
+    paddr_t const frame = reinterpret_cast<Pml2Entry *>(&large)->GetPageAddress();
+
+    withInterrupts (false)
+    {
+        Pml1 & pml1 = *reinterpret_cast<Pml1 *>(RetargetScratchWindow(0, table));
+
+        for (size_t i = 0; i < 512; ++i)
+            pml1[i] = Pml1Entry(frame + psize_t(i * PageSize.Value), true
+                , large.GetWritable(), large.GetUserland(), large.GetGlobal(), large.GetXd());
+    }
+    //  The table is filled before it is linked, so the page walker never sees
+    //  it incomplete.
+
+    bool split = false;
+
+    res = TryTranslate(proc, span, [&large, &split, table, frame](PmlCommonEntry * pE, int level)
+    {
+        if (level != 2 || pE->Value != large.Value)
+            return HandleResult::Okay;
+        //  Someone else got to it first.
+
+        Pmm::AdjustReferenceCount(frame, 511);
+
+        *pE = Pml2Entry(table, true, true, true, false);
+        //  Present, writable, user-accessible, executable.
+
+        split = true;
+
+        return HandleResult::Okay;
+    }, lock);
+
+    if (!split)
+    {
+        Pmm::FreeFrame(table);
+
+        return res == HandleResult::PageUnmapped ? HandleResult::Okay : res;
+    }
+
+    return Vmm::InvalidatePage(proc, span, true);
+    //  The old translation is equivalent, but the page walker may not cache
+    //  both sizes at once.
+}
+
+bool Vmm::CanMapLargePage(Process * proc, vaddr_t const vaddr)
+{
+    //  Tells whether nothing at all is mapped in the 2-MiB span of the given
+    //  address. This is only a hint, taken without locks.
+
+    if (proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    withInterrupts (false)
+    {
+        if ((vaddr < VmmArc::LowerHalfEnd) && !Vmm::IsActive(proc))
+            return false;
+        //  Alien tables aren't worth the trouble.
+
+        if (!VmmArc::GetLocalPml4()->operator[](VmmArc::GetPml4Index(vaddr)).GetPresent())
+            return true;
+
+        if (!VmmArc::GetLocalPml3(vaddr)->operator[](VmmArc::GetPml3Index(vaddr)).GetPresent())
+            return true;
+
+        return !VmmArc::GetLocalPml2(vaddr)->operator[](VmmArc::GetPml2Index(vaddr)).GetPresent();
+    }
+
+    __unreachable_code;
+}
+
+static __thread uint64_t CollapseEntries[512];
+//  Snapshot of the small pages being merged, so they can be copied without
+//  holding the paging lock.
+
+static __forceinline bool IsExclusiveFrame(paddr_t const paddr)
+{
+    FrameSize size;
+    uint32_t refCnt;
+
+    return Pmm::GetFrameInfo(paddr, size, refCnt) == HandleResult::Okay
+        && size == FrameSize::_4KiB && refCnt == 1;
+}
+
+Handle Vmm::CollapseLargePage(Process * proc, vaddr_t const vaddr)
+{
+    //  Merges the 512 small pages of a userland span into a large page, if they
+    //  are all present, alike and referenced by this mapping alone. Their
+    //  contents are copied, so this is meant for idle cores.
+
+    vaddr_t span = RoundDown(vaddr, LargePageSize);
+
+    if unlikely(proc == nullptr || span >= VmmArc::LowerHalfEnd)
+        return HandleResult::ArgumentOutOfRange;
+
+    if unlikely(Cores::GetCount() > Process::ActiveCoresWords * 64)
+        return HandleResult::UnsupportedOperation;
+    //  Keeping the process off every core requires every core to be tracked.
+
+    uint64_t state = __atomic_load_n(&(proc->CollapseState), __ATOMIC_SEQ_CST);
+
+    if ((state & Process::CollapsePhaseMask) != Process::CollapseIdle)
+        return HandleResult::PageInUse;
+
+    uint64_t const copying = (state + Process::CollapseSequence) | Process::CollapseCopying;
+    uint64_t const committing = (state + Process::CollapseSequence) | Process::CollapseCommitting;
+
+    if (!__atomic_compare_exchange_n(&(proc->CollapseState), &state, copying
+        , false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        return HandleResult::PageInUse;
+    //  Another idle core is merging pages of this process.
+
+    Handle res = HandleResult::Okay;
+    paddr_t large = nullpaddr, table = nullpaddr;
+
+    for (size_t i = 0; i < Process::ActiveCoresWords; ++i)
+        if (__atomic_load_n(proc->ActiveCores + i, __ATOMIC_SEQ_CST) != 0)
+        {
+            res = HandleResult::PageInUse;
+
+            goto end;
+        }
+    //  Cores join the mask before checking the state, so either this sees them
+    //  or they abandon the merge.
+
+    large = Pmm::AllocateFrame(FrameSize::_2MiB, AddressMagnitude::Any, 1);
+
+    if unlikely(large == nullpaddr)
+    {
+        res = HandleResult::OutOfMemory;
+
+        goto end;
+    }
+
+    res = AcquireScratchWindows(large);
+
+    if unlikely(res != HandleResult::Okay)
+        goto end;
+
+    res = TryTranslate(proc, span, [](PmlCommonEntry * pE, int level)
+    {
+        if (level != 1)
+            return HandleResult::PageMapped;
+
+        Pml1Entry const * const entries = reinterpret_cast<Pml1Entry const *>(pE);
+        //  This is the first entry of the table.
+
+        uint64_t const ignored = PmlCommonEntry::AddressBits
+                               | PmlCommonEntry::AccessedBit | PmlCommonEntry::DirtyBit;
+
+        for (size_t i = 0; i < 512; ++i)
+        {
+            if (!entries[i].GetPresent() || 0 != ((entries[i].Value ^ entries[0].Value) & ~ignored)
+                || !IsExclusiveFrame(entries[i].GetAddress()))
+                return HandleResult::PageUnmapped;
+            //  Frames referenced elsewhere are shared, and must stay put.
+
+            CollapseEntries[i] = entries[i].Value;
+        }
+
+        return HandleResult::Okay;
+    }, true);
+
+    if unlikely(res != HandleResult::Okay)
+        goto end;
+
+    for (size_t i = 0; i < 512; ++i)
+        withInterrupts (false)
+            ::memcpy(RetargetScratchWindow(0, large + psize_t(i * PageSize.Value))
+                , RetargetScratchWindow(1, paddr_t(CollapseEntries[i] & PmlCommonEntry::AddressBits)), (size_t)PageSize.Value);
+    //  Copied without holding any lock, one page at a time, so the core stays
+    //  responsive. The entries are checked again before committing.
+
+    res = TryTranslate(proc, span, [proc, span, large, copying, committing, &table](PmlCommonEntry * pE, int level)
+    {
+        if (level != 1)
+            return HandleResult::PageMapped;
+
+        Pml1Entry const * const entries = reinterpret_cast<Pml1Entry const *>(pE);
+
+        for (size_t i = 0; i < 512; ++i)
+            if (entries[i].Value != CollapseEntries[i] || !IsExclusiveFrame(entries[i].GetAddress()))
+                return HandleResult::PageUnmapped;
+        //  The span was remapped or shared while copying.
+
+        Pml2Entry & pml2e = VmmArc::GetAlienPml2(span)->operator[](VmmArc::GetPml2Index(span));
+
+        uint64_t expected = pml2e.Value;
+        paddr_t const oldTable = pml2e.GetAddress();
+
+        proc->CollapseSpan = span.Value;
+        proc->CollapseOldEntry = expected;
+        proc->CollapseNewEntry = Pml2Entry(large, true, entries[0].GetWritable(), entries[0].GetUserland()
+            , entries[0].GetGlobal(), entries[0].GetXd()).Value;
+
+        ++proc->TlbGeneration;
+        //  Every core which switches to the process from now on will flush its
+        //  stale entries.
+
+        if (uint64_t state = copying; !__atomic_compare_exchange_n(&(proc->CollapseState), &state
+            , committing, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return HandleResult::PageInUse;
+        //  A core switched to the process during the copy, so it may have
+        //  written to the small pages.
+
+        __atomic_compare_exchange_n(&(pml2e.Value), &expected, proc->CollapseNewEntry
+            , false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        //  A core switching to the process may have swapped it already.
+
+        table = oldTable;
+
+        return HandleResult::Okay;
+    }, true);
+
+    if unlikely(res != HandleResult::Okay)
+        goto end;
+
+    Vmm::InvalidateRange(proc, &span, VmmArc::FullFlushThreshold + 1, 0, false);
+    //  Counting the same address past the threshold flushes all the process'
+    //  translations this core may hold under another PCID.
+
+    withInterrupts (false)
+    {
+        Pml1Entry const * const entries = reinterpret_cast<Pml1Entry const *>(RetargetScratchWindow(0, table));
+
+        for (size_t i = 0; i < 512; ++i)
+            Pmm::AdjustReferenceCount(entries[i].GetAddress(), -1);
+    }
+
+    Pmm::FreeFrame(table);
+
+    large = nullpaddr;
+    //  It's in use now.
+
+end:
+    if (uint64_t current = copying; !__atomic_compare_exchange_n(&(proc->CollapseState), &current
+        , copying & ~Process::CollapsePhaseMask, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+        current = committing;
+
+        __atomic_compare_exchange_n(&(proc->CollapseState), &current
+            , committing & ~Process::CollapsePhaseMask, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+    //  Either phase goes back to idle, unless a switching core did it already.
+
+
+    if (large != nullpaddr)
+        Pmm::FreeFrame(large);
+
+    return res;
+}
+
+/********************
+    Copy-on-Write    >----------------------------------------------------------
+********************/
+
+Handle Vmm::ShareRange(Process * const src, vaddr_t const srcAddr, vsize_t const size
+    , Process * const dst, vaddr_t const dstAddr
+    , MemoryFlags const flags, bool const copyOnWrite)
+{
+    //  Maps the frames behind a userland range of one process into another, and
+    //  each mapping holds a reference. Pages missing from the source are skipped.
+    //  With copy-on-write, both sides are mapped read-only, so the first write on
+    //  either side makes its own copy.
+
+    if unlikely(src == nullptr || dst == nullptr)
+        return HandleResult::ArgumentNull;
+
+    if unlikely(!Is4KiBAligned(srcAddr) || !Is4KiBAligned(dstAddr) || !Is4KiBAligned(size))
+        return HandleResult::AlignmentFailure;
+
+    if unlikely(size == 0 || srcAddr + size > VmmArc::LowerHalfEnd || dstAddr + size > VmmArc::LowerHalfEnd
+        || srcAddr + size < srcAddr || dstAddr + size < dstAddr)
+        return HandleResult::ArgumentOutOfRange;
+
+    Handle res;
+
+    for (vaddr_t span = RoundDown(srcAddr, LargePageSize); span < srcAddr + size; span += LargePageSize)
+    {
+        res = SplitLargePage(src, span, true);
+
+        if unlikely(res != HandleResult::Okay)
+            return res;
+    }
+    //  Copy-on-write works on small pages.
+
+    MemoryFlags const dstFlags = copyOnWrite ? (flags & ~MemoryFlags::Writable) : flags;
+
+    vaddr_t changed[VmmArc::FullFlushThreshold];
+    size_t changeCount = 0;
+
+    for (vsize_t offset { 0 }; offset < size; offset += PageSize)
+    {
+        vaddr_t const vaddr = srcAddr + offset;
+        paddr_t paddr = nullpaddr;
+
+        res = TryTranslate(src, vaddr, [vaddr, copyOnWrite, &paddr, &changed, &changeCount](PmlCommonEntry * pE, int level) -> Handle
+        {
+            if (level == 2)
+                paddr = reinterpret_cast<Pml2Entry *>(pE)->GetPageAddress()
+                      + psize_t(RoundDown(vaddr.Value & (LargePageSize.Value - 1), PageSize.Value));
+                //  A fault made it large again since the split.
+            else
+                paddr = pE->GetAddress();
+
+            Handle refRes = Pmm::AdjustReferenceCount(paddr, 1);
+            //  Taken under the lock, so the frame can neither be freed nor seen
+            //  as exclusive by a copy-on-write fault before it is mapped.
+
+            if unlikely(refRes != HandleResult::Okay && !refRes.IsResult(HandleResult::PagesOutOfAllocatorRange))
+                return refRes;
+
+            if (copyOnWrite && pE->GetWritable())
+            {
+                pE->SetWritable(false);
+
+                if (changeCount < VmmArc::FullFlushThreshold)
+                    changed[changeCount] = vaddr;
+
+                ++changeCount;
+            }
+
+            return HandleResult::Okay;
+        }, true);
+
+        if (res == HandleResult::PageUnmapped)
+            continue;
+        else if unlikely(res != HandleResult::Okay)
+            break;
+
+        res = Vmm::MapPage(dst, dstAddr + offset, paddr, dstFlags, MemoryMapOptions::NoReferenceCounting);
+
+        if unlikely(res != HandleResult::Okay)
+        {
+            Pmm::AdjustReferenceCount(paddr, -1);
+
+            break;
+        }
+    }
+
+    if (changeCount > 0)
+        Vmm::InvalidateRange(src, changed, changeCount, sizeof(vaddr_t));
+    //  Past the threshold, only the first address matters.
+
+    return res == HandleResult::PageUnmapped ? HandleResult::Okay : res;
+}
+
+Handle Vmm::BreakCopyOnWrite(Process * proc, vaddr_t const vaddr)
+{
+    //  Gives the process its own writable copy of a read-only page whose frame
+    //  may be shared. If nobody else holds the frame anymore, it is simply made
+    //  writable. Must be called without any paging locks held.
+
+    if (proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    vaddr_t const page = RoundDown(vaddr, PageSize);
+
+    Handle res = SplitLargePage(proc, page, true);
+
+    if unlikely(res != HandleResult::Okay)
+        return res;
+
+    paddr_t old = nullpaddr;
+    bool done = false;
+
+    res = TryTranslate(proc, page, [&old, &done](PmlCommonEntry * pE, int level)
+    {
+        if (level != 1 || pE->GetWritable())
+        {
+            done = true;
+
+            return HandleResult::Okay;
+        }
+        //  Someone else got to it first; the access will be retried.
+
+        old = pE->GetAddress();
+
+        FrameSize size;
+        uint32_t refCnt;
+
+        if (Pmm::GetFrameInfo(old, size, refCnt) == HandleResult::Okay
+            && size == FrameSize::_4KiB && refCnt == 1)
+        {
+            pE->SetWritable(true);
+            done = true;
+        }
+        //  The last holder of a frame owns it. Stale read-only entries on other
+        //  cores will only cause spurious faults.
+
+        return HandleResult::Okay;
+    }, true);
+
+    if (res != HandleResult::Okay || done)
+        return res;
+
+    paddr_t const copy = Pmm::AllocateFrame(FrameSize::_4KiB, AddressMagnitude::Any, 1);
+
+    if unlikely(copy == nullpaddr)
+        return HandleResult::OutOfMemory;
+
+    res = AcquireScratchWindows(copy);
+
+    if unlikely(res != HandleResult::Okay)
+    {
+        Pmm::FreeFrame(copy);
+
+        return res;
+    }
+
+    withInterrupts (false)
+        ::memcpy(RetargetScratchWindow(0, copy), RetargetScratchWindow(1, old), (size_t)PageSize.Value);
+
+    bool swapped = false;
+
+    res = TryTranslate(proc, page, [old, copy, &swapped](PmlCommonEntry * pE, int level)
+    {
+        if (level == 1 && !pE->GetWritable() && pE->GetAddress() == old)
+        {
+            PmlCommonEntry e = *pE;
+
+            e.SetAddress(copy).SetWritable(true);
+
+            *pE = e;
+            swapped = true;
+        }
+
+        return HandleResult::Okay;
+    }, true);
+
+    if (!swapped)
+    {
+        Pmm::FreeFrame(copy);
+
+        return res == HandleResult::PageUnmapped ? HandleResult::Okay : res;
+    }
+
+    Vmm::InvalidatePage(proc, page, true);
+    //  Other threads may still be reading the shared frame.
+
+    Pmm::AdjustReferenceCount(old, -1);
+
+    return HandleResult::Okay;
+}
+
 /**************************
     Iterative Unmapping    >----------------------------------------------------
 **************************/
@@ -836,7 +1661,7 @@ struct IterativeUnmapState
     vaddr_t Address;
     vaddr_t const EndAddress;
     SmpLock * const AlienLock;
-    SmpLock * const HeapLock;
+    SmpQueuedLock * const HeapLock;
     Beelzebub::InterruptState InterruptState;
     bool const NonLocal, Invalidate, Broadcast, CountReferences;
     Vmm::PreUnmapFunc PreUnmap;
@@ -918,6 +1743,29 @@ static __hot Handle UnmapIteratively(IterativeUnmapState * const state)
 
     state->InterruptState.Restore();
 
+    if (i > 0 && state->Invalidate)
+    {
+        bool const kernel = !IsUserland(iterationStart);
+        TlbShootdownQueue & queue = GetQueue(state->Process, kernel);
+
+        if (state->Broadcast && i <= (int)TlbShootdownQueue::Capacity && IsBatched(queue, kernel))
+        {
+            do
+            {
+                --i;
+
+                Handle res2 = DeferInvalidation(state->Process, queue, UnmapList[i].VirtualAddress
+                    , state->CountReferences ? UnmapList[i].PhysicalAddress : nullpaddr);
+
+                if unlikely(res == HandleResult::Okay)
+                    res = res2;
+            } while (i > 0);
+        }
+        //  The frames are released by the shootdown. Rounds larger than a queue
+        //  are invalidated right away, as deferring them would only split them
+        //  into several shootdowns.
+    }
+
     if (i > 0)
     {
         if likely(state->Invalidate)
@@ -960,7 +1808,7 @@ struct RecursiveUnmapState
     vaddr_t Address;
     vaddr_t const EndAddress;
     SmpLock * const AlienLock;
-    SmpLock * const HeapLock;
+    SmpQueuedLock * const HeapLock;
     Beelzebub::InterruptState InterruptState;
     bool const NonLocal, Invalidate, Broadcast, CountReferences;
     Vmm::PreUnmapFunc PreUnmap;
@@ -1113,7 +1961,8 @@ Handle Vmm::UnmapRange(Process * proc
     bool const invalidate = 0 == (opts & MemoryMapOptions::NoInvalidation);
     bool const broadcast = 0 == (opts & MemoryMapOptions::NoBroadcasting);
 
-    SmpLock * alienLock = nullptr, * heapLock = nullptr;
+    SmpLock * alienLock = nullptr;
+    SmpQueuedLock * heapLock = nullptr;
 
     if (nonLocal && CpuDataSetUp)
         alienLock = &(Cpu::GetProcess()->AlienPagingTablesLock);
@@ -1127,10 +1976,33 @@ Handle Vmm::UnmapRange(Process * proc
     //     MSG_("Unmapping range %Xp-%Xp.%n"
     //         , vaddr, vaddr + size);
 
-    Handle res;
+    Handle res = HandleResult::Okay;
+
+    if likely(heapLock != nullptr)
+    {
+        //  2-MiB pages which straddle either end of the range are split first,
+        //  so only the part within it is unmapped. Callers which hold the lock
+        //  already only ever unmap whole large pages.
+
+        if (!Is2MiBAligned(vaddr))
+            res = SplitLargePage(proc, vaddr, true);
+
+        if (res == HandleResult::Okay && !Is2MiBAligned(endAddr)
+            && RoundDown(endAddr, LargePageSize) != RoundDown(vaddr, LargePageSize))
+            res = SplitLargePage(proc, endAddr, true);
+
+        if unlikely(res != HandleResult::Okay)
+            return res;
+    }
 
     if likely(CpuDataSetUp)
     {
+        bool const batched = invalidate && broadcast;
+
+        if (batched)
+            Vmm::BeginInvalidationBatch(proc, !IsUserland(vaddr));
+        //  Consecutive rounds of unmapping are shot down together.
+
         IterativeUnmapState state {
             proc, vaddr, endAddr, alienLock, heapLock, {}
             , nonLocal, invalidate, broadcast
@@ -1150,10 +2022,15 @@ Handle Vmm::UnmapRange(Process * proc
                 heapLock->Acquire();
 
             res = UnmapIteratively(&state);
+        } while (res == HandleResult::Okay && state.Address < state.EndAddress);
 
-            if (res != HandleResult::Okay)
-                return res;
-        } while (state.Address < state.EndAddress);
+        if (batched)
+        {
+            Handle res2 = Vmm::EndInvalidationBatch(proc, !IsUserland(vaddr));
+
+            if unlikely(res == HandleResult::Okay)
+                res = res2;
+        }
     }
     else
     {
@@ -1195,6 +2072,81 @@ Handle Vmm::UnmapRange(Process * proc
     Page Invaidation    >-------------------------------------------------------
 ***********************/
 
+static __hot void FlushEntireTlb(bool const global)
+{
+    if (global)
+    {
+        Cr4 const cr4 = Cpu::GetCr4();
+
+        if (cr4.GetPge())
+        {
+            Cr4 tmp = cr4;
+
+            Cpu::SetCr4(tmp.SetPge(false));
+            Cpu::SetCr4(cr4);
+
+            return;
+        }
+        //  Toggling global pages flushes every translation.
+    }
+
+    Cpu::SetCr3(Cpu::GetCr3());
+    //  Reloading the tables flushes all the non-global translations.
+}
+
+static __hot void Shootdown(Process * const proc, bool const userland
+    , MailFunction const remote, TimeWaster const local, void * const cookie)
+{
+    //  Performs the invalidation locally and on every other core which may
+    //  cache the translations involved.
+
+    if unlikely(!Mailbox::IsReady())
+        return local(cookie);
+
+    if (userland && likely(Cores::GetCount() <= Process::ActiveCoresWords * 64))
+    {
+        ++proc->TlbGeneration;
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        //  Any core which joins the mask after it is read here loads tables
+        //  which are already changed.
+
+        InterruptGuard<> intGuard;
+        //  Keeps this core's index relevant.
+
+        size_t const self = Cpu::GetData()->Index;
+        uint64_t mask[Process::ActiveCoresWords];
+        unsigned int targetCount = 0;
+
+        for (size_t i = 0; i < Process::ActiveCoresWords; ++i)
+        {
+            mask[i] = __atomic_load_n(proc->ActiveCores + i, __ATOMIC_ACQUIRE);
+
+            if (i == self / 64)
+                mask[i] &= ~(1ULL << (self % 64));
+
+            targetCount += __builtin_popcountll(mask[i]);
+        }
+
+        if (targetCount == 0)
+            return local(cookie);
+
+        ALLOCATE_MAIL(mail, targetCount, remote, cookie);
+
+        for (size_t i = 0, link = 0; i < Process::ActiveCoresWords; ++i)
+            for (uint64_t bits = mask[i]; bits != 0; bits &= bits - 1)
+                mail.Links[link++] = MailboxEntryLink((uint32_t)(i * 64 + __builtin_ctzll(bits)));
+
+        mail.SetAwait(true).Post(local, cookie);
+    }
+    else
+    {
+        ALLOCATE_MAIL_BROADCAST(mail, remote, cookie);
+        mail.SetAwait(true).Post(local, cookie);
+    }
+    //  Kernel translations may be cached by any core.
+}
+
 template<bool caller>
 static __hot __solid void RangeInvalidator(void * cookie)
 {
@@ -1202,7 +2154,12 @@ static __hot __solid void RangeInvalidator(void * cookie)
 
     vaddr_t const * addr = inf->Addresses;
 
-    for (size_t i = 0; i < inf->Count; ++i, PTR_INC(addr, inf->Stride))
+    if (InvalidateForeign(inf->Proc, *addr, addr, inf->Count, inf->Stride))
+        goto end;
+
+    if (inf->Count > VmmArc::FullFlushThreshold)
+        FlushEntireTlb(!IsUserland(*addr));
+    else for (size_t i = 0; i < inf->Count; ++i, PTR_INC(addr, inf->Stride))
     {
         // if (::PrintMemoryOps)
         //     MSG_("Invalidating address %Xp on core %us (%s).%n"
@@ -1213,6 +2170,8 @@ static __hot __solid void RangeInvalidator(void * cookie)
         CpuInstructions::InvalidateTlb(*addr);
     }
 
+end:
+
     if (inf->After != nullptr)
         inf->After(inf, caller);
 
@@ -1225,18 +2184,10 @@ Handle Vmm::InvalidateRange(Process * proc
 {
     if unlikely(proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
 
-    if (broadcast && ((*addresses >= UserlandStart && *addresses < UserlandEnd && proc->ActiveCoreCount == 1 && !VmmArc::PCID) || unlikely(!Mailbox::IsReady())))
-        broadcast = false;
-
     RangeInvalidationInfo info { proc, addresses, count, stride, after, cookie };
 
     if (broadcast)
-    {
-        ALLOCATE_MAIL_BROADCAST(mail, &RangeInvalidator<false>, &info);
-        mail.SetAwait(true).Post(&RangeInvalidator<true>, &info);
-
-        //  Quite simple.
-    }
+        Shootdown(proc, IsUserland(*addresses), &RangeInvalidator<false>, &RangeInvalidator<true>, &info);
     else
         RangeInvalidator<true>(&info);
 
@@ -1249,9 +2200,17 @@ static __hot void ChainInvalidator(void * cookie)
     Vmm::ChainInvalidationInfo const * const inf = (Vmm::ChainInvalidationInfo const *)cookie;
 
     Vmm::PageNode const * tmp = inf->Node;
+    size_t count = 0;
 
-    do
+    if (!InvalidateForeign(inf->Proc, tmp->Address, nullptr, 0, 0)) do
     {
+        if unlikely(++count > VmmArc::FullFlushThreshold)
+        {
+            FlushEntireTlb(!IsUserland(inf->Node->Address));
+
+            break;
+        }
+
         CpuInstructions::InvalidateTlb(tmp->Address);
     } while ((tmp = tmp->Next) != nullptr);
 
@@ -1266,31 +2225,90 @@ Handle Vmm::InvalidateChain(Process * proc, PageNode const * node, bool broadcas
 {
     if unlikely(proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
 
-    if (broadcast && ((node->Address >= UserlandStart && node->Address < UserlandEnd && proc->ActiveCoreCount == 1 && !VmmArc::PCID) || unlikely(!Mailbox::IsReady())))
-        broadcast = false;
-
     ChainInvalidationInfo info { proc, node, after, cookie };
 
     if (broadcast)
-    {
-        ALLOCATE_MAIL_BROADCAST(mail, &ChainInvalidator<false>, &info);
-        mail.SetAwait(true).Post(&ChainInvalidator<true>, &info);
-
-        //  Quite simple.
-    }
+        Shootdown(proc, IsUserland(node->Address), &ChainInvalidator<false>, &ChainInvalidator<true>, &info);
     else
         ChainInvalidator<true>(&info);
 
     return HandleResult::Okay;
 }
 
+/*  Invalidation Batches  */
+
+void Vmm::BeginInvalidationBatch(Process * proc, bool kernel)
+{
+    if (proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    TlbShootdownQueue & queue = GetQueue(proc, kernel);
+    TlbBatch & batch = GetBatch(kernel);
+
+    if (batch.Depth == 0)
+        batch.Queue = &queue;
+    else if (batch.Queue != &queue)
+        return;
+    //  A batch nested within one over another address space is not opened, and
+    //  its unmappings are invalidated right away.
+
+    ++batch.Depth;
+}
+
+Handle Vmm::EndInvalidationBatch(Process * proc, bool kernel)
+{
+    if (proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    TlbShootdownQueue & queue = GetQueue(proc, kernel);
+    TlbBatch & batch = GetBatch(kernel);
+
+    if (batch.Depth == 0 || batch.Queue != &queue || --batch.Depth != 0)
+        return HandleResult::Okay;
+    //  The outermost batch shoots down whatever remains queued, including the
+    //  entries queued by other threads' batches.
+
+    return FlushQueue(proc, queue);
+}
+
+Handle Vmm::FlushInvalidations(Process * proc, bool kernel)
+{
+    if (proc == nullptr) proc = likely(CpuDataSetUp) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    TlbShootdownQueue & queue = GetQueue(proc, kernel);
+
+    if likely(__atomic_load_n(&(queue.Count), __ATOMIC_ACQUIRE) == 0)
+        return HandleResult::Okay;
+
+    return FlushQueue(proc, queue);
+}
+
+/*  TLB Shootdowns  */
+
+void VmmArc::SetActiveCore(Process * const proc, bool const active)
+{
+    size_t const index = Cpu::GetData()->Index;
+
+    if unlikely(index >= Process::ActiveCoresWords * 64)
+        return;
+    //  Such cores are only reached by broadcasts.
+
+    uint64_t const bit = 1ULL << (index % 64);
+
+    if (active)
+        __atomic_fetch_or(proc->ActiveCores + index / 64, bit, __ATOMIC_SEQ_CST);
+    else
+        __atomic_fetch_and(proc->ActiveCores + index / 64, ~bit, __ATOMIC_RELEASE);
+}
+
 Handle Vmm::Translate(Execution::Process * proc, vaddr_t const vaddr, paddr_t & paddr, bool const lock)
 {
-    return TryTranslate(proc, vaddr, [&paddr](PmlCommonEntry * pE, int level)
+    return TryTranslate(proc, vaddr, [vaddr, &paddr](PmlCommonEntry * pE, int level)
     {
-        (void)level;
-
-        paddr = pE->GetAddress();
+        if (level == 2)
+            paddr = reinterpret_cast<Pml2Entry *>(pE)->GetPageAddress()
+                  + psize_t(RoundDown(vaddr.Value & (LargePageSize.Value - 1), PageSize.Value));
+            //  The 4-KiB page within the large one.
+        else
+            paddr = pE->GetAddress();
 
         return HandleResult::Okay;
     }, lock);
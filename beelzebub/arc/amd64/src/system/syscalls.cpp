@@ -80,6 +80,7 @@ void Syscall::Initialize()
             SET_SYSCALL(MemoryRelease, MemoryRelease);
             SET_SYSCALL(MemoryCopy   , MemoryCopy);
             SET_SYSCALL(MemoryFill   , MemoryFill);
+            SET_SYSCALL(MemoryShare  , MemoryShare);
 
             Initialized = true;
         }
@@ -39,6 +39,8 @@
 
 #pragma once
 
+#include <beel/handles.h>
+
 namespace Beelzebub { namespace System
 {
     //  Differs on AMD64 and IA-32.
@@ -46,4 +48,10 @@ namespace Beelzebub { namespace System
 
     //  Common to x86.
     bool TurnIntoNoOp(void * start, void * end, bool useJump = true);
+
+    //  Common to x86. Makes the kernel's code writable while `patcher` runs.
+    __startup Handle PatchKernelCode(Handle (* patcher)(void * cookie), void * cookie = nullptr);
+
+    //  Common to x86. Flushes the cache lines of freshly patched code.
+    void FlushPatchedCode(void * start, void * end);
 }}
@@ -51,6 +51,8 @@
 
 #include <beel/sync/atomic.hpp>
 #include <beel/sync/smp.lock.hpp>
+#include <beel/sync/queue.mpsc.intrusive.hpp>
+#include <beel/sync/queued.lock.hpp>
 
 #define REGFUNC1(regl, regu, type)                                   \
 static __forceinline type MCATS2(Get, regu)()                        \
@@ -110,6 +112,7 @@ namespace Beelzebub { namespace System
           PageFaultStackSize = 1 * PageSize.Value,
         DoubleFaultStackSize = 1 * PageSize.Value,
                 CpuStackSize = 3 * PageSize.Value,
+          SchedulerStackSize = 2 * PageSize.Value,
     };
 
     typedef uint16_t   seg_t; //  Segment register.
@@ -127,15 +130,26 @@ namespace Beelzebub { namespace System
 
         Execution::Thread * LastExtendedStateThread = nullptr;
 
+        uint32_t Node = 0;
+        //  NUMA node of this core.
+
+        uint64_t TlbGeneration = 0;
+        //  TLB generation of the active process which this core has caught up
+        //  with.
+
+        size_t RcuState = 0;
+        //  Whether this core is idle, and whether a grace period awaits it.
+
 #if defined(__BEELZEBUB_SETTINGS_SMP)
-        MailboxEntryBase * MailHead = nullptr, * MailTail = nullptr;
-        Synchronization::SmpLock MailLock {};
+        Synchronization::MpscQueueIntrusive<MailboxEntryLink> MailQueue;
+        //  Links of the mail entries destined to this core.
 
-#ifdef __BEELZEBUB_SETTINGS_MANYCORE
-        uint64_t MailGeneration = 0;
-#endif
+        Synchronization::Atomic<MailboxEntryLink *> MailNmTop { nullptr };
 
-        Synchronization::Atomic<MailboxEntryBase *> MailNmTop { nullptr };
+        Synchronization::QueuedLockNode QueuedLockNodes[Synchronization::QueuedLockNodeCount];
+        //  Nodes with which this core waits on queued locks, one per level of
+        //  nesting.
+        size_t QueuedLockNesting = 0;
 #endif
     };
 
@@ -91,6 +91,17 @@ namespace Beelzebub { namespace System
             return InvalidateTlb(addr.Pointer);
         }
 
+        static constexpr uint64_t const InvalidatePcidAddress = 0;
+        static constexpr uint64_t const InvalidatePcidContext = 1;
+
+        static __artificial void InvalidatePcid(uint64_t const type
+            , uint64_t const pcid, vaddr_t const addr = nullvaddr)
+        {
+            struct { uint64_t Pcid; uint64_t Address; } const desc { pcid, addr.Value };
+
+            asm volatile ( "invpcid %0, %1 \n\t" : : "m"(desc), "r"(type) : "memory" );
+        }
+
         static __artificial void FlushCache(void const * const addr)
         {
             struct _64_bytes { uint8_t x[64]; } const * const p
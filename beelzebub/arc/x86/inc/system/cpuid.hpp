@@ -120,7 +120,7 @@ namespace Beelzebub { namespace System
                          : "a" (in1), "c" (in2));
         }
 
-        static constexpr size_t const FeatureIntegerCount = 5;
+        static constexpr size_t const FeatureIntegerCount = 7;
 
         /*  Cosntructor(s)  */
 
@@ -74,6 +74,8 @@ namespace Beelzebub { namespace System
     {
         //  (L)APIC/x2APIC
         IA32_APIC_BASE      = 0x0000001B,
+        //  TSC Target of Local APIC's TSC Deadline Mode
+        IA32_TSC_DEADLINE   = 0x000006E0,
 
         //  Extended Feature Enables
         IA32_EFER           = 0xC0000080,
@@ -0,0 +1,102 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#include <beel/handles.h>
+
+namespace Beelzebub { namespace System
+{
+    /**
+     *  Describes the NUMA topology of the system: which node each processor
+     *  and each range of physical memory belongs to, and the relative distances
+     *  between nodes.
+     */
+    class Numa
+    {
+    public:
+        /*  Constants  */
+
+        static constexpr uint32_t const MaxNodes = 16;
+        static constexpr size_t const MaxMemoryRanges = 64;
+        static constexpr size_t const MaxProcessors = 256;
+
+        static constexpr uint8_t const LocalDistance = 10;
+        static constexpr uint8_t const RemoteDistance = 20;
+
+        /*  Statics  */
+
+        //  There is always at least one node.
+        static uint32_t NodeCount;
+
+        /*  Constructor(s)  */
+
+    protected:
+        Numa() = default;
+
+    public:
+        Numa(Numa const &) = delete;
+        Numa & operator =(Numa const &) = delete;
+
+        /*  Initialization  */
+
+        //  Proximity domains are firmware-assigned; they are mapped to dense node
+        //  indexes in the order in which they are first seen.
+        static __startup Handle AddMemoryRange(uint32_t domain, paddr_t start, psize_t size);
+        static __startup Handle AddProcessor(uint32_t domain, uint32_t apicId);
+        static __startup Handle SetDistance(uint32_t fromDomain, uint32_t toDomain, uint8_t distance);
+
+        //  Fills in missing distances and computes the fallback orders.
+        static __startup void Finalize();
+
+        /*  Queries  */
+
+        //  Memory not described by the firmware belongs to node 0. The end of
+        //  the contiguous range sharing the returned node is also given.
+        static uint32_t GetAddressNode(paddr_t addr, paddr_t & rangeEnd);
+
+        static uint32_t GetProcessorNode(uint32_t apicId);
+
+        static uint8_t GetDistance(uint32_t from, uint32_t to);
+
+        //  Returns all nodes, ordered by their distance from the given one,
+        //  starting with itself.
+        static uint32_t const * GetFallbackOrder(uint32_t node);
+    };
+}}
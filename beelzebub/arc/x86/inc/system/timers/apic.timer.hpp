@@ -79,6 +79,9 @@ namespace Beelzebub { namespace System { namespace Timers
         static void SetCount(uint32_t count);
         static uint32_t GetCount();
 
+        static void DeadlineMode(uint8_t interrupt, bool mask = true);
+        static void SetDeadline(uint64_t tsc);
+
         static void Stop();
 
     private:
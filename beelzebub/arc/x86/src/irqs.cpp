@@ -38,12 +38,14 @@
 */
 
 #include "irqs.hpp"
+#include "rcu.hpp"
 #include "system/interrupts.hpp"
 #include "system/exceptions.hpp"
 #include "system/nmi.hpp"
 #include "system/gdt.hpp"
 #include "system/interrupt_controllers/pic.hpp"
-#include <beel/sync/smp.lock.hpp>
+#include <beel/sync/big.reader.lock.hpp>
+#include <beel/interrupt.state.hpp>
 #include <debug.hpp>
 
 using namespace Beelzebub;
@@ -61,11 +63,13 @@ namespace Beelzebub
 
 struct InterruptVectorData
 {
-    SmpLock CS;
     InterruptHandlerNode * First;
     InterruptEnderNode const * Ender;
 } Vectors[Interrupts::Count];
 
+static BigReaderLock VectorsLock {};
+//  Every interrupt reads a handler list; handlers are (un)subscribed rarely.
+
 /**********************************
     InterruptHandlerNode struct
 **********************************/
@@ -83,14 +87,20 @@ IrqSubscribeResult InterruptHandlerNode::Subscribe(isr_t isr)
     InterruptVectorData * const vd = Vectors + isr.Value;
     bool added;
 
-    withLock (vd->CS)
+    withInterrupts (false)
     {
+        //  An interrupt on this core would wait for the writer forever.
+
+        VectorsLock.AcquireAsWriter();
+
         added = this->AddToList(&(vd->First));
 
         if likely(added)
         {
             this->IsrVector = isr;
         }
+
+        VectorsLock.ReleaseAsWriter();
     }
 
     return added ? IrqSubscribeResult::Success : IrqSubscribeResult::Unuseable;
@@ -120,8 +130,10 @@ IrqUnsubscribeResult InterruptHandlerNode::Unsubscribe()
     InterruptVectorData * const vd = Vectors + this->IsrVector.Value;
     bool removed;
 
-    withLock (vd->CS)
+    withInterrupts (false)
     {
+        VectorsLock.AcquireAsWriter();
+
         removed = this->RemoveFromList(&(vd->First));
 
         if likely(removed)
@@ -129,6 +141,8 @@ IrqUnsubscribeResult InterruptHandlerNode::Unsubscribe()
             this->IsrVector = isr_invalid;
             this->IrqVector = irq_invalid;
         }
+
+        VectorsLock.ReleaseAsWriter();
     }
 
     ASSERT(removed);
@@ -283,6 +297,7 @@ Handle Irqs::Initialize()
 #if   defined(__BEELZEBUB__ARCH_AMD64)
     Interrupts::Get(KnownIsrs::DoubleFault).GetGate()->SetIst(1);
     Interrupts::Get(KnownIsrs::PageFault  ).GetGate()->SetIst(2);
+    Interrupts::Get(KnownIsrs::Yield      ).GetGate()->SetIst(3);
 #endif
 
     Interrupts::Get(KnownIsrs::DivideError).SetHandler(&DivideErrorHandler);
@@ -342,6 +357,29 @@ void Irqs::CommonInterruptHandler(INTERRUPT_HANDLER_ARGS)
     InterruptContextInternal context { state, isr_t(vector), CurrentContext };
     CurrentContext = &context;
 
+    Execution::Thread * idleThread = nullptr;
+
+    if unlikely(Rcu::IsIdle())
+    {
+        Rcu::ExitIdle();
+        idleThread = Cpu::GetThread();
+    }
+    //  Handlers may read, so grace periods have to wait for them too.
+
+    size_t slot;
+    bool locked;
+
+    if unlikely(vector == (uint8_t)KnownIsrs::Nmi)
+        locked = VectorsLock.TryAcquireAsReader(slot);
+        //  The writer may be on this very core, so an NMI cannot wait for it.
+        //  Failing that, the list is walked as it is; it is only ever changed
+        //  by single pointer stores.
+    else
+    {
+        slot = VectorsLock.AcquireAsReader();
+        locked = true;
+    }
+
     context.CurrentHandler = vd->First;
 
     //  TODO: Exception trapping?
@@ -354,9 +392,17 @@ void Irqs::CommonInterruptHandler(INTERRUPT_HANDLER_ARGS)
         context.CurrentHandler = context.CurrentHandler->Next;
     }
 
+    if likely(locked)
+        VectorsLock.ReleaseAsReader(slot);
+
     if (vd->Ender)
         vd->Ender->Ender(&context, vd->Ender->Cookie, InterruptEndType::AfterKernel);
     //  TODO: Userland-handled interrupts.
 
+    if unlikely(idleThread != nullptr && idleThread == Cpu::GetThread())
+        Rcu::EnterIdle();
+    //  Unless the scheduler switched to another thread, the core goes back to
+    //  idling.
+
     CurrentContext = context.Next;
 }
@@ -43,6 +43,7 @@
 #include "global_options.hpp"
 #include "utils/unit_tests.hpp"
 #include "lock_elision.hpp"
+#include "string_patches.hpp"
 #include "watchdog.hpp"
 #include "djinn.arc.hpp"
 
@@ -60,9 +61,12 @@
 #include "execution/runtime64.hpp"
 #include "execution.hpp"
 #include "scheduler.hpp"
+#include "rcu.hpp"
+#include <beel/sync/lock.stat.hpp>
 
 #include "irqs.hpp"
 #include "system/acpi.hpp"
+#include "system/numa.hpp"
 #include "system/debug.registers.hpp"
 #include "system/interrupt_controllers/lapic.hpp"
 #include "system/interrupt_controllers/ioapic.hpp"
@@ -465,9 +469,12 @@ __startup Handle InitializeAcpiTables()
         , Acpi::PresentLapicCount, Acpi::PresentLapicCount != 1 ? "s" : "");
 #endif
 
-    InitTerminal->WriteFormat(" %us I/O APIC%s..."
+    InitTerminal->WriteFormat(" %us I/O APIC%s,"
         , Acpi::IoapicCount, Acpi::IoapicCount != 1 ? "s" : "");
 
+    InitTerminal->WriteFormat(" %us NUMA node%s..."
+        , (size_t)Numa::NodeCount, Numa::NodeCount != 1 ? "s" : "");
+
     return HandleResult::Okay;
 }
 
@@ -549,6 +556,22 @@ static __startup void MainInitializeCores()
     }
 }
 
+#ifdef __BEELZEBUB__CONF_LOCKSTAT
+static __startup void MainInitializeLockStat()
+{
+    //  Allocate the per-core tables of the lock contention profiler.
+
+    InitTerminal->Write("[....] Initializing lock statistics...");
+    Handle res = LockStat::Initialize(Cores::GetCount());
+
+    if (res.IsOkayResult())
+        InitTerminal->WriteLine(" Done.\r[OKAY]");
+    else
+        InitTerminal->WriteFormat(" Fail..? %H\r[WARN]%n", res);
+        //  The kernel runs fine without them.
+}
+#endif
+
 /*****************
     UNIT TESTS
 *****************/
@@ -1018,6 +1041,22 @@ static __startup void MainElideLocks()
 #endif
 }
 
+static __startup void MainPatchStringFunctions()
+{
+    //  Drop the `rep movsb` shortcuts which this processor does not benefit
+    //  from. This must happen before any other core runs kernel code.
+    //  Mainly common.
+
+    InitTerminal->Write("[....] Selecting string functions...");
+    Handle res = PatchStringFunctions();
+
+    if (res.IsOkayResult())
+        InitTerminal->WriteLine(" Done.\r[OKAY]");
+    else
+        InitTerminal->WriteFormat(" Fail..? %H\r[WARN]%n", res);
+        //  The unpatched functions are correct, just slower.
+}
+
 static __startup void MainInitializeBootModules()
 {
     //  Initialize the modules loaded by the bootloader with the kernel.
@@ -1242,13 +1281,20 @@ void Beelzebub::Main(MainParameters * params)
 
     // MSGEX("Test {0} {1} {2} {2} {0} {1} {1} {0:bit}.\n", true, -124, "rada");
 
-    MainInitializePhysicalMemory();
     MainInitializeAcpiTables();
+    MainInitializePhysicalMemory();
+    //  The ACPI tables are only read through the identity map at first, and
+    //  the memory affinities they describe shape the allocation spaces.
     MainInitializeVirtualMemory();
     MainInitializeBootModules();
+    MainPatchStringFunctions();
 
     MainInitializeCores();
+#ifdef __BEELZEBUB__CONF_LOCKSTAT
+    MainInitializeLockStat();
+#endif
     Cpu::SetProcess(&BootstrapProcess);
+    VmmArc::SetActiveCore(&BootstrapProcess, true);
 
     DebugRegisters::Initialize();
 
@@ -1311,6 +1357,16 @@ void Beelzebub::Main(MainParameters * params)
         MallocTestBarrier.Reset(Cores::GetCount());
 #endif
 
+#if defined(__BEELZEBUB__TEST_HANDLES) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+    if (CHECK_TEST(HANDLES))
+        HandleTableTestBarrier.Reset(Cores::GetCount());
+#endif
+
+#ifdef __BEELZEBUB__TEST_RCU
+    if (CHECK_TEST(RCU))
+        RcuTestBarrier.Reset(Cores::GetCount());
+#endif
+
 #if   defined(__BEELZEBUB_SETTINGS_SMP)
     //  This should really be done under a lock.
     InitializationLock.Acquire();
@@ -1397,6 +1453,16 @@ void Beelzebub::Main(MainParameters * params)
     }
 #endif
 
+#if defined(__BEELZEBUB__TEST_SCHED) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+    if (CHECK_TEST(SCHED))
+    {
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteLine("[TEST] Scheduler run queues...");
+
+        TestScheduler();
+    }
+#endif
+
 #ifdef __BEELZEBUB__TEST_AVL_TREE
     if (CHECK_TEST(AVL_TREE))
     {
@@ -1581,10 +1647,58 @@ void Beelzebub::Main(MainParameters * params)
     }
 #endif
 
+#if defined(__BEELZEBUB__TEST_HANDLES) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+    if (CHECK_TEST(HANDLES))
+    {
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Testing handle table.%n", Cpu::GetData()->Index);
+
+        TestHandleTable(true);
+
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Finished handle table test.%n", Cpu::GetData()->Index);
+    }
+#endif
+
+#ifdef __BEELZEBUB__TEST_RCU
+    if (CHECK_TEST(RCU))
+    {
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Testing RCU.%n", Cpu::GetData()->Index);
+
+        TestRcu(true);
+
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Finished RCU test.%n", Cpu::GetData()->Index);
+    }
+#endif
+
+#ifdef __BEELZEBUB__CONF_LOCKSTAT
+    LockStat::Dump(Debug::DebugTerminal);
+    LockStat::ArmPeriodicDump();
+    //  Boot and the tests are over; dump what they contended on.
+#endif
+
     InitTerminal->WriteFormat("Core %us is ready for idling.%n", Cpu::GetData()->Index);
 
-    //  Allow the CPU to rest.
-    while (true) if (CpuInstructions::CanHalt) CpuInstructions::Halt();
+    //  Allow the CPU to rest, after zeroing frames for page faults and merging
+    //  small pages into large ones.
+    while (true)
+    {
+        Vmm::RefillZeroedFrames();
+        Vmm::CollapseLargePages();
+
+#ifdef __BEELZEBUB__CONF_LOCKSTAT
+        LockStat::DumpIfDue(Debug::DebugTerminal);
+        //  The periodic dump is armed on this core only.
+#endif
+
+        Rcu::EnterIdle();
+
+        if (CpuInstructions::CanHalt) CpuInstructions::Halt();
+
+        Rcu::ExitIdle();
+    }
 }
 
 #if   defined(__BEELZEBUB_SETTINGS_SMP)
@@ -1613,6 +1727,7 @@ static void SecondaryEntryPoint(MainParameters * params)
     //  Register the core with the core manager.
 
     Cpu::SetProcess(&BootstrapProcess);
+    VmmArc::SetActiveCore(&BootstrapProcess, true);
 
     MSG_("Registered core #%us... %W", Cpu::GetData()->Index);
 
@@ -1773,9 +1888,46 @@ static void SecondaryEntryPoint(MainParameters * params)
     }
 #endif
 
+#if defined(__BEELZEBUB__TEST_HANDLES) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+    if (CHECK_TEST(HANDLES))
+    {
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Testing handle table.%n", Cpu::GetData()->Index);
+
+        TestHandleTable(false);
+
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Finished handle table test.%n", Cpu::GetData()->Index);
+    }
+#endif
+
+#ifdef __BEELZEBUB__TEST_RCU
+    if (CHECK_TEST(RCU))
+    {
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Testing RCU.%n", Cpu::GetData()->Index);
+
+        TestRcu(false);
+
+        withLock (TerminalMessageLock)
+            InitTerminal->WriteFormat("Core %us: Finished RCU test.%n", Cpu::GetData()->Index);
+    }
+#endif
+
     InitTerminal->WriteFormat("Core %us is ready for idling.%n", Cpu::GetData()->Index);
 
-    //  Allow the CPU to rest.
-    while (true) if (CpuInstructions::CanHalt) CpuInstructions::Halt();
+    //  Allow the CPU to rest, after zeroing frames for page faults and merging
+    //  small pages into large ones.
+    while (true)
+    {
+        Vmm::RefillZeroedFrames();
+        Vmm::CollapseLargePages();
+
+        Rcu::EnterIdle();
+
+        if (CpuInstructions::CanHalt) CpuInstructions::Halt();
+
+        Rcu::ExitIdle();
+    }
 }
 #endif
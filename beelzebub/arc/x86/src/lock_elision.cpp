@@ -39,21 +39,12 @@
 
 #include <lock_elision.hpp>
 #include <system/code_patch.hpp>
-#include <memory/vmm.hpp>
-#include <system/cpu_instructions.hpp>
-#include <kernel.hpp>
-#include <entry.h>
-#include <math.h>
 
 #include <debug.hpp>
 
 using namespace Beelzebub;
-using namespace Beelzebub::Memory;
 using namespace Beelzebub::System;
 
-__extern long const kernel_mapping_start;
-__extern long const kernel_mapping_end;
-
 struct LockAnnotation
 {
     uintptr_t Start;
@@ -63,55 +54,9 @@ struct LockAnnotation
 __extern LockAnnotation const locks_section_start;
 __extern LockAnnotation const locks_section_end;
 
-Handle Beelzebub::ElideLocks()
+static __startup Handle TurnLocksIntoNoOps(void * cookie)
 {
-    if (&locks_section_start == &locks_section_end)
-        return HandleResult::Okay;
-
-    InterruptGuard<false> intGuard;
-
-    Handle res;
-
-    //  Step 1 is backing up the flags of all the pages, and making them
-    //  writable, if they were not already.
-
-    size_t const kernel_size = RoundUp(reinterpret_cast<uintptr_t>(&kernel_mapping_end) - reinterpret_cast<uintptr_t>(&kernel_mapping_start), PageSize.Value);
-    size_t const kernel_page_count = kernel_size / PageSize.Value;
-
-    msg("Kernel start @ %Xp, end @ %Xp, size %us, page count %us."
-        , &kernel_mapping_start, &kernel_mapping_end
-        , kernel_size, kernel_page_count);
-
-    __extension__ MemoryFlags flags[kernel_page_count] {};
-
-    for (size_t pageInd = 0; pageInd < kernel_page_count; ++pageInd)
-    {
-        vaddr_t const vaddr = vaddr_t(&kernel_mapping_start) + pageInd * PageSize;
-
-        res = Vmm::GetPageFlags(nullptr, vaddr, flags[pageInd]);
-
-        assert_or(res.IsOkayResult()
-            , "Failed to retrieve flags of page %Xp for lock elision: %H"
-            , vaddr, res)
-        {
-            return res;
-        }
-
-        res = Vmm::SetPageFlags(nullptr, vaddr, MemoryFlags::Writable | flags[pageInd]);
-
-        assert_or(res.IsOkayResult()
-            , "Failed to apply flags to page %Xp for lock elision: %H"
-            , vaddr, res)
-        {
-            return res;
-        }
-    }
-
-    //  Step 2 is performing the actual code patches.
-
-    size_t const cacheLineSize = BootstrapCpuid.GetClflushLineSize();
-
-    //  Finally, no-op the code.
+    (void)cookie;
 
     LockAnnotation const * cursor = &locks_section_start;
 
@@ -126,26 +71,17 @@ Handle Beelzebub::ElideLocks()
             return HandleResult::Failed;
         }
 
-        for (uintptr_t i = RoundDown(cursor->Start, cacheLineSize); i < cursor->End; i += cacheLineSize)
-            CpuInstructions::FlushCache((void *)i);
-        //  The cache ought to be flushed, just to be on the safe side.
+        FlushPatchedCode(reinterpret_cast<void *>(cursor->Start)
+            , reinterpret_cast<void *>(cursor->End));
     }
 
-    //  And step 3 is restoring the page flags.
-
-    for (size_t pageInd = 0; pageInd < kernel_page_count; ++pageInd)
-    {
-        vaddr_t const vaddr = vaddr_t(&kernel_mapping_start) + pageInd * PageSize;
-
-        res = Vmm::SetPageFlags(nullptr, vaddr, flags[pageInd]);
+    return HandleResult::Okay;
+}
 
-        assert_or(res.IsOkayResult()
-            , "Failed to restore flags to page %Xp for lock elision: %H"
-            , vaddr, res)
-        {
-            return res;
-        }
-    }
+Handle Beelzebub::ElideLocks()
+{
+    if (&locks_section_start == &locks_section_end)
+        return HandleResult::Okay;
 
-    return HandleResult::Okay;
+    return PatchKernelCode(&TurnLocksIntoNoOps);
 }
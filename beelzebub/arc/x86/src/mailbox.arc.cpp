@@ -52,7 +52,7 @@ lean & mean implementation without his aid.
 #include "kernel.hpp"
 #include "irqs.hpp"
 #include <beel/sync/smp.lock.hpp>
-#include <string.h>
+#include <math.h>
 
 using namespace Beelzebub;
 using namespace Beelzebub::Synchronization;
@@ -64,12 +64,38 @@ using namespace Beelzebub::System::InterruptControllers;
 ****************/
 
 #ifdef __BEELZEBUB_SETTINGS_MANYCORE
-static SmpLock GlobalLock {};
-static MailboxEntryBase * volatile GlobalHead = nullptr;
-static MailboxEntryBase * GlobalTail = nullptr;
-static size_t GlobalGeneration = 0;
+static constexpr unsigned int const BroadcastChunk = 64;
+//  Broadcasts to more cores are split up, so no counter of destinations left
+//  is contended by all of them.
+
+static constexpr size_t const BroadcastChunkSize = sizeof(MailboxEntryBase)
+    + BroadcastChunk * sizeof(MailboxEntryLink);
+
+static_assert(BroadcastChunkSize % sizeof(void *) == 0, "Broadcast chunks must be pointer-aligned.");
 #endif
 
+static __hot __forceinline void Deliver(MailboxEntryLink * link)
+{
+    MailboxEntryBase * const entry = link->GetEntry();
+    MailFunction const func = entry->Function;
+    void * const cookie = entry->Cookie;
+
+    if (entry->GetAwait())
+    {
+        func(cookie);
+
+        --entry->DestinationsLeft;
+    }
+    else
+    {
+        --entry->DestinationsLeft;
+        //  This core no longer needs anything from that mail entry, which may
+        //  go away at any moment now.
+
+        func(cookie);
+    }
+}
+
 static __hot void ExecuteNmMail(InterruptContext const * context, void * isrCookie)
 {
     (void)context;
@@ -77,131 +103,35 @@ static __hot void ExecuteNmMail(InterruptContext const * context, void * isrCook
 
     CpuData * const data = Cpu::GetData();
 
-    MailboxEntryBase * entry;
+    MailboxEntryLink * link;
 
-    while ((entry = data->MailNmTop.Xchg(nullptr)) != nullptr)
+    while ((link = data->MailNmTop.Xchg(nullptr)) != nullptr)
         do
         {
-            MailFunction const func = entry->Function;
-            void * const cookie = entry->Cookie;
-            Synchronization::Atomic<unsigned int> * dstCtr = nullptr;
+            MailboxEntryLink * const next = link->Next;
+            //  Retrieved before the entry can go away.
 
-            for (unsigned int i = 0; i < entry->DestinationCount; ++i)
-            {
-                MailboxEntryLink & link = entry->Links[i];
-
-                if (link.Core == data->Index)
-                {
-                    if (entry->GetAwait())
-                        dstCtr = &(entry->DestinationsLeft);
-                    else
-                    {
-                        --entry->DestinationsLeft;
-                        //  This core no longer needs anything from that mail entry.
-                    }
-
-                    entry = link.Next;
-                    //  Prepares for the next entry as well.
-
-                    break;
-                }
-            }
+            Deliver(link);
 
-            func(cookie);
-
-            if unlikely(dstCtr != nullptr)
-                dstCtr->operator --();
-        } while (entry != nullptr);
+            link = next;
+        } while (link != nullptr);
 }
 
-static __hot __solid bool ExecuteHead()
+static __hot __solid size_t ExecuteMail()
 {
     CpuData * const data = Cpu::GetData();
 
-    MailFunction func = nullptr;
-    void * cookie = nullptr;
-    Synchronization::Atomic<unsigned int> * dstCtr = nullptr;
-
-    withLock (data->MailLock)
-    {
-        auto head = data->MailHead;
-
-        if unlikely(head == nullptr)
-#ifdef __BEELZEBUB_SETTINGS_MANYCORE
-            goto check_global;
-#else
-            return false;
-#endif
-
-        func = head->Function;
-        cookie = head->Cookie;
-
-        for (unsigned int i = 0; i < head->DestinationCount; ++i)
-        {
-            MailboxEntryLink & link = head->Links[i];
-
-            if (link.Core == data->Index)
-            {
-                data->MailHead = link.Next;
-                //  This dequeues the mail entry.
-
-                if (head->GetAwait())
-                    dstCtr = &(head->DestinationsLeft);
-                else
-                {
-                    --head->DestinationsLeft;
-                    //  This core no longer needs anything from that mail entry.
-                }
-
-                break;
-            }
-        }
-
-        if (data->MailHead == nullptr)
-            data->MailTail = nullptr;
-    }
-
-#ifdef __BEELZEBUB_SETTINGS_MANYCORE
-    goto execute;
+    MailboxEntryLink * link;
+    size_t count = 0;
 
-check_global:
-    withLock (GlobalLock)
+    while ((link = data->MailQueue.Pop()) != nullptr)
     {
-        MailboxEntryBase * entry = GlobalHead;
-
-        while (entry != nullptr)
-        {
-            if (entry->Links[0].Generation > data->MailGeneration)
-            {
-                //  Found one!
-
-                data->MailGeneration = entry->Links[0].Generation;
-                //  This becomes the last generation.
-
-                func = entry->Function;
-                cookie = entry->Cookie;
+        Deliver(link);
 
-                --entry->DestinationsLeft;
-
-                break;
-            }
-
-            entry = entry->Links[0].Next;
-        }
-
-        if (entry == nullptr)
-            return false;
+        ++count;
     }
 
-execute:
-#endif
-
-    func(cookie);
-
-    if unlikely(dstCtr != nullptr)
-        dstCtr->operator --();
-
-    return true;
+    return count;
 }
 
 static __hot __realign_stack void MailboxIsrHandler(InterruptContext const * context, void * cookie)
@@ -209,68 +139,94 @@ static __hot __realign_stack void MailboxIsrHandler(InterruptContext const * con
     (void)context;
     (void)cookie;
 
-    while (ExecuteHead()) { /* loopie loop */ }
+    ExecuteMail();
+    //  Everything queued is handled under the one interrupt. Senders only
+    //  interrupt this core again once they find its queue empty.
 }
 
-static __hot void PostInternal(MailboxEntryBase * entry, TimeWaster waster, void * cookie, bool poll, bool broadcast)
+static __forceinline uint32_t GetX2ApicLogicalId(uint32_t const id)
+{
+    //  In x2APIC mode, the logical ID is derived from the APIC ID: bits 4-19
+    //  give the cluster, and bits 0-3 give the core's bit within the cluster.
+
+    return ((id >> 4) << 16) | (1U << (id & 0xF));
+}
+
+static __hot void SendMailIpi(uint32_t const destination, bool const logical)
 {
+    Lapic::SendIpi(LapicIcr(0)
+        .SetDeliveryMode(InterruptDeliveryModes::Fixed)
+        .SetDestinationShorthand(IcrDestinationShorthand::None)
+        .SetDestinationLogical(logical)
+        .SetAssert(true)
+        .SetDestination(destination)
+        .SetVector(KnownIsrs::Mailbox));
+}
+
+static __hot void SendInternal(MailboxEntryBase * entry, bool broadcast)
+{
+    bool const nonMaskable = entry->GetNonMaskable();
+    bool const clustered = !nonMaskable && Lapic::X2ApicMode;
+    uint32_t cluster = 0;
+    //  Logical destination of the targets gathered from the current cluster.
+    unsigned int signals = 0;
+
     for (unsigned int i = 0; i < entry->DestinationCount; ++i)
     {
-        uint32_t const targetCore = entry->Links[i].Core;
-        CpuData * const target = Cores::Get(targetCore);
+        MailboxEntryLink & link = entry->Links[i];
+        CpuData * const target = Cores::Get(link.Core);
+        bool wasEmpty;
 
-        if (entry->GetNonMaskable())
+        link.Index = i;
+
+        if (nonMaskable)
         {
-            MailboxEntryBase * top = target->MailNmTop.Load();
+            MailboxEntryLink * top = target->MailNmTop.Load();
+
+            do link.Next = top; while (!target->MailNmTop.CmpXchgStrong(top, &link));
 
-            do entry->Links[i].Next = top; while (!target->MailNmTop.CmpXchgStrong(top, entry));
+            wasEmpty = top == nullptr;
         }
         else
-        {
-            withLock (target->MailLock)
-            {
-                if likely(target->MailTail != nullptr)
-                {
-                    //  Mail is already queued for this core, so the entry is added to the tail.
+            wasEmpty = target->MailQueue.Push(&link);
 
-                    MailboxEntryBase * const tail = target->MailTail;
+        if (!wasEmpty)
+            continue;
+        //  The target has mail pending, so it has been interrupted already and
+        //  will get to this entry as well.
 
-                    for (unsigned int j = 0; j < entry->DestinationCount; ++j)
-                    {
-                        MailboxEntryLink & link = tail->Links[j];
+        ++signals;
 
-                        if (link.Core == targetCore)
-                        {
-                            link.Next = entry;
+        if (broadcast)
+            continue;
+        //  All of them get one interrupt at the end.
 
-                            break;
-                        }
-                    }
+        if (nonMaskable)
+            Nmi::Send(target->LapicId);
+        else if (clustered)
+        {
+            uint32_t const logical = GetX2ApicLogicalId(target->LapicId);
+
+            if (cluster != 0 && (cluster >> 16) != (logical >> 16))
+            {
+                SendMailIpi(cluster, true);
 
-                    target->MailTail = entry;
-                }
-                else
-                    target->MailTail = target->MailHead = entry;    //  ezpz
+                cluster = 0;
             }
-        }
 
-        if unlikely(!broadcast)
-        {
-            if (entry->GetNonMaskable())
-                Nmi::Send(target->LapicId);
-            else
-                Lapic::SendIpi(LapicIcr(0)
-                    .SetDeliveryMode(InterruptDeliveryModes::Fixed)
-                    .SetDestinationShorthand(IcrDestinationShorthand::None)
-                    .SetAssert(true)
-                    .SetDestination(target->LapicId)
-                    .SetVector(KnownIsrs::Mailbox));
+            cluster |= logical;
         }
+        else
+            SendMailIpi(target->LapicId, false);
     }
 
-    if likely(broadcast)
+    if (cluster != 0)
+        SendMailIpi(cluster, true);
+    //  Cores of the same cluster are interrupted with a single IPI.
+
+    if (broadcast && signals > 0)
     {
-        if (entry->GetNonMaskable())
+        if (nonMaskable)
             Nmi::Broadcast();
         else
             Lapic::SendIpi(LapicIcr(0)
@@ -279,80 +235,26 @@ static __hot void PostInternal(MailboxEntryBase * entry, TimeWaster waster, void
                 .SetAssert(true)
                 .SetVector(KnownIsrs::Mailbox));
     }
+}
 
-    if (waster != nullptr)
-        waster(cookie);
-
+static __hot void AwaitInternal(MailboxEntryBase * entry, bool poll)
+{
     unsigned int destLeft;
 
     while ((destLeft = entry->DestinationsLeft) > 0)
-        if (!(poll && ExecuteHead()))
+        if (!(poll && ExecuteMail() > 0))
             do CpuInstructions::DoNothing(); while (--destLeft > 0);
 }
 
-#ifdef __BEELZEBUB_SETTINGS_MANYCORE
-static __hot void PostGlobal(MailboxEntryBase * entry, TimeWaster waster, void * cookie, bool poll)
+static __hot void PostInternal(MailboxEntryBase * entry, TimeWaster waster, void * cookie, bool poll, bool broadcast)
 {
-    withLock (GlobalLock)
-    {
-        auto gen = ++GlobalGeneration;
-        //  This be the generation of the mail entry.
-
-        entry->Links[0].Generation = gen;
-
-        if (GlobalTail == nullptr)
-            GlobalHead = GlobalTail = entry;
-        else
-        {
-            GlobalTail->Links[0].Next = entry;
-
-            assert(GlobalTail->Links[0].Generation < gen)
-                (GlobalTail->Links[0].Generation)(gen);
-
-            GlobalTail = entry;
-        }
-    }
-
-    Lapic::SendIpi(LapicIcr(0)
-        .SetDeliveryMode(InterruptDeliveryModes::Fixed)
-        .SetDestinationShorthand(IcrDestinationShorthand::AllExcludingSelf)
-        .SetAssert(true)
-        .SetVector(KnownIsrs::Mailbox);
+    SendInternal(entry, broadcast);
 
     if (waster != nullptr)
         waster(cookie);
 
-    {   //  Scope to contain the variable.
-        unsigned int destLeft;
-
-        while ((destLeft = entry->DestinationsLeft) > 0)
-            if (!(poll && ExecuteHead()))
-                do CpuInstructions::DoNothing(); while (--destLeft > 0);
-    }
-
-    //  So, the mail had been handled by all destinations.
-    //  Now it needs to become the head of the queue to be removed from it.
-
-    while (entry != GlobalHead)
-        if (!(poll && ExecuteHead()))
-            CpuInstructions::DoNothing();
-
-    //  Now it should be the head of the queue.
-
-    withLock (GlobalLock)
-    {
-        assert(entry == GlobalHead)((void *)entry)((void *)GlobalHead);
-        //  If another core dequeued it, it's a huge problem.
-
-        entry = entry->Links[0].Next;
-
-        if (entry == nullptr)
-            GlobalHead = GlobalTail = nullptr;
-        else
-            GlobalHead = entry;
-    }
+    AwaitInternal(entry, poll);
 }
-#endif
 
 static SmpLock InitLock {};
 static bool Initialized = false;
@@ -406,31 +308,53 @@ void Mailbox::Post(MailboxEntryBase * entry, TimeWaster waster, void * cookie, b
 
     if (entry->DestinationCount == 1 && entry->Links[0].Core == Broadcast)
     {
-        auto tgCnt = Cores::GetCount() - 1;     //  Target count.
+        unsigned int const tgCnt = Cores::GetCount() - 1;     //  Target count.
+        unsigned int const thisCore = Cpu::GetData()->Index;  //  Index of this core.
 
 #ifdef __BEELZEBUB_SETTINGS_MANYCORE
-        if likely(tgCnt < 64)
+        if unlikely(tgCnt > BroadcastChunk)
         {
-#endif
-            auto thisCore = Cpu::GetData()->Index;  //  Index of this core.
+            unsigned int const chunkCnt = (tgCnt + BroadcastChunk - 1) / BroadcastChunk;
 
-            ALLOCATE_MAIL(newEntry, tgCnt, entry->Function, entry->Cookie);
-            newEntry.Flags = entry->Flags;
+            __extension__ void * buff[chunkCnt * BroadcastChunkSize / sizeof(void *)];
+            //  All chunks are in flight at once, so they need to outlive the
+            //  whole broadcast.
 
-            for (unsigned int link = 0; link < tgCnt; ++link)
-                newEntry.Links[link] = MailboxEntryLink((link < thisCore) ? link : (link + 1));
-            //  Set up all the links properly.
+            for (unsigned int chunk = 0; chunk < chunkCnt; ++chunk)
+            {
+                unsigned int const first = chunk * BroadcastChunk;
+                unsigned int const cnt = Minimum(BroadcastChunk, tgCnt - first);
 
-            return PostInternal(&newEntry, waster, cookie, poll, true);
-#ifdef __BEELZEBUB_SETTINGS_MANYCORE
-        }
-        else
-        {
-            entry->DestinationsLeft = tgCnt;
+                MailboxEntryBase * const newEntry = new (reinterpret_cast<uint8_t *>(buff) + chunk * BroadcastChunkSize)
+                    MailboxEntryBase(cnt, entry->Function, entry->Cookie);
+                newEntry->Flags = entry->Flags;
+
+                for (unsigned int link = 0; link < cnt; ++link)
+                    newEntry->Links[link] = MailboxEntryLink((first + link < thisCore) ? (first + link) : (first + link + 1));
 
-            return PostGlobal(entry, waster, cookie, poll);
+                SendInternal(newEntry, false);
+            }
+
+            if (waster != nullptr)
+                waster(cookie);
+
+            for (unsigned int chunk = 0; chunk < chunkCnt; ++chunk)
+                AwaitInternal(reinterpret_cast<MailboxEntryBase *>(reinterpret_cast<uint8_t *>(buff) + chunk * BroadcastChunkSize), poll);
+            //  Waiting on the chunks in order costs nothing extra, as the
+            //  broadcast is over only once the slowest destination is done.
+
+            return;
         }
 #endif
+
+        ALLOCATE_MAIL(newEntry, tgCnt, entry->Function, entry->Cookie);
+        newEntry.Flags = entry->Flags;
+
+        for (unsigned int link = 0; link < tgCnt; ++link)
+            newEntry.Links[link] = MailboxEntryLink((link < thisCore) ? link : (link + 1));
+        //  Set up all the links properly.
+
+        return PostInternal(&newEntry, waster, cookie, poll, true);
     }
     else
         return PostInternal(entry, waster, cookie, poll, false);
@@ -42,12 +42,16 @@
 #include "scheduler.hpp"
 #include "execution.hpp"
 #include "system/cpu.hpp"
+#include "system/cpuid.hpp"
+#include "irqs.hpp"
 
 using namespace Beelzebub;
 using namespace Beelzebub::Execution;
 using namespace Beelzebub::Memory;
 using namespace Beelzebub::System;
 
+static InterruptHandlerNode YieldNode { &Scheduler::HandleYield };
+
 /**********************
     Scheduler class
 **********************/
@@ -74,3 +78,70 @@ void Scheduler::InitializeIdleThread(MainParameters * params)
 
     Cpu::SetThread(thread);
 }
+
+void Scheduler::GetTopology(uint32_t & core, uint32_t & package)
+{
+    uint32_t a, b, c, d;
+    uint32_t apicId, smtShift = 0, coreShift = 0;
+
+    if (BootstrapCpuid.MaxStandardValue >= 0xB)
+    {
+        //  The extended topology leaf tells how many bits of the x2APIC ID
+        //  identify the hardware thread and the core.
+
+        for (uint32_t level = 0; /* nothing */; ++level)
+        {
+            CpuId::Execute(0xB, level, a, b, c, d);
+
+            uint32_t const type = (c >> 8) & 0xFF;
+
+            if (type == 0)
+                break;
+            else if (type == 1)
+                smtShift = a & 0x1F;
+            else if (type == 2)
+                coreShift = a & 0x1F;
+        }
+
+        apicId = d;
+
+        if (coreShift < smtShift)
+            coreShift = smtShift;
+    }
+    else
+    {
+        //  Without it, all the logical processors of a package are treated as
+        //  distinct cores.
+
+        CpuId::Execute(1, a, b, c, d);
+
+        apicId = b >> 24;
+
+        for (uint32_t logical = (b >> 16) & 0xFF; (1U << coreShift) < logical; ++coreShift) { }
+    }
+
+    core = apicId >> smtShift;
+    package = apicId >> coreShift;
+}
+
+void Scheduler::InitializeYield()
+{
+    ASSERT(YieldNode.Subscribe(Irqs::Yield) == IrqSubscribeResult::Success);
+    //  The vector runs on its own stack, as set up by the IDT initialization.
+}
+
+/*  Blocking  */
+
+void Scheduler::Yield()
+{
+    asm volatile ("int %[vec] \n\t" : : [vec]"i"((uint8_t)KnownIsrs::Yield) : "memory");
+}
+
+void Scheduler::Migrated(Thread * thread)
+{
+    CpuData * const cpuData = Cpu::GetData();
+
+    if (cpuData->LastExtendedStateThread == thread)
+        cpuData->LastExtendedStateThread = nullptr;
+    //  The extended state held by this core may have been changed elsewhere.
+}
@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <string_patches.hpp>
+#include <system/code_patch.hpp>
+#include <system/cpuid.hpp>
+#include <beel/string.arc.h>
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::System;
+
+__extern StringPatchSite const string_patches_start;
+__extern StringPatchSite const string_patches_end;
+
+static __startup Handle TurnUnsupportedSitesIntoNoOps(void * cookie)
+{
+    uintptr_t const features = reinterpret_cast<uintptr_t>(cookie);
+
+    StringPatchSite const * cursor = &string_patches_start;
+
+    for (/* nothing */; cursor < &string_patches_end; ++cursor)
+    {
+        if ((cursor->Feature & features) != 0)
+            continue;
+        //  The jump is worth taking on this processor.
+
+        bool okay = TurnIntoNoOp(reinterpret_cast<void *>(cursor->Start)
+            , reinterpret_cast<void *>(cursor->End), false);
+
+        assert_or(okay, "Failed to turn string patch site %Xp-%Xp into a no-op."
+            , cursor->Start, cursor->End)
+        {
+            return HandleResult::Failed;
+        }
+
+        FlushPatchedCode(reinterpret_cast<void *>(cursor->Start)
+            , reinterpret_cast<void *>(cursor->End));
+    }
+
+    return HandleResult::Okay;
+}
+
+Handle Beelzebub::PatchStringFunctions()
+{
+    uintptr_t features = 0;
+
+    if (BootstrapCpuid.CheckFeature(CpuFeature::ERMS))
+        features |= StringFeatureErms;
+    if (BootstrapCpuid.CheckFeature(CpuFeature::FSRM))
+        features |= StringFeatureFsrm;
+
+    if (features == (StringFeatureErms | StringFeatureFsrm)
+        || &string_patches_start == &string_patches_end)
+        return HandleResult::Okay;
+    //  Every jump stays.
+
+    return PatchKernelCode(&TurnUnsupportedSitesIntoNoOps, reinterpret_cast<void *>(features));
+}
@@ -38,6 +38,7 @@
 */
 
 #include "system/acpi.hpp"
+#include "system/numa.hpp"
 #include "memory/vmm.hpp"
 #include "memory/vmm.arc.hpp"
 #include "entry.h"
@@ -61,6 +62,9 @@ SystemDescriptorTableSource MadtSrc   = SystemDescriptorTableSource::None;
 paddr_t                     SratPaddr = nullpaddr;
 SystemDescriptorTableSource SratSrc   = SystemDescriptorTableSource::None;
 
+paddr_t                     SlitPaddr = nullpaddr;
+SystemDescriptorTableSource SlitSrc   = SystemDescriptorTableSource::None;
+
 /*****************
     ACPI class
 *****************/
@@ -72,6 +76,7 @@ acpi_table_rsdt * Acpi::RsdtPointer = nullptr;
 acpi_table_xsdt * Acpi::XsdtPointer = nullptr;
 acpi_table_madt * Acpi::MadtPointer = nullptr;
 acpi_table_srat * Acpi::SratPointer = nullptr;
+acpi_table_slit * Acpi::SlitPointer = nullptr;
 
 size_t Acpi::LapicCount = 0;
 size_t Acpi::PresentLapicCount = 0;
@@ -117,6 +122,16 @@ Handle Acpi::Crawl()
         return res;
     }
 
+    res = ParseAffinities();
+
+    assert_or(res.IsOkayResult()
+        , "Failure parsing the system resource affinities!%n"
+          "Result = %H"
+        , res)
+    {
+        return res;
+    }
+
     return res;
 }
 
@@ -166,12 +181,15 @@ Handle Acpi::Remap()
     RsdpPointer = RsdpPtr(reinterpret_cast<acpi_table_rsdp *>(reinterpret_cast<uintptr_t>(RsdpPointer.GetInvariantValue()) + VmmArc::IsaDmaStart));
 
     #define REMAP(ptr) \
-    ptr = reinterpret_cast<decltype(ptr)>(reinterpret_cast<uintptr_t>(ptr) - RangeBottom.Value + VirtualBase.Value);
+    if (ptr != nullptr) \
+        ptr = reinterpret_cast<decltype(ptr)>(reinterpret_cast<uintptr_t>(ptr) - RangeBottom.Value + VirtualBase.Value);
+    //  Absent tables must stay null.
 
     REMAP(RsdtPointer)
     REMAP(XsdtPointer)
     REMAP(MadtPointer)
     REMAP(SratPointer)
+    REMAP(SlitPointer)
 
     #undef REMAP
 
@@ -416,6 +434,8 @@ Handle Acpi::HandleSystemDescriptorTable(paddr_t const paddr, SystemDescriptorTa
         return Acpi::HandleMadt(paddr, src);
     else if (::memeq(headerPtr->Signature, ACPI_SIG_SRAT, ACPI_NAME_SIZE))
         return Acpi::HandleSrat(paddr, src);
+    else if (::memeq(headerPtr->Signature, ACPI_SIG_SLIT, ACPI_NAME_SIZE))
+        return Acpi::HandleSlit(paddr, src);
     // else
     //     MSG("$ Found unknown ACPI table: %S%n", ACPI_NAME_SIZE, headerPtr->Signature);
 
@@ -506,6 +526,116 @@ Handle Acpi::HandleSrat(paddr_t const paddr, SystemDescriptorTableSource const s
     return HandleResult::Okay;
 }
 
+Handle Acpi::HandleSlit(paddr_t const paddr, SystemDescriptorTableSource const src)
+{
+    if (SlitPaddr == paddr || (SlitSrc != src && SlitSrc != SystemDescriptorTableSource::None))
+        return HandleResult::Okay;
+
+    assert_or(SlitPointer == nullptr
+        , "Duplicate (different) SLITs found under the same table (%s)?!%n"
+          "First @ %Xp (%XP);%n"
+          "Second @ %XP."
+        , (src == SystemDescriptorTableSource::Xsdt) ? ACPI_SIG_XSDT : ACPI_SIG_RSDT
+        , SlitPointer, SlitPaddr, paddr)
+    {
+        return HandleResult::CardinalityViolation;
+    }
+
+    SlitPointer = (acpi_table_slit *)(uintptr_t)paddr;
+    SlitPaddr = paddr;
+    SlitSrc = src;
+
+    return HandleResult::Okay;
+}
+
+Handle Acpi::ParseAffinities()
+{
+    //  The SLIT refers to proximity domains, which are only known after the
+    //  SRAT is parsed, and the two may be found in any order. Hence this runs
+    //  after all the tables have been found.
+
+    Handle res;
+
+    if (SratPointer != nullptr)
+    {
+        uintptr_t sratEnd = (uintptr_t)SratPointer + SratPointer->Header.Length;
+        uintptr_t e = (uintptr_t)SratPointer + sizeof(*SratPointer);
+        for (/* nothing */; e < sratEnd; e += ((acpi_subtable_header *)e)->Length)
+        {
+            res = HandleResult::Okay;
+
+            switch (((acpi_subtable_header *)e)->Type)
+            {
+            case ACPI_SRAT_TYPE_CPU_AFFINITY:
+                {
+                    auto cpu = (acpi_srat_cpu_affinity *)e;
+
+                    if (0 == (ACPI_SRAT_CPU_USE_AFFINITY & cpu->Flags))
+                        break;
+
+                    uint32_t const domain = cpu->ProximityDomainLo
+                        | ((uint32_t)cpu->ProximityDomainHi[0] << 8)
+                        | ((uint32_t)cpu->ProximityDomainHi[1] << 16)
+                        | ((uint32_t)cpu->ProximityDomainHi[2] << 24);
+
+                    res = Numa::AddProcessor(domain, cpu->ApicId);
+                }
+                break;
+
+            case ACPI_SRAT_TYPE_X2APIC_CPU_AFFINITY:
+                {
+                    auto cpu = (acpi_srat_x2apic_cpu_affinity *)e;
+
+                    if (0 == (ACPI_SRAT_CPU_ENABLED & cpu->Flags))
+                        break;
+
+                    res = Numa::AddProcessor(cpu->ProximityDomain, cpu->ApicId);
+                }
+                break;
+
+            case ACPI_SRAT_TYPE_MEMORY_AFFINITY:
+                {
+                    auto mem = (acpi_srat_mem_affinity *)e;
+
+                    if (0 == (ACPI_SRAT_MEM_ENABLED & mem->Flags) || mem->Length == 0)
+                        break;
+
+                    res = Numa::AddMemoryRange(mem->ProximityDomain
+                        , paddr_t(mem->BaseAddress), psize_t(mem->Length));
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            assert_or(res.IsOkayResult()
+                , "Failed to register SRAT entry of type %u1: %H%n"
+                , ((acpi_subtable_header *)e)->Type, res)
+            {
+                res = HandleResult::Okay;
+            }
+            //  Running out of room for nodes isn't fatal; the surplus is
+            //  simply attributed to node 0.
+        }
+    }
+
+    if (SlitPointer != nullptr)
+    {
+        uint64_t const count = SlitPointer->LocalityCount;
+
+        if likely(offsetof(acpi_table_slit, Entry) + count * count <= SlitPointer->Header.Length)
+            for (uint64_t i = 0; i < count; ++i)
+                for (uint64_t j = 0; j < count; ++j)
+                    Numa::SetDistance((uint32_t)i, (uint32_t)j, SlitPointer->Entry[i * count + j]);
+        //  Unknown domains are ignored by the NUMA manager.
+    }
+
+    Numa::Finalize();
+
+    return HandleResult::Okay;
+}
+
 /*  Utilities  */
 
 Handle Acpi::FindLapicPaddr(paddr_t & paddr)
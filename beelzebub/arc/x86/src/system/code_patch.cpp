@@ -38,11 +38,21 @@
 */
 
 #include <system/code_patch.hpp>
+#include <system/cpu_instructions.hpp>
+#include <system/cpuid.hpp>
+#include <memory/vmm.hpp>
+#include <math.h>
 #include <string.h>
 
+#include <debug.hpp>
+
 using namespace Beelzebub;
+using namespace Beelzebub::Memory;
 using namespace Beelzebub::System;
 
+__extern long const kernel_mapping_start;
+__extern long const kernel_mapping_end;
+
 static uint8_t const Nop1[] = {0x90};
 static uint8_t const Nop2[] = {0x66, 0x90};
 static uint8_t const Nop3[] = {0x0F, 0x1F, 0x00};
@@ -134,3 +144,76 @@ bool System::TurnIntoNoOp(void * start, void * end, bool useJump)
 
     return true;
 }
+
+Handle System::PatchKernelCode(Handle (* patcher)(void * cookie), void * cookie)
+{
+    InterruptGuard<false> intGuard;
+
+    Handle res;
+
+    //  Step 1 is backing up the flags of all the pages, and making them
+    //  writable, if they were not already.
+
+    size_t const kernel_size = RoundUp(reinterpret_cast<uintptr_t>(&kernel_mapping_end) - reinterpret_cast<uintptr_t>(&kernel_mapping_start), PageSize.Value);
+    size_t const kernel_page_count = kernel_size / PageSize.Value;
+
+    msg("Kernel start @ %Xp, end @ %Xp, size %us, page count %us."
+        , &kernel_mapping_start, &kernel_mapping_end
+        , kernel_size, kernel_page_count);
+
+    __extension__ MemoryFlags flags[kernel_page_count] {};
+
+    for (size_t pageInd = 0; pageInd < kernel_page_count; ++pageInd)
+    {
+        vaddr_t const vaddr = vaddr_t(&kernel_mapping_start) + pageInd * PageSize;
+
+        res = Vmm::GetPageFlags(nullptr, vaddr, flags[pageInd]);
+
+        assert_or(res.IsOkayResult()
+            , "Failed to retrieve flags of page %Xp for code patching: %H"
+            , vaddr, res)
+        {
+            return res;
+        }
+
+        res = Vmm::SetPageFlags(nullptr, vaddr, MemoryFlags::Writable | flags[pageInd]);
+
+        assert_or(res.IsOkayResult()
+            , "Failed to apply flags to page %Xp for code patching: %H"
+            , vaddr, res)
+        {
+            return res;
+        }
+    }
+
+    //  Step 2 is performing the actual code patches.
+
+    Handle const patchRes = patcher(cookie);
+
+    //  And step 3 is restoring the page flags, whether patching worked or not.
+
+    for (size_t pageInd = 0; pageInd < kernel_page_count; ++pageInd)
+    {
+        vaddr_t const vaddr = vaddr_t(&kernel_mapping_start) + pageInd * PageSize;
+
+        res = Vmm::SetPageFlags(nullptr, vaddr, flags[pageInd]);
+
+        assert_or(res.IsOkayResult()
+            , "Failed to restore flags to page %Xp after code patching: %H"
+            , vaddr, res)
+        {
+            return res;
+        }
+    }
+
+    return patchRes;
+}
+
+void System::FlushPatchedCode(void * start, void * end)
+{
+    size_t const cacheLineSize = BootstrapCpuid.GetClflushLineSize();
+
+    for (uintptr_t i = RoundDown(reinterpret_cast<uintptr_t>(start), cacheLineSize); i < reinterpret_cast<uintptr_t>(end); i += cacheLineSize)
+        CpuInstructions::FlushCache(reinterpret_cast<void *>(i));
+    //  The cache ought to be flushed, just to be on the safe side.
+}
@@ -88,6 +88,14 @@ void CpuId::Initialize()
     Execute(0x00000001U, this->VersionInformation, this->FeatureFlagsStandardB
                        , this->FeatureIntegers[1], this->FeatureIntegers[0]);
 
+    if (this->MaxStandardValue >= 0x00000007U)
+    {
+        //  Find the structured extended feature flags.
+        Execute(0x00000007U, 0U
+            , dummy, this->FeatureIntegers[5]
+            , dummy, this->FeatureIntegers[6]);
+    }
+
     //  Find the extended feature flags.
     Execute(0x80000001U, this->ExtendedSignature, this->FeatureFlagsExtendedB
                        , this->FeatureFlagsExtendedC, this->FeatureIntegers[2]);
@@ -0,0 +1,217 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <system/numa.hpp>
+#include <memory/enums.hpp>
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::System;
+
+static_assert(Numa::MaxNodes <= Memory::PreferableNodes
+    , "Every NUMA node must be expressible in memory allocation options.");
+
+/*  For internal use  */
+
+struct NumaMemoryRange
+{
+    paddr_t Start, End;
+    uint32_t Node;
+};
+
+struct NumaProcessor
+{
+    uint32_t ApicId;
+    uint32_t Node;
+};
+
+static uint32_t Domains[Numa::MaxNodes];
+//  Proximity domain of each node.
+
+static NumaMemoryRange MemoryRanges[Numa::MaxMemoryRanges];
+static size_t MemoryRangeCount = 0;
+
+static NumaProcessor Processors[Numa::MaxProcessors];
+static size_t ProcessorCount = 0;
+
+static uint8_t Distances[Numa::MaxNodes][Numa::MaxNodes];
+static uint32_t FallbackOrders[Numa::MaxNodes][Numa::MaxNodes];
+
+static uint32_t DomainCount = 0;
+
+static __startup uint32_t GetDomainNode(uint32_t const domain, bool const add)
+{
+    for (uint32_t i = 0; i < DomainCount; ++i)
+        if (Domains[i] == domain)
+            return i;
+
+    if (!add || DomainCount == Numa::MaxNodes)
+        return Numa::MaxNodes;
+
+    Domains[DomainCount] = domain;
+
+    return DomainCount++;
+}
+
+/*****************
+    Numa class
+*****************/
+
+/*  Statics  */
+
+uint32_t Numa::NodeCount = 1;
+
+/*  Initialization  */
+
+Handle Numa::AddMemoryRange(uint32_t domain, paddr_t start, psize_t size)
+{
+    uint32_t const node = GetDomainNode(domain, true);
+
+    if unlikely(node == MaxNodes || MemoryRangeCount == MaxMemoryRanges)
+        return HandleResult::OutOfMemory;
+
+    size_t i = MemoryRangeCount++;
+
+    for (/* nothing */; i > 0 && MemoryRanges[i - 1].Start > start; --i)
+        MemoryRanges[i] = MemoryRanges[i - 1];
+    //  Kept sorted by start address.
+
+    MemoryRanges[i] = { start, start + size, node };
+
+    return HandleResult::Okay;
+}
+
+Handle Numa::AddProcessor(uint32_t domain, uint32_t apicId)
+{
+    uint32_t const node = GetDomainNode(domain, true);
+
+    if unlikely(node == MaxNodes || ProcessorCount == MaxProcessors)
+        return HandleResult::OutOfMemory;
+
+    Processors[ProcessorCount++] = { apicId, node };
+
+    return HandleResult::Okay;
+}
+
+Handle Numa::SetDistance(uint32_t fromDomain, uint32_t toDomain, uint8_t distance)
+{
+    uint32_t const from = GetDomainNode(fromDomain, false), to = GetDomainNode(toDomain, false);
+
+    if unlikely(from == MaxNodes || to == MaxNodes)
+        return HandleResult::NotFound;
+    //  Distances to domains without processors or memory are meaningless.
+
+    Distances[from][to] = distance;
+
+    return HandleResult::Okay;
+}
+
+void Numa::Finalize()
+{
+    NodeCount = DomainCount > 0 ? DomainCount : 1;
+
+    for (uint32_t i = 0; i < NodeCount; ++i)
+    {
+        for (uint32_t j = 0; j < NodeCount; ++j)
+            if (i == j ? Distances[i][j] != LocalDistance : Distances[i][j] <= LocalDistance)
+                Distances[i][j] = (i == j) ? LocalDistance : RemoteDistance;
+        //  Missing or nonsensical distances (which the SLIT forbids) are replaced
+        //  with the defaults.
+
+        for (uint32_t j = 0, k; j < NodeCount; ++j)
+        {
+            for (k = j; k > 0 && Distances[i][FallbackOrders[i][k - 1]] > Distances[i][j]; --k)
+                FallbackOrders[i][k] = FallbackOrders[i][k - 1];
+
+            FallbackOrders[i][k] = j;
+        }
+        //  Stable insertion sort, so equidistant nodes stay in index order and
+        //  the node itself comes first.
+    }
+}
+
+/*  Queries  */
+
+uint32_t Numa::GetAddressNode(paddr_t addr, paddr_t & rangeEnd)
+{
+    for (size_t i = 0; i < MemoryRangeCount; ++i)
+    {
+        if (addr < MemoryRanges[i].Start)
+        {
+            rangeEnd = MemoryRanges[i].Start;
+
+            return 0;
+        }
+
+        if (addr < MemoryRanges[i].End)
+        {
+            rangeEnd = MemoryRanges[i].End;
+
+            return MemoryRanges[i].Node;
+        }
+    }
+
+    rangeEnd = paddr_t(~(paddr_inner_t)0);
+
+    return 0;
+}
+
+uint32_t Numa::GetProcessorNode(uint32_t apicId)
+{
+    for (size_t i = 0; i < ProcessorCount; ++i)
+        if (Processors[i].ApicId == apicId)
+            return Processors[i].Node;
+
+    return 0;
+}
+
+uint8_t Numa::GetDistance(uint32_t from, uint32_t to)
+{
+    assert(from < NodeCount && to < NodeCount)(from)(to)(NodeCount);
+
+    return Distances[from][to];
+}
+
+uint32_t const * Numa::GetFallbackOrder(uint32_t node)
+{
+    assert(node < NodeCount)(node)(NodeCount);
+
+    return FallbackOrders[node];
+}
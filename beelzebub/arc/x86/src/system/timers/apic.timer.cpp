@@ -260,6 +260,23 @@ uint32_t ApicTimer::GetCount()
     return Lapic::ReadRegister(LapicRegister::TimerCurrentCount);
 }
 
+void ApicTimer::DeadlineMode(uint8_t interrupt, bool mask)
+{
+    Lapic::WriteTimerLvt(ApicTimerLvt(0)
+        .SetVector(interrupt)
+        .SetMode(ApicTimerMode::TscDeadline)
+        .SetMask(mask));
+
+    asm volatile ( "mfence \n\t" : : : "memory" );
+    //  The LVT write must be ordered before any write to the deadline MSR.
+}
+
+void ApicTimer::SetDeadline(uint64_t tsc)
+{
+    Msrs::Write(Msr::IA32_TSC_DEADLINE, tsc);
+    //  A deadline of 0 disarms the timer.
+}
+
 void ApicTimer::Stop()
 {
     Lapic::WriteRegister(LapicRegister::TimerInitialCount, 0);
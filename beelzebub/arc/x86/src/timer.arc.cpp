@@ -39,15 +39,21 @@
 
 #include "timer.hpp"
 #include "irqs.hpp"
+#include "scheduler.hpp"
 #include "system/timers/apic.timer.hpp"
 #include "system/interrupt_controllers/lapic.hpp"
+#include "system/cpu.hpp"
 #include "system/cpuid.hpp"
+#include <memory/object_allocator_smp.hpp>
+#include <memory/object_allocator_pools_heap.hpp>
 #include <beel/sync/smp.lock.hpp>
-#include <string.h>
+#include <beel/interrupt.state.hpp>
+#include <new>
 
 #include <debug.hpp>
 
 using namespace Beelzebub;
+using namespace Beelzebub::Memory;
 using namespace Beelzebub::Synchronization;
 using namespace Beelzebub::System;
 using namespace Beelzebub::System::InterruptControllers;
@@ -57,49 +63,288 @@ using namespace Beelzebub::System::Timers;
     Internals
 ****************/
 
-struct TimerEntry
+//  Every core has a hierarchical timing wheel. Time is measured in units of
+//  a power-of-two number of TSC counts, at most a microsecond long. Level 0
+//  has a slot for each unit, and every level above has slots as long as the
+//  whole level beneath. A timer is kept on the lowest level whose span around
+//  the current time covers its expiry, and moves down ("cascades") when the
+//  wheel reaches its slot. Timers past the last level are kept aside until
+//  the wheel catches up with them.
+
+static constexpr unsigned int const LevelBits = 6;
+static constexpr unsigned int const LevelCount = 6;
+static constexpr unsigned int const SlotCount = 1U << LevelBits;
+static constexpr uint64_t const SlotMask = SlotCount - 1;
+static constexpr uint64_t const Never = ~(uint64_t)0;
+
+struct TimerWheel;
+
+namespace Beelzebub
 {
-    TimedFunctionVoid Function;
-    void * Cookie;
-    uint32_t Time;
+    struct TimerEntry
+    {
+        TimerEntry * Next;
+        TimerEntry ** Link;
+        //  Whatever points to this entry while it is armed.
+        TimerWheel * Wheel;
+        //  Null while the entry is not armed.
+        uint64_t Sequence;
+        uint64_t Expiry;
+        //  In wheel units.
+        TimedFunctionVoid Function;
+        void * Cookie;
+        unsigned int Level, Slot;
+    };
+}
+
+struct TimerWheel
+{
+    SmpLock * Lock;
+    size_t Count;
+    uint64_t Now;
+    //  Every unit before this one has been processed.
+    uint64_t Deadline;
+    //  Unit at which the timer interrupt is armed to fire.
+    uint64_t Occupied[LevelCount];
+    TimerEntry * Slots[LevelCount][SlotCount];
+    TimerEntry * Far;
 };
 
-static __thread uint_fast16_t MyTimersCount = 0;
-static __thread TimerEntry MyTimers[Timer::Count];
+static __thread TimerWheel MyWheel;
+static __thread TimerEntry * MyFreeEntries;
+static SmpLock WheelLocks[Scheduler::MaximumCPUs];
 
-static __hot void TimerIrqHandler(InterruptContext const * context, void * cookie)
+static ObjectAllocatorSmp EntryAllocator;
+//  Entries are recycled by the cores but never returned to the allocator, so
+//  a stale timer identifier always points to a valid entry.
+
+static unsigned int UnitShift;
+
+static __forceinline uint64_t GetTime()
 {
-    (void)context;
-    (void)cookie;
+    return CpuInstructions::Rdtsc() >> UnitShift;
+}
+
+static __hot TimerEntry * AllocateEntry()
+{
+    TimerEntry * res = MyFreeEntries;
+
+    if likely(res != nullptr)
+    {
+        MyFreeEntries = res->Next;
 
-    auto timersCount = MyTimersCount;
+        return res;
+    }
+
+    if unlikely(!EntryAllocator.AllocateObject(res).IsOkayResult())
+        return nullptr;
+
+    res->Wheel = nullptr;
+    res->Sequence = 0;
+
+    return res;
+}
+
+static __hot void FreeEntry(TimerEntry * entry)
+{
+    entry->Next = MyFreeEntries;
+    MyFreeEntries = entry;
+}
+
+/*  Wheel Operations  */
 
-    if likely(timersCount > 0)
+static __hot void Place(TimerWheel * wheel, TimerEntry * entry)
+{
+    uint64_t const diff = entry->Expiry ^ wheel->Now;
+    unsigned int const level = (diff == 0) ? 0 : (63 - __builtin_clzll(diff)) / LevelBits;
+    TimerEntry ** head;
+
+    if likely(level < LevelCount)
     {
-        TimerEntry const entry = MyTimers[0];
+        unsigned int const slot = (entry->Expiry >> (level * LevelBits)) & SlotMask;
+
+        head = &(wheel->Slots[level][slot]);
+        wheel->Occupied[level] |= 1ULL << slot;
+
+        entry->Slot = slot;
+    }
+    else
+        head = &(wheel->Far);
+
+    entry->Level = level;
+
+    if ((entry->Next = *head) != nullptr)
+        entry->Next->Link = &(entry->Next);
+
+    *head = entry;
+    entry->Link = head;
+}
+
+static __hot void Unlink(TimerWheel * wheel, TimerEntry * entry)
+{
+    if ((*(entry->Link) = entry->Next) != nullptr)
+        entry->Next->Link = entry->Link;
+
+    if (entry->Level < LevelCount && wheel->Slots[entry->Level][entry->Slot] == nullptr)
+        wheel->Occupied[entry->Level] &= ~(1ULL << entry->Slot);
+
+    entry->Link = nullptr;
+}
+
+static __hot uint64_t GetNextEvent(TimerWheel const * wheel, unsigned int & level)
+{
+    //  Finds the earliest unit at which a slot expires or needs to cascade.
+    //  Lower levels always come first, as their timers are within the span of
+    //  the current slots of the upper levels.
+
+    uint64_t const now = wheel->Now;
+
+    for (level = 0; level < LevelCount; ++level)
+    {
+        unsigned int const shift = level * LevelBits;
+        uint64_t const pending = wheel->Occupied[level] & (~0ULL << ((now >> shift) & SlotMask));
+
+        if (pending != 0)
+            return ((now >> (shift + LevelBits)) << (shift + LevelBits))
+                 + ((uint64_t)__builtin_ctzll(pending) << shift);
+    }
+
+    if (wheel->Far != nullptr)
+        return ((now >> (LevelCount * LevelBits)) + 1) << (LevelCount * LevelBits);
+
+    return Never;
+}
+
+static __hot TimerEntry * Advance(TimerWheel * wheel, uint64_t const time)
+{
+    //  Processes the wheel up to the given time, and returns the list of
+    //  expired entries, in order.
+
+    TimerEntry * expired = nullptr, ** tail = &expired;
+    unsigned int level;
+    uint64_t when;
+
+    while ((when = GetNextEvent(wheel, level)) <= time)
+    {
+        if (when > wheel->Now)
+            wheel->Now = when;
+
+        TimerEntry * list;
+
+        if (level < LevelCount)
+        {
+            unsigned int const slot = (when >> (level * LevelBits)) & SlotMask;
+
+            list = wheel->Slots[level][slot];
+            wheel->Slots[level][slot] = nullptr;
+            wheel->Occupied[level] &= ~(1ULL << slot);
+        }
+        else
+        {
+            list = wheel->Far;
+            wheel->Far = nullptr;
+        }
+
+        if (level == 0)
+        {
+            for (TimerEntry * cur = list; cur != nullptr; cur = cur->Next)
+            {
+                cur->Link = nullptr;
+                __atomic_store_n(&(cur->Wheel), nullptr, __ATOMIC_RELEASE);
+
+                --wheel->Count;
+            }
+
+            *tail = list;
 
-        MyTimersCount = --timersCount;
-        //  First timer is popped.
+            while (*tail != nullptr)
+                tail = &((*tail)->Next);
 
-        if (timersCount > 0)
+            wheel->Now = when + 1;
+        }
+        else while (list != nullptr)
         {
-            memmove(&(MyTimers[0]), &(MyTimers[1]), timersCount * sizeof(TimerEntry));
-            //  Shifts the remaining items.
+            TimerEntry * const next = list->Next;
 
-            uint32_t next = MyTimers[0].Time;
+            Place(wheel, list);
+            //  Lands on a lower level now.
 
-            if unlikely(next == 0)
-                next = 1;
+            list = next;
+        }
+    }
 
-            ApicTimer::SetCount(next);
+    return expired;
+}
 
-            //  It is VITAL that the timer is used again to guarantee that the
-            //  function runs on the same core again, because the function could
-            //  enable interrupts and get pre-empted or something, and end up
-            //  finishing the interrupt on another core.
+static __hot void Program(TimerWheel * wheel)
+{
+    unsigned int level;
+    uint64_t const when = GetNextEvent(wheel, level);
+
+    if (when == wheel->Deadline)
+        return;
+
+    wheel->Deadline = when;
+
+    if (ApicTimer::TscDeadline)
+        ApicTimer::SetDeadline(when == Never ? 0 : (when << UnitShift));
+    else if (when == Never)
+        ApicTimer::Stop();
+    else
+    {
+        //  Distant deadlines make the timer fire early, to no effect but to
+        //  be armed again.
+
+        uint64_t const target = when << UnitShift, now = CpuInstructions::Rdtsc();
+        uint64_t ticks = 1;
+
+        if (target > now)
+        {
+            uint64_t const micros = (target - now) / ApicTimer::CountsPerMicrosecond;
+
+            ticks = (micros >= 0xFFFFFFFFULL / ApicTimer::TicksPerMicrosecond)
+                ? 0xFFFFFFFFULL
+                : micros * ApicTimer::TicksPerMicrosecond + 1;
         }
 
-        return entry.Function(entry.Cookie);
+        ApicTimer::SetCount((uint32_t)ticks);
+    }
+}
+
+static __hot void TimerIrqHandler(InterruptContext const * context, void * cookie)
+{
+    (void)context;
+    (void)cookie;
+
+    TimerWheel * const wheel = &MyWheel;
+    TimerEntry * expired;
+
+    wheel->Lock->Acquire();
+
+    wheel->Deadline = Never;
+    //  Whatever was armed has fired.
+
+    expired = Advance(wheel, GetTime());
+
+    Program(wheel);
+    //  It is VITAL that the timer is armed again before running the functions,
+    //  because they could enable interrupts and get pre-empted or something,
+    //  and end up finishing the interrupt on another core.
+
+    wheel->Lock->Release();
+
+    while (expired != nullptr)
+    {
+        TimerEntry * const entry = expired;
+        TimedFunctionVoid const func = entry->Function;
+        void * const funcCookie = entry->Cookie;
+
+        expired = entry->Next;
+
+        FreeEntry(entry);
+        //  Freed first, so functions which enqueue a new timer reuse it.
+
+        func(funcCookie);
     }
 }
 
@@ -116,9 +361,14 @@ static InterruptHandlerNode ApicTimerNode { &TimerIrqHandler, nullptr, Irqs::Hig
 
 void Timer::Initialize()
 {
-    MyTimersCount = 0;
+    MyWheel.Lock = WheelLocks + Cpu::GetData()->Index;
+    MyWheel.Count = 0;
+    MyWheel.Deadline = Never;
 
-    ApicTimer::OneShot(0, (uint8_t)Irqs::ApicTimer.Value, false);
+    if (ApicTimer::TscDeadline)
+        ApicTimer::DeadlineMode((uint8_t)Irqs::ApicTimer.Value, false);
+    else
+        ApicTimer::OneShot(0, (uint8_t)Irqs::ApicTimer.Value, false);
 
     //  A lock is used here because this code must only be executed once, and
     //  other cores should wait for it to finish.
@@ -129,6 +379,14 @@ void Timer::Initialize()
             return;
 
         Initialized = true;
+
+        UnitShift = (ApicTimer::CountsPerMicrosecond > 1)
+            ? 63 - __builtin_clzll(ApicTimer::CountsPerMicrosecond)
+            : 0;
+        //  Units are never longer than a microsecond.
+
+        new (&EntryAllocator) ObjectAllocatorSmp(sizeof(TimerEntry), __alignof(TimerEntry)
+            , &AcquirePoolInKernelHeap, &EnlargePoolInKernelHeap, &ReleasePoolFromKernelHeap);
     }
 
     ASSERT(ApicTimerNode.Subscribe(Irqs::ApicTimer) == IrqSubscribeResult::Success);
@@ -140,76 +398,105 @@ void Timer::Initialize()
 
 /*  Operation  */
 
-bool Timer::Enqueue(TimeSpanLite delay, TimedFunctionVoid func, void * cookie)
+TimeInstantLite Timer::Now()
 {
-    uint64_t ticks = delay.Value * ApicTimer::TicksPerMicrosecond;
+    if unlikely(ApicTimer::CountsPerMicrosecond == 0)
+        return TimeInstantLite();
+    //  Not calibrated yet.
 
-    if unlikely(ticks == 0)
-        ticks = 1;
+    return TimeInstantLite(CpuInstructions::Rdtsc() / ApicTimer::CountsPerMicrosecond);
+}
+
+bool Timer::Enqueue(TimeSpanLite delay, TimedFunctionVoid func, void * cookie, TimerId * id)
+{
+    uint64_t units = (delay.Value < Never / ApicTimer::CountsPerMicrosecond)
+        ? (delay.Value * ApicTimer::CountsPerMicrosecond) >> UnitShift
+        : Never;
+
+    if unlikely(units == 0)
+        units = 1;
 
     InterruptGuard<> intGuard;
 
-    uint_fast16_t timersCount = MyTimersCount;
+    TimerEntry * const entry = AllocateEntry();
 
-    if unlikely(timersCount == Timer::Count)
-    {
-        MSG_("Too many timers!%n");
+    if unlikely(entry == nullptr)
         return false;
-    }
 
-    if likely(timersCount > 0)
+    entry->Function = func;
+    entry->Cookie = cookie;
+
+    TimerWheel * const wheel = &MyWheel;
+
+    wheel->Lock->Acquire();
+
+    uint64_t const now = GetTime();
+
+    if (wheel->Count++ == 0 && now > wheel->Now)
+        wheel->Now = now;
+    //  An empty wheel skips ahead right away, instead of cascading through all
+    //  the time it spent idle.
+
+    entry->Expiry = (units < Never - now) ? now + units : Never - 1;
+
+    if unlikely(entry->Expiry < wheel->Now)
+        entry->Expiry = wheel->Now;
+    entry->Sequence++;
+    __atomic_store_n(&(entry->Wheel), wheel, __ATOMIC_RELEASE);
+
+    Place(wheel, entry);
+
+    if (id != nullptr)
     {
-        //  If there are some timers already queued, the full algorithm needs to
-        //  be employed.
+        id->Entry = entry;
+        id->Sequence = entry->Sequence;
+    }
 
-        ticks += MyTimers[0].Time - ApicTimer::GetCount();
-        //  Add the already-elapsed time to the target time.
+    unsigned int level;
 
-        uint64_t lastTicks = 0;
-        unsigned int i = 0;
+    if (GetNextEvent(wheel, level) < wheel->Deadline)
+        Program(wheel);
 
-        for (uint64_t acc = 0; i < timersCount && (acc += MyTimers[i].Time) <= ticks; ++i)
-            lastTicks = acc;
+    wheel->Lock->Release();
 
-        if unlikely(ticks - lastTicks > 0xFFFFFFFFULL)
-            return false;
-        //  Difference is too large.
+    return true;
+}
 
-        uint32_t diff = (uint32_t)(ticks - lastTicks);
+bool Timer::Cancel(TimerId const & id)
+{
+    TimerEntry * const entry = id.Entry;
 
-        if (i < timersCount)
-        {
-            ::memmove(&(MyTimers[i + 1]), &(MyTimers[i]), (timersCount - i) * sizeof(TimerEntry));
-            //  Shift forward the elements after the insertion point.
+    if unlikely(entry == nullptr)
+        return false;
 
-            MyTimers[i + 1].Time -= diff;
-            //  Adjust timer after insertion point.
-        }
+    InterruptGuard<> intGuard;
+
+    TimerWheel * const wheel = __atomic_load_n(&(entry->Wheel), __ATOMIC_ACQUIRE);
 
-        if (i == 0)
-            ApicTimer::SetCount(diff);
+    if (wheel == nullptr)
+        return false;
+    //  Expired or cancelled already.
 
-        MyTimers[i].Time = diff;
-        MyTimers[i].Function = func;
-        MyTimers[i].Cookie = cookie;
+    bool cancelled = false;
 
-        ++MyTimersCount;
-    }
-    else
+    wheel->Lock->Acquire();
+
+    if (entry->Wheel == wheel && entry->Sequence == id.Sequence)
     {
-        //  No timers means a simple insertion at the first position.
+        Unlink(wheel, entry);
 
-        if unlikely(ticks > 0xFFFFFFFFULL)
-            return false;
+        entry->Wheel = nullptr;
+        --wheel->Count;
 
-        ApicTimer::SetCount((uint32_t)ticks);
+        cancelled = true;
+    }
+    //  Otherwise, the entry was reused since.
 
-        MyTimers[0].Time = (uint32_t)ticks;
-        MyTimers[0].Function = func;
-        MyTimers[0].Cookie = cookie;
+    wheel->Lock->Release();
 
-        MyTimersCount = 1;
-    }
+    if (cancelled)
+        FreeEntry(entry);
+    //  The wheel's interrupt may still fire at the old deadline, doing nothing.
 
-    return true;
+    return cancelled;
 }
@@ -99,6 +99,18 @@
 #include "tests/malloc.hpp"
 #endif
 
+#if defined(__BEELZEBUB__TEST_SCHED) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+#include "tests/sched.hpp"
+#endif
+
+#if defined(__BEELZEBUB__TEST_HANDLES) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+#include "tests/handle.table.hpp"
+#endif
+
+#ifdef __BEELZEBUB__TEST_RCU
+#include "tests/rcu.hpp"
+#endif
+
 #ifdef __BEELZEBUB__TEST_INTERRUPT_LATENCY
 #include "tests/interrupt_latency.hpp"
 #endif
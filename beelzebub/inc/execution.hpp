@@ -50,6 +50,7 @@ namespace Beelzebub
     __startup void InitializeExecutionData();
 
     Memory::UniquePointer<Execution::Process> SpawnProcess();
+    Execution::Process * FindProcess(uint16_t id);
     Memory::UniquePointer<Execution::Thread> SpawnThread(Execution::Process * owner);
 
     static __forceinline Memory::UniquePointer<Execution::Thread> SpawnThread(Memory::LocalPointer<Execution::Process> owner)
@@ -56,6 +56,11 @@
 
 extern "C" uint8_t process_data_start;
 
+namespace Beelzebub { namespace Memory
+{
+    class Vmm;
+}}
+
 namespace Beelzebub { namespace Execution
 {
     class Thread;
@@ -93,6 +98,7 @@ namespace Beelzebub { namespace Execution
                   , public ProcessArchitecturalBase
     {
         friend class Thread;
+        friend class Memory::Vmm;
     public:
         /*  Constructors  */
 
@@ -101,6 +107,7 @@ namespace Beelzebub { namespace Execution
             , ProcessBase()
             , ProcessArchitecturalBase()
             , Id(id)
+            , Parent(nullptr)
             , Status(ProcessStatus::Constructing)
             , Name(nullptr)
             , ActiveCoreCount(0)
@@ -123,6 +130,9 @@ namespace Beelzebub { namespace Execution
 
         uint16_t const Id;
 
+        Process * Parent;
+        //  The process which spawned this one, if any.
+
         /*  Operations  */
 
         ProcessStatus Status;
@@ -136,7 +146,7 @@ namespace Beelzebub { namespace Execution
 
         /*  Memory  */
 
-        Synchronization::SmpLock LocalTablesLock;
+        Synchronization::SmpQueuedLock LocalTablesLock;
 
         Synchronization::SmpLock AlienPagingTablesLock;
 
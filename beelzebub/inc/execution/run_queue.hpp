@@ -0,0 +1,346 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#include "scheduler.hpp"
+#include "timer.hpp"
+
+#include <debug.hpp>
+
+namespace Beelzebub { namespace Synchronization
+{
+    class WaitQueue;
+}}
+
+namespace Beelzebub { namespace Execution
+{
+    struct RunQueue;
+    struct RunQueueLevel;
+
+    /**
+     *  Scheduling state of a thread.
+     */
+    struct ThreadSchedulerState
+    {
+        ThreadSchedulerState * Next, * Previous;
+        RunQueue * Owner;
+        RunQueueLevel * Queue;
+        SchedulerStatus Status;
+        int Priority;
+        bool Pinned;
+        //  Pinned threads are only ever queued on one core.
+        uint64_t Ticket;
+        //  Order of insertion, used to break ties between pinned and migratable threads.
+        Scheduler::AffinityMask * Affinity;
+        //  Cores the thread may run on, owned by it and kept out of line. Null
+        //  when it may run on any core.
+        size_t LastCpu;
+        //  Index of the core which last ran this thread.
+
+        Synchronization::WaitQueue * volatile WaitingOn;
+        //  Wait queue in which a blocked thread is linked, via `Next` and `Previous`.
+        bool volatile TimedOut;
+        bool volatile TimeoutPending;
+        //  Set while a timeout handler may still be touching this thread.
+        TimerId WaitTimer;
+        //  Timer armed for the timeout of the current wait.
+    };
+
+    /**
+     *  FIFO of threads with the same priority.
+     */
+    struct RunQueueLevel
+    {
+        /*  Operations  */
+
+        inline ThreadSchedulerState * Pop(bool & empty)
+        {
+            ThreadSchedulerState * const cur = this->First;
+
+            assert(cur != nullptr);
+            assert(cur->Queue == this)((void *)cur->Queue);
+
+            if likely((this->First = cur->Next) != nullptr)
+            {
+                cur->Next->Previous = nullptr;
+                empty = false;
+            }
+            else
+            {
+                this->Last = nullptr;
+                empty = true;
+            }
+
+            cur->Queue = nullptr;
+
+            return cur;
+        }
+
+        inline void Remove(ThreadSchedulerState * cur, bool & empty)
+        {
+            assert(cur->Queue == this)((void *)cur->Queue);
+
+            if (cur->Next != nullptr)
+                cur->Next->Previous = cur->Previous;
+            else
+                this->Last = cur->Previous;
+
+            if (cur->Previous != nullptr)
+                cur->Previous->Next = cur->Next;
+            else
+                this->First = cur->Next;
+
+            empty = this->First == nullptr;
+
+            cur->Queue = nullptr;
+        }
+
+        inline void Push(ThreadSchedulerState * tsc)
+        {
+            tsc->Previous = this->Last;
+            //  tsc->Next is guaranteed to be null here.
+
+            if likely(this->Last != nullptr)
+                this->Last->Next = tsc;
+            else
+                this->First = tsc;
+
+            this->Last = tsc;
+
+            tsc->Queue = this;
+        }
+
+        /*  Fields  */
+
+        ThreadSchedulerState * First, * Last;
+    };
+
+    /**
+     *  Threads of all priorities, with a bitmap of non-empty levels.
+     */
+    struct RunQueueSet
+    {
+        static constexpr size_t const SizeShift = sizeof(size_t) == 4 ? 5 : 6;
+        static constexpr size_t const SizeMask = sizeof(size_t) * 8UL - 1UL;
+        static constexpr size_t const BitmapSize = (Scheduler::PriorityLevels + sizeof(size_t) * 8 - 1) / (sizeof(size_t) * 8);
+
+        /*  Properties  */
+
+        inline int GetHighestPriority() const
+        {
+            size_t bitmapIndex = BitmapSize;
+
+            do
+            {
+                --bitmapIndex;
+
+                if (this->Bitmap[bitmapIndex] != 0)
+                    return (int)(bitmapIndex * sizeof(size_t) * 8 + SizeMask - __builtin_clzl(this->Bitmap[bitmapIndex]));
+            } while (bitmapIndex > 0);
+
+            return -1;
+        }
+
+        inline ThreadSchedulerState * Peek(int const priority) const
+        {
+            return this->Levels[priority].First;
+        }
+
+        /*  Operations  */
+
+        inline ThreadSchedulerState * Pop(int const priority)
+        {
+            bool empty;
+
+            ThreadSchedulerState * const ret = this->Levels[priority].Pop(empty);
+
+            if unlikely(empty)
+                this->Bitmap[(priority & ~SizeMask) >> SizeShift] &= ~(1UL << (priority & SizeMask));
+
+            return ret;
+        }
+
+        /**
+         *  <summary>
+         *  Pops the highest-priority thread which may run on the given core, if
+         *  any. Takes time proportional to the number of threads skipped.
+         *  </summary>
+         */
+        inline ThreadSchedulerState * PopAllowed(size_t const cpuIndex)
+        {
+            for (int priority = this->GetHighestPriority(); priority >= 0; --priority)
+                for (ThreadSchedulerState * cur = this->Levels[priority].First; cur != nullptr; cur = cur->Next)
+                    if (cur->Affinity == nullptr || (*cur->Affinity)[cpuIndex])
+                    {
+                        this->Remove(cur);
+
+                        return cur;
+                    }
+
+            return nullptr;
+        }
+
+        inline void Remove(ThreadSchedulerState * tsc)
+        {
+            bool empty;
+            int const priority = tsc->Priority;
+
+            this->Levels[priority].Remove(tsc, empty);
+
+            if unlikely(empty)
+                this->Bitmap[(priority & ~SizeMask) >> SizeShift] &= ~(1UL << (priority & SizeMask));
+        }
+
+        inline void Push(ThreadSchedulerState * tsc)
+        {
+            int const priority = tsc->Priority;
+
+            this->Levels[priority].Push(tsc);
+            this->Bitmap[(priority & ~SizeMask) >> SizeShift] |= 1UL << (priority & SizeMask);
+        }
+
+        /*  Fields  */
+
+        size_t Bitmap[BitmapSize];
+        RunQueueLevel Levels[Scheduler::PriorityLevels];
+    };
+
+    /**
+     *  The queues of runnable threads of a single core.
+     */
+    struct RunQueue
+    {
+        /*  Constructor(s)  */
+
+        inline void Initialize(size_t const cpuIndex)
+        {
+            this->CpuIndex = cpuIndex;
+            this->Count = 0;
+            this->Tickets = 0;
+        }
+
+        /*  Properties  */
+
+        inline int GetHighestPriority() const
+        {
+            int const pinned = this->Pinned.GetHighestPriority();
+            int const migratable = this->Migratable.GetHighestPriority();
+
+            return pinned > migratable ? pinned : migratable;
+        }
+
+        /*  Operations  */
+
+        /**
+         *  <summary>
+         *  Pops the next thread which may run on the given core, in constant time
+         *  for the owning core. Other cores only get migratable threads which
+         *  their affinity allows.
+         *  </summary>
+         */
+        inline ThreadSchedulerState * Pop(size_t const cpuIndex)
+        {
+            ThreadSchedulerState * ret;
+            int const migratable = this->Migratable.GetHighestPriority();
+
+            if likely(cpuIndex == this->CpuIndex)
+            {
+                int const pinned = this->Pinned.GetHighestPriority();
+
+                if (pinned > migratable
+                    || (pinned == migratable && pinned >= 0
+                        && this->Pinned.Peek(pinned)->Ticket < this->Migratable.Peek(migratable)->Ticket))
+                    ret = this->Pinned.Pop(pinned);
+                else if (migratable >= 0)
+                    ret = this->Migratable.Pop(migratable);
+                else
+                    return nullptr;
+            }
+            else if (migratable < 0 || (ret = this->Migratable.PopAllowed(cpuIndex)) == nullptr)
+                return nullptr;
+
+            ret->Owner = nullptr;
+            ret->Next = ret->Previous = nullptr;
+
+            --this->Count;
+
+            return ret;
+        }
+
+        inline void Remove(ThreadSchedulerState * tsc)
+        {
+            assert(tsc->Owner == this)((void *)tsc->Owner);
+
+            (tsc->Pinned ? this->Pinned : this->Migratable).Remove(tsc);
+
+            tsc->Owner = nullptr;
+            tsc->Next = tsc->Previous = nullptr;
+
+            --this->Count;
+        }
+
+        inline void Push(ThreadSchedulerState * tsc)
+        {
+            assert(tsc->Priority >= 0 && tsc->Priority < Scheduler::PriorityLevels)(tsc->Priority);
+            assert(tsc->Next == nullptr)((void *)tsc->Next);
+            assert(tsc->Previous == nullptr)((void *)tsc->Previous);
+
+            tsc->Ticket = this->Tickets++;
+
+            (tsc->Pinned ? this->Pinned : this->Migratable).Push(tsc);
+
+            ++this->Count;
+
+            tsc->Owner = this;
+            tsc->Status = SchedulerStatus::Queued;
+        }
+
+        /*  Fields  */
+
+        size_t CpuIndex;
+        size_t volatile Count;
+        //  Number of queued threads; read without the lock by other cores.
+        uint64_t Tickets;
+
+        RunQueueSet Pinned, Migratable;
+    };
+}}
+
+DECLARE_THREAD_DATA(Beelzebub::Execution::ThreadSchedulerState, SchedulingData)
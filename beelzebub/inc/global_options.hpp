@@ -49,6 +49,14 @@ namespace Beelzebub
     extern CommandLineOptionSpecification CMDO_Debugger;
     extern CommandLineOptionSpecification CMDO_UnitTests;
     extern CommandLineOptionSpecification CMDO_SmpEnable;
+    extern CommandLineOptionSpecification CMDO_FrameCacheHigh;
+    extern CommandLineOptionSpecification CMDO_FrameCacheLow;
+    extern CommandLineOptionSpecification CMDO_FaultAround;
+    extern CommandLineOptionSpecification CMDO_ZeroedFrames;
+    extern CommandLineOptionSpecification CMDO_LargePages;
+    extern CommandLineOptionSpecification CMDO_HandleFreeListHigh;
+    extern CommandLineOptionSpecification CMDO_HandleFreeListBatch;
+    extern CommandLineOptionSpecification CMDO_LockStatInterval;
 
     extern CommandLineOptionSpecification * CommandLineOptionsHead;
 
@@ -44,7 +44,8 @@
  */
 #define __ENUM_HANDLETABINITRES(ENUMINST) \
     ENUMINST(Success    , 0) \
-    ENUMINST(OutOfMemory, 1)
+    ENUMINST(OutOfMemory, 1) \
+    ENUMINST(InvalidParameters, 2)
 
 __PUB_ENUM(HandleTableInitializationResult, __ENUM_HANDLETABINITRES, LITE, uint8_t)
 
@@ -55,28 +55,28 @@ namespace Beelzebub
     {
         /*  Constructor(s)  */
 
-        inline MailboxEntryLink() : Next( nullptr), Core(0) { }
+        inline MailboxEntryLink() : Next( nullptr), Core(0), Index(0) { }
 
         inline MailboxEntryLink(uint32_t core)
             : Next( nullptr)
             , Core(core)
+            , Index(0)
         {
 
         }
 
-        /*  Fields  */
+        /*  Properties  */
 
-        MailboxEntryBase * Next;
+        inline MailboxEntryBase * GetEntry() const;
 
-        union
-        {
-            uint32_t Core;
-#ifdef __BEELZEBUB_SETTINGS_MANYCORE
-            size_t Generation;
-#endif
+        /*  Fields  */
 
-            uintptr_t Padding;
-        };
+        MailboxEntryLink * Next;
+        //  Next link in the queue of the destination core.
+
+        uint32_t Core;
+        uint32_t Index;
+        //  Position of this link within its entry; set when posting.
     };
 
     struct MailboxEntryBase
@@ -123,6 +123,11 @@ namespace Beelzebub
 
     static_assert(sizeof(MailboxEntryBase) == (2 * sizeof(void *) + 2 * sizeof(unsigned int) + sizeof(size_t)), "Struct size mismatch.");
 
+    inline MailboxEntryBase * MailboxEntryLink::GetEntry() const
+    {
+        return reinterpret_cast<MailboxEntryBase *>(reinterpret_cast<uintptr_t>(this - this->Index) - sizeof(MailboxEntryBase));
+    }
+
     template<unsigned int N>
     struct MailboxEntry : public MailboxEntryBase
     {
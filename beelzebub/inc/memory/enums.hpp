@@ -82,12 +82,39 @@ namespace Beelzebub { namespace Memory
         //  No physical pages will be allocated until actually used.
         AllocateOnDemand     = 0x000000C0,
 
+        //  Writes to the pages give the writer a private copy of the frame when
+        //  it is shared with another mapping.
+        CopyOnWrite          = 0x00000100,
+
         StrategyMask         = 0x000000F0,
         UniquenessMask       = 0x0000000F,
+
+        //  The physical pages will preferably come from the NUMA node whose
+        //  index plus one is stored here. Zero means the node of the allocating
+        //  core.
+        NodeMask             = 0x7FFF0000,
     };
 
     __ENUMOPS(MemoryAllocationOptions, uint32_t)
 
+    //  Number of NUMA nodes which can be preferred in allocation options.
+    static constexpr uint32_t const PreferableNodes = (uint32_t)MemoryAllocationOptions::NodeMask >> 16;
+
+    //  Nodes which do not fit in the options yield no preference, rather than
+    //  someone else's node.
+    __forceinline constexpr MemoryAllocationOptions PreferNode(uint32_t const node)
+    {
+        return node < PreferableNodes
+            ? (MemoryAllocationOptions)((node + 1) << 16)
+            : MemoryAllocationOptions::None;
+    }
+
+    //  Yields ~0 (meaning the local node) when no node is preferred.
+    __forceinline constexpr uint32_t GetPreferredNode(MemoryAllocationOptions const opts)
+    {
+        return (((uint32_t)opts & (uint32_t)MemoryAllocationOptions::NodeMask) >> 16) - 1;
+    }
+
     /**
      *  Represents the flags related to a page fault.
      */
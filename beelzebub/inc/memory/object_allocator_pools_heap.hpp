@@ -43,6 +43,10 @@
 
 namespace Beelzebub { namespace Memory
 {
+    /// <summary>Size and alignment of pools acquired by
+    /// <see cref="AcquireAlignedPoolInKernelHeap"/>.</summary>
+    constexpr size_t const AlignedPoolSize = 16 * 1024;
+
     __noinline void FillPool(ObjectPoolBase volatile * volatile pool
                            , size_t const objectSize
                            , size_t const headerSize
@@ -61,4 +65,13 @@ namespace Beelzebub { namespace Memory
     Handle ReleasePoolFromKernelHeap(size_t objectSize
                                    , size_t headerSize
                                    , ObjectPoolBase * pool);
+
+    Handle AcquireAlignedPoolInKernelHeap(size_t objectSize
+                                        , size_t headerSize
+                                        , size_t minimumObjects
+                                        , ObjectPoolBase * & result);
+
+    Handle ReleaseAlignedPoolFromKernelHeap(size_t objectSize
+                                          , size_t headerSize
+                                          , ObjectPoolBase * pool);
 }}
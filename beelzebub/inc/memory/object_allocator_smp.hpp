@@ -62,7 +62,9 @@
         #define OBJA_ALOC_TYPE      ObjectAllocatorSmp
         #define OBJA_MULTICONSUMER  true
         #define OBJA_UNINTERRUPTED  true
+        #define OBJA_MAGAZINES      true
         #include <memory/object_allocator_hbase.inc>
+        #undef OBJA_MAGAZINES
         #undef OBJA_UNINTERRUPTED
         #undef OBJA_MULTICONSUMER
         #undef OBJA_ALOC_TYPE
@@ -54,9 +54,19 @@ namespace Beelzebub { namespace Memory
     class Pmm
     {
     public:
+        /*  Constants  */
+
+        //  Allocations prefer the NUMA node of the current core.
+        static constexpr uint32_t const LocalNode = ~0U;
+
         /*  Frame operations  */
 
-        static __hot __solid paddr_t AllocateFrame(FrameSize size = FrameSize::_4KiB, AddressMagnitude magn = AddressMagnitude::Any, uint32_t refCnt = 0);
+        //  Frames come from the given node if possible, otherwise from the
+        //  nearest node which has any.
+        static __hot __solid paddr_t AllocateFrame(FrameSize size, AddressMagnitude magn, uint32_t refCnt, uint32_t node);
+
+        static __hot __forceinline paddr_t AllocateFrame(FrameSize size = FrameSize::_4KiB, AddressMagnitude magn = AddressMagnitude::Any, uint32_t refCnt = 0)
+        { return AllocateFrame(size, magn, refCnt, LocalNode); }
 
         static __hot __forceinline paddr_t AllocateFrame(AddressMagnitude magn, FrameSize size = FrameSize::_4KiB, uint32_t refCnt = 0)
         { return AllocateFrame(size, magn, refCnt); }
@@ -44,7 +44,7 @@
 #include <memory/object_allocator.hpp>
 
 #include <beel/utils/avl.tree.hpp>
-#include <beel/sync/rw.ticket.lock.hpp>
+#include <beel/sync/big.reader.lock.hpp>
 #include <beel/sync/atomic.hpp>
 
 namespace Beelzebub { namespace Memory
@@ -55,6 +55,10 @@ namespace Beelzebub { namespace Memory
     class Vas
     {
     public:
+        /*  Statics  */
+
+        static size_t SequenceBase;
+
         /*  Constructors  */
 
         inline Vas()
@@ -62,7 +66,7 @@ namespace Beelzebub { namespace Memory
             , Alloc()
             , Tree()
             , First(nullptr)
-            , LastSearched(nullptr)
+            , Sequence(0)
         {
             this->Tree.Cookie = this;
         }
@@ -73,13 +77,14 @@ namespace Beelzebub { namespace Memory
         Handle Initialize(vaddr_t start, vaddr_t end
             , AcquirePoolFunc acquirer, EnlargePoolFunc enlarger, ReleasePoolFunc releaser
             , PoolReleaseOptions const releaseOptions = PoolReleaseOptions::ReleaseAll
-            , size_t const quota = SIZE_MAX);
+            , size_t const quota = SIZE_MAX, size_t const poolAlignment = 0);
 
         /*  Operations  */
 
         __hot Handle Allocate(vaddr_t & vaddr, vsize_t size
             , MemoryFlags flags, MemoryContent content
-            , MemoryAllocationOptions type, bool lock = true);
+            , MemoryAllocationOptions type, bool lock = true
+            , vsize_t alignment = PageSize);
 
         __hot Handle Free(vaddr_t vaddr, vsize_t size
             , bool sparse = false, bool tolerant = false, bool lock = true);
@@ -87,8 +92,54 @@ namespace Beelzebub { namespace Memory
         __hot Handle Modify(vaddr_t vaddr, vsize_t size
             , MemoryFlags flags, bool lock = true);
 
+        __hot Handle Split(vaddr_t vaddr, bool lock = true);
+
         __hot MemoryRegion * FindRegion(vaddr_t vaddr);
 
+        /*  Lock-free Reading  */
+
+        /**
+         *  <summary>Acquires the lock as the writer and marks the tree as being modified.</summary>
+         */
+        __forceinline void BeginWrite()
+        {
+            this->Lock.AcquireAsWriter();
+
+            __atomic_add_fetch(&(this->Sequence), 1, __ATOMIC_ACQ_REL);
+            //  Odd means a writer is at work.
+        }
+
+        /**
+         *  <summary>Marks the end of a modification and releases the writer lock.</summary>
+         */
+        __forceinline void EndWrite()
+        {
+            __atomic_add_fetch(&(this->Sequence), 1, __ATOMIC_ACQ_REL);
+
+            this->Lock.ReleaseAsWriter();
+        }
+
+        /**
+         *  <summary>Obtains the current sequence number of the tree.</summary>
+         *  <return>An odd number if a writer is at work; an even number otherwise.</return>
+         */
+        __forceinline size_t ReadBegin() const
+        {
+            return __atomic_load_n(&(this->Sequence), __ATOMIC_ACQUIRE);
+        }
+
+        /**
+         *  <summary>Checks whether the tree was left untouched since the given sequence number was read.</summary>
+         */
+        __forceinline bool ReadValidate(size_t const seq) const
+        {
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            return __atomic_load_n(&(this->Sequence), __ATOMIC_RELAXED) == seq;
+        }
+
+        __hot bool FindRegionOptimistic(vaddr_t vaddr, MemoryRegion & copy, size_t & seq);
+
         /*  Support  */
 
         __hot Handle AllocateNode(Utils::AvlTree<MemoryRegion>::Node * & node);
@@ -113,11 +164,17 @@ namespace Beelzebub { namespace Memory
 
         /*  Fields  */
 
-        Synchronization::RwTicketLock Lock;
+        Synchronization::BigReaderLock Lock;
+        //  Page faults read-lock it on every core, so its readers stay on
+        //  their own cores' slots.
 
         ObjectAllocator Alloc;
         Utils::AvlTree<MemoryRegion> Tree;
 
-        MemoryRegion * First, * LastSearched;
+        MemoryRegion * First;
+
+        size_t Sequence;
+        //  Bumped by writers on entry and on exit, so readers can validate what
+        //  they have seen without taking the lock.
     };
 }}
@@ -97,7 +97,7 @@ namespace Beelzebub { namespace Memory
 
         /*  Statics  */
 
-        static Synchronization::SmpLock KernelHeapLock;
+        static Synchronization::SmpQueuedLock KernelHeapLock;
 
         static KernelVas KVas;
 
@@ -106,6 +106,27 @@ namespace Beelzebub { namespace Memory
         static vaddr_t KernelStart;
         static vaddr_t KernelEnd;
 
+        /*  Fault-around and Zeroed Frames  */
+
+        static constexpr size_t const MaxFaultAround = 63;
+        static constexpr size_t const ZeroedFramePoolCapacity = 256;
+
+        //  Number of pages following a faulting one, in the same region, which
+        //  get mapped along with it.
+        static size_t FaultAroundPages;
+        //  Number of zeroed frames each core keeps ready for page faults.
+        static size_t ZeroedFrameTarget;
+
+        static __cold Handle SetFaultAround(size_t pages, size_t zeroedFrames);
+
+        /*  Transparent Large Pages  */
+
+        static constexpr size_t const CollapseQueueCapacity = 16;
+
+        //  Whether on-demand and committed regions are backed by 2-MiB pages
+        //  wherever they cover an entire aligned span.
+        static bool TransparentLargePages;
+
         /*  Utils  */
 
         static Handle AcquirePoolForVas(size_t objectSize, size_t headerSize
@@ -210,6 +231,19 @@ namespace Beelzebub { namespace Memory
             return UnmapPage(proc, vaddr, dummy1, dummy2, opts);
         }
 
+        static __hot __solid Handle ZeroFrame(paddr_t const paddr);
+        static void RefillZeroedFrames();
+
+        static Handle ShareRange(Execution::Process * const src, vaddr_t const srcAddr, vsize_t const size
+            , Execution::Process * const dst, vaddr_t const dstAddr
+            , MemoryFlags const flags, bool const copyOnWrite);
+        static __hot Handle BreakCopyOnWrite(Execution::Process * proc, vaddr_t const vaddr);
+
+        static __hot bool CanMapLargePage(Execution::Process * proc, vaddr_t const vaddr);
+        static Handle CollapseLargePage(Execution::Process * proc, vaddr_t const vaddr);
+        static void QueueCollapse(Execution::Process * proc, vaddr_t const span);
+        static void CollapseLargePages();
+
         static __hot __solid Handle UnmapRange(Execution::Process * proc
             , vaddr_t vaddr, vsize_t size
             , MemoryMapOptions opts = MemoryMapOptions::None
@@ -239,6 +273,17 @@ namespace Beelzebub { namespace Memory
             return InvalidateChain(proc, PageNode(vaddr), broadcast);
         }
 
+        /*  Invalidation Batches  */
+
+        //  While a thread has a batch open over an address space, the
+        //  invalidations of the pages it unmaps there are queued and shot down
+        //  together, and the references to their frames are dropped afterwards.
+        //  The kernel's address space is shared by all processes.
+        static __hot __solid void BeginInvalidationBatch(Execution::Process * proc, bool kernel = false);
+        static __hot __solid Handle EndInvalidationBatch(Execution::Process * proc, bool kernel = false);
+
+        static __hot __solid Handle FlushInvalidations(Execution::Process * proc, bool kernel = false);
+
         static __hot __solid Handle Translate(Execution::Process * proc
             , vaddr_t const vaddr, paddr_t & paddr, bool const lock = true);
 
@@ -249,7 +294,8 @@ namespace Beelzebub { namespace Memory
 
         static __hot __solid Handle AllocatePages(Execution::Process * proc
             , vsize_t const size, MemoryAllocationOptions const type
-            , MemoryFlags const flags, MemoryContent content, vaddr_t & vaddr);
+            , MemoryFlags const flags, MemoryContent content, vaddr_t & vaddr
+            , vsize_t const alignment = PageSize);
 
         static __hot __forceinline Handle AllocatePages(vsize_t const size
             , MemoryAllocationOptions const type
@@ -266,6 +312,13 @@ namespace Beelzebub { namespace Memory
             return FreePages(nullptr, vaddr, size);
         }
 
+        /*  Sharing  */
+
+        static Handle SharePages(Execution::Process * src
+            , vaddr_t const srcAddr, vsize_t const size
+            , Execution::Process * const dst, vaddr_t & dstAddr
+            , bool const copyOnWrite, bool const readOnly = false);
+
         /*  Flags  */
 
         static __hot __solid Handle CheckMemoryRegion(Execution::Process * proc
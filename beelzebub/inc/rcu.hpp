@@ -0,0 +1,181 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#include "cores.hpp"
+#include <beel/interrupt.state.hpp>
+
+namespace Beelzebub
+{
+    typedef void (* RcuFunction)(void * cookie);
+
+    /**
+     *  <summary>
+     *  A function to call once every reader which may still see an object is
+     *  gone. Usually embedded in the object itself.
+     *  </summary>
+     */
+    struct RcuEntry
+    {
+        /*  Constructor(s)  */
+
+        inline RcuEntry() : Next(nullptr), Function(nullptr), Cookie(nullptr) { }
+
+        inline RcuEntry(RcuFunction func, void * cookie = nullptr)
+            : Next(nullptr)
+            , Function(func)
+            , Cookie(cookie)
+        {
+
+        }
+
+        /*  Fields  */
+
+        RcuEntry * Next;
+
+        RcuFunction Function;
+        void * Cookie;
+    };
+
+    /**
+     *  <summary>
+     *  Read-copy-update: readers go lock-free and writers defer reclamation
+     *  until all cores have passed through a quiescent state.
+     *  </summary>
+     *  <remarks>
+     *  A read-side section only disables interrupts, so the core cannot be
+     *  preempted within it. Scheduler ticks, context switches and idling are
+     *  therefore quiescent states. Read-side sections must not block or yield.
+     *  </remarks>
+     */
+    class Rcu
+    {
+    public:
+        /*  Constants  */
+
+        static constexpr size_t const IdleBit = 1;
+        static constexpr size_t const PendingBit = 2;
+        //  Bits of the per-core state: whether the core is idle, and whether
+        //  the grace period in progress awaits a quiescent state from it.
+
+    protected:
+        /*  Constructor(s)  */
+
+        Rcu() = default;
+
+    public:
+        Rcu(Rcu const &) = delete;
+        Rcu & operator =(Rcu const &) = delete;
+
+        /*  Reading  */
+
+        /**
+         *  <summary>Begins a read-side section.</summary>
+         *  <return>The interrupt state to give back when ending the section.</return>
+         */
+        static __forceinline InterruptState ReadLock()
+        {
+            return InterruptState::Disable();
+        }
+
+        /**
+         *  <summary>Ends a read-side section.</summary>
+         */
+        static __forceinline void ReadUnlock(InterruptState const cookie)
+        {
+            cookie.Restore();
+        }
+
+        /*  Reclamation  */
+
+        /**
+         *  <summary>
+         *  Calls the entry's function once a grace period has elapsed after this
+         *  call. The function may run in an interrupt handler, on any core.
+         *  </summary>
+         */
+        static void CallAfterGracePeriod(RcuEntry * entry);
+
+        static inline void CallAfterGracePeriod(RcuEntry * entry, RcuFunction func, void * cookie = nullptr)
+        {
+            entry->Function = func;
+            entry->Cookie = cookie;
+
+            CallAfterGracePeriod(entry);
+        }
+
+        /**
+         *  <summary>
+         *  Waits for a grace period to elapse, and for all the functions given
+         *  before to have been called.
+         *  </summary>
+         *  <remarks>Requires interrupts to be enabled, so it is not in a read-side section.</remarks>
+         */
+        static void Synchronize();
+
+        /*  Quiescent States  */
+
+        /**
+         *  <summary>Reports that this core is not within a read-side section.</summary>
+         */
+        static __hot void QuiescentState();
+
+        /**
+         *  <summary>Marks this core as idle; grace periods will not wait for it.</summary>
+         */
+        static void EnterIdle();
+
+        /**
+         *  <summary>Marks this core as busy again.</summary>
+         */
+        static void ExitIdle();
+
+        /*  Properties  */
+
+        static __hot __forceinline bool IsIdle()
+        {
+            return likely(Cores::IsReady()) && 0 != (System::Cpu::GetData()->RcuState & IdleBit);
+        }
+
+        static uint64_t GetCompletedGracePeriods();
+    };
+
+    #define withRcuReader with(Beelzebub::InterruptGuard<> MCATS(_rcu_guard, __LINE__))
+}
@@ -43,9 +43,12 @@
 
 #include "execution/thread.hpp"
 #include "kernel.hpp"
+#include <beel/sync/smp.lock.hpp>
 
 namespace Beelzebub
 {
+    struct InterruptContext;
+
     /**
      *  Scheduler assistance!
      */
@@ -71,6 +74,16 @@ namespace Beelzebub
                 return val == 0;
             }
 
+            inline size_t GetCount() const
+            {
+                size_t cnt = 0;
+
+                for (size_t i = 0; i < Size; ++i)
+                    cnt += (size_t)__builtin_popcountl(this->Bitmap[i]);
+
+                return cnt;
+            }
+
             inline bool IsAllOne() const
             {
                 size_t val = ~(size_t)0UL;
@@ -117,15 +130,38 @@ namespace Beelzebub
 
     private:
         static __startup void InitializeIdleThread(MainParameters * params);
+        static __startup void GetTopology(uint32_t & core, uint32_t & package);
+        static __startup void InitializeYield();
 
     public:
         static void Engage();
 
         static void Enroll(Execution::Thread * thread);
 
+        /*  Blocking  */
+
+        static bool CanBlock();
+        //  False in interrupt handlers, with interrupts disabled, or before
+        //  the scheduler is engaged.
+
+        static void Yield();
+        static void Block(Synchronization::SmpLock * lock);
+        //  The caller must hold the given lock with interrupts disabled. It is
+        //  released once the current thread is switched out, and the thread
+        //  resumes after being enrolled again.
+
+        static void HandleYield(InterruptContext const * context, void * cookie);
+
+        static void Migrated(Execution::Thread * thread);
+        //  Called when a thread is switched in on a different core than before.
+
         /*  Properties  */
 
         static SchedulerStatus GetStatus(Execution::Thread * thread);
-        static void SetAffinity(Execution::Thread * thread, AffinityMask const & affinity);
+        static Handle SetAffinity(Execution::Thread * thread, AffinityMask const & affinity);
+        //  The mask is copied out of line, and the copy belongs to the thread.
+
+        static void Release(Execution::Thread * thread);
+        //  Frees the scheduling state owned by a thread which is going away.
     };
 }
@@ -49,6 +49,18 @@ namespace Beelzebub
     template<typename TCookie>
     using TimedFunction = void (*)(TCookie *);
 
+    struct TimerEntry;
+
+    /**
+     *  <summary>Identifies an armed timer, so it can be cancelled.</summary>
+     */
+    struct TimerId
+    {
+        TimerEntry * Entry;
+        uint64_t Sequence;
+        //  Distinguishes between the uses of the same entry.
+    };
+
     /**
      *  <summary>Represents an abstract system timer.</summary>
      */
@@ -60,8 +72,6 @@ namespace Beelzebub
         static uint64_t Frequency;
         static size_t TicksPerMicrosecond;
 
-        static constexpr uint_fast16_t const Count = 32;
-
     protected:
         /*  Constructor(s)  */
 
@@ -77,12 +87,25 @@ namespace Beelzebub
 
         /*  Operation  */
 
-        static bool Enqueue(TimeSpanLite delay, TimedFunctionVoid func, void * cookie = nullptr);
+        /**
+         *  <summary>Obtains the current time, in microseconds.</summary>
+         */
+        static TimeInstantLite Now();
+
+        static bool Enqueue(TimeSpanLite delay, TimedFunctionVoid func, void * cookie = nullptr, TimerId * id = nullptr);
 
         template<typename TCookie>
-        static bool Enqueue(TimeSpanLite delay, TimedFunction<TCookie> func, TCookie * cookie)
+        static bool Enqueue(TimeSpanLite delay, TimedFunction<TCookie> func, TCookie * cookie, TimerId * id = nullptr)
         {
-            return Enqueue(delay, reinterpret_cast<TimedFunctionVoid>(func), cookie);
+            return Enqueue(delay, reinterpret_cast<TimedFunctionVoid>(func), cookie, id);
         }
+
+        /**
+         *  <summary>
+         *  Cancels a timer, from any core. Returns false if the timer's function
+         *  is already running or has run, in which case it will not be stopped.
+         *  </summary>
+         */
+        static bool Cancel(TimerId const & id);
     };
 }
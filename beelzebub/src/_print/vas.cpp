@@ -59,7 +59,7 @@ namespace Beelzebub { namespace Terminals
 
         withInterrupts (false)
         {
-            vas->Lock.AcquireAsReader();
+            size_t const slot = vas->Lock.AcquireAsReader();
 
             MemoryRegion const * reg = vas->First;
 
@@ -82,7 +82,7 @@ namespace Beelzebub { namespace Terminals
                 reg = next;
             }
 
-            vas->Lock.ReleaseAsReader();
+            vas->Lock.ReleaseAsReader(slot);
         }
 
         return term;
@@ -39,6 +39,8 @@
 
 #include "execution.hpp"
 #include "kernel.hpp"
+#include "cores.hpp"
+#include "system/cpu.hpp"
 #include <memory/object_allocator_smp.hpp>
 #include <memory/object_allocator_pools_heap.hpp>
 #include <beel/utils/id.pool.hpp>
@@ -126,6 +128,9 @@ UniquePointer<Process> Beelzebub::SpawnProcess()
     new (obj) Process((uint16_t)id);
     ::memset(obj + 1, 0, ProcessSize - sizeof(*obj));
 
+    if likely(Cores::IsReady())
+        obj->Parent = System::Cpu::GetProcess();
+
     ASSERTX(ProcessIds.SetPointer(id, obj))
         (id)
         ((void *)obj)
@@ -136,6 +141,12 @@ UniquePointer<Process> Beelzebub::SpawnProcess()
     return obj;
 }
 
+Process * Beelzebub::FindProcess(uint16_t id)
+{
+    return ProcessIds.Resolve(id);
+    //  Processes are never reclaimed yet, so the pointer remains valid.
+}
+
 UniquePointer<Thread> Beelzebub::SpawnThread(Process * owner)
 {
     uintptr_t id = ThreadIds.Acquire();
@@ -177,6 +177,8 @@ rollbackMapping:
     //  It starts with a decrement because vaddr points to a page that failed
     //  to map.
 
+    Vmm::BeginInvalidationBatch(proc);
+
     do
     {
         vaddr -= PageSize;
@@ -188,6 +190,8 @@ rollbackMapping:
             , vaddr, &phdr, res);
     } while (vaddr > segVaddr);
 
+    Vmm::EndInvalidationBatch(proc);
+
     Vmm::FreePages(proc, segVaddr, vsize_t(phdr.VSize + PageSize.Value - 1));
 
     return false;
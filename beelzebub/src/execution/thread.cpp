@@ -38,6 +38,7 @@
 */
 
 #include <execution/thread.hpp>
+#include <scheduler.hpp>
 
 using namespace Beelzebub;
 using namespace Beelzebub::Execution;
@@ -76,6 +77,8 @@ Thread::~Thread()
 
 void Thread::ReleaseMemory()
 {
+    Scheduler::Release(this);
+
     if (this->Owner != nullptr)
         this->Owner->ReleaseReference();
     else
@@ -48,6 +48,14 @@ CommandLineOptionSpecification Beelzebub::CMDO_Tests;
 CommandLineOptionSpecification Beelzebub::CMDO_Debugger;
 CommandLineOptionSpecification Beelzebub::CMDO_UnitTests;
 CommandLineOptionSpecification Beelzebub::CMDO_SmpEnable;
+CommandLineOptionSpecification Beelzebub::CMDO_FrameCacheHigh;
+CommandLineOptionSpecification Beelzebub::CMDO_FrameCacheLow;
+CommandLineOptionSpecification Beelzebub::CMDO_FaultAround;
+CommandLineOptionSpecification Beelzebub::CMDO_ZeroedFrames;
+CommandLineOptionSpecification Beelzebub::CMDO_LargePages;
+CommandLineOptionSpecification Beelzebub::CMDO_HandleFreeListHigh;
+CommandLineOptionSpecification Beelzebub::CMDO_HandleFreeListBatch;
+CommandLineOptionSpecification Beelzebub::CMDO_LockStatInterval;
 
 CommandLineOptionSpecification * Beelzebub::CommandLineOptionsHead;
 
@@ -58,8 +66,17 @@ Handle Beelzebub::InstanceGlobalOptions()
     CMDO_LINKED_EX(Tests, nullptr, "tests", String, Debugger);
     CMDO_LINKED_EX(UnitTests, nullptr, "unit-tests", BooleanByPresence, Tests);
     CMDO_LINKED_EX(SmpEnable, nullptr, "smp", BooleanExplicit, UnitTests);
+    CMDO_LINKED_EX(FrameCacheHigh, nullptr, "frame-cache-high", UnsignedInteger, SmpEnable);
+    CMDO_LINKED_EX(FrameCacheLow, nullptr, "frame-cache-low", UnsignedInteger, FrameCacheHigh);
+    CMDO_LINKED_EX(FaultAround, nullptr, "fault-around", UnsignedInteger, FrameCacheLow);
+    CMDO_LINKED_EX(ZeroedFrames, nullptr, "zeroed-frames", UnsignedInteger, FaultAround);
+    CMDO_LINKED_EX(LargePages, nullptr, "large-pages", BooleanExplicit, ZeroedFrames);
+    CMDO_LINKED_EX(HandleFreeListHigh, nullptr, "handle-free-high", UnsignedInteger, LargePages);
+    CMDO_LINKED_EX(HandleFreeListBatch, nullptr, "handle-free-batch", UnsignedInteger, HandleFreeListHigh);
 
-    CommandLineOptionsHead = &CMDO_SmpEnable;
+    CMDO_LINKED_EX(LockStatInterval, nullptr, "lockstat-interval", UnsignedInteger, HandleFreeListBatch);
+
+    CommandLineOptionsHead = &CMDO_LockStatInterval;
 
     return HandleResult::Okay;
 }
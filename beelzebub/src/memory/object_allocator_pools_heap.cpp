@@ -215,3 +215,61 @@ Handle Memory::ReleasePoolFromKernelHeap(size_t objectSize
 
     return res;
 }
+
+Handle Memory::AcquireAlignedPoolInKernelHeap(size_t objectSize
+                                            , size_t headerSize
+                                            , size_t minimumObjects
+                                            , ObjectPoolBase * & result)
+{
+    assert(headerSize >= sizeof(ObjectPoolBase)
+        , "The given header size apprats to be lower than the size of an "
+          "actual pool struct..?")
+        (headerSize)(sizeof(ObjectPoolBase));
+
+    (void)minimumObjects;
+    //  Aligned pools have a fixed size, so the owning allocator can find them
+    //  by masking the address of any of their objects.
+
+    if unlikely(objectSize + headerSize > AlignedPoolSize)
+        return HandleResult::ArgumentOutOfRange;
+
+    vaddr_t addr { nullptr };
+
+    Handle res = Vmm::AllocatePages(nullptr
+        , vsize_t(AlignedPoolSize)
+        , MemoryAllocationOptions::Commit | MemoryAllocationOptions::VirtualKernelHeap
+        , MemoryFlags::Global | MemoryFlags::Writable
+        , MemoryContent::Generic
+        , addr
+        , vsize_t(AlignedPoolSize));
+
+    if (res != HandleResult::Okay)
+        return res;
+
+    ObjectPoolBase volatile * volatile pool = (ObjectPoolBase *)addr.Pointer;
+
+    new (const_cast<ObjectPoolBase *>(pool)) ObjectPoolBase();
+
+    FillPool(pool, objectSize, headerSize
+        , (obj_ind_t)((AlignedPoolSize - headerSize) / objectSize));
+
+    result = const_cast<ObjectPoolBase *>(pool);
+
+    return HandleResult::Okay;
+}
+
+Handle Memory::ReleaseAlignedPoolFromKernelHeap(size_t objectSize
+                                              , size_t headerSize
+                                              , ObjectPoolBase * pool)
+{
+    (void)objectSize;
+    (void)headerSize;
+
+    Handle res = Vmm::FreePages(nullptr, vaddr_t(pool), vsize_t(AlignedPoolSize));
+
+    assert(res.IsOkayResult(), "Failed to unmap aligned object pool.")
+        ("pool", (void *)pool)
+        (res);
+
+    return res;
+}
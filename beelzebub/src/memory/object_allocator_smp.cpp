@@ -43,12 +43,14 @@
 
     #include <memory/object_allocator_smp.hpp>
     #include <beel/interrupt.state.hpp>
+    #include <mailbox.hpp>
 
     #include <math.h>
     #include <debug.hpp>
 
     using namespace Beelzebub;
     using namespace Beelzebub::Memory;
+    using namespace Beelzebub::Synchronization;
 
     #define OBJA_LOCK_TYPE Beelzebub::Synchronization::SmpLockUni
     #define OBJA_COOK_TYPE Beelzebub::InterruptState
@@ -57,7 +59,9 @@
     #define OBJA_ALOC_TYPE      ObjectAllocatorSmp
     #define OBJA_MULTICONSUMER  true
     #define OBJA_UNINTERRUPTED  true
+    #define OBJA_MAGAZINES      true
     #include <memory/object_allocator_cbase.inc>
+    #undef OBJA_MAGAZINES
     #undef OBJA_UNINTERRUPTED
     #undef OBJA_MULTICONSUMER
     #undef OBJA_ALOC_TYPE
@@ -66,4 +70,255 @@
     #undef OBJA_COOK_TYPE
     #undef OBJA_LOCK_TYPE
 
+    /****************
+        Internals
+    ****************/
+
+    //  Every core keeps two magazines of objects for each cached allocator:
+    //  a loaded one, which serves allocations and deallocations, and the
+    //  previous one, which is either full or empty. Full magazines are
+    //  exchanged with the allocator's depot, so the pools are only touched
+    //  when both the core and the depot run out (or over).
+
+    struct ObjectMagazine
+    {
+        void * Head;
+        //  Objects are chained through their first word.
+        size_t Count;
+    };
+
+    struct ObjectCache
+    {
+        size_t Owner;
+        //  Cache identifier of the allocator using this slot.
+        ObjectMagazine Loaded, Previous;
+    };
+
+    static constexpr size_t const ObjectCacheCount = 64;
+
+    static __thread ObjectCache MyObjectCaches[ObjectCacheCount];
+
+    static __hot __forceinline ObjectCache * GetCache(size_t const id)
+    {
+        ObjectCache * const cache = MyObjectCaches + (id & (ObjectCacheCount - 1));
+
+        if likely(cache->Owner == id)
+            return cache;
+
+        if (cache->Loaded.Count == 0 && cache->Previous.Count == 0)
+        {
+            cache->Owner = id;
+
+            return cache;
+        }
+
+        return nullptr;
+        //  Another allocator holds objects in this slot.
+    }
+
+    static __forceinline void * & NextObject(void * const obj)
+    {
+        return reinterpret_cast<void **>(obj)[0];
+    }
+
+    static __forceinline void * & NextMagazine(void * const obj)
+    {
+        return reinterpret_cast<void **>(obj)[1];
+    }
+
+    static void ReleaseChain(ObjectAllocatorSmp * const alloc, void * obj)
+    {
+        while (obj != nullptr)
+        {
+            void * const next = NextObject(obj);
+
+            alloc->DeallocateShared(obj);
+
+            obj = next;
+        }
+    }
+
+    static void FlushLocalCache(ObjectAllocatorSmp * const alloc, size_t const id)
+    {
+        ObjectCache * const cache = MyObjectCaches + (id & (ObjectCacheCount - 1));
+
+        if (cache->Owner != id)
+            return;
+
+        ReleaseChain(alloc, cache->Loaded.Head);
+        ReleaseChain(alloc, cache->Previous.Head);
+
+        cache->Loaded.Head = cache->Previous.Head = nullptr;
+        cache->Loaded.Count = cache->Previous.Count = 0;
+    }
+
+    /********************************
+        ObjectAllocatorSmp class
+    ********************************/
+
+    Atomic<size_t> ObjectAllocatorSmp::NextCacheId {0};
+
+    void ObjectAllocatorSmp::FlushCacheMail(void * cookie)
+    {
+        ObjectAllocatorSmp * const alloc = reinterpret_cast<ObjectAllocatorSmp *>(cookie);
+
+        FlushLocalCache(alloc, alloc->CacheId);
+    }
+
+    /*  Methods  */
+
+    Handle ObjectAllocatorSmp::AllocateObject(void * & result, size_t estimatedLeft)
+    {
+        if (this->CacheId == 0)
+            return this->AllocateShared(result, estimatedLeft);
+
+        InterruptGuard<> intGuard;
+        //  The cache belongs to the core, and so does everything until the
+        //  guard goes out of scope.
+
+        if unlikely(this->AcquirePool == nullptr)
+            return HandleResult::ObjectDisposed;
+
+        ObjectCache * const cache = GetCache(this->CacheId);
+
+        if unlikely(cache == nullptr)
+            return this->AllocateShared(result, estimatedLeft);
+
+        if unlikely(cache->Loaded.Count == 0)
+        {
+            if (cache->Previous.Count > 0)
+            {
+                ObjectMagazine const temp = cache->Loaded;
+                cache->Loaded = cache->Previous;
+                cache->Previous = temp;
+            }
+            else
+            {
+                void * full;
+
+                withLock (this->DepotLock)
+                    if ((full = this->Depot) != nullptr)
+                    {
+                        this->Depot = NextMagazine(full);
+                        --this->DepotCount;
+                    }
+
+                if (full == nullptr)
+                    return this->AllocateShared(result, estimatedLeft);
+                //  Magazines are only filled by deallocations.
+
+                cache->Loaded.Head = full;
+                cache->Loaded.Count = MagazineSize;
+            }
+        }
+
+        void * const obj = cache->Loaded.Head;
+
+        cache->Loaded.Head = NextObject(obj);
+        --cache->Loaded.Count;
+
+        result = obj;
+
+        return HandleResult::Okay;
+    }
+
+    Handle ObjectAllocatorSmp::DeallocateObject(void * const object)
+    {
+        if (this->CacheId == 0)
+            return this->DeallocateShared(object);
+
+        InterruptGuard<> intGuard;
+
+        if unlikely(this->AcquirePool == nullptr)
+            return HandleResult::ObjectDisposed;
+
+        ObjectCache * const cache = GetCache(this->CacheId);
+
+        if unlikely(cache == nullptr)
+            return this->DeallocateShared(object);
+
+        if unlikely(cache->Loaded.Count == MagazineSize)
+        {
+            if (cache->Previous.Count == 0)
+            {
+                ObjectMagazine const temp = cache->Loaded;
+                cache->Loaded = cache->Previous;
+                cache->Previous = temp;
+            }
+            else
+            {
+                void * const full = cache->Previous.Head;
+                bool stored = false;
+
+                withLock (this->DepotLock)
+                    if (this->DepotCount < DepotLimit)
+                    {
+                        NextMagazine(full) = this->Depot;
+                        this->Depot = full;
+                        ++this->DepotCount;
+
+                        stored = true;
+                    }
+
+                if (!stored)
+                    ReleaseChain(this, full);
+                //  The depot has plenty, so the pools get these back.
+
+                cache->Previous = cache->Loaded;
+                cache->Loaded.Head = nullptr;
+                cache->Loaded.Count = 0;
+            }
+        }
+
+        NextObject(object) = cache->Loaded.Head;
+        cache->Loaded.Head = object;
+        ++cache->Loaded.Count;
+
+        return HandleResult::Okay;
+    }
+
+    void ObjectAllocatorSmp::FlushCache()
+    {
+        if (this->CacheId == 0)
+            return;
+
+        InterruptGuard<> intGuard;
+
+        void * depot;
+
+        FlushLocalCache(this, this->CacheId);
+
+        withLock (this->DepotLock)
+        {
+            depot = this->Depot;
+
+            this->Depot = nullptr;
+            this->DepotCount = 0;
+        }
+
+        while (depot != nullptr)
+        {
+            void * const next = NextMagazine(depot);
+
+            ReleaseChain(this, depot);
+
+            depot = next;
+        }
+    }
+
+    void ObjectAllocatorSmp::FlushAllCaches()
+    {
+        if (this->CacheId == 0)
+            return;
+
+        if likely(Mailbox::IsReady())
+        {
+            ALLOCATE_MAIL_BROADCAST(mail, &FlushCacheMail, this);
+            mail.SetAwait(true).Post();
+            //  Every other core flushes its own cache before this returns.
+        }
+
+        this->FlushCache();
+    }
+
 #endif
@@ -41,6 +41,7 @@
 
 #include <valloc/platform.hpp>
 #include "memory/vmm.hpp"
+#include "memory/pmm.hpp"
 // #include "system/debug.registers.hpp"
 // #include "utils/stack_walk.hpp"
 // #include "_print/isr.hpp"
@@ -111,7 +112,7 @@ using namespace Valloc;
 //     END_OF_INTERRUPT();
 // }
 
-void Platform::AllocateMemory(void * & addr, size_t & size)
+void Platform::AllocateMemory(void * & addr, size_t & size, size_t alignment)
 {
     vaddr_t vaddr { addr };
 
@@ -120,7 +121,8 @@ void Platform::AllocateMemory(void * & addr, size_t & size)
         , MemoryAllocationOptions::VirtualKernelHeap | MemoryAllocationOptions::AllocateOnDemand
         , MemoryFlags::Global | MemoryFlags::Writable
         , MemoryContent::Generic
-        , vaddr);
+        , vaddr
+        , alignment == 0 ? vsize_t(PageSize) : vsize_t(alignment));
 
     // MSG_("Allocating memory for vAlloc: %Xp %Xs %H%n", vaddr, size, res);
 
@@ -138,6 +140,66 @@ void Platform::AllocateMemory(void * & addr, size_t & size)
     }
 }
 
+void Platform::AllocateLargeMemory(void * & addr, size_t & size)
+{
+    vaddr_t vaddr { addr };
+
+    if unlikely(size % LargePageSize != 0 || vaddr.Value % LargePageSize != 0)
+        goto fail;
+
+    {
+        Handle res = Vmm::AllocatePages(nullptr
+            , vsize_t(size)
+            , MemoryAllocationOptions::VirtualKernelHeap | MemoryAllocationOptions::AllocateOnDemand
+            , MemoryFlags::Global | MemoryFlags::Writable
+            , MemoryContent::Generic
+            , vaddr
+            , vsize_t(LargePageSize));
+
+        if unlikely(res != HandleResult::Okay)
+            goto fail;
+
+        //  The region is reserved for on-demand allocation, but it is mapped
+        //  entirely right away, so it never faults.
+
+        for (size_t offset = 0; offset < size; offset += LargePageSize)
+        {
+            paddr_t const paddr = Pmm::AllocateFrame(FrameSize::_2MiB);
+
+            if unlikely(paddr == nullpaddr)
+                goto undo;
+
+            res = Vmm::MapPage(vaddr + vsize_t(offset), paddr, FrameSize::_2MiB
+                , MemoryFlags::Global | MemoryFlags::Writable);
+
+            if unlikely(res != HandleResult::Okay)
+            {
+                Pmm::FreeFrame(paddr);
+
+                goto undo;
+            }
+        }
+
+        addr = const_cast<void *>(vaddr.Pointer);
+
+        return;
+    }
+
+undo:
+    Vmm::FreePages(nullptr, vaddr, vsize_t(size));
+
+fail:
+    addr = nullptr;
+    size = 0;
+}
+
+void Platform::PurgeMemory(void * addr, size_t size)
+{
+    Vmm::UnmapRange(nullptr, vaddr_t(addr), vsize_t(size));
+    //  The pages are unmapped but the region stays allocated on demand, so
+    //  they are faulted in again when touched.
+}
+
 void Platform::FreeMemory(void * addr, size_t size)
 {
     // MSG_("Freeing memory for vAlloc: %Xp %Xs%n", addr, size);
@@ -141,7 +141,7 @@ struct OperationParameters
         {
             cookie = InterruptState::Disable();
 
-            vas->Lock.AcquireAsWriter();
+            vas->BeginWrite();
         }
 
         if unlikely(this->Allocation && vaddr == nullvaddr)
@@ -207,9 +207,6 @@ struct OperationParameters
             goto end;
         }
 
-        if (vas->LastSearched == reg)
-            vas->LastSearched = nullptr;
-
         if (endAddr > reg->Range.End)
         {
             if (this->Sparse)
@@ -501,7 +498,7 @@ struct OperationParameters
 
         if likely(lock)
         {
-            vas->Lock.ReleaseAsWriter();
+            vas->EndWrite();
 
             cookie.Restore();
         }
@@ -514,16 +511,24 @@ struct OperationParameters
     Vas class
 ****************/
 
+/*  Statics  */
+
+size_t Vas::SequenceBase = 0;
+
 /*  Constructors  */
 
 Handle Vas::Initialize(vaddr_t start, vaddr_t end
     , AcquirePoolFunc acquirer, EnlargePoolFunc enlarger, ReleasePoolFunc releaser
     , PoolReleaseOptions const releaseOptions
-    , size_t const quota)
+    , size_t const quota, size_t const poolAlignment)
 {
     new (&(this->Alloc)) ObjectAllocator(
         sizeof(*(this->Tree.Root)), __alignof(*(this->Tree.Root)),
-        acquirer, enlarger, releaser, releaseOptions, SIZE_MAX, quota);
+        acquirer, enlarger, releaser, releaseOptions, SIZE_MAX, quota, poolAlignment);
+
+    this->Sequence = __atomic_add_fetch(&SequenceBase, (size_t)1 << 32, __ATOMIC_RELAXED);
+    //  Every VAS counts from a different base, so a lookup hint left behind by
+    //  a dead VAS cannot pass for one of its successors at the same address.
 
     return this->Tree.Insert(MemoryRegion(start, end
         , MemoryFlags::None
@@ -536,7 +541,7 @@ Handle Vas::Initialize(vaddr_t start, vaddr_t end
 
 Handle Vas::Allocate(vaddr_t & vaddr, vsize_t size
     , MemoryFlags flags, MemoryContent content
-    , MemoryAllocationOptions type, bool lock)
+    , MemoryAllocationOptions type, bool lock, vsize_t alignment)
 {
     if unlikely(this->First == nullptr)
         return HandleResult::ObjectDisposed;
@@ -554,11 +559,14 @@ Handle Vas::Allocate(vaddr_t & vaddr, vsize_t size
         /*  Constructor(s)  */
 
         inline AllocateOperation(Memory::Vas * vas, vaddr_t vaddr, vsize_t size
-                               , MemoryFlags flags, MemoryContent content, MemoryAllocationOptions type)
+                               , MemoryFlags flags, MemoryContent content, MemoryAllocationOptions type
+                               , vsize_t alignment, vsize_t lowOffset)
             : OperationParameters(vas, vaddr, size, false, false, true)
             , Flags(flags)
             , Content(content)
             , Type(type)
+            , Alignment(alignment)
+            , LowOffset(lowOffset)
         {
 
         }
@@ -614,14 +622,19 @@ Handle Vas::Allocate(vaddr_t & vaddr, vsize_t size
 
         virtual bool CanAllocateAnonymously(MemoryRegion * reg) override
         {
-            //  TODO: Alignment rules.
+            if (reg->GetSize() < this->StartSize)
+                return false;
 
-            bool res = reg->GetSize() >= this->StartSize;
+            vaddr_t const addr = RoundDown(reg->Range.End - this->StartSize + this->LowOffset, this->Alignment)
+                - this->LowOffset;
+            //  The address handed out (past the low guard) is the aligned one.
 
-            if (res)
-                this->Address = reg->Range.End - this->StartSize;
+            if (addr < reg->Range.Start)
+                return false;
 
-            return res;
+            this->Address = addr;
+
+            return true;
         }
 
         /*  Fields  */
@@ -629,7 +642,8 @@ Handle Vas::Allocate(vaddr_t & vaddr, vsize_t size
         MemoryFlags Flags;
         MemoryContent Content;
         MemoryAllocationOptions Type;
-    } manip(this, effectiveAddress, effectiveSize, flags, content, type);
+        vsize_t Alignment, LowOffset;
+    } manip(this, effectiveAddress, effectiveSize, flags, content, type, alignment, lowOffset);
 
     res = manip.Execute(lock);
 
@@ -715,7 +729,7 @@ Handle Vas::Modify(vaddr_t vaddr, vsize_t size
     {
         cookie = InterruptState::Disable();
 
-        this->Lock.AcquireAsWriter();
+        this->BeginWrite();
     }
 
     //  So, this is gonna suck a bit. There are... Lots of options.
@@ -723,7 +737,78 @@ Handle Vas::Modify(vaddr_t vaddr, vsize_t size
 //end:
     if likely(lock)
     {
-        this->Lock.ReleaseAsWriter();
+        this->EndWrite();
+
+        cookie.Restore();
+    }
+
+    return res;
+}
+
+Handle Vas::Split(vaddr_t vaddr, bool lock)
+{
+    if unlikely(this->First == nullptr)
+        return HandleResult::ObjectDisposed;
+
+    Handle res = HandleResult::Okay;
+
+    InterruptState cookie;
+
+    if likely(lock)
+    {
+        cookie = InterruptState::Disable();
+
+        this->BeginWrite();
+    }
+
+    MemoryRegion * const reg = this->FindRegion(vaddr);
+
+    if unlikely(reg == nullptr)
+    {
+        res = HandleResult::PageFree;
+
+        goto end;
+    }
+
+    if (reg->Range.Start != vaddr)
+    {
+        //  The given address becomes the start of a new region, which takes
+        //  over the upper part of the old one along with its high guard.
+
+        vaddr_t const oldEnd = reg->Range.End;
+        MemoryAllocationOptions const oldHighGuard = reg->Type & MemoryAllocationOptions::GuardHigh;
+
+        reg->Range.End = vaddr;
+        reg->Type &= ~MemoryAllocationOptions::GuardHigh;
+
+        MemoryRegion * newReg = nullptr;
+
+        res = this->Tree.Insert(MemoryRegion(
+            vaddr, oldEnd, reg->Flags, reg->Content
+            , (reg->Type & ~MemoryAllocationOptions::GuardLow) | oldHighGuard
+            , reg, reg->Next
+        ), newReg);
+
+        if unlikely(res != HandleResult::Okay)
+        {
+            reg->Range.End = oldEnd;
+            reg->Type |= oldHighGuard;
+            //  Put the old region back the way it was.
+
+            goto end;
+        }
+
+        reg->Next = newReg;
+
+        if (newReg->Next != nullptr)
+            newReg->Next->Prev = newReg;
+        //  Patch linkage.
+    }
+
+end:
+    if likely(lock)
+    {
+        this->EndWrite();
 
         cookie.Restore();
     }
@@ -762,6 +847,45 @@ MemoryRegion * Vas::FindRegion(vaddr_t vaddr)
 #endif
 }
 
+bool Vas::FindRegionOptimistic(vaddr_t vaddr, MemoryRegion & copy, size_t & seq)
+{
+    typedef AvlTree<MemoryRegion>::Node Node;
+
+    seq = this->ReadBegin();
+
+    if unlikely((seq & 1) != 0)
+        return false;
+    //  A writer is at work, the tree cannot be trusted.
+
+    Node const * node = __atomic_load_n(&(this->Tree.Root), __ATOMIC_ACQUIRE);
+
+    for (size_t depth = 0; node != nullptr && depth < 64; ++depth)
+    {
+        //  The nodes may be recycled by a concurrent writer. Their memory stays
+        //  mapped for as long as the VAS lives, but a freed node's links are
+        //  overwritten by the allocator, so a pointer read from one must not be
+        //  followed. Validating after every load proves that no writer started
+        //  before the node was reached, hence it was not freed yet.
+
+        if unlikely(!this->ReadValidate(seq))
+            return false;
+
+        comp_t const compRes = Compare(node->Payload, vaddr);
+
+        if (compRes == 0)
+        {
+            copy = node->Payload;
+
+            return this->ReadValidate(seq);
+        }
+
+        node = __atomic_load_n(compRes > 0 ? &(node->Left) : &(node->Right), __ATOMIC_RELAXED);
+    }
+
+    return false;
+    //  Not found, or gave up. Either way, the locked path has the final word.
+}
+
 /*  Support  */
 
 Handle Vas::AllocateNode(AvlTree<MemoryRegion>::Node * & node)
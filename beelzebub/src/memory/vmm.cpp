@@ -66,16 +66,260 @@ static __forceinline bool Is4KiBAligned(TInt val) { return (val.Value & (     Pa
 template<typename TInt>
 static __forceinline bool Is2MiBAligned(TInt val) { return (val.Value & (LargePageSize.Value - 1)) == 0; }
 
+/*  Last Region Hint  */
+
+struct LastRegionHint
+{
+    Memory::Vas * Vas = nullptr;
+    MemoryRegion Region;
+    size_t Sequence = 0;
+};
+
+static __thread LastRegionHint LastRegion;
+//  A copy of the region which satisfied the last lookup on this core. It is
+//  only trusted while the sequence number of its VAS hasn't moved.
+
+/*  Zeroed Frame Pool  */
+
+struct ZeroedFramePool
+{
+    size_t Count;
+    paddr_inner_t Frames[Vmm::ZeroedFramePoolCapacity];
+};
+
+static __thread ZeroedFramePool MyZeroedFrames;
+//  Frames zeroed in advance by this core while idle. Their reference count is
+//  zero, like that of any freshly allocated frame.
+
+static __hot paddr_t TakeZeroedFrame()
+{
+    InterruptGuard<> intGuard;
+
+    if (MyZeroedFrames.Count == 0)
+        return nullpaddr;
+
+    return paddr_t(MyZeroedFrames.Frames[--MyZeroedFrames.Count]);
+}
+
+static __hot void ReturnZeroedFrame(paddr_t const paddr)
+{
+    {   //  Scope to contain the guard.
+        InterruptGuard<> intGuard;
+
+        if likely(MyZeroedFrames.Count < Vmm::ZeroedFramePoolCapacity)
+        {
+            MyZeroedFrames.Frames[MyZeroedFrames.Count++] = paddr.Value;
+
+            return;
+        }
+    }
+
+    Pmm::FreeFrame(paddr);
+}
+
+/*  Collapse Queue  */
+
+struct CollapseCandidate
+{
+    Process * Proc;
+    vaddr_inner_t Span;
+};
+
+struct CollapseQueue
+{
+    size_t Head, Count;
+    CollapseCandidate Entries[Vmm::CollapseQueueCapacity];
+};
+
+static __thread CollapseQueue MyCollapseCandidates;
+//  Userland spans which this core filled with small pages. When idle, it tries
+//  to merge them into large pages. Every candidate holds a reference to its
+//  process, so the process outlives its queued spans.
+
+void Vmm::QueueCollapse(Process * const proc, vaddr_t const span)
+{
+    Process * evicted = nullptr;
+
+    withInterrupts (false)
+    {
+        CollapseQueue & q = MyCollapseCandidates;
+
+        if (q.Count > 0)
+        {
+            CollapseCandidate const & last = q.Entries[(q.Head + q.Count - 1) % CollapseQueueCapacity];
+
+            if (last.Proc == proc && last.Span == span.Value)
+                return;
+        }
+        //  Faults tend to come in runs within the same span.
+
+        if (q.Count == CollapseQueueCapacity)
+        {
+            evicted = q.Entries[q.Head].Proc;
+
+            q.Head = (q.Head + 1) % CollapseQueueCapacity;
+            --q.Count;
+        }
+        //  The oldest candidate makes room.
+
+        proc->AcquireReference();
+
+        q.Entries[(q.Head + q.Count++) % CollapseQueueCapacity] = CollapseCandidate { proc, span.Value };
+    }
+
+    if (evicted != nullptr)
+        evicted->ReleaseReference();
+    //  Released outside the guard, in case it was the last reference.
+}
+
+/*  Copy-on-Write  */
+
+static Handle HandleCopyOnWriteFault(Process * proc, vaddr_t const vaddr, PageFaultFlags const flags)
+{
+    if (proc == nullptr) proc = likely(Cores::IsReady()) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    Memory::Vas * const vas = &(proc->Vas);
+    Handle res;
+
+    size_t const slot = vas->Lock.AcquireAsReader();
+
+    MemoryRegion const * const reg = vas->FindRegion(vaddr);
+
+    if unlikely(reg == nullptr || reg->Content == MemoryContent::Free
+             || 0 == (reg->Type & MemoryAllocationOptions::CopyOnWrite)
+             || 0 == (reg->Flags & MemoryFlags::Writable)
+             || (0 != (flags & PageFaultFlags::Userland) && 0 == (reg->Flags & MemoryFlags::Userland)))
+        res = HandleResult::Failed;
+    else
+        res = Vmm::BreakCopyOnWrite(proc, vaddr);
+    //  The lock keeps the region, and thus the page, from going away meanwhile.
+
+    vas->Lock.ReleaseAsReader(slot);
+
+    return res;
+}
+
 /****************
     Vmm class
 ****************/
 
 /*  Statics  */
 
-SmpLock Vmm::KernelHeapLock;
+SmpQueuedLock Vmm::KernelHeapLock;
 
 KernelVas Vmm::KVas;
 
+size_t Vmm::FaultAroundPages = 0;
+size_t Vmm::ZeroedFrameTarget = 64;
+
+bool Vmm::TransparentLargePages = true;
+
+/*  Fault-around and Zeroed Frames  */
+
+Handle Vmm::SetFaultAround(size_t pages, size_t zeroedFrames)
+{
+    if unlikely(pages > MaxFaultAround || zeroedFrames > ZeroedFramePoolCapacity)
+        return HandleResult::ArgumentOutOfRange;
+
+    FaultAroundPages = pages;
+    ZeroedFrameTarget = zeroedFrames;
+
+    return HandleResult::Okay;
+}
+
+void Vmm::RefillZeroedFrames()
+{
+    //  Meant to be called by idle cores, with interrupts enabled. The pool is
+    //  brought to its target one frame at a time, so the core stays responsive.
+
+    if unlikely(!Cores::IsReady())
+        return;
+
+    while (MyZeroedFrames.Count > ZeroedFrameTarget)
+    {
+        paddr_t const paddr = TakeZeroedFrame();
+
+        if (paddr != nullpaddr)
+            Pmm::FreeFrame(paddr);
+    }
+
+    while (MyZeroedFrames.Count < ZeroedFrameTarget)
+    {
+        paddr_t const paddr = Pmm::AllocateFrame();
+
+        if unlikely(paddr == nullpaddr)
+            return;
+
+        if unlikely(Vmm::ZeroFrame(paddr) != HandleResult::Okay)
+        {
+            Pmm::FreeFrame(paddr);
+
+            return;
+        }
+
+        ReturnZeroedFrame(paddr);
+    }
+}
+
+/*  Transparent Large Pages  */
+
+void Vmm::CollapseLargePages()
+{
+    //  Meant to be called by idle cores, with interrupts enabled.
+
+    if unlikely(!Cores::IsReady() || !TransparentLargePages)
+        return;
+
+    while (true)
+    {
+        CollapseCandidate cand;
+
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            CollapseQueue & q = MyCollapseCandidates;
+
+            if (q.Count == 0)
+                return;
+
+            cand = q.Entries[q.Head];
+            q.Head = (q.Head + 1) % CollapseQueueCapacity;
+            --q.Count;
+        }
+
+        Memory::Vas * const vas = &(cand.Proc->Vas);
+        Handle res = HandleResult::PageMapped;
+
+        size_t const slot = vas->Lock.AcquireAsReader();
+
+        MemoryRegion const * const reg = vas->FindRegion(vaddr_t(cand.Span));
+
+        bool const eligible = reg != nullptr && reg->Content != MemoryContent::Share
+            && 0 == (reg->Type & MemoryAllocationOptions::CopyOnWrite)
+            && reg->Range.Start <= vaddr_t(cand.Span)
+            && reg->Range.End >= vaddr_t(cand.Span) + LargePageSize;
+        //  Frames shared with other mappings must stay where they are, and a
+        //  part of the span may have been split off and shared since it was
+        //  queued.
+
+        vas->Lock.ReleaseAsReader(slot);
+
+        if (eligible)
+            res = CollapseLargePage(cand.Proc, vaddr_t(cand.Span));
+        //  Pages shared meanwhile gain references, which the merge checks for
+        //  under the paging lock before committing.
+
+        if (res == HandleResult::PageInUse)
+            QueueCollapse(cand.Proc, vaddr_t(cand.Span));
+        //  The process was running somewhere; it may be idle next time.
+
+        cand.Proc->ReleaseReference();
+
+        if (res == HandleResult::PageInUse)
+            return;
+    }
+}
+
 /*  Page Management  */
 
 Handle Vmm::HandlePageFault(Execution::Process * proc
@@ -84,8 +328,17 @@ Handle Vmm::HandlePageFault(Execution::Process * proc
     //  Assumes interrupts are disabled upon call.
 
     if unlikely(0 != (flags & PageFaultFlags::Present))
-        return HandleResult::Failed;
-    //  Page is present. This means this is an access (write/execute) failure.
+    {
+        //  Page is present. This means this is an access (write/execute) failure,
+        //  which is only legitimate for writes to copy-on-write pages.
+
+        if (0 == (flags & PageFaultFlags::Write)
+            || 0 != (flags & (PageFaultFlags::Execute | PageFaultFlags::Reserved))
+            || !(vaddr >= Vmm::UserlandStart && vaddr < Vmm::UserlandEnd))
+            return HandleResult::Failed;
+
+        return HandleCopyOnWriteFault(proc, vaddr, flags);
+    }
 
     if unlikely(!((vaddr >= Vmm::UserlandStart && vaddr <= Vmm::UserlandEnd)
                || (vaddr >= Vmm::KernelStart   && vaddr <= Vmm::KernelEnd  )))
@@ -100,7 +353,11 @@ Handle Vmm::HandlePageFault(Execution::Process * proc
     paddr_t paddr;
 
     vaddr_t const vaddr_algn = RoundDown(vaddr, PageSize);
-    MemoryRegion * reg;
+    MemoryRegion reg;
+    size_t seq, slot = 0;
+    bool locked = false;
+
+    LastRegionHint * const hint = likely(Cores::IsReady()) ? &LastRegion : nullptr;
 
     if unlikely(vaddr >= Vmm::KernelStart)
     {
@@ -109,89 +366,246 @@ Handle Vmm::HandlePageFault(Execution::Process * proc
             ("enlarger", KVas.EnlargingCore)XEND;
     }
 
-    vas->Lock.AcquireAsReader();
-
 #define RETURN(HRES) do { res = HandleResult::HRES; goto end; } while (false)
 
-    if (vas->LastSearched != nullptr && vas->LastSearched->Contains(vaddr))
-        reg = vas->LastSearched;
-        //  No need to check whether anything can be allocated in the page or not.
+    seq = vas->ReadBegin();
+
+    if (hint != nullptr && hint->Vas == vas && hint->Sequence == seq
+        && hint->Region.Contains(vaddr))
+        reg = hint->Region;
+        //  The hint is a copy taken at this very sequence number, so it is
+        //  exactly what the tree holds. It already passed the checks below.
     else
     {
-        reg = vas->FindRegion(vaddr);
+        if unlikely(!vas->FindRegionOptimistic(vaddr, reg, seq))
+        {
+            //  Either a writer is at work or the region isn't there; the lock
+            //  will tell.
+
+            slot = vas->Lock.AcquireAsReader();
+            locked = true;
+
+            seq = vas->ReadBegin();
 
-        if unlikely( reg == nullptr
-                 || reg->Content == MemoryContent::Free)
+            MemoryRegion const * const found = vas->FindRegion(vaddr);
+
+            if unlikely(found == nullptr)
+                RETURN(ArgumentOutOfRange);
+
+            reg = *found;
+        }
+
+        if unlikely(reg.Content == MemoryContent::Free)
             RETURN(ArgumentOutOfRange);
         //  Either of these conditions means this page fault was caused by a hit on
         //  unallocated/freed memory.
 
-        if unlikely((reg->Type & MemoryAllocationOptions::StrategyMask) != MemoryAllocationOptions::AllocateOnDemand)
+        if unlikely((reg.Type & MemoryAllocationOptions::StrategyMask) != MemoryAllocationOptions::AllocateOnDemand)
             RETURN(PageUndemandable);
         //  Regions which aren't allocated on demand aren't covered by this handler.
+
+        if (hint != nullptr)
+        {
+            hint->Vas = vas;
+            hint->Region = reg;
+            hint->Sequence = seq;
+        }
+        //  Make the next fault on this core potentially faster. The guard and
+        //  access checks below depend on the faulting address and flags, so they
+        //  are performed every time anyway.
     }
 
-    if unlikely((0 != (reg->Type & MemoryAllocationOptions::GuardLow ) && vaddr_algn <  (reg->Range.Start + PageSize))
-             || (0 != (reg->Type & MemoryAllocationOptions::GuardHigh) && vaddr_algn >= (reg->Range.End   - PageSize)))
+    if unlikely((0 != (reg.Type & MemoryAllocationOptions::GuardLow ) && vaddr_algn <  (reg.Range.Start + PageSize))
+             || (0 != (reg.Type & MemoryAllocationOptions::GuardHigh) && vaddr_algn >= (reg.Range.End   - PageSize)))
         RETURN(PageGuard);
     //  Thie hit seems to have landed on a guard page.
 
-    if unlikely((0 != (flags & PageFaultFlags::Execute ) && 0 == (reg->Flags & MemoryFlags::Executable))
-             || (0 != (flags & PageFaultFlags::Userland) && 0 == (reg->Flags & MemoryFlags::Userland  )))
+    if unlikely((0 != (flags & PageFaultFlags::Execute ) && 0 == (reg.Flags & MemoryFlags::Executable))
+             || (0 != (flags & PageFaultFlags::Userland) && 0 == (reg.Flags & MemoryFlags::Userland  )))
         RETURN(Failed);
     //  So this was either an attempt to execute a non-executable page, or to
     //  access (in any way) a supervisor page from userland.
 
     //  Reaching this point means this page is meant to be allocated.
 
-    vas->LastSearched = reg;
-    //  Make the next operation potentially faster. This is done even if the
-    //  following allocation fails, because it doesn't affect the correctness of
-    //  the VAS.
+    {
+        bool const user = vaddr < KernelStart;
+        bool const pooled = user && hint != nullptr
+            && 0 != (reg.Flags & MemoryFlags::Writable)
+            && GetPreferredNode(reg.Type) == Pmm::LocalNode;
+        //  Only writable userland pages are zeroed, and the pool only holds
+        //  frames from the local node.
 
-    paddr = Pmm::AllocateFrame();
+        vaddr_t const usableStart = 0 != (reg.Type & MemoryAllocationOptions::GuardLow)
+            ? reg.Range.Start + PageSize : reg.Range.Start;
+        vaddr_t const usableEnd = 0 != (reg.Type & MemoryAllocationOptions::GuardHigh)
+            ? reg.Range.End - PageSize : reg.Range.End;
 
-    if unlikely(paddr == nullpaddr)
-        RETURN(OutOfMemory);
-    //  Okay... Out of memory... Bad.
-    //  TODO: Handle this.
+        size_t pageCount = (usableEnd - vaddr_algn).Value / PageSize.Value;
 
-    //  Right now, the page is categorically unmapped.
+        if (pageCount > 1 + FaultAroundPages)
+            pageCount = 1 + FaultAroundPages;
+        //  Fault-around goes forward, which suits sequential access.
 
-    res = Vmm::MapPage(proc, vaddr_algn, paddr, reg->Flags);
+        uint64_t mapped = 0, dirty = 0;
+        //  Bit i stands for the i-th page starting at the faulting one.
 
-    //  Very important note - here are two acceptable results:
-    //  Okay and PageMapped.
+        vaddr_t const span = RoundDown(vaddr_algn, LargePageSize);
+        bool large = false;
 
-    if unlikely(res != HandleResult::Okay)
-    {
-        Pmm::FreeFrame(paddr);
-        //  Get rid of the physical page if mapping failed. :frown:
-    }
+        if (TransparentLargePages && hint != nullptr
+            && span >= usableStart && span + LargePageSize <= usableEnd)
+        {
+            //  The whole 2-MiB span belongs to this region, so it may as well be
+            //  a single page.
+
+            if (Vmm::CanMapLargePage(proc, span))
+            {
+                paddr = Pmm::AllocateFrame(FrameSize::_2MiB, AddressMagnitude::Any, 0, GetPreferredNode(reg.Type));
+
+                if (paddr != nullpaddr)
+                {
+                    if likely(Vmm::MapPage(proc, span, paddr, FrameSize::_2MiB, reg.Flags) == HandleResult::Okay)
+                    {
+                        large = true;
+                        pageCount = 0;
+                    }
+                    else
+                        Pmm::FreeFrame(paddr);
+                    //  Small pages got there first.
+                }
+            }
+            else if (user && reg.Content != MemoryContent::Share
+                && 0 == (reg.Type & MemoryAllocationOptions::CopyOnWrite))
+                Vmm::QueueCollapse(proc, span);
+            //  Small pages are already there; they may be merged later.
+        }
 
-    vas->Lock.ReleaseAsReader();
+        for (size_t i = 0; i < pageCount; ++i)
+        {
+            vaddr_t const page = vaddr_algn + vsize_t(i * PageSize.Value);
+            bool clean = false;
 
-    // MSG_("Allocated on demand page %XP at %Xp.%n", paddr, vaddr_algn);
+            if (pooled && (paddr = TakeZeroedFrame()) != nullpaddr)
+                clean = true;
+            else
+                paddr = Pmm::AllocateFrame(FrameSize::_4KiB, AddressMagnitude::Any, 0, GetPreferredNode(reg.Type));
 
-    if likely(res == HandleResult::Okay)
-    {
-        if likely(vaddr < KernelStart)
-        {
-            //  This was a request in userland, therefore the page contents need to
-            //  be TERMINATED.
+            if unlikely(paddr == nullpaddr)
+            {
+                if (i == 0)
+                    RETURN(OutOfMemory);
+                //  Okay... Out of memory... Bad.
+                //  TODO: Handle this.
+
+                break;
+                //  The neighbours can wait for their own faults.
+            }
+
+            //  Right now, the page is categorically unmapped.
+
+            Handle const mapRes = Vmm::MapPage(proc, page, paddr, reg.Flags);
 
-            if (0 != (reg->Flags & MemoryFlags::Writable))
-                memset(vaddr_algn, 0, PageSize);
-                //  This is allowed.
+            //  Very important note - here are two acceptable results:
+            //  Okay and PageMapped.
+
+            if likely(mapRes == HandleResult::Okay)
+            {
+                mapped |= 1ULL << i;
+
+                if (!clean)
+                    dirty |= 1ULL << i;
+            }
             else
-                withWriteProtect (false)
-                    memset(vaddr_algn, 0xCA, PageSize);
-                //  It's all CACA! It shouldn't be read, it should be written to using
-                //  a syscall.
+            {
+                if (clean)
+                    ReturnZeroedFrame(paddr);
+                else
+                    Pmm::FreeFrame(paddr);
+                //  Get rid of the physical page if mapping failed. :frown:
+
+                if (i == 0)
+                    res = mapRes;
+
+                if (mapRes != HandleResult::PageMapped)
+                    break;
+                //  A neighbour mapped by someone else is simply skipped.
+            }
+        }
+
+        if (!locked && (mapped != 0 || large) && unlikely(!vas->ReadValidate(seq)))
+        {
+            //  The VAS changed while the pages were being mapped without the
+            //  lock. Writers unmap the pages of the regions they free while
+            //  holding the lock, so the lock holds the verdict on whether these
+            //  pages survive.
+
+            slot = vas->Lock.AcquireAsReader();
+
+            MemoryRegion const * const found = vas->FindRegion(vaddr);
+
+            if unlikely(found == nullptr
+                     || !(found->Range == reg.Range)
+                     || found->Content != reg.Content
+                     || found->Type != reg.Type
+                     || found->Flags != reg.Flags)
+            {
+                if (large)
+                    Vmm::UnmapPage(proc, span);
+                else for (size_t i = 0; i < pageCount; ++i)
+                    if (0 != (mapped & (1ULL << i)))
+                        Vmm::UnmapPage(proc, vaddr_algn + vsize_t(i * PageSize.Value));
+                //  This drops the frames' reference counts, freeing them. If a
+                //  writer got to them first, this fails harmlessly.
+
+                mapped = 0;
+                large = false;
+                //  Not zeroed either. The access will fault again if it retries.
+            }
+
+            vas->Lock.ReleaseAsReader(slot);
+        }
+
+        if (locked)
+            vas->Lock.ReleaseAsReader(slot);
+
+        // MSG_("Allocated on demand page %XP at %Xp.%n", paddr, vaddr_algn);
+
+        if likely(user)
+        {
+            //  This was a request in userland, therefore the page contents need to
+            //  be TERMINATED. Frames from the pool are zeroed already.
+
+            if (large)
+            {
+                if (0 != (reg.Flags & MemoryFlags::Writable))
+                    memclrnt(reinterpret_cast<void *>(span.Value), LargePageSize.Value);
+                    //  Far larger than the caches, so it would only flush them.
+                else
+                    withWriteProtect (false)
+                        memset(span, 0xCA, LargePageSize);
+            }
+
+            for (size_t i = 0; i < pageCount; ++i)
+            {
+                if (0 == (mapped & dirty & (1ULL << i)))
+                    continue;
+
+                vaddr_t const page = vaddr_algn + vsize_t(i * PageSize.Value);
+
+                if (0 != (reg.Flags & MemoryFlags::Writable))
+                    memset(page, 0, PageSize);
+                    //  This is allowed.
+                else
+                    withWriteProtect (false)
+                        memset(page, 0xCA, PageSize);
+                    //  It's all CACA! It shouldn't be read, it should be written to using
+                    //  a syscall.
+            }
         }
         // else
         // {
-        //     ASSERTX(0 != (reg->Flags & MemoryFlags::Writable)
+        //     ASSERTX(0 != (reg.Flags & MemoryFlags::Writable)
         //         , "Kernel should not request read-only pages allocated on demand!")XEND;
 
         //     memset(reinterpret_cast<void *>(vaddr_algn), 0, PageSize);
@@ -203,7 +617,8 @@ Handle Vmm::HandlePageFault(Execution::Process * proc
 
 #undef RETURN
 end:
-    vas->Lock.ReleaseAsReader();
+    if (locked)
+        vas->Lock.ReleaseAsReader(slot);
 
     return res;
 }
@@ -233,14 +648,17 @@ Handle Vmm::CheckMemoryRegion(Execution::Process * proc
         (  0 != (type & MemoryCheckType::Writable) ? MemoryFlags::Writable : MemoryFlags::None)
         | (0 != (type & MemoryCheckType::Userland) ? MemoryFlags::Userland : MemoryFlags::None);
 
-    MemoryRegion * reg;
+    MemoryRegion const * reg;
+
+    LastRegionHint const * const hint = likely(Cores::IsReady()) ? &LastRegion : nullptr;
 
 #define RETURN(HRES) do { res = HandleResult::HRES; goto end; } while (false)
 
-    vas->Lock.AcquireAsReader();
+    size_t const slot = vas->Lock.AcquireAsReader();
 
-    if (vas->LastSearched != nullptr && vas->LastSearched->Contains(addr))
-        reg = vas->LastSearched;
+    if (hint != nullptr && hint->Vas == vas && hint->Sequence == vas->ReadBegin()
+        && hint->Region.Contains(addr))
+        reg = &(hint->Region);
         //  No need to check whether anything can be allocated in the page or not.
     else
     {
@@ -270,9 +688,11 @@ Handle Vmm::CheckMemoryRegion(Execution::Process * proc
 
     if unlikely((0 != (type & MemoryCheckType::Private))
          && (reg->Content == MemoryContent::Share
-          || reg->Content == MemoryContent::Runtime))
+          || reg->Content == MemoryContent::Runtime
+          || 0 != (reg->Type & MemoryAllocationOptions::CopyOnWrite)))
         RETURN(Failed);
-    //  Private memory was asked for, and this is shared or part of the runtime.
+    //  Private memory was asked for, and this is shared, part of the runtime, or
+    //  may share frames until written.
 
     //  Reaching this point means this region is passing the check.
 
@@ -289,7 +709,7 @@ next_region:
 
 #undef RETURN
 end:
-    vas->Lock.ReleaseAsReader();
+    vas->Lock.ReleaseAsReader(slot);
 
     return res;
 }
@@ -300,10 +720,15 @@ Handle Vmm::AllocatePages(Process * proc, vsize_t const size
     , MemoryAllocationOptions const type
     , MemoryFlags const flags
     , MemoryContent content
-    , vaddr_t & vaddr)
+    , vaddr_t & vaddr
+    , vsize_t const alignment)
 {
     if (proc == nullptr) proc = likely(Cores::IsReady()) ? Cpu::GetProcess() : &BootstrapProcess;
 
+    Vmm::FlushInvalidations(proc, 0 == (type & MemoryAllocationOptions::VirtualUser));
+    //  Pages unmapped lazily must not be handed out again while other cores
+    //  may still hold stale translations of them.
+
     if (MemoryAllocationOptions::AllocateOnDemand == (type & MemoryAllocationOptions::AllocateOnDemand)
         || 0 == (type & MemoryAllocationOptions::Commit))
     {
@@ -311,27 +736,27 @@ Handle Vmm::AllocatePages(Process * proc, vsize_t const size
         //  AoD and reserved are both very simple to handle.
 
         if (0 != (type & MemoryAllocationOptions::VirtualUser))
-            return proc->Vas.Allocate(vaddr, size, flags, content, type);
+            return proc->Vas.Allocate(vaddr, size, flags, content, type, true, alignment);
         else
-            return KVas.Allocate(vaddr, size, flags, content, type);
+            return KVas.Allocate(vaddr, size, flags, content, type, true, alignment);
     }
     else if (0 != (type & MemoryAllocationOptions::Commit))
     {
         Handle res;             //  Intermediary result.
         vaddr_t ret = vaddr;    //  Just a quicker way...
-        SmpLock * heapLock;
+        SmpQueuedLock * heapLock;
 
         // MSG_("ret = vaddr = %Xp BEFORE; size = %Xs%n", ret, size);
 
         if (0 != (type & MemoryAllocationOptions::VirtualUser))
         {
-            res = proc->Vas.Allocate(ret, size, flags, content, type);
+            res = proc->Vas.Allocate(ret, size, flags, content, type, true, alignment);
 
             heapLock = &(proc->LocalTablesLock);
         }
         else
         {
-            res = KVas.Allocate(ret, size, flags, content, type);
+            res = KVas.Allocate(ret, size, flags, content, type, true, alignment);
 
             heapLock = &(Vmm::KernelHeapLock);
         }
@@ -346,24 +771,43 @@ Handle Vmm::AllocatePages(Process * proc, vsize_t const size
         InterruptGuard<> intGuard;
         //  Guard the rest of the scope from interrupts.
 
-        LockGuard<SmpLock > heapLg {*heapLock};
+        LockGuard<SmpQueuedLock> heapLg {*heapLock};
         //  Note: this ain't flexible because heapLock ain't gonna be null.
 
         vsize_t offset { 0 };
-        for (; offset < size; offset += PageSize)
+        while (offset < size)
         {
-            paddr_t const paddr = Pmm::AllocateFrame();
+            FrameSize fSize = FrameSize::_4KiB;
+            paddr_t paddr = nullpaddr;
+
+            if (TransparentLargePages && Is2MiBAligned(ret + offset) && size - offset >= LargePageSize)
+            {
+                paddr = Pmm::AllocateFrame(FrameSize::_2MiB, AddressMagnitude::Any, 0, GetPreferredNode(type));
+
+                if likely(paddr != nullpaddr)
+                    fSize = FrameSize::_2MiB;
+            }
+            //  Whole aligned spans get large pages, if there are any left.
+
+            if (paddr == nullpaddr)
+                paddr = Pmm::AllocateFrame(FrameSize::_4KiB, AddressMagnitude::Any, 0, GetPreferredNode(type));
 
             if unlikely(paddr == nullpaddr)
                 goto backtrack;
 
             res = Vmm::MapPage(proc, ret + offset, paddr
-                , flags, MemoryMapOptions::NoLocking);
+                , fSize, flags, MemoryMapOptions::NoLocking);
 
             // MSG_("Mapped %XP at %Xp: %H%n", paddr, ret + offset, res);
 
             if unlikely(res != HandleResult::Okay)
+            {
+                Pmm::FreeFrame(paddr);
+
                 goto backtrack;
+            }
+
+            offset += fSize == FrameSize::_2MiB ? vsize_t(LargePageSize.Value) : vsize_t(PageSize.Value);
         }
 
         if likely(0 != (type & MemoryAllocationOptions::VirtualUser))
@@ -396,9 +840,9 @@ Handle Vmm::FreePages(Process * proc, vaddr_t const vaddr, vsize_t const size)
 
     Memory::Vas * vas = &(proc->Vas);
 
-    if (vaddr >= KernelStart)
+    if (vaddr >= KernelStart && vaddr < KernelEnd)
         vas = &(Vmm::KVas);
-    else
+    else if (!(vaddr >= UserlandStart && vaddr < UserlandEnd))
         return HandleResult::PageMapIllegalRange;
     //  Cannot use this to free memory from elsewhere.
 
@@ -408,13 +852,13 @@ Handle Vmm::FreePages(Process * proc, vaddr_t const vaddr, vsize_t const size)
             (void)proc_;
             (void)vaddr_;
 
-            reinterpret_cast<Memory::Vas *>(cookie)->Lock.AcquireAsWriter();
+            reinterpret_cast<Memory::Vas *>(cookie)->BeginWrite();
         }, [](Process * proc_, vaddr_t vaddr_, vsize_t size_, Handle oRes, void * cookie)
         {
             (void)proc_;
 
             Handle res = reinterpret_cast<Memory::Vas *>(cookie)->Free(vaddr_, size_, false, false, false);
-            reinterpret_cast<Memory::Vas *>(cookie)->Lock.ReleaseAsWriter();
+            reinterpret_cast<Memory::Vas *>(cookie)->EndWrite();
 
             if unlikely(oRes != HandleResult::Okay && oRes != HandleResult::PageUnmapped)
                 return oRes;
@@ -423,3 +867,134 @@ Handle Vmm::FreePages(Process * proc, vaddr_t const vaddr, vsize_t const size)
         }
         , vas);
 }
+
+/*  Sharing  */
+
+Handle Vmm::SharePages(Process * src, vaddr_t const srcAddr, vsize_t const size
+    , Process * const dst, vaddr_t & dstAddr, bool const copyOnWrite, bool const readOnly)
+{
+    if (src == nullptr) src = likely(Cores::IsReady()) ? Cpu::GetProcess() : &BootstrapProcess;
+
+    if unlikely(dst == nullptr)
+        return HandleResult::ArgumentNull;
+
+    if unlikely(!Is4KiBAligned(srcAddr) || !Is4KiBAligned(size))
+        return HandleResult::AlignmentFailure;
+
+    if unlikely(size == 0 || srcAddr < UserlandStart || srcAddr + size > UserlandEnd
+        || srcAddr + size < srcAddr)
+        return HandleResult::ArgumentOutOfRange;
+    //  Only userland memory can be shared.
+
+    Memory::Vas * const vas = &(src->Vas);
+    PointerAndSize const rng { srcAddr.Value, size.Value };
+    Handle res = HandleResult::Okay;
+    MemoryRegion reg;
+
+    vas->BeginWrite();
+
+    MemoryRegion * const found = vas->FindRegion(srcAddr);
+
+    if unlikely(found == nullptr || found->Content == MemoryContent::Free
+             || srcAddr + size > found->Range.End)
+        res = HandleResult::ArgumentOutOfRange;
+        //  The range must lie within a single allocated region.
+    else if unlikely((found->Type & MemoryAllocationOptions::StrategyMask) == MemoryAllocationOptions::Reserve
+                  || 0 == (found->Flags & MemoryFlags::Userland))
+        res = HandleResult::PageReserved;
+    else if unlikely((0 != (found->Type & MemoryAllocationOptions::GuardLow ) && DoRangesIntersect(rng, { (found->Range.Start         ).Value, PageSize.Value }))
+                  || (0 != (found->Type & MemoryAllocationOptions::GuardHigh) && DoRangesIntersect(rng, { (found->Range.End - PageSize).Value, PageSize.Value })))
+        res = HandleResult::PageGuard;
+    else if (!copyOnWrite)
+    {
+        //  Both sides must see the same frames, so pages which would be allocated
+        //  on demand are allocated now.
+
+        for (vsize_t offset { 0 }; offset < size; offset += PageSize)
+        {
+            paddr_t paddr;
+
+            if (Vmm::Translate(src, srcAddr + offset, paddr) != HandleResult::PageUnmapped)
+                continue;
+
+            paddr = Pmm::AllocateFrame(FrameSize::_4KiB, AddressMagnitude::Any, 0, GetPreferredNode(found->Type));
+
+            if unlikely(paddr == nullpaddr)
+            {
+                res = HandleResult::OutOfMemory;
+
+                break;
+            }
+
+            res = Vmm::ZeroFrame(paddr);
+
+            if likely(res == HandleResult::Okay)
+                res = Vmm::MapPage(src, srcAddr + offset, paddr, found->Flags);
+
+            if unlikely(res != HandleResult::Okay)
+            {
+                Pmm::FreeFrame(paddr);
+
+                break;
+            }
+        }
+
+    }
+
+    if likely(res == HandleResult::Okay && srcAddr + size < found->Range.End)
+        res = vas->Split(srcAddr + size, false);
+
+    if likely(res == HandleResult::Okay && srcAddr > found->Range.Start)
+        res = vas->Split(srcAddr, false);
+    //  Only the shared range is marked, so it gets a region of its own.
+
+    if likely(res == HandleResult::Okay)
+    {
+        MemoryRegion * const shared = vas->FindRegion(srcAddr);
+
+        if (copyOnWrite)
+            shared->Type |= MemoryAllocationOptions::CopyOnWrite;
+        else
+            shared->Content = MemoryContent::Share;
+
+        reg = *shared;
+    }
+
+    vas->EndWrite();
+
+    if unlikely(res != HandleResult::Okay)
+        return res;
+
+    MemoryAllocationOptions type = MemoryAllocationOptions::VirtualUser
+        | (reg.Type & MemoryAllocationOptions::NodeMask);
+    MemoryFlags flags = reg.Flags;
+
+    if (copyOnWrite)
+    {
+        type |= MemoryAllocationOptions::CopyOnWrite;
+
+        if ((reg.Type & MemoryAllocationOptions::StrategyMask) == MemoryAllocationOptions::AllocateOnDemand)
+            type |= MemoryAllocationOptions::AllocateOnDemand;
+        else
+            type |= MemoryAllocationOptions::Used;
+        //  Pages missing from the source are missing from the copy too.
+    }
+    else
+        type |= MemoryAllocationOptions::Used;
+
+    if (readOnly)
+        flags &= ~MemoryFlags::Writable;
+
+    res = Vmm::AllocatePages(dst, size, type, flags
+        , copyOnWrite ? MemoryContent::Generic : MemoryContent::Share, dstAddr);
+
+    if unlikely(res != HandleResult::Okay)
+        return res;
+
+    res = Vmm::ShareRange(src, srcAddr, size, dst, dstAddr, flags, copyOnWrite);
+
+    if unlikely(res != HandleResult::Okay)
+        Vmm::FreePages(dst, dstAddr, size);
+
+    return res;
+}
@@ -0,0 +1,286 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include "rcu.hpp"
+#include <beel/sync/smp.lock.hpp>
+#include <beel/sync/atomic.hpp>
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+/****************
+    Internals
+****************/
+
+static SmpLock GraceLock {};
+//  Guards the lists of entries, and the start and the end of grace periods.
+
+static RcuEntry * Waiting = nullptr, * * WaitingTail = &Waiting;
+//  Entries given since the grace period in progress began.
+static RcuEntry * Current = nullptr, * * CurrentTail = &Current;
+//  Entries which the grace period in progress is for.
+
+static bool InProgress = false;
+static Atomic<size_t> Remaining {0};
+//  Cores which have yet to pass through a quiescent state, plus one while the
+//  grace period is being started.
+static uint64_t Completed = 0;
+
+static void StartGracePeriod(bool & finished);
+static void FinishGracePeriod();
+
+static __forceinline void ReportQuiescentState()
+{
+    if (--Remaining == 0)
+        FinishGracePeriod();
+    //  This core was the last one the grace period waited for.
+}
+
+void StartGracePeriod(bool & finished)
+{
+    //  Must be called with the lock held.
+
+    Current = Waiting;
+    CurrentTail = WaitingTail;
+
+    Waiting = nullptr;
+    WaitingTail = &Waiting;
+
+    InProgress = true;
+    Remaining.Store(1);
+    //  Keeps the grace period from ending before all cores are accounted for.
+
+    for (size_t i = 0, count = Cores::GetCount(); i < count; ++i)
+    {
+        size_t * const state = &(Cores::Get(i)->RcuState);
+        size_t cur = __atomic_load_n(state, __ATOMIC_RELAXED);
+
+        ++Remaining;
+
+        do
+        {
+            if (0 != (cur & Rcu::IdleBit))
+            {
+                --Remaining;
+                //  Idle cores are not reading anything, and they stay out of
+                //  read-side sections until they wake up, by which point they
+                //  can only find what is left after the update.
+
+                break;
+            }
+        } while (!__atomic_compare_exchange_n(state, &cur, cur | Rcu::PendingBit
+            , false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    }
+
+    finished = --Remaining == 0;
+}
+
+void FinishGracePeriod()
+{
+    bool finished;
+
+    do
+    {
+        RcuEntry * done;
+
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            GraceLock.Acquire();
+
+            done = Current;
+            Current = nullptr;
+            CurrentTail = &Current;
+
+            __atomic_add_fetch(&Completed, 1, __ATOMIC_RELEASE);
+            InProgress = false;
+
+            finished = false;
+
+            if (Waiting != nullptr)
+                StartGracePeriod(finished);
+            //  Entries given meanwhile need another one.
+
+            GraceLock.Release();
+        }
+
+        while (done != nullptr)
+        {
+            RcuEntry * const next = done->Next;
+            //  The function may reuse the entry.
+
+            done->Function(done->Cookie);
+
+            done = next;
+        }
+    } while (finished);
+}
+
+/****************
+    Rcu class
+****************/
+
+/*  Reclamation  */
+
+void Rcu::CallAfterGracePeriod(RcuEntry * entry)
+{
+    ASSERT(entry->Function != nullptr);
+
+    entry->Next = nullptr;
+
+    bool finished = false;
+
+    {   //  Scope to contain the guard.
+        InterruptGuard<> intGuard;
+
+        GraceLock.Acquire();
+
+        *WaitingTail = entry;
+        WaitingTail = &(entry->Next);
+
+        if (!InProgress && likely(Cores::IsReady()))
+            StartGracePeriod(finished);
+        //  Until all cores are up, their quiescent states cannot be tracked.
+        //  The first one reported afterwards starts the grace period.
+
+        GraceLock.Release();
+    }
+
+    if (finished)
+        FinishGracePeriod();
+}
+
+static void SetFlag(void * cookie)
+{
+    reinterpret_cast<Atomic<bool> *>(cookie)->Store(true);
+}
+
+void Rcu::Synchronize()
+{
+    ASSERT(InterruptState::IsEnabled()
+        , "Cannot wait for a grace period within a read-side section.");
+    ASSERT(Cores::IsReady()
+        , "Cannot wait for a grace period before all cores are up.");
+
+    Atomic<bool> done {false};
+    RcuEntry entry { &SetFlag, &done };
+
+    CallAfterGracePeriod(&entry);
+
+    while (!done.Load())
+    {
+        QuiescentState();
+        //  This core is not reading anything, and it may be the last one the
+        //  grace period waits for.
+
+        DO_NOTHING();
+    }
+}
+
+/*  Quiescent States  */
+
+void Rcu::QuiescentState()
+{
+    if unlikely(!Cores::IsReady())
+        return;
+
+    size_t * const state = &(Cpu::GetData()->RcuState);
+
+    if likely(0 == (*state & PendingBit))
+    {
+        if unlikely(Waiting != nullptr && !InProgress)
+        {
+            //  Entries were given before grace periods could be started.
+
+            bool finished = false;
+
+            {   //  Scope to contain the guard.
+                InterruptGuard<> intGuard;
+
+                GraceLock.Acquire();
+
+                if (Waiting != nullptr && !InProgress)
+                    StartGracePeriod(finished);
+
+                GraceLock.Release();
+            }
+
+            if (finished)
+                FinishGracePeriod();
+        }
+
+        return;
+    }
+    //  Usually nothing is awaited, and this costs no atomic operation.
+
+    if (0 != (__atomic_fetch_and(state, ~PendingBit, __ATOMIC_ACQ_REL) & PendingBit))
+        ReportQuiescentState();
+}
+
+void Rcu::EnterIdle()
+{
+    if unlikely(!Cores::IsReady())
+        return;
+
+    size_t const old = __atomic_exchange_n(&(Cpu::GetData()->RcuState), IdleBit, __ATOMIC_SEQ_CST);
+
+    if (0 != (old & PendingBit))
+        ReportQuiescentState();
+}
+
+void Rcu::ExitIdle()
+{
+    if unlikely(!Cores::IsReady())
+        return;
+
+    __atomic_exchange_n(&(Cpu::GetData()->RcuState), (size_t)0, __ATOMIC_SEQ_CST);
+    //  Nothing can be pending on an idle core. The exchange also orders this
+    //  core's reads after the updates which preceded grace periods that did
+    //  not wait for it.
+}
+
+/*  Properties  */
+
+uint64_t Rcu::GetCompletedGracePeriods()
+{
+    return __atomic_load_n(&Completed, __ATOMIC_ACQUIRE);
+}
@@ -38,246 +38,360 @@
 */
 
 #include "scheduler.hpp"
+#include "execution/run_queue.hpp"
 #include "timer.hpp"
+#include "rcu.hpp"
 #include "irqs.hpp"
 #include "system/cpu.hpp"
 
+#include <beel/interrupt.state.hpp>
+#include <beel/sync/atomic.hpp>
+
 using namespace Beelzebub;
 using namespace Beelzebub::Execution;
 using namespace Beelzebub::Memory;
 using namespace Beelzebub::Synchronization;
 using namespace Beelzebub::System;
 
-static constexpr size_t const SizeShift = sizeof(size_t) == 4 ? 5 : 6;
-static constexpr size_t const SizeMask = sizeof(size_t) * 8UL - 1UL;
-
 static constexpr int const AffinityLevels = 3;
-static constexpr size_t const PriorityBitmapSize = (Scheduler::PriorityLevels + sizeof(size_t) * 8 - 1) / (sizeof(size_t) * 8);
+//  0 = hardware threads of the same core, 1 = cores of the same package,
+//  2 = the whole system.
+
+static constexpr size_t const MigrationPeriod = 8;
+//  Number of scheduler ticks between two push-migration attempts.
+static constexpr size_t const MigrationImbalance = 2;
+//  Minimum difference in queue length which warrants pushing a thread away.
+
+static constexpr TimeSpanLite const TargetLatency = 30msecs_l;
+//  Every runnable thread on a core should get to run within this period.
+static constexpr TimeSpanLite const MinimumSlice = 1msecs_l;
+static constexpr TimeSpanLite const MaximumSlice = 50msecs_l;
+static constexpr TimeSpanLite const PostponeDelay = 100usecs_l;
+//  How long pre-emption is deferred while `Scheduler::Postpone` is set.
+static constexpr TimeSpanLite const WakeupDelay = 10usecs_l;
+//  Delay of the first tick after a tickless core receives work.
 
-struct SchedulerData;
-struct SchedulerQueue;
+DEFINE_THREAD_DATA(ThreadSchedulerState, SchedulingData)
 
-struct ThreadSchedulerState
+struct SchedulerData : public RunQueue
 {
-    ThreadSchedulerState * Next, * Previous;
-    SchedulerData * Scheduler;
-    SchedulerQueue * Queue;
-    SchedulerStatus Status;
-    int Priority;
-    Scheduler::AffinityMask Affinity;
-};
+    void Initialize(size_t const cpuIndex, SmpLock * lock)
+    {
+        this->RunQueue::Initialize(cpuIndex);
 
-DEFINE_THREAD_DATA(ThreadSchedulerState, SchedulingData)
+        this->Engaged = false;
+        this->Ticking = false;
+        this->Ticks = 0;
+        this->Pending = nullptr;
+        this->BlockLock = nullptr;
+
+        this->Lock = lock;
+
+        for (size_t i = 0; i < AffinityLevels; ++i)
+            this->Next[i] = this;
+    }
 
-struct SchedulerQueue
+    bool Engaged;
+    bool volatile Ticking;
+    //  False when the tick is stopped because nothing can run on this core.
+    ThreadSchedulerState * CurrentThread;
+    ThreadSchedulerState * IdleThread;
+    ThreadSchedulerState * Pending;
+    SmpLock * BlockLock;
+    //  Released once the blocking thread is switched out.
+
+    SmpLock * Lock;
+    //  Kept outside, because locks cannot be thread-local.
+    size_t Ticks;
+
+    SchedulerData * Next[AffinityLevels];
+    uint32_t Topology[AffinityLevels];
+};
+
+namespace
 {
-    ThreadSchedulerState * Pop(size_t const cpuIndex, bool & empty)
-    {
-        ThreadSchedulerState * cur = this->First;
+    __thread SchedulerData MySchedulerData;
 
-        if unlikely(cur == nullptr)
-            return nullptr;
+    SchedulerData * Schedulers[Scheduler::MaximumCPUs];
+    SmpLock SchedulerLocks[Scheduler::MaximumCPUs];
+    SmpLock SchedulersLock {};
 
-        assert(cur->Scheduler == this->Scheduler)((void *)cur->Scheduler);
-        assert(cur->Queue == this)((void *)cur->Queue);
+    Atomic<size_t> IdleCores {0};
+    //  Engaged cores whose tick is stopped, which can only steal work once
+    //  someone wakes them up.
 
-        size_t const cpuIndexWord = (cpuIndex & ~SizeMask) >> SizeShift;
-        size_t const cpuIndexBitMask = 1UL << (cpuIndex & SizeMask);
+    /*  Topology  */
 
-        if likely(0 != (cur->Affinity.Bitmap[cpuIndexWord] & cpuIndexBitMask))
+    __startup void RegisterScheduler(SchedulerData * scdt)
+    {
+        withLock (SchedulersLock)
         {
-            this->First = cur->Next;
+            for (int i = 0; i < AffinityLevels; ++i)
+                for (size_t j = 0; j < Scheduler::MaximumCPUs; ++j)
+                    if (SchedulerData * const other = Schedulers[j]; other != nullptr && other->Topology[i] == scdt->Topology[i])
+                    {
+                        scdt->Next[i] = other->Next[i];
 
-            if likely(cur->Next != nullptr)
-            {
-                cur->Next->Previous = cur->Previous;
-                empty = false;
-            }
-            else
-            {
-                this->Last = nullptr;
-                empty = true;
-            }
+                        COMPILER_MEMORY_BARRIER();
+                        //  The new ring member must be complete before it is published.
+
+                        other->Next[i] = scdt;
 
-            cur->Queue = nullptr;
+                        break;
+                    }
+                    //  Other cores may be walking the rings already, so the new
+                    //  scheduler is spliced in right after a peer.
 
-            return cur;
+            Schedulers[scdt->CpuIndex] = scdt;
         }
+    }
+
+    //  Whether the two schedulers share the given affinity level.
+    __forceinline bool SameDomain(SchedulerData const * a, SchedulerData const * b, int const level)
+    {
+        return level >= 0 && a->Topology[level] == b->Topology[level];
+    }
 
-        empty = false;
+    /*  Balancing  */
 
-        while ((cur = cur->Next) != nullptr)
-        {
-            assert(cur->Scheduler == this->Scheduler)((void *)cur->Scheduler);
-            assert(cur->Queue == this)((void *)cur->Queue);
+    ThreadSchedulerState * Steal(SchedulerData * scdt)
+    {
+        //  Victims are searched from the nearest affinity level outwards, so
+        //  threads migrate between hardware threads of the same core before
+        //  crossing to other cores or packages.
 
-            if likely(0 != (cur->Affinity.Bitmap[cpuIndexWord] & cpuIndexBitMask))
+        for (int i = 0; i < AffinityLevels; ++i)
+            for (SchedulerData * victim = scdt->Next[i]; victim != scdt; victim = victim->Next[i])
             {
-                cur->Previous->Next = cur->Next;
+                if (SameDomain(scdt, victim, i - 1) || victim->Count == 0)
+                    continue;
+                //  Closer levels were already visited.
 
-                if likely(cur->Next != nullptr)
-                    cur->Next->Previous = cur->Previous;
-                else
-                    this->Last = cur->Previous;
+                if (!victim->Lock->TryAcquire())
+                    continue;
+                //  A contended victim is skipped rather than waited upon.
 
-                cur->Queue = nullptr;
+                ThreadSchedulerState * const ret = victim->Pop(scdt->CpuIndex);
 
-                return cur;
+                victim->Lock->Release();
+
+                if (ret != nullptr)
+                    return ret;
             }
-        }
 
         return nullptr;
     }
 
-    void Pop(ThreadSchedulerState * cur, bool & empty)
+    SchedulerData * PushMigrate(SchedulerData * scdt)
     {
-        assert(cur->Scheduler == this->Scheduler)((void *)cur->Scheduler);
-        assert(cur->Queue == this)((void *)cur->Queue);
+        //  Returns the target if its tick needs to be restarted.
 
-        if (cur->Next != nullptr)
-            cur->Next->Previous = cur->Previous;
-        else
-            this->Last = cur->Previous;
+        //  Looks for the least loaded core, preferring nearer ones on ties.
 
-        if (cur->Previous != nullptr)
-            cur->Previous->Next = cur->Next;
-        else
-            this->First = cur->Next;
+        SchedulerData * target = nullptr;
+        size_t targetCount = scdt->Count;
 
-        empty = this->First == nullptr;
+        for (int i = 0; i < AffinityLevels; ++i)
+            for (SchedulerData * cand = scdt->Next[i]; cand != scdt; cand = cand->Next[i])
+            {
+                if (SameDomain(scdt, cand, i - 1))
+                    continue;
 
-        cur->Queue = nullptr;
+                if (size_t const cnt = cand->Count; cnt + MigrationImbalance <= targetCount)
+                {
+                    target = cand;
+                    targetCount = cnt;
+                }
+            }
+
+        if (target == nullptr || !target->Lock->TryAcquire())
+            return nullptr;
+
+        ThreadSchedulerState * const tsc = scdt->Pop(target->CpuIndex);
+
+        if (tsc != nullptr)
+            target->Push(tsc);
+        //  Only threads allowed on the target are popped for it.
+
+        target->Lock->Release();
+
+        return (tsc != nullptr && !target->Ticking) ? target : nullptr;
+        //  The flag is read after the push, under the same lock which the
+        //  target holds when stopping its tick, so no wakeup is lost.
     }
 
-    void Push(ThreadSchedulerState * tsc)
+    SchedulerData * FindIdle(SchedulerData * scdt)
     {
-        tsc->Previous = this->Last;
-        //  tsc->Next is guaranteed to be null here.
+        //  Looks for a core with a stopped tick which could take work off the
+        //  given one, preferring nearer ones.
 
-        if likely(this->Last != nullptr)
-            this->Last->Next = tsc;
-        else
-            this->First = tsc;
+        if likely(IdleCores.Load() == 0)
+            return nullptr;
 
-        this->Last = tsc;
+        for (int i = 0; i < AffinityLevels; ++i)
+            for (SchedulerData * cand = scdt->Next[i]; cand != scdt; cand = cand->Next[i])
+                if (!SameDomain(scdt, cand, i - 1) && cand->Engaged && !cand->Ticking)
+                    return cand;
 
-        tsc->Queue = this;
+        return nullptr;
     }
 
-    ThreadSchedulerState * First, * Last;
-    SchedulerData * Scheduler;
-};
+    void SchedulerTick(SchedulerData * scdt);
 
-struct SchedulerData
-{
-    void Initialize()
+    void WakeTick(void * cookie)
     {
-        this->Engaged = false;
+        (void)cookie;
 
-        for (size_t i = 0; i < Scheduler::PriorityLevels; ++i)
-            this->Queues[i].Scheduler = this;
+        SchedulerData * const scdt = &MySchedulerData;
 
-        for (size_t i = 0; i < AffinityLevels; ++i)
-            this->Next[i] = this;
+        if (!scdt->Ticking && scdt->Engaged)
+        {
+            scdt->Ticking = true;
+            --IdleCores;
+
+            bool const enqueued = Timer::Enqueue(WakeupDelay, &SchedulerTick, scdt);
+
+            assert(enqueued);
+            (void)enqueued;
+        }
     }
 
-    ThreadSchedulerState * Pop(size_t cpuIndex)
+    void Wake(SchedulerData * scdt)
     {
-        ThreadSchedulerState * ret = nullptr;
+        if (scdt == &MySchedulerData)
+            return WakeTick(nullptr);
 
-        size_t bitmapIndex = PriorityBitmapSize;
-
-        do
-        {
-            --bitmapIndex;
+        if unlikely(!Mailbox::IsReady())
+            return;
 
-            if (this->Bitmap[bitmapIndex] != 0)
-            {
-                size_t highestPriority = SizeMask - __builtin_clzl(this->Bitmap[bitmapIndex]);
-                bool empty;
+        ALLOCATE_MAIL(mail, 1, &WakeTick);
+        mail.Links[0] = MailboxEntryLink((uint32_t)scdt->CpuIndex);
+        mail.Post();
+    }
 
-                ret = this->Queues[bitmapIndex * sizeof(size_t) * 8 + highestPriority].Pop(cpuIndex, empty);
+    TimeSpanLite GetSlice(SchedulerData const * scdt, ThreadSchedulerState const * tsc)
+    {
+        //  The target latency is shared between all the runnable threads, and
+        //  higher priorities get proportionally longer slices, up to double.
 
-                if unlikely(empty)
-                    this->Bitmap[bitmapIndex] &= ~(1UL << highestPriority);
+        if (tsc == scdt->IdleThread)
+            return MaximumSlice;
 
-                if (ret != nullptr)
-                {
-                    ret->Scheduler = nullptr;
-                    ret->Next = ret->Previous = nullptr;
-                }
+        uint64_t slice = TargetLatency.Value / (scdt->Count + 1);
 
-                break;
-            }
-        } while (bitmapIndex > 0);
+        slice = slice * (uint64_t)(Scheduler::PriorityLevels + tsc->Priority) / Scheduler::PriorityLevels;
 
-        return ret;
+        if (slice < MinimumSlice.Value)
+            return MinimumSlice;
+        else if (slice > MaximumSlice.Value)
+            return MaximumSlice;
+        else
+            return TimeSpanLite(slice);
     }
 
-    void Push(ThreadSchedulerState * tsc)
+    ThreadSchedulerState * GetNext(SchedulerData * scdt, ThreadSchedulerState * const curThread, bool const yielding)
     {
-        int priority = tsc->Priority;
+        //  Returns null when the current thread ought to keep running.
 
-        assert(priority >= 0 && priority < Scheduler::PriorityLevels)(priority);
-        assert(tsc->Next == nullptr)((void *)tsc->Next);
-        assert(tsc->Previous == nullptr)((void *)tsc->Previous);
+        bool const curIdle = curThread == scdt->IdleThread;
+        bool const anyNext = curIdle || yielding;
+        //  Yielding threads give way to threads of any priority.
+        ThreadSchedulerState * ret = nullptr;
+        SchedulerData * wake = nullptr;
 
-        this->Queues[priority].Push(tsc);
-        this->Bitmap[(priority & ~SizeMask) >> SizeShift] |= 1UL << (priority & SizeMask);
+        scdt->Lock->Acquire();
 
-        tsc->Scheduler = this;
-        tsc->Status = SchedulerStatus::Queued;
-    }
+        if (ThreadSchedulerState * const prev = scdt->Pending; prev != nullptr)
+        {
+            scdt->Pending = nullptr;
+            scdt->Push(prev);
+        }
+        //  The thread switched out during the previous tick is only queued now,
+        //  once its kernel stack is definitely not in use anymore. Otherwise
+        //  other cores could steal it too early.
 
-    size_t CpuIndex;
-    bool Engaged;
-    ThreadSchedulerState * CurrentThread;
-    ThreadSchedulerState * IdleThread;
+        if unlikely(++scdt->Ticks % MigrationPeriod == 0 && scdt->Count > MigrationImbalance)
+            wake = PushMigrate(scdt);
 
-    SchedulerData * Next[AffinityLevels];
+        if (anyNext || scdt->GetHighestPriority() >= curThread->Priority)
+            ret = scdt->Pop(scdt->CpuIndex);
+        //  Threads of equal priority take turns.
 
-    size_t Bitmap[PriorityBitmapSize];
-    SchedulerQueue Queues[Scheduler::PriorityLevels];
-};
+        if (wake == nullptr && scdt->Count > 0)
+            wake = FindIdle(scdt);
+        //  Threads are left waiting here while other cores have stopped ticking,
+        //  so one of them is woken up to steal.
 
-struct WaitingList
-{
-    SchedulerData * Sched;
+        scdt->Lock->Release();
 
-    ThreadSchedulerState * First, * Last;
-};
+        if unlikely(wake != nullptr)
+            Wake(wake);
 
-namespace
-{
-    __thread SchedulerData MySchedulerData;
+        if (ret == nullptr && anyNext && (ret = Steal(scdt)) == nullptr && curIdle)
+        {
+            scdt->Lock->Acquire();
+
+            if (scdt->Count == 0 && scdt->Pending == nullptr)
+            {
+                scdt->Ticking = false;
+                ++IdleCores;
+            }
+            //  Nothing to do on this core, so the tick stops until work is given
+            //  to it.
+
+            scdt->Lock->Release();
+        }
+
+        return ret;
+    }
 
-    ThreadSchedulerState * GetNext(SchedulerData * scdt)
+    ThreadSchedulerState * Switch(SchedulerData * scdt, InterruptContext const * ic, bool const yielding)
     {
-        SchedulerData * cur[AffinityLevels + 1];
-        //  An extra level is used as a dummy value to know when all the real
-        //  affinity levels have been exhausted.
+        //  Returns the thread which runs next, which may be the current one.
 
-        for (size_t i = 0; i <= AffinityLevels; ++i)
-            cur[i] = scdt;
+        ThreadSchedulerState * const curThread = scdt->CurrentThread;
+        bool const blocking = curThread->Status == SchedulerStatus::Blocked;
+        ThreadSchedulerState * nextThread = GetNext(scdt, curThread, yielding);
 
-        do
+        if (nextThread == nullptr)
         {
-        loop_from_level_0:
-            if (ThreadSchedulerState * ret = cur[0]->Pop(scdt->CpuIndex); ret != nullptr)
-                return ret;
+            if likely(!blocking)
+                return curThread;
 
-            for (int i = 0; i < AffinityLevels; ++i)
-                if (SchedulerData * next = cur[i]->Next[i]; next != cur[i + 1])
-                {
-                    do cur[i] = next; while (i-- >= 0);
+            nextThread = scdt->IdleThread;
+            //  Blocked threads cannot continue.
+        }
 
-                    goto loop_from_level_0;
-                }
+        nextThread->Status = SchedulerStatus::Executing;
+
+        if unlikely(nextThread->LastCpu != scdt->CpuIndex)
+        {
+            nextThread->LastCpu = scdt->CpuIndex;
+
+            Scheduler::Migrated(SchedulingData.GetContainer(nextThread));
+        }
 
-            return scdt->IdleThread;
-        } while (true);
+        SchedulingData.GetContainer(curThread)->SwitchTo(SchedulingData.GetContainer(nextThread), ic->Registers);
 
-        // FAIL("Unable to find a thread to schedule?!");
+        scdt->CurrentThread = nextThread;
+
+        if (blocking)
+        {
+            SmpLock * const lock = scdt->BlockLock;
+            scdt->BlockLock = nullptr;
+
+            lock->Release();
+            //  The thread may be woken up from now on. It runs on the scheduler
+            //  stack, so its own kernel stack is free to be used elsewhere.
+        }
+        else if likely(curThread != scdt->IdleThread)
+        {
+            curThread->Status = SchedulerStatus::Queued;
+            scdt->Pending = curThread;
+        }
+        //  The idle thread is never queued; it is only picked when nothing else can run.
+
+        return nextThread;
     }
 
     void SchedulerTick(SchedulerData * scdt)
@@ -287,30 +401,27 @@ namespace
 
         assert(ic->Next == nullptr, "An interrupt handler was pre-empted?!")((void *)ic->Next);
 
+        Rcu::QuiescentState();
+        //  The tick came through, so the thread wasn't in a read-side section.
+
         // msg_("Core %us|%Xp pre-empted at %Xp; Postpone = %B.%n", Cpu::GetData()->Index, scdt, ic->Registers->RIP, Scheduler::Postpone);
 
         if unlikely(Scheduler::Postpone)
         {
-            enqueued = Timer::Enqueue(10usecs_l, &SchedulerTick, scdt);
+            enqueued = Timer::Enqueue(PostponeDelay, &SchedulerTick, scdt);
             goto end_of_tick;
         }
 
-        {   //  Limiting the scope of a couple of variables here.
-            ThreadSchedulerState * const curThread = scdt->CurrentThread;
-            scdt->Push(curThread);
-            //  First put this thread back in the queue. It might need to be rescheduled again
-            //  if it's got the highest priority and it's alone at that priority level.
+        {   //  Limiting the scope of a variable here.
+            ThreadSchedulerState * const nextThread = Switch(scdt, ic, false);
 
-            ThreadSchedulerState * const nextThread = GetNext(scdt);
-            nextThread->Status = SchedulerStatus::Executing;
+            if unlikely(!scdt->Ticking)
+                return;
+            //  Tickless; the next tick is armed when work arrives.
 
-            SchedulingData.GetContainer(scdt->CurrentThread)->SwitchTo(SchedulingData.GetContainer(nextThread), ic->Registers);
-
-            scdt->CurrentThread = nextThread;
+            enqueued = Timer::Enqueue(GetSlice(scdt, nextThread), &SchedulerTick, scdt);
         }
 
-        enqueued = Timer::Enqueue(10msecs_l, &SchedulerTick, scdt);
-
     end_of_tick:
         assert(enqueued);
         (void)enqueued;
@@ -345,23 +456,38 @@ void Scheduler::Initialize(MainParameters * params)
         assert(AllCpusMask.IsAllOne());
     }
 
-    MySchedulerData.Initialize();
+    size_t const cpuIndex = Cpu::GetData()->Index;
+
+    MySchedulerData.Initialize(cpuIndex, SchedulerLocks + cpuIndex);
+    GetTopology(MySchedulerData.Topology[0], MySchedulerData.Topology[1]);
+    MySchedulerData.Topology[2] = 0;
 
     MySchedulerData.CurrentThread = &SchedulingData(Cpu::GetThread());
     MySchedulerData.IdleThread = MySchedulerData.CurrentThread;
     // assert(Timer::Enqueue(10msecs_l, &SchedulerTick, MySchedulerData));
 
-    MySchedulerData.CurrentThread->Affinity.SetBit(MySchedulerData.CpuIndex);
+    MySchedulerData.CurrentThread->Pinned = true;
+    MySchedulerData.CurrentThread->LastCpu = cpuIndex;
     //  Only allow this thread to run on this core.
 
     Cpu::GetThread()->AcquireReference();
+
+    RegisterScheduler(&MySchedulerData);
+
+    if (params->BSP)
+        InitializeYield();
 }
 
 void Scheduler::Engage()
 {
     SchedulerData * scdt = &MySchedulerData;
 
-    bool const enqueued = Timer::Enqueue(10msecs_l, &SchedulerTick, scdt);
+    InterruptGuard<> intGuard;
+
+    scdt->Engaged = true;
+    scdt->Ticking = true;
+
+    bool const enqueued = Timer::Enqueue(GetSlice(scdt, scdt->CurrentThread), &SchedulerTick, scdt);
 
     assert(enqueued);
 
@@ -378,10 +504,92 @@ void Scheduler::Enroll(Thread * thread)
         thread->AcquireReference();
     //  While threads are in the scheduling system, they cannot be deallocated.
 
-    if likely(tsc->Affinity.IsAllZero())
-        tsc->Affinity = _AllCpusMask;
+    SchedulerData * target = &MySchedulerData;
 
-    MySchedulerData.Push(tsc);
+    if likely(tsc->Affinity == nullptr)
+        tsc->Pinned = false;
+    else
+    {
+        //  Threads with restricted affinity are queued on this core if allowed,
+        //  otherwise on the first allowed core. Only those allowed on a single
+        //  core are pinned; the rest migrate between the allowed cores.
+
+        AffinityMask const & affinity = *(tsc->Affinity);
+
+        tsc->Pinned = affinity.GetCount() == 1;
+
+        if unlikely(!affinity[target->CpuIndex])
+        {
+            target = nullptr;
+
+            for (size_t i = 0; i < MaximumCPUs; ++i)
+                if (affinity[i] && Schedulers[i] != nullptr)
+                {
+                    target = Schedulers[i];
+
+                    break;
+                }
+
+            assert(target != nullptr, "Thread affinity excludes all the cores.");
+        }
+    }
+
+    InterruptGuard<> intGuard;
+
+    target->Lock->Acquire();
+    target->Push(tsc);
+    target->Lock->Release();
+
+    if (!target->Ticking)
+        Wake(target);
+    //  The target core may have stopped its tick while idle.
+    else if (!tsc->Pinned && target->CurrentThread != target->IdleThread)
+        if (SchedulerData * const idle = FindIdle(target); idle != nullptr)
+            Wake(idle);
+    //  The target is busy, so a core with nothing to do may as well steal the
+    //  new thread.
+}
+
+/*  Blocking  */
+
+bool Scheduler::CanBlock()
+{
+    if (!InterruptState::IsEnabled())
+        return false;
+    //  Interrupt handlers and critical sections cannot block.
+
+    InterruptGuard<> intGuard;
+
+    SchedulerData const * const scdt = &MySchedulerData;
+
+    return scdt->Engaged && scdt->CurrentThread != scdt->IdleThread;
+}
+
+void Scheduler::Block(SmpLock * lock)
+{
+    assert(!InterruptState::IsEnabled(), "Blocking requires interrupts to be disabled.");
+
+    SchedulerData * const scdt = &MySchedulerData;
+
+    assert(scdt->CurrentThread != scdt->IdleThread, "The idle thread cannot block.");
+
+    scdt->CurrentThread->Status = SchedulerStatus::Blocked;
+    scdt->BlockLock = lock;
+
+    Yield();
+    //  Returns after being enrolled again.
+}
+
+void Scheduler::HandleYield(InterruptContext const * context, void * cookie)
+{
+    (void)cookie;
+
+    assert(context->Next == nullptr, "Cannot yield from an interrupt handler.")((void *)context->Next);
+
+    Rcu::QuiescentState();
+    //  Read-side sections cannot yield.
+
+    Switch(&MySchedulerData, context, true);
 }
 
 /*  Properties  */
@@ -390,3 +598,38 @@ SchedulerStatus Scheduler::GetStatus(Thread * thread)
 {
     return SchedulingData(thread).Status;
 }
+
+Handle Scheduler::SetAffinity(Thread * thread, AffinityMask const & affinity)
+{
+    ThreadSchedulerState * tsc = &SchedulingData(thread);
+
+    assert(tsc->Status == SchedulerStatus::Unscheduled || tsc->Status == SchedulerStatus::Blocked)("status", tsc->Status);
+    //  Queued threads would end up in the wrong queue.
+
+    AffinityMask * copy = nullptr;
+
+    if (!affinity.IsAllOne())
+    {
+        copy = new (std::nothrow) AffinityMask(affinity);
+
+        if unlikely(copy == nullptr)
+            return HandleResult::OutOfMemory;
+    }
+    //  Unrestricted threads need no mask at all.
+
+    AffinityMask * const old = tsc->Affinity;
+
+    tsc->Affinity = copy;
+
+    delete old;
+
+    return HandleResult::Okay;
+}
+
+void Scheduler::Release(Thread * thread)
+{
+    ThreadSchedulerState * tsc = &SchedulingData(thread);
+
+    delete tsc->Affinity;
+    tsc->Affinity = nullptr;
+}
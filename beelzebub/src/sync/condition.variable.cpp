@@ -0,0 +1,80 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <beel/sync/condition.variable.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+
+/********************************
+    ConditionVariable class
+********************************/
+
+/*  Operations  */
+
+namespace
+{
+    struct WaitCookie
+    {
+        Atomic<uint32_t> const * Sequence;
+        uint32_t Expected;
+    };
+
+    bool NotSignalled(void * cookie)
+    {
+        WaitCookie const * const wc = reinterpret_cast<WaitCookie *>(cookie);
+
+        return wc->Sequence->Load() == wc->Expected;
+    }
+}
+
+Handle ConditionVariable::Wait(Mutex & mutex, TimeSpanLite timeout)
+{
+    WaitCookie wc { &(this->Sequence), this->Sequence.Load() };
+    //  Sampled while the mutex is held, so signals sent after releasing it
+    //  stop the thread from sleeping.
+
+    mutex.Release();
+
+    Handle const res = this->Waiters.Wait(timeout, &NotSignalled, &wc);
+
+    mutex.Acquire();
+
+    return res;
+}
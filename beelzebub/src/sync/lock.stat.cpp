@@ -0,0 +1,405 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#ifdef __BEELZEBUB__CONF_LOCKSTAT
+
+#include <beel/sync/lock.stat.hpp>
+#include <beel/sync/smp.lock.hpp>
+#include <beel/terminals/base.hpp>
+#include <memory/vmm.hpp>
+#include <system/cpu_instructions.hpp>
+#include <global_options.hpp>
+#include "cores.hpp"
+#include "timer.hpp"
+
+#include <string.h>
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Memory;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+using namespace Beelzebub::Terminals;
+
+/****************
+    Internals
+****************/
+
+static constexpr size_t const SiteProbeLength = 8;
+//  Sites which do not fit within this many slots of their hash are dropped.
+static constexpr size_t const ReportedSiteCount = 32;
+
+struct LockStatHeld
+{
+    void const volatile * Lock;
+    LockSiteStatistics * Statistics;
+    uint64_t Start;
+};
+
+struct LockStatCore
+{
+    LockSiteStatistics Sites[LockStatSiteCount];
+    LockStatHeld Held[LockStatHeldDepth];
+
+    size_t HeldCount;
+    uint64_t Dropped;
+    //  Acquisitions and releases which could not be recorded.
+
+    bool Busy;
+    //  Set while the core is recording, so nothing is recorded twice.
+} __aligned(64);
+
+static LockStatCore * Tables = nullptr;
+static size_t TableCount = 0;
+
+static SmpLock DumpLock {};
+//  Guards the merged table, which is too large for a stack.
+
+static LockSiteStatistics Merged[LockStatSiteCount];
+static bool Printed[LockStatSiteCount];
+
+static __hot __forceinline size_t HashSite(void const * site)
+{
+    return (size_t)(((uint64_t)(uintptr_t)site * 0x9E3779B97F4A7C15ULL) >> 32) % LockStatSiteCount;
+}
+
+static __hot LockSiteStatistics * FindSite(LockSiteStatistics * sites, void const * site, size_t probes)
+{
+    size_t const hash = HashSite(site);
+
+    for (size_t i = 0; i < probes; ++i)
+    {
+        LockSiteStatistics * const stats = sites + (hash + i) % LockStatSiteCount;
+
+        if (stats->Site == site)
+            return stats;
+
+        if (stats->Site == nullptr)
+        {
+            stats->Site = site;
+
+            return stats;
+        }
+    }
+
+    return nullptr;
+}
+
+static __hot __forceinline size_t GetHistogramBucket(uint64_t cycles)
+{
+    if (cycles < 128)
+        return 0;
+
+    size_t const bucket = (size_t)(63 - __builtin_clzll(cycles)) - 6;
+    //  128 to 255 cycles go in the second bucket.
+
+    return bucket < LockStatHistogramBuckets ? bucket : LockStatHistogramBuckets - 1;
+}
+
+static __hot __forceinline LockStatCore * GetCore()
+{
+    if unlikely(Tables == nullptr || !Cores::IsReady())
+        return nullptr;
+
+    size_t const index = Cpu::GetData()->Index;
+
+    return index < TableCount ? Tables + index : nullptr;
+}
+
+static bool volatile DumpDue = false;
+
+static void PeriodicDump(void * cookie)
+{
+    DumpDue = true;
+    //  This runs in an interrupt, which may have landed in the middle of a dump
+    //  or a terminal write. The dump itself is left to the idle loop.
+
+    Timer::Enqueue(TimeSpanLite(reinterpret_cast<uintptr_t>(cookie)), &PeriodicDump, cookie);
+}
+
+/*********************
+    LockStat class
+*********************/
+
+/*  Initialization  */
+
+Handle LockStat::Initialize(size_t const coreCount)
+{
+    vsize_t const size = RoundUp(vsize_t(coreCount * sizeof(LockStatCore)), PageSize);
+    vaddr_t addr = nullvaddr;
+
+    Handle res = Vmm::AllocatePages(nullptr
+        , size
+        , MemoryAllocationOptions::Commit | MemoryAllocationOptions::VirtualKernelHeap
+          | MemoryAllocationOptions::GuardLow | MemoryAllocationOptions::GuardHigh
+        , MemoryFlags::Global | MemoryFlags::Writable
+        , MemoryContent::Generic
+        , addr);
+
+    if (!res.IsOkayResult())
+        return res;
+
+    ::memset(reinterpret_cast<void *>(addr.Value), 0, size.Value);
+
+    TableCount = coreCount;
+
+    COMPILER_MEMORY_BARRIER();
+
+    Tables = reinterpret_cast<LockStatCore *>(addr.Value);
+    //  Recording starts only once the tables are clean.
+
+    return HandleResult::Okay;
+}
+
+bool LockStat::ArmPeriodicDump()
+{
+    if (!CMDO_LockStatInterval.ParsingResult.IsValid()
+        || CMDO_LockStatInterval.UnsignedIntegerValue == 0)
+        return false;
+
+    uintptr_t const interval = (uintptr_t)(1secs_l).Value * CMDO_LockStatInterval.UnsignedIntegerValue;
+
+    return Timer::Enqueue(TimeSpanLite(interval), &PeriodicDump, reinterpret_cast<void *>(interval));
+}
+
+/*  Recording  */
+
+uint64_t LockStat::Begin()
+{
+    return CpuInstructions::Rdtsc();
+}
+
+void LockStat::Acquired(void const volatile * lock, void const * site, uint64_t const start)
+{
+    uint64_t const now = CpuInstructions::Rdtsc();
+
+    InterruptGuard<> intGuard;
+
+    LockStatCore * const core = GetCore();
+
+    if (core == nullptr || core->Busy)
+        return;
+
+    core->Busy = true;
+
+    LockSiteStatistics * const stats = FindSite(core->Sites, site, SiteProbeLength);
+
+    if likely(stats != nullptr)
+    {
+        uint64_t const wait = now - start;
+
+        ++stats->Acquisitions;
+        stats->SpinCycles += wait;
+
+        if (wait > LockStatContentionThreshold)
+            ++stats->Contentions;
+
+        if (wait > stats->MaximumWait)
+            stats->MaximumWait = wait;
+
+        if unlikely(core->HeldCount == LockStatHeldDepth)
+        {
+            ::memmove(core->Held, core->Held + 1, (LockStatHeldDepth - 1) * sizeof(LockStatHeld));
+            --core->HeldCount;
+            ++core->Dropped;
+            //  The oldest entry is most likely a lock released on another core.
+        }
+
+        core->Held[core->HeldCount++] = { lock, stats, now };
+    }
+    else
+        ++core->Dropped;
+
+    core->Busy = false;
+}
+
+void LockStat::Released(void const volatile * lock)
+{
+    uint64_t const now = CpuInstructions::Rdtsc();
+
+    InterruptGuard<> intGuard;
+
+    LockStatCore * const core = GetCore();
+
+    if (core == nullptr || core->Busy)
+        return;
+
+    core->Busy = true;
+
+    for (size_t i = core->HeldCount; i > 0; --i)
+    {
+        LockStatHeld const held = core->Held[i - 1];
+
+        if (held.Lock != lock)
+            continue;
+
+        uint64_t const hold = now - held.Start;
+
+        held.Statistics->HoldCycles += hold;
+        ++held.Statistics->HoldHistogram[GetHistogramBucket(hold)];
+
+        ::memmove(core->Held + i - 1, core->Held + i, (core->HeldCount - i) * sizeof(LockStatHeld));
+        --core->HeldCount;
+
+        break;
+    }
+    //  Locks acquired on another core or before recording began are not found.
+
+    core->Busy = false;
+}
+
+/*  Reporting  */
+
+void LockStat::Dump(TerminalBase * term)
+{
+    if (Tables == nullptr || term == nullptr)
+        return;
+
+    withLock (DumpLock)
+    {
+        ::memset(Merged, 0, sizeof(Merged));
+        ::memset(Printed, 0, sizeof(Printed));
+
+        uint64_t dropped = 0;
+
+        for (size_t i = 0; i < TableCount; ++i)
+        {
+            LockStatCore const * const core = Tables + i;
+            //  Other cores keep recording, so the counters are approximate.
+
+            dropped += core->Dropped;
+
+            for (size_t j = 0; j < LockStatSiteCount; ++j)
+            {
+                LockSiteStatistics const * const src = core->Sites + j;
+
+                if (src->Site == nullptr)
+                    continue;
+
+                LockSiteStatistics * const dst = FindSite(Merged, src->Site, LockStatSiteCount);
+
+                if (dst == nullptr)
+                {
+                    dropped += src->Acquisitions;
+
+                    continue;
+                }
+
+                dst->Acquisitions += src->Acquisitions;
+                dst->Contentions += src->Contentions;
+                dst->SpinCycles += src->SpinCycles;
+                dst->HoldCycles += src->HoldCycles;
+
+                if (src->MaximumWait > dst->MaximumWait)
+                    dst->MaximumWait = src->MaximumWait;
+
+                for (size_t k = 0; k < LockStatHistogramBuckets; ++k)
+                    dst->HoldHistogram[k] += src->HoldHistogram[k];
+            }
+        }
+
+        term->WriteFormat("Lock statistics of %us cores; %u8 operations were not recorded.%n"
+            , TableCount, dropped);
+        term->WriteFormat("Site address: acquisitions, contended, spin cycles, maximum wait, hold cycles | hold histogram from 128 cycles, by powers of two%n");
+
+        for (size_t n = 0; n < ReportedSiteCount; ++n)
+        {
+            LockSiteStatistics const * top = nullptr;
+            size_t topIndex = 0;
+
+            for (size_t j = 0; j < LockStatSiteCount; ++j)
+                if (!Printed[j] && Merged[j].Site != nullptr
+                    && (top == nullptr || Merged[j].SpinCycles > top->SpinCycles))
+                {
+                    top = Merged + j;
+                    topIndex = j;
+                }
+
+            if (top == nullptr)
+                break;
+
+            Printed[topIndex] = true;
+
+            term->WriteFormat("%Xp: %u8, %u8, %u8, %u8, %u8 |"
+                , top->Site, top->Acquisitions, top->Contentions
+                , top->SpinCycles, top->MaximumWait, top->HoldCycles);
+
+            for (size_t k = 0; k < LockStatHistogramBuckets; ++k)
+                term->WriteFormat(" %u4", top->HoldHistogram[k]);
+
+            term->WriteFormat("%n");
+        }
+    }
+}
+
+void LockStat::DumpIfDue(TerminalBase * term)
+{
+    if likely(!DumpDue)
+        return;
+
+    DumpDue = false;
+
+    Dump(term);
+}
+
+void LockStat::Reset()
+{
+    if (Tables == nullptr)
+        return;
+
+    for (size_t i = 0; i < TableCount; ++i)
+    {
+        LockStatCore * const core = Tables + i;
+
+        for (size_t j = 0; j < LockStatSiteCount; ++j)
+        {
+            LockSiteStatistics * const stats = core->Sites + j;
+
+            stats->Acquisitions = stats->Contentions = stats->SpinCycles = 0;
+            stats->MaximumWait = stats->HoldCycles = 0;
+
+            ::memset(stats->HoldHistogram, 0, sizeof(stats->HoldHistogram));
+        }
+
+        core->Dropped = 0;
+    }
+    //  Sites stay in place, so concurrent recording never loses its slot.
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <beel/sync/mutex.hpp>
+#include <beel/sync/mutex.h>
+#include "scheduler.hpp"
+#include "system/cpu_instructions.hpp"
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+static_assert(sizeof(Synchronization::Mutex) == sizeof(::Mutex), "C and C++ mutex sizes mismatch.");
+
+/********************
+    Mutex class
+********************/
+
+/*  Operations  */
+
+namespace
+{
+    bool IsContended(void * cookie)
+    {
+        return reinterpret_cast<Atomic<uint32_t> *>(cookie)->Load() == 2;
+    }
+}
+
+void Synchronization::Mutex::AcquireSlow()
+{
+    for (size_t i = SpinCount; i > 0; --i)
+    {
+        uint32_t expected = 0;
+
+        if (this->State.Load() == 0 && this->State.CmpXchgStrong(expected, 1))
+            return;
+
+        CpuInstructions::DoNothing();
+    }
+    //  Owners usually release quickly, which is cheaper to wait for than a sleep.
+
+    if unlikely(!Scheduler::CanBlock())
+    {
+        while (this->State.Load() != 0 || this->State.Xchg(2U) != 0)
+            CpuInstructions::DoNothing();
+
+        return;
+    }
+    //  The state is left at 2 because there may be sleepers too.
+
+    while (this->State.Xchg(2U) != 0)
+        this->Waiters.Wait(WaitQueue::Forever, &IsContended, &(this->State));
+    //  Sleeps only if the mutex is still marked as contended, under the queue
+    //  lock, so a concurrent release cannot be missed.
+}
+
+/*  C API  */
+
+void MutexAcquire(::Mutex * const mutex)
+{
+    reinterpret_cast<Synchronization::Mutex *>(mutex)->Acquire();
+}
+
+bool MutexTryAcquire(::Mutex * const mutex)
+{
+    return reinterpret_cast<Synchronization::Mutex *>(mutex)->TryAcquire();
+}
+
+void MutexRelease(::Mutex * const mutex)
+{
+    reinterpret_cast<Synchronization::Mutex *>(mutex)->Release();
+}
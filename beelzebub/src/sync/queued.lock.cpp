@@ -0,0 +1,156 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <beel/sync/queued.lock.hpp>
+#include "system/cpu.hpp"
+#include "cores.hpp"
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+#if defined(__BEELZEBUB_SETTINGS_SMP)
+
+static __forceinline uint16_t EncodeTail(size_t const core, size_t const level)
+{
+    return (uint16_t)((core + 1) * QueuedLockNodeCount + level);
+}
+
+static __forceinline QueuedLockNode * DecodeTail(uint16_t const tail)
+{
+    return Cores::Get(tail / QueuedLockNodeCount - 1)->QueuedLockNodes + tail % QueuedLockNodeCount;
+}
+
+/****************************
+    QueuedLockBase struct
+****************************/
+
+/*  Operations  */
+
+void QueuedLockBase::AcquireSlow() volatile
+{
+    if unlikely(!Cores::IsReady())
+    {
+        while (!this->TryLock())
+            DO_NOTHING();
+
+        return;
+    }
+    //  The nodes of other cores cannot be found yet.
+
+    InterruptGuard<> intGuard;
+    //  The node belongs to this core, so the thread must not leave it while
+    //  queued.
+
+    CpuData * const data = Cpu::GetData();
+    size_t const level = data->QueuedLockNesting++;
+
+    if unlikely(level >= QueuedLockNodeCount)
+    {
+        while (!this->TryLock())
+            DO_NOTHING();
+
+        --data->QueuedLockNesting;
+
+        return;
+    }
+    //  Too deep; this one competes without queueing.
+
+    QueuedLockNode * const node = data->QueuedLockNodes + level;
+    uint16_t const myTail = EncodeTail(data->Index, level);
+
+    node->Next = nullptr;
+    node->Waiting = true;
+
+    uint16_t const prevTail = __atomic_exchange_n(&(this->Value.Tail), myTail, __ATOMIC_ACQ_REL);
+
+    if (prevTail != 0)
+    {
+        __atomic_store_n(&(DecodeTail(prevTail)->Next), node, __ATOMIC_RELEASE);
+
+        while (__atomic_load_n(&(node->Waiting), __ATOMIC_ACQUIRE))
+            DO_NOTHING();
+        //  Only this core's cache line is touched while waiting.
+    }
+
+    //  This core is at the head of the queue now. The fast path fails while
+    //  anybody is queued, so only the holder stands in the way.
+
+    while (true)
+    {
+        queuedlock_t const val { __atomic_load_n(&(this->Value.Overall), __ATOMIC_ACQUIRE) };
+
+        if (val.Locked != 0)
+        {
+            DO_NOTHING();
+
+            continue;
+        }
+
+        if (val.Tail == myTail)
+        {
+            uint32_t cmp = val.Overall;
+
+            if (__atomic_compare_exchange_n(&(this->Value.Overall), &cmp, 1
+                , false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                goto end;
+            //  Nobody queued up behind, so the queue is emptied.
+
+            continue;
+        }
+
+        __atomic_store_n(&(this->Value.Locked), (uint8_t)1, __ATOMIC_RELAXED);
+
+        break;
+    }
+
+    {   //  Somebody is queued behind, and will be linked shortly.
+        QueuedLockNode * next;
+
+        while ((next = __atomic_load_n(&(node->Next), __ATOMIC_ACQUIRE)) == nullptr)
+            DO_NOTHING();
+
+        __atomic_store_n(&(next->Waiting), false, __ATOMIC_RELEASE);
+    }
+
+end:
+    --data->QueuedLockNesting;
+}
+
+#endif
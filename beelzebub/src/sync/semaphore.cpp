@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <beel/sync/semaphore.hpp>
+#include "scheduler.hpp"
+#include "timer.hpp"
+#include "system/cpu_instructions.hpp"
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+/************************
+    Semaphore class
+************************/
+
+/*  Operations  */
+
+namespace
+{
+    bool IsDepleted(void * cookie)
+    {
+        return reinterpret_cast<Semaphore *>(cookie)->GetCount() == 0;
+    }
+}
+
+Handle Semaphore::Acquire(TimeSpanLite timeout)
+{
+    bool const canBlock = Scheduler::CanBlock();
+    uint64_t deadline = ~(uint64_t)0;
+
+    if (timeout != WaitQueue::Forever)
+    {
+        uint64_t const now = Timer::Now().Value;
+
+        if likely(timeout.Value < deadline - now)
+            deadline = now + timeout.Value;
+    }
+    //  Wakeups which find the semaphore depleted again only wait for whatever
+    //  time is left.
+
+    while (!this->TryAcquire())
+    {
+        TimeSpanLite remaining = WaitQueue::Forever;
+
+        if (deadline != ~(uint64_t)0)
+        {
+            uint64_t const now = Timer::Now().Value;
+
+            if (now >= deadline)
+                return HandleResult::Timeout;
+
+            remaining = TimeSpanLite(deadline - now);
+        }
+
+        if unlikely(!canBlock)
+        {
+            CpuInstructions::DoNothing();
+
+            continue;
+        }
+
+        Handle const res = this->Waiters.Wait(remaining, &IsDepleted, this);
+
+        if (!res.IsOkayResult())
+            return res;
+    }
+
+    return HandleResult::Okay;
+}
@@ -0,0 +1,219 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#include <beel/sync/wait.queue.hpp>
+#include "execution/run_queue.hpp"
+#include "scheduler.hpp"
+#include "timer.hpp"
+#include "system/cpu.hpp"
+
+#include <beel/interrupt.state.hpp>
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Execution;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+/************************
+    WaitQueue class
+************************/
+
+/*  Operations  */
+
+Handle WaitQueue::Wait(TimeSpanLite timeout, WaitPredicate pred, void * cookie)
+{
+    assert(Scheduler::CanBlock(), "Only threads which can block may wait.");
+
+    InterruptGuard<> intGuard;
+    //  Also keeps the timeout handler of this core from taking the lock.
+
+    ThreadSchedulerState * const tsc = &SchedulingData(Cpu::GetThread());
+    bool timed = false;
+
+    this->Lock.Acquire();
+
+    if (pred != nullptr && !pred(cookie))
+    {
+        this->Lock.Release();
+
+        return HandleResult::Okay;
+    }
+
+    if (timeout != Forever)
+    {
+        if unlikely(timeout.Value == 0)
+        {
+            this->Lock.Release();
+
+            return HandleResult::Timeout;
+        }
+
+        tsc->TimeoutPending = timed = true;
+
+        if unlikely(!Timer::Enqueue(timeout, &HandleTimeout, tsc, &(tsc->WaitTimer)))
+        {
+            tsc->TimeoutPending = false;
+
+            this->Lock.Release();
+
+            return HandleResult::OutOfMemory;
+        }
+        //  The handler cannot run before interrupts are enabled on this core,
+        //  which only happens after the thread blocks.
+    }
+
+    tsc->TimedOut = false;
+
+    this->Link(tsc);
+
+    Scheduler::Block(&this->Lock);
+    //  The lock is released by the scheduler once the thread is switched out.
+
+    if (timed)
+    {
+        if (Timer::Cancel(tsc->WaitTimer))
+            tsc->TimeoutPending = false;
+        //  Woken before the timeout; the handler will never run.
+        else
+            while (tsc->TimeoutPending)
+                CpuInstructions::DoNothing();
+        //  The handler has claimed this wait; it must be done with this thread
+        //  and this queue before either can go away.
+    }
+
+    return tsc->TimedOut ? HandleResult::Timeout : HandleResult::Okay;
+}
+
+size_t WaitQueue::Wake(size_t const count)
+{
+    ThreadSchedulerState * first, * cur;
+    size_t n = 0;
+
+    InterruptGuard<> intGuard;
+
+    this->Lock.Acquire();
+
+    for (first = cur = this->First; cur != nullptr && n < count; cur = cur->Next, ++n)
+        cur->WaitingOn = nullptr;
+
+    if ((this->First = cur) == nullptr)
+        this->Last = nullptr;
+    else
+        cur->Previous = nullptr;
+    //  The woken threads are detached in one go.
+
+    this->Lock.Release();
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        ThreadSchedulerState * const next = first->Next;
+        //  Overwritten when enrolling.
+
+        Scheduler::Enroll(SchedulingData.GetContainer(first));
+
+        first = next;
+    }
+
+    return n;
+}
+
+bool WaitQueue::WakeOne()
+{
+    return this->Wake(1) != 0;
+}
+
+void WaitQueue::HandleTimeout(void * cookie)
+{
+    ThreadSchedulerState * const tsc = reinterpret_cast<ThreadSchedulerState *>(cookie);
+    WaitQueue * const queue = tsc->WaitingOn;
+    bool expired = false;
+
+    if (queue != nullptr)
+    {
+        queue->Lock.Acquire();
+
+        if (tsc->WaitingOn == queue)
+        {
+            queue->Unlink(tsc);
+
+            tsc->TimedOut = expired = true;
+        }
+
+        queue->Lock.Release();
+    }
+    //  Otherwise, the thread is being woken up concurrently.
+
+    if (expired)
+        Scheduler::Enroll(SchedulingData.GetContainer(tsc));
+
+    COMPILER_MEMORY_BARRIER();
+
+    tsc->TimeoutPending = false;
+}
+
+void WaitQueue::Link(ThreadSchedulerState * tsc)
+{
+    tsc->Next = nullptr;
+
+    if ((tsc->Previous = this->Last) == nullptr)
+        this->First = tsc;
+    else
+        this->Last->Next = tsc;
+
+    this->Last = tsc;
+    tsc->WaitingOn = this;
+}
+
+void WaitQueue::Unlink(ThreadSchedulerState * tsc)
+{
+    assert(tsc->WaitingOn == this)((void *)tsc->WaitingOn);
+
+    if (tsc->Previous == nullptr)
+        this->First = tsc->Next;
+    else
+        tsc->Previous->Next = tsc->Next;
+
+    if (tsc->Next == nullptr)
+        this->Last = tsc->Previous;
+    else
+        tsc->Next->Previous = tsc->Previous;
+
+    tsc->WaitingOn = nullptr;
+}
@@ -41,6 +41,7 @@
 #include <beel/exceptions.hpp>
 #include <memory/vmm.hpp>
 #include <system/cpu.hpp>
+#include <execution.hpp>
 #include <math.h>
 #include <string.h>
 
@@ -88,7 +89,13 @@ Handle Beelzebub::MemoryRequest(uintptr_t const _addr, size_t const _size, Memor
     if (0 != (opts & MemoryRequestOptions::Executable))
         flags |= MemoryFlags::Executable;
 
-    Handle res = Vmm::AllocatePages(nullptr, size, type, flags, content, addr);
+    vsize_t alignment { PageSize.Value };
+
+    if (addr == nullvaddr && size >= LargePageSize && Vmm::TransparentLargePages)
+        alignment = vsize_t(LargePageSize.Value);
+    //  Placed this way, the request can be backed by large pages.
+
+    Handle res = Vmm::AllocatePages(nullptr, size, type, flags, content, addr, alignment);
 
     if unlikely(!res.IsOkayResult())
         return res;
@@ -221,3 +228,43 @@ Handle Beelzebub::MemoryFill(uintptr_t const _dst, uint8_t const val, size_t con
 
     return HandleResult::Okay;
 }
+
+Handle Beelzebub::MemoryShare(uintptr_t const _addr, size_t const _size, size_t const process, MemoryShareOptions opts)
+{
+    vaddr_t const addr { _addr };
+    vsize_t const size { _size };
+
+    if unlikely(addr % PageSize != 0 || size % PageSize != 0)
+        return HandleResult::AlignmentFailure;
+
+    vaddr_t const end = addr + size;
+
+    if unlikely(size == 0 || end < addr || addr < Vmm::UserlandStart || end > Vmm::UserlandEnd)
+        return HandleResult::ArgumentOutOfRange;
+
+    if unlikely(process > 0xFFFF)
+        return HandleResult::ArgumentOutOfRange;
+
+    Execution::Process * const dst = FindProcess((uint16_t)process);
+
+    if unlikely(dst == nullptr)
+        return HandleResult::ArgumentOutOfRange;
+
+    Execution::Process * const self = System::Cpu::GetProcess();
+
+    if unlikely(dst != self && dst->Parent != self)
+        return HandleResult::UnsupportedOperation;
+    //  A process may only share its memory with its own children.
+
+    vaddr_t dstAddr = nullvaddr;
+
+    Handle res = Vmm::SharePages(nullptr, addr, size, dst, dstAddr
+        , 0 != (opts & MemoryShareOptions::Duplicate)
+        , 0 != (opts & MemoryShareOptions::ReadOnly));
+
+    if unlikely(!res.IsOkayResult())
+        return res;
+
+    return Handle(HandleType::Page, dstAddr.Value, false);
+    //  The address is within the other process.
+}
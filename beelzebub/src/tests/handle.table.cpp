@@ -0,0 +1,186 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#if defined(__BEELZEBUB__TEST_HANDLES) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+
+#include "tests/handle.table.hpp"
+#include "handle.table.hpp"
+#include "system/cpu.hpp"
+#include "cores.hpp"
+#include "scheduler.hpp"
+#include <new>
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+Barrier HandleTableTestBarrier;
+
+#define SYNC HandleTableTestBarrier.Reach()
+
+static constexpr handle_inner_t const TableSize = 1 << 20;
+
+static constexpr size_t const ChurnRounds = 10'000;
+static constexpr size_t const ChurnWindow = 256;
+//  Larger than the local free list, so it spills into the global stack.
+static __thread handle_inner_t MyHandles[ChurnWindow];
+static Atomic<size_t> ChurnCounter {0};
+
+static constexpr size_t const HandoffCount = 1024;
+static constexpr size_t const HandoffRounds = 64;
+static handle_inner_t * Handoff = nullptr;
+static Atomic<size_t> HandoffCounter {0};
+
+static __startup void CheckHandles(handle_inner_t const * handles, size_t count, uint16_t pcid)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const entry = HandleTable::Get(handle_t(handles[i]));
+
+        ASSERT(entry.Error == HandleGetResult::Success)(i)(handles[i]);
+        ASSERT(entry.Value.ProcessId == pcid)(i)(handles[i])(entry.Value.ProcessId)(pcid);
+        //  Another core owning the same handle would have overwritten this.
+    }
+}
+
+void TestHandleTable(bool const bsp)
+{
+    if (bsp) Scheduler::Postpone = true;
+
+    size_t const coreIndex = Cpu::GetData()->Index;
+    uint16_t const pcid = (uint16_t)coreIndex;
+    uint64_t perfStart, perfEnd;
+
+    if (bsp)
+    {
+        ASSERT(HandleTable::Initialize(handle_t(TableSize)) == HandleTableInitializationResult::Success);
+
+        ASSERT((Handoff = new (std::nothrow) handle_inner_t[Cores::GetCount() * HandoffCount]) != nullptr);
+
+        MSG_("Handle churn.%n");
+    }
+
+    SYNC;
+
+    perfStart = CpuInstructions::Rdtsc();
+
+    for (size_t round = 0; round < ChurnRounds; ++round)
+    {
+        for (size_t i = 0; i < ChurnWindow; ++i)
+        {
+            auto const res = HandleTable::Allocate(pcid);
+
+            ASSERT(res.Error == HandleAllocationResult::Success)(round)(i);
+
+            MyHandles[i] = res.Value.Value;
+        }
+
+        CheckHandles(MyHandles, ChurnWindow, pcid);
+
+        for (size_t i = 0; i < ChurnWindow; ++i)
+            ASSERT(HandleTable::Deallocate(handle_t(MyHandles[i])))(round)(i);
+    }
+
+    perfEnd = CpuInstructions::Rdtsc();
+
+    ChurnCounter += perfEnd - perfStart;
+
+    SYNC;
+
+    if (bsp)
+    {
+        size_t const itcnt = Cores::GetCount() * ChurnRounds * ChurnWindow;
+
+        MSG_("%us cores did %us handle allocation & free pairs in %us cycles; %us cycles per pair.%n"
+            , Cores::GetCount(), itcnt, ChurnCounter.Load(), (ChurnCounter + itcnt / 2) / itcnt);
+
+        MSG_("Cross-core frees.%n");
+    }
+
+    SYNC;
+
+    {   //  Every core frees what the next one allocated.
+        size_t const coreCount = Cores::GetCount();
+        handle_inner_t * const mine = Handoff + coreIndex * HandoffCount;
+        handle_inner_t * const theirs = Handoff + ((coreIndex + 1) % coreCount) * HandoffCount;
+
+        for (size_t round = 0; round < HandoffRounds; ++round)
+        {
+            for (size_t i = 0; i < HandoffCount; ++i)
+            {
+                auto const res = HandleTable::Allocate(pcid);
+
+                ASSERT(res.Error == HandleAllocationResult::Success)(round)(i);
+
+                mine[i] = res.Value.Value;
+            }
+
+            CheckHandles(mine, HandoffCount, pcid);
+
+            SYNC;
+
+            perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t i = 0; i < HandoffCount; ++i)
+                ASSERT(HandleTable::Deallocate(handle_t(theirs[i])))(round)(i);
+
+            perfEnd = CpuInstructions::Rdtsc();
+
+            HandoffCounter += perfEnd - perfStart;
+
+            SYNC;
+        }
+    }
+
+    if (bsp)
+    {
+        size_t const itcnt = Cores::GetCount() * HandoffRounds * HandoffCount;
+
+        MSG_("%us cores did %us frees of handles allocated by another core in %us cycles; %us cycles per free.%n"
+            , Cores::GetCount(), itcnt, HandoffCounter.Load(), (HandoffCounter + itcnt / 2) / itcnt);
+
+        delete[] Handoff;
+
+        Scheduler::Postpone = false;
+    }
+}
+
+#endif
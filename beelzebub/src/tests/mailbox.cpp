@@ -44,6 +44,7 @@
 #include "cores.hpp"
 #include "kernel.hpp"
 #include "scheduler.hpp"
+#include <math.h>
 
 #include <debug.hpp>
 
@@ -58,6 +59,7 @@ Barrier MailboxTestBarrier;
 
 static constexpr size_t const PingPongCount = 200000;
 static constexpr size_t const SpamCount = 200000;
+static constexpr size_t const MulticastCount = 20000;
 
 struct PingPongState
 {
@@ -148,6 +150,43 @@ static __startup void TestEmptyFunc(void * cookie)
     return TestEmptyFunc2(cookie);
 }
 
+static __startup void BenchmarkMulticast(size_t const dstCnt)
+{
+    unsigned int const thisCore = Cpu::GetData()->Index;
+    uint64_t acc = 0, min = 0xFFFFFFFFFFFFFFFFULL, max = 0;
+
+    for (size_t i = 0; i < MulticastCount; ++i)
+    {
+        ALLOCATE_MAIL(mail, dstCnt, &TestEmptyFunc);
+
+        for (unsigned int j = 0; j < dstCnt; ++j)
+            mail.Links[j] = MailboxEntryLink((j < thisCore) ? j : (j + 1));
+
+        COMPILER_MEMORY_BARRIER();
+        uint64_t const start = CpuInstructions::Rdtsc();
+        COMPILER_MEMORY_BARRIER();
+
+        mail.Post(false);
+        //  Returns once every destination has picked the mail up.
+
+        COMPILER_MEMORY_BARRIER();
+        uint64_t const time = CpuInstructions::Rdtsc() - start;
+        COMPILER_MEMORY_BARRIER();
+
+        acc += time;
+
+        if (time < min)
+            min = time;
+        if (time > max)
+            max = time;
+    }
+
+    DEBUG_TERM_
+        << "Mail to " << dstCnt << " cores: AVG " << (acc / MulticastCount)
+        << "; MIN " << min << "; MAX " << max
+        << "; per delivery " << (acc / (MulticastCount * dstCnt)) << EndLine;
+}
+
 void TestMailbox(bool bsp)
 {
     assert(InterruptState::IsEnabled());
@@ -200,8 +239,19 @@ void TestMailbox(bool bsp)
             << "Spam mail latency: AVG "
             << ((perfEnd - perfStart) / (SpamCount * Cores::GetCount())) << EndLine;
 
-        Scheduler::Postpone = false;
+        //  Now the latency and throughput of mail with a growing number of
+        //  destinations, while the other cores idle.
+
+        size_t const targets = Cores::GetCount() - 1;
+
+        for (size_t dstCnt = 1; dstCnt <= targets; dstCnt = (dstCnt == targets) ? (dstCnt + 1) : Minimum(dstCnt * 2, targets))
+            BenchmarkMulticast(dstCnt);
     }
+
+    SYNC;
+
+    if (bsp)
+        Scheduler::Postpone = false;
 }
 
 #endif
@@ -85,6 +85,30 @@ static __thread TestStructure * MyCache[CacheSize];
 static Atomic<size_t> RandomerCounter {0};
 //  There is no space on the stack for this one.
 
+static constexpr size_t const MixedIterations = 1'000'000;
+static constexpr size_t const MixedSlots = 1024;
+static __thread void * MyMixed[MixedSlots];
+static Atomic<size_t> MixedCounter {0};
+
+static constexpr size_t const HandoffCount = 4096;
+static constexpr size_t const HandoffRounds = 64;
+static void * * Handoff = nullptr;
+static Atomic<size_t> HandoffCounter {0};
+
+static __startup size_t MixedSize(uint64_t & state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    //  Xorshift, good enough for picking sizes.
+
+    if ((state & 7) != 0)
+        return 16 + (state >> 8) % 497;
+    else
+        return 513 + (state >> 8) % 3584;
+    //  Seven out of eight allocations are small.
+}
+
 void TestMalloc(bool const bsp)
 {
     if (bsp) Scheduler::Postpone = true;
@@ -470,6 +494,147 @@ void TestMalloc(bool const bsp)
     SYNC;
 #endif
 
+    if (bsp)
+    {
+        MSG_("Cross-thread frees.%n");
+
+        ASSERT((Handoff = new (std::nothrow) void *[Cores::GetCount() * HandoffCount]) != nullptr);
+    }
+
+    SYNC;
+
+    {   //  Every core frees what the next one allocated.
+        size_t const coreCount = Cores::GetCount();
+        void * * const mine = Handoff + coreIndex * HandoffCount;
+        void * * const theirs = Handoff + ((coreIndex + 1) % coreCount) * HandoffCount;
+
+        for (size_t round = 0; round < HandoffRounds; ++round)
+        {
+            for (size_t i = 0; i < HandoffCount; ++i)
+                ASSERT((mine[i] = malloc((i & 3) == 3 ? 1024 : 64)) != nullptr)(round)(i);
+            //  Both slab objects and arena chunks.
+
+            SYNC;
+
+            perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t i = 0; i < HandoffCount; ++i)
+                free(theirs[i]);
+
+            perfEnd = CpuInstructions::Rdtsc();
+
+            HandoffCounter += perfEnd - perfStart;
+
+            SYNC;
+        }
+    }
+
+#ifdef __BEELZEBUB_SETTINGS_KRNDYNALLOC_VALLOC
+    {   //  Every core abandons its memory, as an exiting thread would, while
+        //  its objects are still alive. The next core frees them, and whoever
+        //  collects garbage first adopts the lot.
+
+        size_t const coreCount = Cores::GetCount();
+        void * * const mine = Handoff + coreIndex * HandoffCount;
+        void * * const theirs = Handoff + ((coreIndex + 1) % coreCount) * HandoffCount;
+
+        for (size_t i = 0; i < HandoffCount; ++i)
+            ASSERT((mine[i] = malloc((i & 3) == 3 ? 1024 : 64)) != nullptr)(i);
+
+        Valloc::AbandonMyMemory();
+
+        SYNC;
+
+        for (size_t i = 0; i < HandoffCount; ++i)
+            free(theirs[i]);
+
+        SYNC;
+
+        Valloc::CollectMyGarbage();
+
+        SYNC;
+    }
+#endif
+
+#ifdef __BEELZEBUB_SETTINGS_KRNDYNALLOC_VALLOC
+    Valloc::CollectMyGarbage();
+#endif
+
+    SYNC;
+
+    if (bsp)
+    {
+        size_t const itcnt = Cores::GetCount() * HandoffRounds * HandoffCount;
+
+        MSG_("%us cores did %us frees of objects allocated by another core in %us cycles; %us cycles per free.%n"
+            , Cores::GetCount(), itcnt, HandoffCounter.Load(), (HandoffCounter + itcnt / 2) / itcnt);
+
+        delete[] Handoff;
+
+        MSG_("Mixed sizes.%n");
+
+#ifdef __BEELZEBUB_SETTINGS_KRNDYNALLOC_VALLOC
+        MSG_("Footprint before: %us KiB.%n", Valloc::GetFootprint() / 1024);
+#endif
+    }
+
+    for (size_t i = 0; i < MixedSlots; ++i)
+        MyMixed[i] = nullptr;
+
+    SYNC;
+
+    uint64_t sizeState = 0x9E3779B97F4A7C15ULL + coreIndex;
+
+    perfStart = CpuInstructions::Rdtsc();
+
+    for (size_t i = 0, j = 0; j < MixedIterations; ++j)
+    {
+        if (MyMixed[i] != nullptr)
+            free(MyMixed[i]);
+
+        ASSERT((MyMixed[i] = malloc(MixedSize(sizeState))) != nullptr)(j);
+
+        *reinterpret_cast<uint8_t *>(MyMixed[i]) = (uint8_t)j;
+        //  Touch it.
+
+        if (++i == MixedSlots) i = 0;
+    }
+
+    perfEnd = CpuInstructions::Rdtsc();
+
+    MixedCounter += perfEnd - perfStart;
+
+    SYNC;
+
+    if (bsp)
+    {
+        size_t const itcnt = Cores::GetCount() * MixedIterations;
+
+        MSG_("%us cores did %us mixed-size malloc & free pairs in %us cycles; %us cycles per pair.%n"
+            , Cores::GetCount(), itcnt, MixedCounter.Load(), (MixedCounter + itcnt / 2) / itcnt);
+
+#ifdef __BEELZEBUB_SETTINGS_KRNDYNALLOC_VALLOC
+        MSG_("Footprint with %us live objects per core: %us KiB.%n"
+            , MixedSlots, Valloc::GetFootprint() / 1024);
+#endif
+    }
+
+    SYNC;
+
+    for (size_t i = 0; i < MixedSlots; ++i)
+        free(MyMixed[i]);
+
+#ifdef __BEELZEBUB_SETTINGS_KRNDYNALLOC_VALLOC
+    Valloc::CollectMyGarbage();
+
+    SYNC;
+
+    if (bsp)
+        MSG_("Footprint after: %us KiB.%n", Valloc::GetFootprint() / 1024);
+#endif
+
+    SYNC;
+
     if (bsp)
     {
         DEBUG_TERM_ << &(Memory::Vmm::KVas);
@@ -43,6 +43,7 @@
 #include "memory/object_allocator_smp.hpp"
 #include "memory/object_allocator_pools_heap.hpp"
 #include "kernel.hpp"
+#include "cores.hpp"
 
 #include "system/cpu.hpp"
 #include <math.h>
@@ -74,6 +75,9 @@ struct TestStructure
 };
 
 static ObjectAllocatorSmp testAllocator;
+static ObjectAllocatorSmp scalingAllocator;
+static ObjectAllocatorSmp alignedAllocator;
+static Atomic<uint64_t> scalingCycles {0};
 SmpLockUni syncer;
 
 // bool askedToAcquire, askedToEnlarge, askedToRemove, canEnlarge;
@@ -814,6 +818,169 @@ __startup Handle ObjectAllocatorParallelAcquireTest()
     return HandleResult::Okay;
 }
 
+static constexpr size_t const ScalingBatch = 32;
+static constexpr size_t const ScalingRounds = 4000;
+
+template<bool cached>
+static __startup uint64_t ObjectAllocatorScalingRun()
+{
+    TestStructure * objs[ScalingBatch];
+
+    uint64_t const perfStart = CpuInstructions::Rdtsc();
+
+    for (size_t x = 0; x < ScalingRounds; ++x)
+    {
+        for (size_t i = 0; i < ScalingBatch; ++i)
+        {
+            void * obj;
+
+            Handle res = cached
+                ? scalingAllocator.AllocateObject(obj)
+                : scalingAllocator.AllocateShared(obj);
+
+            ASSERTX(res.IsOkayResult()
+                , "Failed to allocate scaling test object #%us: %H%n"
+                , i, res)XEND;
+
+            objs[i] = reinterpret_cast<TestStructure *>(obj);
+        }
+
+        for (size_t i = 0; i < ScalingBatch; ++i)
+        {
+            Handle res = cached
+                ? scalingAllocator.DeallocateObject(objs[i])
+                : scalingAllocator.DeallocateShared(objs[i]);
+
+            ASSERTX(res.IsOkayResult()
+                , "Failed to deallocate scaling test object #%us (%Xp): %H%n"
+                , i, objs[i], res)XEND;
+        }
+    }
+
+    return CpuInstructions::Rdtsc() - perfStart;
+}
+
+__startup Handle ObjectAllocatorScalingTest(bool const bsp)
+{
+    if (bsp)
+        new (&scalingAllocator) ObjectAllocatorSmp(sizeof(TestStructure), __alignof(TestStructure)
+            , &AcquirePoolInKernelHeap, &EnlargePoolInKernelHeap, &ReleasePoolFromKernelHeap);
+    //  Without a busy bit or a quota, so objects are cached per core.
+
+    size_t const coreCount = Cores::GetCount();
+    size_t const index = Cpu::GetData()->Index;
+
+    for (size_t active = 1; active <= coreCount; active = (active == coreCount) ? (active + 1) : Minimum(active * 2, coreCount))
+    {
+        for (size_t cached = 0; cached < 2; ++cached)
+        {
+            SYNC;
+
+            if (index < active)
+                scalingCycles += cached
+                    ? ObjectAllocatorScalingRun<true>()
+                    : ObjectAllocatorScalingRun<false>();
+
+            SYNC;
+
+            if (bsp)
+            {
+                MSG_("Object allocator %s: %us cores, %u8 cycles per operation.%n"
+                    , cached ? "with caches" : "pools only", active
+                    , scalingCycles.Load() / (active * ScalingRounds * ScalingBatch * 2));
+
+                scalingCycles = 0;
+            }
+        }
+    }
+
+    scalingAllocator.FlushCache();
+
+    SYNC;
+
+    return HandleResult::Okay;
+}
+
+__startup Handle ObjectAllocatorAlignedTest()
+{
+    new (&alignedAllocator) ObjectAllocatorSmp(sizeof(TestStructure), __alignof(TestStructure)
+        , &AcquireAlignedPoolInKernelHeap, nullptr, &ReleaseAlignedPoolFromKernelHeap
+        , PoolReleaseOptions::ReleaseAll, 0, SIZE_MAX, AlignedPoolSize);
+
+    TestStructure * tOx = nullptr, * tOy = nullptr;
+    size_t count = 0;
+
+    do
+    {
+        Handle res = alignedAllocator.AllocateObject(tOx);
+
+        ASSERTX(res.IsOkayResult()
+            , "Failed to allocate aligned test object #%us: %H%n"
+            , count, res)XEND;
+
+        tOx->Next = tOy;
+        tOy = tOx;
+        ++count;
+    } while (alignedAllocator.PoolCount < 3);
+    //  Fills two pools and starts a third one.
+
+    ASSERTX(alignedAllocator.GetBusyCount() == count
+        , "Aligned test allocator should have %us busy objects, not %us.%n"
+        , count, alignedAllocator.GetBusyCount())XEND;
+
+    for (size_t i = 0; tOy != nullptr; ++i)
+    {
+        auto next = tOy->Next;
+
+        if ((i & 1) == 0)
+        {
+            Handle res = alignedAllocator.DeallocateObject(tOy);
+
+            ASSERTX(res.IsOkayResult()
+                , "Failed to deallocate aligned test object %Xp: %H%n"
+                , tOy, res)XEND;
+
+            res = alignedAllocator.DeallocateObject(tOy);
+
+            ASSERTX(res.IsResult(HandleResult::ObjaAlreadyFree)
+                , "Second deallocation of aligned test object %Xp should've "
+                  "returned \"already freed\": %H%n"
+                , tOy, res)XEND;
+        }
+        else
+        {
+            tOy->Next = tOx;
+            tOx = tOy;
+        }
+
+        tOy = next;
+    }
+
+    //  Every pool is partially used now; the remaining objects are freed in the
+    //  opposite order, which must release all the pools.
+
+    while (tOx != nullptr)
+    {
+        auto next = tOx->Next;
+
+        Handle res = alignedAllocator.DeallocateObject(tOx);
+
+        ASSERTX(res.IsOkayResult()
+            , "Failed to deallocate aligned test object %Xp: %H%n"
+            , tOx, res)XEND;
+
+        tOx = next;
+    }
+
+    ASSERTX(alignedAllocator.PoolCount == 0 && alignedAllocator.GetCapacity() == 0
+        , "Aligned test allocator should have no pools now, not %us (capacity %us).%n"
+        , alignedAllocator.PoolCount.Load(), alignedAllocator.GetCapacity())XEND;
+
+    alignedAllocator.Dispose();
+
+    return HandleResult::Okay;
+}
+
 Handle TestObjectAllocator(bool const bsp)
 {
     Handle res;
@@ -839,7 +1006,12 @@ Handle TestObjectAllocator(bool const bsp)
 
         //  The BSP will do more magic between these tests.
 
-        return ObjectAllocatorParallelAcquireTest();
+        res = ObjectAllocatorParallelAcquireTest();
+
+        if (!res.IsOkayResult())
+            return res;
+
+        return ObjectAllocatorScalingTest(false);
     }
     else
     {
@@ -1095,6 +1267,11 @@ Handle TestObjectAllocator(bool const bsp)
         // if (!res.IsOkayResult())
         //     return res;
 
+        res = ObjectAllocatorAlignedTest();
+
+        if (!res.IsOkayResult())
+            return res;
+
         //  Now parallel allocations should test that pool acquisition doesn't mess up.
 
         res = ObjectAllocatorParallelAcquireTest();
@@ -1102,7 +1279,7 @@ Handle TestObjectAllocator(bool const bsp)
         if (!res.IsOkayResult())
             return res;
 
-        return HandleResult::Okay;
+        return ObjectAllocatorScalingTest(true);
     }
 }
 
@@ -41,6 +41,7 @@
 
 #include "tests/pmm.hpp"
 #include "memory/pmm.hpp"
+#include "memory/vmm.hpp"
 #include "cores.hpp"
 #include "scheduler.hpp"
 #include <new>
@@ -73,6 +74,11 @@ static Atomic<size_t> RandomerCounter {0};
 #endif
 //  There is no space on the stack for this one.
 
+static constexpr size_t const StormPages = 2048;
+static Atomic<uint64_t> StormCycles {0};
+
+static __solid void TestPageFaultStorm(bool const bsp);
+
 void TestPmm(bool const bsp)
 {
     if (bsp) Scheduler::Postpone = true;
@@ -399,7 +405,74 @@ void TestPmm(bool const bsp)
 
     SYNC;
 
+    TestPageFaultStorm(bsp);
+
     if (bsp) Scheduler::Postpone = false;
 }
 
+void TestPageFaultStorm(bool const bsp)
+{
+    //  Every participating core touches pages allocated on demand, so every
+    //  access faults and allocates a frame. The round is repeated with twice as
+    //  many cores each time, to show how allocation throughput scales.
+
+    size_t const coreIndex = Cpu::GetData()->Index, coreCount = Cores::GetCount();
+
+    for (size_t active = 1; /* nothing */; active = (active * 2 > coreCount) ? coreCount : active * 2)
+    {
+        if (bsp) StormCycles.Store(0);
+
+        SYNC;
+
+        if (coreIndex < active)
+        {
+            vaddr_t vaddr = nullvaddr;
+
+            Handle res = Vmm::AllocatePages(nullptr
+                , vsize_t(StormPages * PageSize.Value)
+                , MemoryAllocationOptions::AllocateOnDemand | MemoryAllocationOptions::VirtualKernelHeap
+                , MemoryFlags::Global | MemoryFlags::Writable
+                , MemoryContent::Generic
+                , vaddr);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            uint64_t const perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t i = 0; i < StormPages; ++i)
+                *reinterpret_cast<uint8_t volatile *>(vaddr.Value + i * PageSize.Value) = (uint8_t)i;
+
+            uint64_t const perfEnd = CpuInstructions::Rdtsc();
+
+            res = Vmm::FreePages(nullptr, vaddr, vsize_t(StormPages * PageSize.Value));
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            uint64_t const elapsed = perfEnd - perfStart;
+            uint64_t cur = StormCycles.Load();
+
+            while (cur < elapsed && !StormCycles.CmpXchgWeak(cur, elapsed)) { }
+            //  The slowest core determines the duration of the round.
+        }
+
+        SYNC;
+
+#ifdef PRINT
+        if (bsp)
+        {
+            size_t const faults = active * StormPages;
+            uint64_t const cycles = StormCycles.Load();
+
+            MSG_("%us cores took %us page faults in %us cycles; %us faults per million cycles.%n"
+                , active, faults, cycles, (faults * 1'000'000 + cycles / 2) / cycles);
+        }
+
+        SYNC;
+#endif
+
+        if (active == coreCount)
+            break;
+    }
+}
+
 #endif
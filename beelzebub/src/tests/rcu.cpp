@@ -0,0 +1,172 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#ifdef __BEELZEBUB__TEST_RCU
+
+#include "tests/rcu.hpp"
+#include "rcu.hpp"
+#include "system/cpu.hpp"
+#include "cores.hpp"
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Synchronization;
+using namespace Beelzebub::System;
+
+Barrier RcuTestBarrier;
+
+#define SYNC RcuTestBarrier.Reach()
+
+struct RcuTestObject
+{
+    RcuEntry Entry;
+    size_t Value;
+    bool Alive;
+};
+
+static constexpr size_t const ObjectCount = 64;
+static constexpr size_t const UpdateCount = 10'000;
+static constexpr size_t const Poison = 0xDEADBEEFDEADBEEF;
+
+static RcuTestObject Objects[ObjectCount];
+static RcuTestObject * Published = nullptr;
+static Atomic<bool> WriterDone {false};
+
+static void Retire(void * cookie)
+{
+    RcuTestObject * const obj = reinterpret_cast<RcuTestObject *>(cookie);
+
+    obj->Value = Poison;
+    __atomic_store_n(&(obj->Alive), false, __ATOMIC_RELEASE);
+}
+
+static __startup void Update()
+{
+    uint64_t const gpStart = Rcu::GetCompletedGracePeriods();
+
+    for (size_t i = 1; i <= UpdateCount; ++i)
+    {
+        RcuTestObject * const obj = Objects + i % ObjectCount;
+
+        while (__atomic_load_n(&(obj->Alive), __ATOMIC_ACQUIRE))
+        {
+            Rcu::QuiescentState();
+
+            DO_NOTHING();
+        }
+        //  The object can only be reused once no reader can see it anymore.
+
+        obj->Value = i;
+        obj->Alive = true;
+
+        RcuTestObject * const old = __atomic_exchange_n(&Published, obj, __ATOMIC_ACQ_REL);
+
+        Rcu::CallAfterGracePeriod(&(old->Entry), &Retire, old);
+
+        Rcu::QuiescentState();
+    }
+
+    Rcu::Synchronize();
+
+    for (size_t i = 0; i < ObjectCount; ++i)
+        if (Objects + i != Published)
+            ASSERT(!Objects[i].Alive)(i)(Objects[i].Value);
+    //  Everything retired before the barrier must be gone after it.
+
+    MSG_("Core %us did %us updates over %us grace periods.%n"
+        , Cpu::GetData()->Index, UpdateCount
+        , Rcu::GetCompletedGracePeriods() - gpStart);
+
+    WriterDone.Store(true);
+}
+
+static __startup void Read()
+{
+    size_t last = 0, reads = 0;
+
+    while (!WriterDone.Load())
+    {
+        withRcuReader
+        {
+            RcuTestObject const * const obj = __atomic_load_n(&Published, __ATOMIC_ACQUIRE);
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                ASSERT(obj->Alive)(obj->Value);
+
+                size_t const val = *(size_t volatile *)&(obj->Value);
+
+                ASSERT(val != Poison && val >= last)(val)(last);
+                //  Updates are published in order.
+
+                last = val;
+            }
+        }
+
+        Rcu::QuiescentState();
+        ++reads;
+    }
+
+    MSG_("Core %us did %us read-side sections.%n", Cpu::GetData()->Index, reads);
+}
+
+void TestRcu(bool const bsp)
+{
+    if (bsp)
+    {
+        WriterDone.Store(false);
+
+        Objects[0].Value = 0;
+        Objects[0].Alive = true;
+
+        Published = Objects;
+    }
+
+    SYNC;
+
+    if (bsp)
+        Update();
+    else
+        Read();
+
+    SYNC;
+}
+
+#endif
@@ -43,6 +43,7 @@
 #include "cores.hpp"
 #include "kernel.hpp"
 #include <beel/sync/rw.ticket.lock.hpp>
+#include <beel/sync/smp.lock.hpp>
 
 #include <debug.hpp>
 
@@ -61,6 +62,56 @@ Barrier RwTicketLockTestBarrier;
 
 static RwTicketLock tLock {};
 
+static constexpr size_t const ContendedAcquisitionCount = 100'000;
+
+static SmpLock ContendedTicketLock {};
+static SmpQueuedLock ContendedQueuedLock {};
+static size_t ContendedCounter = 0;
+
+template<typename TLock>
+static __startup void BenchmarkContention(TLock & lock, char const * const name, bool bsp)
+{
+    //  Every core hammers the same lock, and the counter it guards tells
+    //  whether anybody got in at the wrong time.
+
+    if (bsp) ContendedCounter = 0;
+
+    SYNC;
+
+#ifdef PRINT
+    uint64_t perfStart = 0, perfEnd = 0;
+
+    perfStart = CpuInstructions::Rdtsc();
+#endif
+
+    for (size_t i = ContendedAcquisitionCount; i > 0; --i)
+    {
+        lock.Acquire();
+
+        ++ContendedCounter;
+
+        lock.Release();
+    }
+
+#ifdef PRINT
+    perfEnd = CpuInstructions::Rdtsc();
+#endif
+
+    SYNC;
+
+    if (bsp) ASSERT(ContendedCounter == Cores::GetCount() * ContendedAcquisitionCount)(ContendedCounter);
+
+#ifdef PRINT
+    MSG_("Core %us did %us contended %s pairs in %us cycles: %us per pair.%n"
+        , Cpu::GetData()->Index, ContendedAcquisitionCount, name, perfEnd - perfStart
+        , (perfEnd - perfStart + ContendedAcquisitionCount / 2) / ContendedAcquisitionCount);
+#else
+    (void)name;
+#endif
+
+    SYNC;
+}
+
 void TestRwTicketLock(bool bsp)
 {
     if (bsp) Scheduler::Postpone = true;
@@ -187,6 +238,9 @@ void TestRwTicketLock(bool bsp)
 
     SYNC;
 
+    BenchmarkContention(ContendedTicketLock, "ticket lock", bsp);
+    BenchmarkContention(ContendedQueuedLock, "queued lock", bsp);
+
     if (bsp) Scheduler::Postpone = false;
 }
 
@@ -43,6 +43,8 @@
 #include "cores.hpp"
 #include "kernel.hpp"
 #include <beel/sync/rw.spinlock.hpp>
+#include <beel/sync/rw.ticket.lock.hpp>
+#include <beel/sync/big.reader.lock.hpp>
 
 #include <debug.hpp>
 
@@ -61,6 +63,147 @@ Barrier RwSpinlockTestBarrier;
 
 static RwSpinlock tLock {};
 
+static constexpr size_t const ReaderAcquisitionCount = 1'000'000;
+
+static RwTicketLock ReadersTicketLock {};
+static BigReaderLock ReadersBigLock {};
+
+static size_t GuardedA = 0, GuardedB = 0;
+
+static __forceinline void ReaderPair(RwSpinlock & lock)
+{
+    lock.AcquireAsReader();
+    lock.ReleaseAsReader();
+}
+
+static __forceinline void ReaderPair(RwTicketLock & lock)
+{
+    lock.AcquireAsReader();
+    lock.ReleaseAsReader();
+}
+
+static __forceinline void ReaderPair(BigReaderLock & lock)
+{
+    size_t const slot = lock.AcquireAsReader();
+    lock.ReleaseAsReader(slot);
+}
+
+template<typename TLock>
+static __startup void BenchmarkReaders(TLock & lock, char const * const name)
+{
+    //  Readers only, as page faults and interrupts would do.
+
+    SYNC;
+
+#ifdef PRINT
+    uint64_t perfStart = 0, perfEnd = 0;
+
+    perfStart = CpuInstructions::Rdtsc();
+#endif
+
+    for (size_t i = ReaderAcquisitionCount; i > 0; --i)
+        ReaderPair(lock);
+
+#ifdef PRINT
+    perfEnd = CpuInstructions::Rdtsc();
+
+    SYNC;
+
+    MSG_("Core %us did %us %s reader pairs in %us cycles: %us per pair.%n"
+        , Cpu::GetData()->Index, ReaderAcquisitionCount, name, perfEnd - perfStart
+        , (perfEnd - perfStart + ReaderAcquisitionCount / 2) / ReaderAcquisitionCount);
+#else
+    (void)name;
+#endif
+
+    SYNC;
+}
+
+static __startup void TestBigReaderLock(bool bsp)
+{
+    if (bsp) ReadersBigLock.Reset();
+
+    SYNC;
+
+    ASSERT(!ReadersBigLock.HasWriter());
+    ASSERT_EQ("%us", 0UL, ReadersBigLock.GetReaderCount());
+
+    SYNC;
+
+    size_t slot = ReadersBigLock.AcquireAsReader();
+
+    SYNC;
+
+    ASSERT(!ReadersBigLock.HasWriter());
+    ASSERT_EQ("%us", Cores::GetCount(), ReadersBigLock.GetReaderCount());
+
+    if (bsp)
+        ASSERT(!ReadersBigLock.TryAcquireAsWriter());
+
+    SYNC;
+
+    ReadersBigLock.ReleaseAsReader(slot);
+
+    SYNC;
+
+    if (bsp)
+    {
+        ASSERT(ReadersBigLock.TryAcquireAsWriter());
+        ASSERT(ReadersBigLock.HasWriter());
+    }
+
+    SYNC;
+
+    if (!bsp)
+        ASSERT(!ReadersBigLock.TryAcquireAsReader(slot));
+    //  All must fail while the writer is in.
+
+    SYNC;
+
+    if (bsp)
+        ReadersBigLock.ReleaseAsWriter();
+
+    SYNC;
+
+    ASSERT(!ReadersBigLock.HasWriter());
+    ASSERT_EQ("%us", 0UL, ReadersBigLock.GetReaderCount());
+
+    SYNC;
+
+    //  Now the writer updates a pair of values which readers must never see
+    //  apart.
+
+    if (bsp)
+        for (size_t i = WriterAcquisitionCount; i > 0; --i)
+        {
+            ReadersBigLock.AcquireAsWriter();
+
+            ++GuardedA;
+            ++GuardedB;
+
+            ReadersBigLock.ReleaseAsWriter();
+        }
+    else
+        for (size_t i = WriterAcquisitionCount; i > 0; --i)
+        {
+            slot = ReadersBigLock.AcquireAsReader();
+
+            size_t const a = *(size_t volatile *)&GuardedA;
+            size_t const b = *(size_t volatile *)&GuardedB;
+
+            ReadersBigLock.ReleaseAsReader(slot);
+
+            ASSERT_EQ("%us", a, b);
+        }
+
+    SYNC;
+
+    ASSERT_EQ("%us", WriterAcquisitionCount, GuardedA);
+    ASSERT_EQ("%us", WriterAcquisitionCount, GuardedB);
+
+    SYNC;
+}
+
 void TestRwSpinlock(bool bsp)
 {
     if (bsp) Scheduler::Postpone = true;
@@ -251,6 +394,12 @@ void TestRwSpinlock(bool bsp)
 
     SYNC;
 
+    TestBigReaderLock(bsp);
+
+    BenchmarkReaders(tLock, "RW spinlock");
+    BenchmarkReaders(ReadersTicketLock, "RW ticket lock");
+    BenchmarkReaders(ReadersBigLock, "big reader lock");
+
     if (bsp) Scheduler::Postpone = false;
 }
 
@@ -0,0 +1,180 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#if defined(__BEELZEBUB__TEST_SCHED) && !defined(__BEELZEBUB_SETTINGS_KRNDYNALLOC_NONE)
+
+#include "tests/sched.hpp"
+#include "execution/run_queue.hpp"
+#include "system/cpu_instructions.hpp"
+#include <new>
+
+#include <debug.hpp>
+
+using namespace Beelzebub;
+using namespace Beelzebub::Execution;
+using namespace Beelzebub::System;
+using namespace Beelzebub::Terminals;
+
+static constexpr size_t const QueueSizes[] = { 10, 100, 1'000, 10'000 };
+static constexpr size_t const MaximumThreads = 10'000;
+static constexpr size_t const Iterations = 100'000;
+static constexpr size_t const PinnedRatio = 4;
+//  One in this many threads is pinned.
+
+static RunQueue Queue;
+//  Too large for the stack.
+
+static __startup void BenchmarkPickNext(ThreadSchedulerState * states, size_t const count)
+{
+    new (&Queue) RunQueue();
+    Queue.Initialize(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ThreadSchedulerState * const tsc = new (states + i) ThreadSchedulerState();
+
+        tsc->Priority = (int)(i % Scheduler::PriorityLevels);
+        tsc->Pinned = (i % PinnedRatio) == 0;
+
+        Queue.Push(tsc);
+    }
+
+    ASSERT(Queue.Count == count)(Queue.Count)(count);
+
+    //  Local pick: pop the best thread and requeue it, like a tick does.
+
+    uint64_t perfStart = CpuInstructions::Rdtsc();
+
+    for (size_t i = 0; i < Iterations; ++i)
+    {
+        int const highest = Queue.GetHighestPriority();
+
+        ThreadSchedulerState * const tsc = Queue.Pop(0);
+
+        ASSERT(tsc != nullptr && tsc->Priority == highest)(highest);
+
+        Queue.Push(tsc);
+    }
+
+    uint64_t perfEnd = CpuInstructions::Rdtsc();
+
+    DEBUG_TERM_ << "Local pick-next with " << count << " queued threads: "
+                << (perfEnd - perfStart) / Iterations << " cycles per pick."
+                << EndLine;
+
+    //  Remote pick: only migratable threads are visible, like stealing.
+
+    perfStart = CpuInstructions::Rdtsc();
+
+    for (size_t i = 0; i < Iterations; ++i)
+    {
+        ThreadSchedulerState * const tsc = Queue.Pop(1);
+
+        ASSERT(tsc != nullptr && !tsc->Pinned);
+
+        Queue.Push(tsc);
+    }
+
+    perfEnd = CpuInstructions::Rdtsc();
+
+    DEBUG_TERM_ << "Remote pick-next with " << count << " queued threads: "
+                << (perfEnd - perfStart) / Iterations << " cycles per pick."
+                << EndLine;
+
+    for (size_t i = 0; i < count; ++i)
+        ASSERT(Queue.Pop(0) != nullptr);
+
+    ASSERT(Queue.Count == 0)(Queue.Count);
+    ASSERT(Queue.Pop(0) == nullptr);
+}
+
+static __startup void TestRestrictedPick(ThreadSchedulerState * states)
+{
+    //  Threads allowed on cores 0 and 2 are only handed out to those cores.
+
+    new (&Queue) RunQueue();
+    Queue.Initialize(0);
+
+    Scheduler::AffinityMask mask {};
+    mask.SetBit(0);
+    mask.SetBit(2);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ThreadSchedulerState * const tsc = new (states + i) ThreadSchedulerState();
+
+        tsc->Priority = (int)i;
+        tsc->Affinity = (i & 1) == 0 ? &mask : nullptr;
+
+        Queue.Push(tsc);
+    }
+
+    ThreadSchedulerState * tsc = Queue.Pop(1);
+    ASSERT(tsc == states + 3)((void *)tsc);
+
+    tsc = Queue.Pop(1);
+    ASSERT(tsc == states + 1)((void *)tsc);
+
+    ASSERT(Queue.Pop(1) == nullptr);
+    //  Only restricted threads are left, and core 1 is not in their mask.
+
+    tsc = Queue.Pop(2);
+    ASSERT(tsc == states + 2)((void *)tsc);
+
+    tsc = Queue.Pop(0);
+    ASSERT(tsc == states + 0)((void *)tsc);
+
+    ASSERT(Queue.Count == 0)(Queue.Count);
+}
+
+void TestScheduler()
+{
+    ThreadSchedulerState * states = new (std::nothrow) ThreadSchedulerState[MaximumThreads];
+
+    ASSERT(states != nullptr);
+
+    TestRestrictedPick(states);
+
+    for (size_t count : QueueSizes)
+        BenchmarkPickNext(states, count);
+
+    delete[] states;
+}
+
+#endif
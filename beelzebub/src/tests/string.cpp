@@ -40,11 +40,16 @@
 #ifdef __BEELZEBUB__TEST_STR
 
 #include <tests/string.hpp>
+#include "system/cpu_instructions.hpp"
+#include <beel/string.arc.h>
 #include <string.h>
     
 #include <debug.hpp>
 
+// #define PRINT
+
 using namespace Beelzebub;
+using namespace Beelzebub::System;
 
 char const * const tStrA = "";
 char const * const tStrB = "a";
@@ -68,6 +73,205 @@ size_t const tStrHlen = 28;
 size_t const tStrIlen = 3;
 size_t const tStrJlen = 0;
 
+static size_t const BulkSize = 8192;
+static size_t const BulkRounds = 64;
+static size_t const BulkLengths[] = { 1, 7, 16, 33, 64, 255, 1024, 4096 };
+
+__aligned(64) static uint8_t BulkSource[BulkSize + 64];
+__aligned(64) static uint8_t BulkDestination[BulkSize + 64];
+
+static void TestBulkCorrectness()
+{
+    for (size_t i = 0; i < sizeof(BulkSource); ++i)
+        BulkSource[i] = (uint8_t)(i * 13 + 7);
+
+    for (size_t len : BulkLengths) for (size_t off = 0; off < 8; ++off)
+    {
+        uint8_t * const dst = BulkDestination + off;
+        uint8_t const * const src = BulkSource + 8 - off;
+
+        memset(BulkDestination, 0xA5, sizeof(BulkDestination));
+        memcpy(dst, src, len);
+
+        for (size_t i = 0; i < len; ++i)
+            ASSERT(dst[i] == src[i], "memcpy mismatch at byte %us of %us, offset %us.", i, len, off);
+
+        ASSERT(off == 0 || BulkDestination[off - 1] == 0xA5
+            , "memcpy wrote before its destination; length %us, offset %us.", len, off);
+        ASSERT(dst[len] == 0xA5
+            , "memcpy wrote past its destination; length %us, offset %us.", len, off);
+
+        ASSERT(memcmp(dst, src, len) == 0, "memcmp reports a difference after memcpy of %us bytes.", len);
+
+        dst[len - 1] ^= 0x80;
+        ASSERT(memcmp(dst, src, len) != 0, "memcmp misses a difference in the last of %us bytes.", len);
+        ASSERT(!memeq(dst, src, len), "memeq misses a difference in the last of %us bytes.", len);
+        ASSERT((memcmp(dst, src, len) < 0) == (dst[len - 1] < src[len - 1])
+            , "memcmp returns the wrong sign for %us bytes.", len);
+
+        memset(dst, 0x3C, len);
+
+        for (size_t i = 0; i < len; ++i)
+            ASSERT(dst[i] == 0x3C, "memset mismatch at byte %us of %us, offset %us.", i, len, off);
+
+        ASSERT(dst[len] == 0xA5
+            , "memset wrote past its destination; length %us, offset %us.", len, off);
+
+        dst[len] = 0;
+        ASSERT(strlen(reinterpret_cast<char const *>(dst)) == len
+            , "strlen is wrong for %us bytes at offset %us.", len, off);
+    }
+}
+
+static size_t const VectorLengths[] = { 16, 17, 31, 32, 33, 47, 63, 64, 65, 100, 255, 1000, 2047, 2048, 4096 };
+
+static void TestVectorKernels(uint32_t const features, char const * const name)
+{
+    //  The kernel selects no vector kernels for itself, so they are called
+    //  directly. This thread gets its own extended state on first use.
+
+    for (size_t len : VectorLengths) for (size_t off = 0; off < 8; ++off)
+    {
+        uint8_t * const dst = BulkDestination + off;
+        uint8_t const * const src = BulkSource + 8 - off;
+
+        memset(BulkDestination, 0xA5, sizeof(BulkDestination));
+
+        ASSERT(StringCopyWith(features, dst, src, len) == dst + len
+            , "%s copy returned the wrong end; length %us, offset %us.", name, len, off);
+
+        for (size_t i = 0; i < len; ++i)
+            ASSERT(dst[i] == src[i], "%s copy mismatch at byte %us of %us, offset %us.", name, i, len, off);
+
+        ASSERT(off == 0 || BulkDestination[off - 1] == 0xA5
+            , "%s copy wrote before its destination; length %us, offset %us.", name, len, off);
+        ASSERT(dst[len] == 0xA5
+            , "%s copy wrote past its destination; length %us, offset %us.", name, len, off);
+
+        ASSERT(StringMismatchWith(features, dst, src, len) == len
+            , "%s compare reports a difference after a copy of %us bytes.", name, len);
+
+        for (size_t j = 0; j < 3; ++j)
+        {
+            size_t const k = j * (len - 1) / 2;
+            //  First, middle and last bytes.
+
+            dst[k] ^= 0x80;
+
+            size_t const mismatch = StringMismatchWith(features, dst, src, len);
+
+            ASSERT(mismatch == k, "%s compare found byte %us instead of %us of %us."
+                , name, mismatch, k, len);
+
+            dst[k] ^= 0x80;
+        }
+
+        ASSERT(StringSetWith(features, dst, 0x3C, len) == dst + len
+            , "%s fill returned the wrong end; length %us, offset %us.", name, len, off);
+
+        for (size_t i = 0; i < len; ++i)
+            ASSERT(dst[i] == 0x3C, "%s fill mismatch at byte %us of %us, offset %us.", name, i, len, off);
+
+        ASSERT(dst[len] == 0xA5
+            , "%s fill wrote past its destination; length %us, offset %us.", name, len, off);
+
+        dst[len] = 0;
+        ASSERT(StringLengthWith(features, reinterpret_cast<char const *>(dst)) == len
+            , "%s length is wrong for %us bytes at offset %us.", name, len, off);
+    }
+}
+
+static size_t const MoveDistances[] = { 1, 7, 16, 100, 2047, 2048, 2049, 3000 };
+static size_t const MoveLengths[] = { 1, 33, 255, 1024, 4096 };
+
+static void TestMove()
+{
+    //  The destination buffer starts out as a copy of the source one, so the
+    //  latter tells what every byte should be after moving.
+
+    for (size_t dist : MoveDistances) for (size_t len : MoveLengths) for (size_t off = 0; off < 8; ++off)
+    {
+        for (size_t backward = 0; backward < 2; ++backward)
+        {
+            memcpy(BulkDestination, BulkSource, sizeof(BulkDestination));
+
+            size_t const from = backward ? off : off + dist;
+            size_t const to   = backward ? off + dist : off;
+
+            bool const end = (len & 1) != 0;
+            //  Odd lengths go through `mempmove`, to cover it too.
+
+            void * const res = end
+                ? mempmove(BulkDestination + to, BulkDestination + from, len)
+                : memmove(BulkDestination + to, BulkDestination + from, len);
+
+            ASSERT(res == BulkDestination + to + (end ? len : 0)
+                , "Move returned the wrong pointer; distance %us, length %us, offset %us."
+                , dist, len, off);
+
+            for (size_t i = 0; i < sizeof(BulkDestination); ++i)
+            {
+                uint8_t const expected = (i >= to && i < to + len) ? BulkSource[i - to + from] : BulkSource[i];
+
+                ASSERT(BulkDestination[i] == expected
+                    , "Move mismatch at byte %us; distance %us, length %us, offset %us, %s."
+                    , i, dist, len, off, backward ? "backward" : "forward");
+            }
+        }
+    }
+}
+
+static size_t const ClearLengths[] = { 0, 1, 7, 8, 9, 31, 32, 33, 100, 4095, 4096 };
+
+static void TestClearNonTemporal()
+{
+    for (size_t len : ClearLengths) for (size_t off = 0; off < 9; ++off)
+    {
+        uint8_t * const dst = BulkDestination + off;
+
+        memset(BulkDestination, 0xA5, sizeof(BulkDestination));
+
+        ASSERT(memclrnt(dst, len) == dst);
+
+        for (size_t i = 0; i < sizeof(BulkDestination); ++i)
+            ASSERT(BulkDestination[i] == ((i >= off && i < off + len) ? 0 : 0xA5)
+                , "memclrnt mismatch at byte %us; length %us, offset %us.", i, len, off);
+    }
+}
+
+#ifdef PRINT
+static void BenchmarkBulk()
+{
+    for (size_t len : BulkLengths)
+    {
+        uint64_t perfCopy, perfSet, perfCmp, perfStart;
+
+        perfStart = CpuInstructions::Rdtsc();
+
+        for (size_t i = 0; i < BulkRounds; ++i)
+            memcpy(BulkDestination, BulkSource, len);
+
+        perfCopy = CpuInstructions::Rdtsc() - perfStart;
+        perfStart = CpuInstructions::Rdtsc();
+
+        for (size_t i = 0; i < BulkRounds; ++i)
+            memset(BulkDestination, (int)i, len);
+
+        perfSet = CpuInstructions::Rdtsc() - perfStart;
+        memcpy(BulkDestination, BulkSource, len);
+        perfStart = CpuInstructions::Rdtsc();
+
+        for (size_t i = 0; i < BulkRounds; ++i)
+            ASSERT(memcmp(BulkDestination, BulkSource, len) == 0);
+
+        perfCmp = CpuInstructions::Rdtsc() - perfStart;
+
+        MSG_("%us bytes: memcpy %us, memset %us, memcmp %us cycles per call.%n"
+            , len, perfCopy / BulkRounds, perfSet / BulkRounds, perfCmp / BulkRounds);
+    }
+}
+#endif
+
 Handle TestStringLibrary()
 {
 #define testlen(name)                                        \
@@ -310,6 +514,20 @@ ASSERT(MCATS(str, name, Nlen, tseq) == (size_t)(expctd)                 \
     testCaseCmpEq("rada", "rAdA");
     testCaseCmpEqN("rada", "rAdA", 5);
 
+    TestBulkCorrectness();
+    TestMove();
+    TestClearNonTemporal();
+
+    uint32_t const features = StringDetectFeatures();
+
+    if (0 != (features & StringFeatureSse2))
+        TestVectorKernels(StringFeatureSse2, "SSE2");
+    if (0 != (features & StringFeatureAvx2))
+        TestVectorKernels(StringFeatureAvx2, "AVX2");
+
+#ifdef PRINT
+    BenchmarkBulk();
+#endif
 
     return HandleResult::Okay;
 }
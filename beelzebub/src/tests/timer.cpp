@@ -53,6 +53,10 @@ using namespace Beelzebub::Terminals;
 
 static Synchronization::Atomic<int> Counter {6};
 
+static constexpr size_t const ManyCount = 4096;
+static TimerId ManyIds[ManyCount];
+static Synchronization::Atomic<size_t> ManyFired {0};
+
 static __startup void Test1(void * cookie)
 {
     Rtc::Read();
@@ -64,6 +68,23 @@ static __startup void Test1(void * cookie)
     --Counter;
 }
 
+static void TestMany(void * cookie)
+{
+    size_t const index = reinterpret_cast<size_t>(cookie);
+
+    ASSERT((index & 1) == 0)(index);
+    //  Odd timers are cancelled.
+
+    ++ManyFired;
+}
+
+static void TestNever(void * cookie)
+{
+    (void)cookie;
+
+    ASSERT(false, "Cancelled timer fired.");
+}
+
 void TestTimer()
 {
     InterruptGuard<true> intGuard;
@@ -92,6 +113,36 @@ void TestTimer()
     ASSERT(InterruptState::IsEnabled());
 
     while (Counter > 0) { }
+
+    //  Now many timers at once, half of them cancelled.
+
+    for (size_t i = 0; i < ManyCount; ++i)
+        ASSERT(Timer::Enqueue(TimeSpanLite(1000 + (i * 7919) % 50000), &TestMany
+            , reinterpret_cast<void *>(i), ManyIds + i))(i);
+
+    for (size_t i = 1; i < ManyCount; i += 2)
+        ASSERT(Timer::Cancel(ManyIds[i]))(i);
+
+    for (size_t i = 1; i < ManyCount; i += 2)
+        ASSERT(!Timer::Cancel(ManyIds[i]))(i);
+    //  Cannot be cancelled twice.
+
+    while (ManyFired < ManyCount / 2) { }
+
+    for (size_t i = 0; i < ManyCount; i += 2)
+        ASSERT(!Timer::Cancel(ManyIds[i]))(i);
+    //  Cannot be cancelled after firing.
+
+    //  A delay far longer than the APIC timer can count in one go.
+
+    TimerId longId;
+
+    ASSERT(Timer::Enqueue(TimeSpanLite(3600ULL * 1000 * 1000), &TestNever, nullptr, &longId));
+    ASSERT(Timer::Cancel(longId));
+
+    DEBUG_TERM_ << "Fired " << ManyFired.Load() << " out of " << ManyCount << " timers." << EndLine;
+
+    ASSERT(ManyFired == ManyCount / 2)(ManyFired.Load());
 }
 
 #endif
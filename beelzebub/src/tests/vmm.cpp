@@ -41,10 +41,13 @@
 
 #include "tests/vmm.hpp"
 #include "memory/vmm.hpp"
+#include "memory/vmm.arc.hpp"
+#include "memory/pmm.hpp"
 #include "cores.hpp"
 #include "scheduler.hpp"
 #include "watchdog.hpp"
 #include "system/debug.registers.hpp"
+#include "system/timers/apic.timer.hpp"
 #include <new>
 
 #include <beel/sync/smp.lock.hpp>
@@ -86,6 +89,29 @@ static __solid void TestVmmCrossIntegrity(bool const bsp);
 #endif
 
 static __solid void TestVmmIntegrity(bool const bsp);
+static __solid void TestContextSwitch(bool const bsp);
+static __solid void TestFirstTouch(bool const bsp);
+static __solid void TestFaultThroughput(bool const bsp);
+static __solid void TestLargePages(bool const bsp);
+static __solid void TestCopyOnWrite(bool const bsp);
+
+static constexpr size_t const TouchPages = 4096;
+static vaddr_t TouchBuffer;
+static Atomic<size_t> TouchCounter {0};
+
+static constexpr size_t const SwitchIterations = 10'000;
+static constexpr size_t const SwitchPages = 64;
+static Execution::Process SwitchProcesses[2];
+
+static constexpr size_t const FaultPages = Vmm::ZeroedFramePoolCapacity;
+static constexpr size_t const FaultRounds = 16;
+static Execution::Process FaultProcess;
+
+static constexpr size_t const LargeTestPages = 4096;
+static constexpr size_t const LargeTestPasses = 4;
+static constexpr size_t const LargeTestFrames = LargeTestPages * PageSize.Value / LargePageSize.Value;
+
+static constexpr size_t const CowTestPages = 256;
 // static __hot void DumpStack(INTERRUPT_HANDLER_ARGS, void * address, System::BreakpointProperties & bp);
 
 void TestVmm(bool const bsp)
@@ -457,6 +483,26 @@ void TestVmm(bool const bsp)
 
     SYNC;
 
+    TestContextSwitch(bsp);
+
+    SYNC;
+
+    TestFirstTouch(bsp);
+
+    SYNC;
+
+    TestFaultThroughput(bsp);
+
+    SYNC;
+
+    TestLargePages(bsp);
+
+    SYNC;
+
+    TestCopyOnWrite(bsp);
+
+    SYNC;
+
 #ifdef PRINT
     if (bsp)
     {
@@ -477,6 +523,560 @@ void TestVmm(bool const bsp)
     }
 }
 
+void TestFirstTouch(bool const bsp)
+{
+    //  A buffer allocated on demand gets touched for the first time by 1, 2,
+    //  4, ... N cores, each taking every Nth page. The page faults look up
+    //  the kernel VAS concurrently, so the time per page ought to drop as
+    //  cores are added.
+
+    size_t const coreIndex = Cpu::GetData()->Index;
+    size_t const coreCount = Cores::GetCount();
+
+    for (size_t active = 1; /* nothing */; active <<= 1)
+    {
+        if (active > coreCount)
+            active = coreCount;
+
+        if (bsp)
+        {
+            TouchBuffer = nullvaddr;
+
+            Handle res = Vmm::AllocatePages(nullptr
+                , vsize_t(TouchPages * PageSize.Value)
+                , MemoryAllocationOptions::AllocateOnDemand | MemoryAllocationOptions::VirtualKernelHeap
+                , MemoryFlags::Global | MemoryFlags::Writable
+                , MemoryContent::Generic
+                , TouchBuffer);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            TouchCounter.Store(0);
+        }
+
+        SYNC;
+
+        if (coreIndex < active)
+        {
+            uint64_t const perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t i = coreIndex; i < TouchPages; i += active)
+                *reinterpret_cast<uint8_t volatile *>(TouchBuffer.Value + i * PageSize.Value) = 1;
+
+            uint64_t const perfEnd = CpuInstructions::Rdtsc();
+
+            TouchCounter += perfEnd - perfStart;
+        }
+
+        SYNC;
+
+        if (bsp)
+        {
+            MSG_("%us cores first-touched %us pages in %us cycles per core; %us cycles per page.%n"
+                , active, TouchPages, TouchCounter.Load() / active
+                , (TouchCounter.Load() / active + TouchPages / 2) / TouchPages);
+
+            Handle res = Vmm::FreePages(nullptr, TouchBuffer, vsize_t(TouchPages * PageSize.Value));
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+        }
+
+        SYNC;
+
+        if (active == coreCount)
+            break;
+    }
+}
+
+void TestFaultThroughput(bool const bsp)
+{
+    //  The bootstrap core touches a fresh userland buffer allocated on demand,
+    //  with and without fault-around and with and without a full pool of
+    //  zeroed frames. The other cores keep waiting on the barrier meanwhile.
+
+    if (!bsp)
+        return;
+
+    Execution::Process * const home = Cpu::GetProcess();
+
+    new (&FaultProcess) Execution::Process();
+
+    Handle res = Vmm::Initialize(&FaultProcess);
+
+    ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+    size_t const faultAround = Vmm::FaultAroundPages, zeroedTarget = Vmm::ZeroedFrameTarget;
+
+    for (size_t mode = 0; mode < 4; ++mode)
+    {
+        bool const around = 0 != (mode & 1), pooled = 0 != (mode & 2);
+
+        res = Vmm::SetFaultAround(around ? 15 : 0, pooled ? FaultPages : 0);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        uint64_t cycles = 0;
+        size_t faults = 0;
+
+        for (size_t round = 0; round < FaultRounds; ++round)
+        {
+            vaddr_t vaddr = nullvaddr;
+
+            res = Vmm::AllocatePages(&FaultProcess
+                , vsize_t(FaultPages * PageSize.Value)
+                , MemoryAllocationOptions::AllocateOnDemand | MemoryAllocationOptions::VirtualUser
+                , MemoryFlags::Userland | MemoryFlags::Writable
+                , MemoryContent::Generic
+                , vaddr);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            faults += around ? (FaultPages + 15) / 16 : FaultPages;
+            //  Pages are touched in order, so every fault maps the following 15.
+
+            Vmm::RefillZeroedFrames();
+            //  Fills the pool, or empties it.
+
+            {   //  Scope to contain the guard.
+                InterruptGuard<> intGuard;
+
+                res = home->SwitchTo(&FaultProcess);
+
+                ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+                uint64_t const perfStart = CpuInstructions::Rdtsc();
+
+                for (size_t j = 0; j < FaultPages; ++j)
+                    *reinterpret_cast<uint8_t volatile *>(vaddr.Value + j * PageSize.Value) = 1;
+
+                cycles += CpuInstructions::Rdtsc() - perfStart;
+
+                FaultProcess.SwitchTo(home);
+            }
+
+            res = Vmm::FreePages(&FaultProcess, vaddr, vsize_t(FaultPages * PageSize.Value));
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+        }
+
+#ifdef PRINT
+        MSG_("Fault-around %s, zeroed frames %s: %us faults for %us pages; %us cycles per page, %us cycles per fault"
+            , around ? "on" : "off", pooled ? "on" : "off"
+            , faults, FaultPages * FaultRounds
+            , (cycles + FaultPages * FaultRounds / 2) / (FaultPages * FaultRounds)
+            , faults == 0 ? 0 : (cycles + faults / 2) / faults);
+
+        if (Timers::ApicTimer::TscFrequency != 0 && cycles != 0)
+            MSG_("; %us faults per second.%n", (faults * Timers::ApicTimer::TscFrequency) / cycles);
+        else
+            MSG_(".%n");
+#else
+        (void)cycles;
+        (void)faults;
+#endif
+    }
+
+    res = Vmm::SetFaultAround(faultAround, zeroedTarget);
+
+    ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+    Vmm::RefillZeroedFrames();
+}
+
+void TestLargePages(bool const bsp)
+{
+    //  The bootstrap core touches a fresh userland buffer allocated on demand,
+    //  backed by small pages and then by large ones, and then walks it a few
+    //  more times to show the difference in TLB reach. Freeing a page from the
+    //  middle of a large one must leave its neighbours in place. The other
+    //  cores keep waiting on the barrier meanwhile.
+
+    if (!bsp)
+        return;
+
+    Execution::Process * const home = Cpu::GetProcess();
+    bool const largePages = Vmm::TransparentLargePages;
+
+    for (size_t mode = 0; mode < 2; ++mode)
+    {
+        bool const large = mode == 1;
+
+        Vmm::TransparentLargePages = large;
+
+        vaddr_t vaddr = nullvaddr;
+
+        Handle res = Vmm::AllocatePages(&FaultProcess
+            , vsize_t(LargeTestPages * PageSize.Value)
+            , MemoryAllocationOptions::AllocateOnDemand | MemoryAllocationOptions::VirtualUser
+            , MemoryFlags::Userland | MemoryFlags::Writable
+            , MemoryContent::Generic
+            , vaddr
+            , vsize_t(LargePageSize.Value));
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        uint64_t touchCycles, walkCycles;
+
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            res = home->SwitchTo(&FaultProcess);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            uint64_t perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t j = 0; j < LargeTestPages; ++j)
+                *reinterpret_cast<uint8_t volatile *>(vaddr.Value + j * PageSize.Value) = 1;
+
+            touchCycles = CpuInstructions::Rdtsc() - perfStart;
+
+            perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t k = 0; k < LargeTestPasses; ++k)
+                for (size_t j = 0; j < LargeTestPages; ++j)
+                    (void)*reinterpret_cast<uint8_t volatile *>(vaddr.Value + j * PageSize.Value);
+
+            walkCycles = CpuInstructions::Rdtsc() - perfStart;
+
+            FaultProcess.SwitchTo(home);
+        }
+
+        vaddr_t const hole = vaddr + vsize_t(LargePageSize.Value + 7 * PageSize.Value);
+        paddr_t before, after;
+
+        res = Vmm::Translate(&FaultProcess, hole + PageSize, before);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        res = Vmm::FreePages(&FaultProcess, hole, PageSize);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        res = Vmm::Translate(&FaultProcess, hole, after);
+
+        ASSERTX(res == HandleResult::PageUnmapped)(res)XEND;
+
+        res = Vmm::Translate(&FaultProcess, hole + PageSize, after);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+        ASSERTX(before == after)(before)(after)XEND;
+        //  Splitting keeps the neighbours where they were.
+
+        res = Vmm::FreePages(&FaultProcess, vaddr, vsize_t(hole - vaddr));
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        res = Vmm::FreePages(&FaultProcess, hole + PageSize
+            , vsize_t(LargeTestPages * PageSize.Value) - vsize_t(hole + PageSize - vaddr));
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        paddr_t frames[LargeTestFrames];
+
+        for (size_t j = 0; j < LargeTestFrames; ++j)
+        {
+            frames[j] = Pmm::AllocateFrame(FrameSize::_2MiB);
+
+            ASSERTX(frames[j] != nullpaddr)(j)XEND;
+            ASSERTX((frames[j].Value & (LargePageSize.Value - 1)) == 0)(frames[j])(j)XEND;
+        }
+        //  The split span was released through its 4 KiB entries, which point
+        //  inside the large frame. Whatever the frame caches hand out now must
+        //  still be aligned.
+
+        for (size_t j = 0; j < LargeTestFrames; ++j)
+        {
+            res = Pmm::FreeFrame(frames[j]);
+
+            ASSERTX(res == HandleResult::Okay)(res)(frames[j])XEND;
+        }
+
+#ifdef PRINT
+        MSG_("%s pages: %us cycles per page touched first, %us cycles per page walked after.%n"
+            , large ? "Large" : "Small"
+            , (touchCycles + LargeTestPages / 2) / LargeTestPages
+            , (walkCycles + LargeTestPages * LargeTestPasses / 2) / (LargeTestPages * LargeTestPasses));
+#else
+        (void)touchCycles;
+        (void)walkCycles;
+#endif
+    }
+
+    Vmm::TransparentLargePages = largePages;
+}
+
+void TestCopyOnWrite(bool const bsp)
+{
+    //  The bootstrap core duplicates a committed buffer into another process
+    //  and writes to every page of the copy, which makes each of them private.
+    //  Then it shares an on-demand buffer, whose writes must show on both sides.
+    //  The other cores keep waiting on the barrier meanwhile.
+
+    if (!bsp)
+        return;
+
+    Execution::Process * const home = Cpu::GetProcess();
+    Execution::Process * const other = SwitchProcesses + 0;
+    vsize_t const size { CowTestPages * PageSize.Value };
+
+    for (size_t mode = 0; mode < 2; ++mode)
+    {
+        bool const duplicate = mode == 0;
+
+        vaddr_t src = nullvaddr, dst = nullvaddr;
+
+        Handle res = Vmm::AllocatePages(&FaultProcess, size
+            , (duplicate ? MemoryAllocationOptions::Commit : MemoryAllocationOptions::AllocateOnDemand)
+            | MemoryAllocationOptions::VirtualUser
+            , MemoryFlags::Userland | MemoryFlags::Writable
+            , MemoryContent::Generic
+            , src);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            res = home->SwitchTo(&FaultProcess);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            for (size_t j = 0; j < CowTestPages; j += 2)
+                *reinterpret_cast<uint32_t volatile *>(src.Value + j * PageSize.Value) = (uint32_t)j;
+            //  Half the pages are left untouched, and thus unmapped in share mode.
+
+            FaultProcess.SwitchTo(home);
+        }
+
+        uint64_t perfStart = CpuInstructions::Rdtsc();
+
+        res = Vmm::SharePages(&FaultProcess, src, size, other, dst, duplicate);
+
+        uint64_t const shareCycles = CpuInstructions::Rdtsc() - perfStart;
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        paddr_t srcFrame, dstFrame;
+
+        for (size_t j = 0; j < CowTestPages; ++j)
+        {
+            res = Vmm::Translate(&FaultProcess, src + vsize_t(j * PageSize.Value), srcFrame);
+
+            ASSERTX(res == HandleResult::Okay)(res)(j)XEND;
+
+            res = Vmm::Translate(other, dst + vsize_t(j * PageSize.Value), dstFrame);
+
+            ASSERTX(res == HandleResult::Okay)(res)(j)XEND;
+            ASSERTX(srcFrame == dstFrame)(srcFrame)(dstFrame)(j)XEND;
+        }
+        //  Both sides start with the same frames.
+
+        uint64_t writeCycles;
+
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            res = home->SwitchTo(other);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            for (size_t j = 0; j < CowTestPages; ++j)
+            {
+                uint32_t const val = *reinterpret_cast<uint32_t volatile *>(dst.Value + j * PageSize.Value);
+
+                ASSERTX(val == ((j & 1) == 0 ? (uint32_t)j : 0))(val)(j)XEND;
+            }
+
+            perfStart = CpuInstructions::Rdtsc();
+
+            for (size_t j = 0; j < CowTestPages; ++j)
+                *reinterpret_cast<uint32_t volatile *>(dst.Value + j * PageSize.Value) = ~(uint32_t)j;
+
+            writeCycles = CpuInstructions::Rdtsc() - perfStart;
+
+            res = other->SwitchTo(&FaultProcess);
+
+            ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+            for (size_t j = 0; j < CowTestPages; ++j)
+            {
+                uint32_t const val = *reinterpret_cast<uint32_t volatile *>(src.Value + j * PageSize.Value);
+
+                uint32_t const expected = duplicate
+                    ? ((j & 1) == 0 ? (uint32_t)j : 0)
+                    : ~(uint32_t)j;
+
+                ASSERTX(val == expected)(val)(expected)(j)XEND;
+            }
+
+            *reinterpret_cast<uint32_t volatile *>(src.Value) = 42;
+            //  In duplicate mode, this page is no longer shared, so it only
+            //  becomes writable again.
+
+            FaultProcess.SwitchTo(home);
+        }
+
+        for (size_t j = 0; j < CowTestPages; ++j)
+        {
+            res = Vmm::Translate(&FaultProcess, src + vsize_t(j * PageSize.Value), srcFrame);
+
+            ASSERTX(res == HandleResult::Okay)(res)(j)XEND;
+
+            res = Vmm::Translate(other, dst + vsize_t(j * PageSize.Value), dstFrame);
+
+            ASSERTX(res == HandleResult::Okay)(res)(j)XEND;
+            ASSERTX((srcFrame == dstFrame) != duplicate)(srcFrame)(dstFrame)(j)XEND;
+        }
+        //  Copies diverge once written; shares never do.
+
+        res = Vmm::FreePages(other, dst, size);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        res = Vmm::FreePages(&FaultProcess, src, size);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+#ifdef PRINT
+        MSG_("%s: %us cycles per page shared, %us cycles per page written after.%n"
+            , duplicate ? "Copy-on-write" : "Shared"
+            , (shareCycles + CowTestPages / 2) / CowTestPages
+            , (writeCycles + CowTestPages / 2) / CowTestPages);
+#else
+        (void)shareCycles;
+        (void)writeCycles;
+#endif
+    }
+
+    vaddr_t src = nullvaddr, dst = nullvaddr;
+
+    Handle res = Vmm::AllocatePages(&FaultProcess, 3 * PageSize
+        , MemoryAllocationOptions::Commit | MemoryAllocationOptions::VirtualUser
+        , MemoryFlags::Userland | MemoryFlags::Writable
+        , MemoryContent::Generic
+        , src);
+
+    ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+    res = Vmm::SharePages(&FaultProcess, src + PageSize, PageSize, other, dst, true);
+
+    ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+    for (size_t j = 0; j < 3; ++j)
+    {
+        MemoryRegion const * const reg = FaultProcess.Vas.FindRegion(src + vsize_t(j * PageSize.Value));
+
+        ASSERTX(reg != nullptr)(j)XEND;
+        ASSERTX((0 != (reg->Type & MemoryAllocationOptions::CopyOnWrite)) == (j == 1))(j)XEND;
+    }
+    //  Only the shared page is marked, its neighbours are split off.
+
+    res = Vmm::FreePages(other, dst, PageSize);
+
+    ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+    res = Vmm::FreePages(&FaultProcess, src, 3 * PageSize);
+
+    ASSERTX(res == HandleResult::Okay)(res)XEND;
+}
+
+void TestContextSwitch(bool const bsp)
+{
+    //  The bootstrap core switches back and forth between two processes and
+    //  touches a few of their pages after every switch. The time spent touching
+    //  shows how many translations survived the switch. The other cores keep
+    //  waiting on the barrier meanwhile.
+
+    if (!bsp)
+        return;
+
+    Execution::Process * const home = Cpu::GetProcess();
+    vaddr_t vaddrs[2];
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        new (SwitchProcesses + i) Execution::Process();
+
+        Handle res = Vmm::Initialize(SwitchProcesses + i);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+        vaddrs[i] = nullvaddr;
+
+        res = Vmm::AllocatePages(SwitchProcesses + i
+            , vsize_t(SwitchPages * PageSize.Value)
+            , MemoryAllocationOptions::Commit | MemoryAllocationOptions::VirtualUser
+            , MemoryFlags::Userland | MemoryFlags::Writable
+            , MemoryContent::Generic
+            , vaddrs[i]);
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+    }
+
+    bool const pcid = VmmArc::PCID;
+
+    for (int mode = pcid ? 1 : 0; mode >= 0; --mode)
+    {
+        VmmArc::PCID = mode != 0;
+        //  Turning PCIDs off makes every switch flush, without losing track of
+        //  the translations tagged already.
+
+        uint64_t switchCycles = 0, touchCycles = 0;
+
+        {   //  Scope to contain the guard.
+            InterruptGuard<> intGuard;
+
+            Execution::Process * cur = home;
+
+            for (size_t i = 0; i < SwitchIterations; ++i)
+            {
+                Execution::Process * const next = SwitchProcesses + (i & 1);
+
+                uint64_t const perfStart = CpuInstructions::Rdtsc();
+
+                Handle res = cur->SwitchTo(next);
+
+                uint64_t const perfMid = CpuInstructions::Rdtsc();
+
+                ASSERTX(res == HandleResult::Okay)(res)XEND;
+
+                for (size_t j = 0; j < SwitchPages; ++j)
+                    (void)*reinterpret_cast<uint8_t volatile *>(vaddrs[i & 1].Value + j * PageSize.Value);
+
+                uint64_t const perfEnd = CpuInstructions::Rdtsc();
+
+                switchCycles += perfMid - perfStart;
+                touchCycles += perfEnd - perfMid;
+
+                cur = next;
+            }
+
+            cur->SwitchTo(home);
+        }
+
+#ifdef PRINT
+        MSG_("PCID %s: %us cycles per process switch; %us cycles to touch %us pages after a switch.%n"
+            , mode != 0 ? "on" : "off"
+            , (switchCycles + SwitchIterations / 2) / SwitchIterations
+            , (touchCycles + SwitchIterations / 2) / SwitchIterations
+            , SwitchPages);
+#else
+        (void)switchCycles;
+        (void)touchCycles;
+#endif
+    }
+
+    VmmArc::PCID = pcid;
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        Handle res = Vmm::FreePages(SwitchProcesses + i, vaddrs[i], vsize_t(SwitchPages * PageSize.Value));
+
+        ASSERTX(res == HandleResult::Okay)(res)XEND;
+    }
+}
+
 #include "memory/pmm.hpp"
 
 static constexpr size_t const TestCount = 1'000, CrossTestCount = 200, IterationCount = 1'000;
@@ -44,6 +44,15 @@
 
 #include <string.h>
 
+typedef size_t StringWord __attribute__((__may_alias__, __aligned__(1)));
+
+#define STRING_WORD_ONES  (~(size_t)0 / 0xFF)
+#define STRING_WORD_HIGHS (STRING_WORD_ONES << 7)
+
+#define STRING_WORD_HAS_ZERO(word) \
+    ((((word) - STRING_WORD_ONES) & ~(word) & STRING_WORD_HIGHS) != 0)
+//  Whether any byte of the word is zero; checks a whole word per iteration.
+
 void * memchr(void const * src, int val, size_t len)
 {
 //     asm volatile ( "repne scasb   \n\t"
@@ -63,6 +72,12 @@ void * memchr(void const * src, int val, size_t len)
 
     uint8_t const * s = (uint8_t const *)src;
     uint8_t const bVal = val & 0xFF;
+    size_t const pattern = STRING_WORD_ONES * bVal;
+
+    for (; len >= sizeof(size_t); s += sizeof(size_t), len -= sizeof(size_t))
+        if (STRING_WORD_HAS_ZERO(*(StringWord const *)s ^ pattern))
+            break;
+    //  Matching bytes become zero, and the first one is within this word.
 
     for (; len > 0; ++s, --len)
         if (*s == bVal)
@@ -296,6 +311,24 @@ char * strchr(char const * haystack, int needle)
 {
     char c;
 
+    for (; ((uintptr_t)haystack & (sizeof(size_t) - 1)) != 0; ++haystack)
+        if ((c = *haystack) == '\0')
+            return nullptr;
+        else if (c == needle)
+            return (char *)haystack;
+
+    size_t const pattern = STRING_WORD_ONES * (uint8_t)needle;
+
+    for (;; haystack += sizeof(size_t))
+    {
+        size_t const word = *(StringWord const *)haystack;
+
+        if (STRING_WORD_HAS_ZERO(word) || STRING_WORD_HAS_ZERO(word ^ pattern))
+            break;
+        //  Aligned words never cross into the next page, so reading past the
+        //  terminator cannot fault.
+    }
+
     while ((c = *(haystack++)) != '\0')
         if (c == needle)
             return (char *)haystack - 1;
@@ -311,11 +344,22 @@ char * strstr(char const * haystack, char const * needle)
         return nullptr;
     //  No way the needle can be larger than the haystack.
 
-    size_t lenDiff = hLen - nLen;
+    if (nLen == 0)
+        return (char *)haystack;
 
-    for (size_t i = 0; i <= lenDiff; ++i)
-        if (memeq(haystack + i, needle, nLen))
-            return (char *)(haystack + i);
+    char const * const last = haystack + (hLen - nLen);
+
+    for (char const * cand = haystack; cand <= last; ++cand)
+    {
+        cand = (char const *)memchr(cand, needle[0], (size_t)(last - cand) + 1);
+
+        if (cand == nullptr)
+            break;
+        //  Only positions starting with the needle's first character matter.
+
+        if (memeq(cand + 1, needle + 1, nLen - 1))
+            return (char *)cand;
+    }
 
     return nullptr;
 }
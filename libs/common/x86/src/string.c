@@ -40,91 +40,178 @@
 /**
  *  The loops here should be perfectly compatible with single machine code
  *  instructions. Maybe with a branch or two mixed in.
+ *
+ *  Which instructions pay off depends on the processor. Every path taken here
+ *  is correct on all of them; the kernel turns the jumps in `STRING_PATCH_SITE`
+ *  into no-ops at boot where the feature they assume is missing, and userland
+ *  may additionally select vector kernels.
  */
 
 #include <string.h>
+#include <string.simd.h>
 
-bool memeq(void const * src1, void const * src2, size_t len)
+typedef size_t StringWord __attribute__((__may_alias__, __aligned__(1)));
+
+#if   defined(__BEELZEBUB__ARCH_AMD64)
+    #define STRING_WORD_SUFFIX "q"
+#else
+    #define STRING_WORD_SUFFIX "l"
+#endif
+
+#define STRING_WORD_ONES  (~(size_t)0 / 0xFF)
+#define STRING_WORD_HIGHS (STRING_WORD_ONES << 7)
+
+#define STRING_PATCH_SITE(feature, target)                  \
+    asm goto ( "1: jmp %l1                          \n\t"   \
+               "2:                                  \n\t"   \
+               ".pushsection .string_patches, \"aw\"\n\t"   \
+               ".dc.a 1b, 2b, %c0                   \n\t"   \
+               ".popsection                         \n\t"   \
+             : : "i"(feature) : : target)
+
+/*  Helpers  */
+
+static __forceinline void * CopyForward(void * dst, void const * src, size_t len)
 {
-    if (src1 == src2)
-        return true;
+    if (len < StringShortLength)
+    {
+        if (StringVectorFeatures != 0 && len >= StringVectorMinimum)
+            return StringCopyVector(dst, src, len);
 
-    bool ret;
+        STRING_PATCH_SITE(StringFeatureFsrm, bytes);
 
-    asm volatile ( "repe cmpsb \n\t"
-                   "sete %3    \n\t"
-                 : "+D" (src1), "+S" (src2), "+c" (len), "=a"(ret)
-                 :
-                 : "memory" );
+        uint8_t * d = (uint8_t *)dst;
+        uint8_t const * s = (uint8_t const *)src;
 
-    return ret;
+        for (/* nothing */; len >= sizeof(size_t); len -= sizeof(size_t), d += sizeof(size_t), s += sizeof(size_t))
+            *(StringWord *)d = *(StringWord const *)s;
+
+        for (/* nothing */; len > 0; --len)
+            *(d++) = *(s++);
 
-    /* The following code is equivalent to the assembly above
+        return d;
+    }
 
-    byte const * s1 = (byte *)src1;
-    byte const * s2 = (byte *)src2;
+    if (StringVectorFeatures != 0 && len < StringVectorMaximum)
+        return StringCopyVector(dst, src, len);
 
-    for (; len > 0; ++s1, ++s2, --len)
-        if (*s1 != *s2)
-            return false;
+    STRING_PATCH_SITE(StringFeatureErms, bytes);
 
-    return true; //*/
+    {
+        size_t words = len / sizeof(size_t);
+        len %= sizeof(size_t);
+
+        asm volatile ( "rep movs" STRING_WORD_SUFFIX " \n\t"
+                     : "+D"(dst), "+S"(src), "+c"(words)
+                     : : "memory" );
+        //  Without ERMS, word-sized moves are faster; the rest of the bytes
+        //  are moved below.
+    }
+
+bytes:
+    asm volatile ( "rep movsb \n\t"
+                 : "+D"(dst), "+S"(src), "+c"(len)
+                 : : "memory" );
+
+    return dst;
 }
 
-comp_t memcmp(void const * src1, void const * src2, size_t len)
+static __forceinline void * SetForward(void * dst, int const val, size_t len)
 {
-    if (src1 == src2)
-        return 0;
+    size_t const word = STRING_WORD_ONES * (uint8_t)val;
+
+    if (len < StringShortLength)
+    {
+        if (StringVectorFeatures != 0 && len >= StringVectorMinimum)
+            return StringSetVector(dst, val, len);
+
+        uint8_t * d = (uint8_t *)dst;
+
+        for (/* nothing */; len >= sizeof(size_t); len -= sizeof(size_t), d += sizeof(size_t))
+            *(StringWord *)d = word;
+
+        for (/* nothing */; len > 0; --len)
+            *(d++) = (uint8_t)val;
+
+        return d;
+    }
 
-    comp_t ret = 0;
+    if (StringVectorFeatures != 0 && len < StringVectorMaximum)
+        return StringSetVector(dst, val, len);
 
-    asm volatile ( "repe cmpsb \n\t"
-                   "sete %%al  \n\t"
-                 : "+D" (src1), "+S" (src2), "+c" (len), "=a"(ret)
-                 :
+    STRING_PATCH_SITE(StringFeatureErms, bytes);
+
+    {
+        size_t words = len / sizeof(size_t);
+        len %= sizeof(size_t);
+
+        asm volatile ( "rep stos" STRING_WORD_SUFFIX " \n\t"
+                     : "+D" (dst), "+c" (words)
+                     : "a" (word)
+                     : "memory" );
+    }
+
+bytes:
+    asm volatile ( "rep stosb \n\t"
+                 : "+D" (dst), "+c" (len)
+                 : "a" (val)
                  : "memory" );
 
-    //msg("!! AFTER memcmp: DI = %Xp (%X1), SI = %Xp (%X1), C = %Xs, A = %s8 !!", src1, *((byte *)src1), src2, *((byte *)src2), len, ret);
+    return dst;
+}
 
-    return ret;
+static __forceinline size_t Mismatch(void const * src1, void const * src2, size_t len)
+{
+    if (StringVectorFeatures != 0 && len >= StringVectorMinimum)
+        return StringMismatchVector(src1, src2, len);
 
-    /* The following code is equivalent to the assembly above
-    byte const * s1 = (byte *)src1;
-    byte const * s2 = (byte *)src2;
+    uint8_t const * s1 = (uint8_t const *)src1;
+    uint8_t const * s2 = (uint8_t const *)src2;
+    size_t i = 0;
 
-    sbyte res = 0;    //  Used to store subtraction/comparison results.
+    for (/* nothing */; i + sizeof(size_t) <= len; i += sizeof(size_t))
+        if (*(StringWord const *)(s1 + i) != *(StringWord const *)(s2 + i))
+            break;
+    //  The differing byte is within the word, if any.
 
-    for (; len > 0; ++s1, ++s2, --len)
-        if ((res = (sbyte)(*s1) - (sbyte)(*s2)) != 0)
-            return (comp_t)res;
+    for (/* nothing */; i < len; ++i)
+        if (s1[i] != s2[i])
+            return i;
 
-    return 0; //*/
+    return len;
 }
 
-void * memcpy(void * dst, void const * src, size_t len)
+/*  Comparison  */
+
+bool memeq(void const * src1, void const * src2, size_t len)
 {
-    void * ret = dst;
+    if (src1 == src2)
+        return true;
 
-    if (src != dst)
-    {
-        asm volatile ( "rep movsb \n\t"
-                     : "+D"(dst), "+S"(src), "+c"(len)
-                     : : "memory" );
-    }
+    return Mismatch(src1, src2, len) == len;
+}
 
-    return ret;
+comp_t memcmp(void const * src1, void const * src2, size_t len)
+{
+    if (src1 == src2)
+        return 0;
 
-    /* The following code is equivalent to the assembly above
-    if (src == dst)
-        return dst;
+    size_t const i = Mismatch(src1, src2, len);
+
+    if (i == len)
+        return 0;
 
-          byte * d = (byte *)dst;
-    byte const * s = (byte *)src;
+    return (comp_t)((uint8_t const *)src1)[i] - (comp_t)((uint8_t const *)src2)[i];
+}
 
-    for (; len > 0; ++d, ++s, --len)
-        *d = *s;
+/*  Copying  */
 
-    return dst; //*/
+void * memcpy(void * dst, void const * src, size_t len)
+{
+    if (src != dst)
+        CopyForward(dst, src, len);
+
+    return dst;
 }
 
 void * memmove(void * dst, void const * src, size_t len)
@@ -135,9 +222,14 @@ void * memmove(void * dst, void const * src, size_t len)
     {
         //  Loop forward.
 
-        asm volatile ( "rep movsb \n\t"
-                       : "+D"(dst), "+S"(src), "+c"(len)
-                       : : "memory" );
+        if ((uintptr_t)src - (uintptr_t)dst >= StringVectorMaximum)
+            CopyForward(dst, src, len);
+        else
+            asm volatile ( "rep movsb \n\t"
+                           : "+D"(dst), "+S"(src), "+c"(len)
+                           : : "memory" );
+        //  Vector and word moves are only safe if the source is far enough
+        //  ahead not to be overwritten before it is read.
     }
     else if (src < dst)
     {
@@ -154,39 +246,14 @@ void * memmove(void * dst, void const * src, size_t len)
     }
 
     return ret;
-
-    /* The following code is equivalent to the code & assembly above
-    if (src == dst)
-        return dst;
-
-          byte * d = (byte *)dst;
-    byte const * s = (byte *)src;
-
-    if (dst < src)
-        for (; len > 0; ++d, ++s, --len)
-            *d = *s;
-    else
-    {
-        dst += len;
-        src += len;
-
-        for (; i < len; --d, --s, --len)
-            *d = *s;
-    }
-
-    return dst; //*/
 }
 
 void * mempcpy(void * dst, void const * src, size_t len)
 {
     if (src != dst)
-    {
-        asm volatile ( "rep movsb \n\t"
-                     : "+D"(dst), "+S"(src), "+c"(len)
-                     : : "memory" );
-    }
+        return CopyForward(dst, src, len);
 
-    return dst;
+    return (void *)((uintptr_t)dst + len);
 }
 
 void * mempmove(void * dst, void const * src, size_t len)
@@ -195,6 +262,9 @@ void * mempmove(void * dst, void const * src, size_t len)
     {
         //  Loop forward.
 
+        if ((uintptr_t)src - (uintptr_t)dst >= StringVectorMaximum)
+            return CopyForward(dst, src, len);
+
         asm volatile ( "rep movsb \n\t"
                        : "+D"(dst), "+S"(src), "+c"(len)
                        : : "memory" );
@@ -222,33 +292,18 @@ void * mempmove(void * dst, void const * src, size_t len)
     return (void *)((uintptr_t)dst + len);
 }
 
+/*  Filling  */
+
 void * memset(void * dst, int const val, size_t len)
 {
-    void * ret = dst;
+    SetForward(dst, val, len);
 
-    asm volatile ( "rep stosb \n\t"
-                 : "+D" (dst), "+c" (len)
-                 : "a" (val)
-                 : "memory" );
-
-    /* The following code is equivalent to the assembly above
-          byte * d = (byte *)dst;
-    byte const   v = (byte  )val;
-
-    for (; len > 0; ++d, --len)
-        *d = v; //*/
-
-    return ret;
+    return dst;
 }
 
 void * mempset(void * dst, int const val, size_t len)
 {
-    asm volatile ( "rep stosb \n\t"
-                 : "+D" (dst), "+c" (len)
-                 : "a" (val)
-                 : "memory" );
-
-    return dst;
+    return SetForward(dst, val, len);
 }
 
 void * memset16(void * dst, int const val, size_t cnt)
@@ -295,27 +350,68 @@ void * mempset32(void * dst, long const val, size_t cnt)
     return dst;
 }
 
+void * memclrnt(void * dst, size_t len)
+{
+    uint8_t * b = (uint8_t *)dst;
+
+    for (/* nothing */; len > 0 && ((uintptr_t)b & (sizeof(size_t) - 1)) != 0; --len)
+        *(b++) = 0;
+    //  Non-temporal stores only come in whole words, which ought to be aligned.
+
+    size_t * d = (size_t *)b;
+    size_t const zero = 0;
+
+    for (/* nothing */; len >= 4 * sizeof(size_t); len -= 4 * sizeof(size_t), d += 4)
+        asm volatile ( "movnti %[zero], %[d0] \n\t"
+                       "movnti %[zero], %[d1] \n\t"
+                       "movnti %[zero], %[d2] \n\t"
+                       "movnti %[zero], %[d3] \n\t"
+                     : [d0]"=m"(d[0]), [d1]"=m"(d[1]), [d2]"=m"(d[2]), [d3]"=m"(d[3])
+                     : [zero]"r"(zero) );
+    //  Non-temporal stores keep the zeroes from evicting anything useful from
+    //  the caches. They only use general-purpose registers, so the kernel can
+    //  use them too.
+
+    for (/* nothing */; len >= sizeof(size_t); len -= sizeof(size_t), ++d)
+        asm volatile ( "movnti %[zero], %[d0] \n\t"
+                     : [d0]"=m"(d[0])
+                     : [zero]"r"(zero) );
+
+    asm volatile ( "sfence \n\t" : : : "memory" );
+
+    for (b = (uint8_t *)d; len > 0; --len)
+        *(b++) = 0;
+
+    return dst;
+}
+
+/*  Strings  */
+
 size_t strlen(char const * str)
 {
-#if   defined(__BEELZEBUB__ARCH_AMD64)
-    register size_t ret  asm("rcx") = ~((size_t)0);
-    register size_t null asm("rax") =   (size_t)0;
-#else
-    register size_t ret  asm("ecx") = ~((size_t)0);
-    register size_t null asm("eax") =   (size_t)0;
-#endif
+    if (StringVectorFeatures != 0)
+        return StringLengthVector(str);
 
-    asm volatile ( "repne scasb \n\t"
-                 : "+D"(str), "+c"(ret)
-                 : "a"(null)
-                 : "memory" );
-    //  `ret` started at -1, and is decremented once for every character
-    //  encountered up to 0 inclusively. Therefore, `ret` will contain
-    //  `-length - 2` after the assembly block. `~ret` flips all the bits
-    //  so the value becomes `length + 2 - 1` (`length + 1`), so the `- 1`
-    //  brings it to the desired result.
+    char const * s = str;
+
+    for (/* nothing */; ((uintptr_t)s & (sizeof(size_t) - 1)) != 0; ++s)
+        if (*s == '\0')
+            return (size_t)(s - str);
+
+    for (/* nothing */; ; s += sizeof(size_t))
+    {
+        size_t const word = *(StringWord const *)s;
+
+        if (((word - STRING_WORD_ONES) & ~word & STRING_WORD_HIGHS) != 0)
+            break;
+        //  Aligned words never cross into the next page, so reading past the
+        //  terminator cannot fault.
+    }
+
+    while (*s != '\0')
+        ++s;
 
-    return ~ret - 1;
+    return (size_t)(s - str);
 }
 
 size_t strnlen(char const * str, size_t len)
@@ -0,0 +1,270 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+/**
+ *  These kernels use SSE2 and AVX2 through per-function targets, because the
+ *  rest of the library is built without vector registers for the kernel's
+ *  sake. They are only ever reached when `StringVectorFeatures` allows it.
+ */
+
+#include <string.simd.h>
+
+typedef char Vector16  __attribute__((__vector_size__(16), __may_alias__));
+typedef char Vector16U __attribute__((__vector_size__(16), __may_alias__, __aligned__(1)));
+typedef char Vector32U __attribute__((__vector_size__(32), __may_alias__, __aligned__(1)));
+
+#define SSE2_KERNEL static __attribute__((__noinline__, __target__("sse2")))
+#define AVX2_KERNEL static __attribute__((__noinline__, __target__("avx2")))
+
+uint32_t StringVectorFeatures = 0;
+
+/*****************
+    SSE2 Kernels
+*****************/
+
+SSE2_KERNEL void CopySse2(char * dst, char const * src, size_t len)
+{
+    Vector16U const last = *(Vector16U const *)(src + len - 16);
+
+    for (size_t i = 0; i < len - 16; i += 16)
+        *(Vector16U *)(dst + i) = *(Vector16U const *)(src + i);
+
+    *(Vector16U *)(dst + len - 16) = last;
+    //  The last vector may overlap the previous one, which saves a byte loop.
+}
+
+SSE2_KERNEL void SetSse2(char * dst, char val, size_t len)
+{
+    Vector16U const v = (Vector16U){ 0 } + val;
+
+    for (size_t i = 0; i < len - 16; i += 16)
+        *(Vector16U *)(dst + i) = v;
+
+    *(Vector16U *)(dst + len - 16) = v;
+}
+
+SSE2_KERNEL size_t MismatchSse2(char const * src1, char const * src2, size_t len)
+{
+    size_t i = 0;
+
+    for (/* nothing */; i + 16 <= len; i += 16)
+    {
+        unsigned int const mask = (unsigned int)__builtin_ia32_pmovmskb128(
+            *(Vector16U const *)(src1 + i) == *(Vector16U const *)(src2 + i));
+
+        if (mask != 0xFFFFU)
+            return i + __builtin_ctz(~mask);
+    }
+
+    for (/* nothing */; i < len; ++i)
+        if (src1[i] != src2[i])
+            return i;
+
+    return len;
+}
+
+SSE2_KERNEL size_t LengthSse2(char const * str)
+{
+    size_t const offset = (uintptr_t)str & 15;
+    char const * s = str - offset;
+    //  Aligned loads never cross into the next page, so they cannot fault
+    //  past the terminator.
+
+    unsigned int mask = (unsigned int)__builtin_ia32_pmovmskb128(*(Vector16 const *)s == (Vector16){ 0 }) >> offset;
+
+    if (mask != 0)
+        return __builtin_ctz(mask);
+
+    do
+    {
+        s += 16;
+
+        mask = (unsigned int)__builtin_ia32_pmovmskb128(*(Vector16 const *)s == (Vector16){ 0 });
+    } while (mask == 0);
+
+    return (size_t)(s - str) + __builtin_ctz(mask);
+}
+
+/*****************
+    AVX2 Kernels
+*****************/
+
+AVX2_KERNEL void CopyAvx2(char * dst, char const * src, size_t len)
+{
+    Vector32U const last = *(Vector32U const *)(src + len - 32);
+
+    for (size_t i = 0; i < len - 32; i += 32)
+        *(Vector32U *)(dst + i) = *(Vector32U const *)(src + i);
+
+    *(Vector32U *)(dst + len - 32) = last;
+}
+
+AVX2_KERNEL void SetAvx2(char * dst, char val, size_t len)
+{
+    Vector32U const v = (Vector32U){ 0 } + val;
+
+    for (size_t i = 0; i < len - 32; i += 32)
+        *(Vector32U *)(dst + i) = v;
+
+    *(Vector32U *)(dst + len - 32) = v;
+}
+
+AVX2_KERNEL size_t MismatchAvx2(char const * src1, char const * src2, size_t len)
+{
+    size_t i = 0;
+
+    for (/* nothing */; i + 32 <= len; i += 32)
+    {
+        unsigned int const mask = (unsigned int)__builtin_ia32_pmovmskb256(
+            *(Vector32U const *)(src1 + i) == *(Vector32U const *)(src2 + i));
+
+        if (mask != 0xFFFFFFFFU)
+            return i + __builtin_ctz(~mask);
+    }
+
+    for (/* nothing */; i < len; ++i)
+        if (src1[i] != src2[i])
+            return i;
+
+    return len;
+}
+
+/*****************
+    Dispatchers
+*****************/
+
+void * StringCopyWith(uint32_t features, void * dst, void const * src, size_t len)
+{
+    if ((features & StringFeatureAvx2) && len >= 32)
+        CopyAvx2((char *)dst, (char const *)src, len);
+    else
+        CopySse2((char *)dst, (char const *)src, len);
+
+    return (char *)dst + len;
+}
+
+void * StringSetWith(uint32_t features, void * dst, int val, size_t len)
+{
+    if ((features & StringFeatureAvx2) && len >= 32)
+        SetAvx2((char *)dst, (char)val, len);
+    else
+        SetSse2((char *)dst, (char)val, len);
+
+    return (char *)dst + len;
+}
+
+size_t StringMismatchWith(uint32_t features, void const * src1, void const * src2, size_t len)
+{
+    if (features & StringFeatureAvx2)
+        return MismatchAvx2((char const *)src1, (char const *)src2, len);
+    else
+        return MismatchSse2((char const *)src1, (char const *)src2, len);
+}
+
+size_t StringLengthWith(uint32_t features, char const * str)
+{
+    (void)features;
+
+    return LengthSse2(str);
+    //  Most strings are short, so wider loads would not pay off.
+}
+
+void * StringCopyVector(void * dst, void const * src, size_t len)
+{
+    return StringCopyWith(StringVectorFeatures, dst, src, len);
+}
+
+void * StringSetVector(void * dst, int val, size_t len)
+{
+    return StringSetWith(StringVectorFeatures, dst, val, len);
+}
+
+size_t StringMismatchVector(void const * src1, void const * src2, size_t len)
+{
+    return StringMismatchWith(StringVectorFeatures, src1, src2, len);
+}
+
+size_t StringLengthVector(char const * str)
+{
+    return StringLengthWith(StringVectorFeatures, str);
+}
+
+/*****************
+    Selection
+*****************/
+
+uint32_t StringDetectFeatures(void)
+{
+    uint32_t a, b, c, d, max, features = 0;
+
+    asm volatile ( "cpuid" : "=a"(max), "=b"(b), "=c"(c), "=d"(d) : "a"(0U) );
+    asm volatile ( "cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1U) );
+
+    if (0 != (d & (1U << 26)))
+        features |= StringFeatureSse2;
+
+    bool const avx = 0 != (c & (1U << 28)) && 0 != (c & (1U << 27));
+    //  AVX, and XSAVE enabled by the operating system.
+
+    if (max >= 7U)
+    {
+        asm volatile ( "cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(7U), "c"(0U) );
+
+        if (0 != (b & (1U << 9)))
+            features |= StringFeatureErms;
+        if (0 != (d & (1U << 4)))
+            features |= StringFeatureFsrm;
+
+        if (avx && 0 != (b & (1U << 5)))
+        {
+            asm volatile ( "xgetbv" : "=a"(a), "=d"(d) : "c"(0U) );
+
+            if ((a & 6U) == 6U)
+                features |= StringFeatureAvx2;
+            //  Only if the SSE and AVX states are both preserved.
+        }
+    }
+
+    return features;
+}
+
+void StringSelectVectorKernels(uint32_t features)
+{
+    StringVectorFeatures = features & (StringFeatureSse2 | StringFeatureAvx2);
+}
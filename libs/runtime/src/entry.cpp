@@ -41,6 +41,7 @@
 #include <beel/terminals/debug.hpp>
 #include <kernel_data.hpp>
 #include <execution/process_image.hpp>
+#include <beel/string.arc.h>
 
 #include <debug.hpp>
 
@@ -55,6 +56,9 @@ static DebugTerminal procDbgTrm;
 
 __extern __bland __used void _start(char * args)
 {
+    StringSelectVectorKernels(StringDetectFeatures());
+    //  Before anything else gets to copy memory around.
+
     _init();
 
     Debug::DebugTerminal = &procDbgTrm;
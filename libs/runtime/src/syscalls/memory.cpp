@@ -96,3 +96,19 @@ Handle Beelzebub::MemoryFill(uintptr_t dst, uint8_t val, size_t len)
         , reinterpret_cast<void *>((uintptr_t)val)
         , reinterpret_cast<void *>((uintptr_t)len));
 }
+
+Handle Beelzebub::MemoryShare(uintptr_t addr, size_t size, size_t process, MemoryShareOptions opts)
+{
+    if unlikely(addr % PageSize.Value != 0 || size % PageSize.Value != 0)
+        return HandleResult::AlignmentFailure;
+    //  The kernel will also perform this check.
+
+    if unlikely((addr + size) < addr || size == 0)
+        return HandleResult::ArgumentOutOfRange;
+
+    return PerformSyscall(SyscallSelection::MemoryShare
+        , reinterpret_cast<void *>(addr)
+        , reinterpret_cast<void *>((uintptr_t)size)
+        , reinterpret_cast<void *>((uintptr_t)process)
+        , reinterpret_cast<void *>((uintptr_t)(int)opts));
+}
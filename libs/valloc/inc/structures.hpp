@@ -49,6 +49,8 @@ namespace Valloc
     struct BusyChunk;
     struct ThreadData;
     struct Aligner;
+    struct Slab;
+    struct SlabObject;
 
     /***************
         Pointers
@@ -253,6 +255,12 @@ namespace Valloc
 #endif
 
         AtomicPointer<Chunk> FreeList;
+        //  Chunks freed by other threads, which the owner collects lazily.
+        bool Retired, Huge;
+        uint16_t Decay;
+        size_t PurgedFree;
+        //  Huge arenas are backed by large pages and never purged. The others
+        //  have their free pages purged after staying sparse for a while.
 
         inline explicit Arena(ThreadData * const o, size_t const s)
             : Prev( nullptr), Next(nullptr)
@@ -264,6 +272,9 @@ namespace Valloc
             , Padding0()
 #endif
             , FreeList(nullptr)
+            , Retired(false), Huge(false)
+            , Decay(0)
+            , PurgedFree(0)
         {
 
         }
@@ -321,9 +332,112 @@ namespace Valloc
     static_assert(sizeof(Chunk) < VALLOC_CACHE_LINE_SIZE, "Chunk header exceeds cache line size.");
 #endif
 
+    /************
+        Slabs
+    ************/
+
+    //  Small allocations are served from size-segregated slabs, without any
+    //  header. Slabs are aligned to their size so their header is found by
+    //  masking the address of an object. Slab objects never share the offset
+    //  within a cache line of chunk contents, which is how they are told apart.
+
+    static constexpr size_t const SlabSize = 64 * 1024;
+    static constexpr size_t const SlabClassCount = 12;
+    static constexpr size_t const SlabMaximumObjectSize = 512;
+
+    //  Size classes are multiples of half a cache line, so that objects of a
+    //  class can always be laid out at offsets which are not chunk contents.
+    static constexpr uint16_t const SlabClassSizes[SlabClassCount] {
+        32, 64, 96, 128, 160, 192, 224, 256, 320, 384, 448, 512,
+    };
+
+    //  Indexed by the size rounded up to 16 bytes, divided by 16.
+    static constexpr uint8_t const SlabSizeToClass[SlabMaximumObjectSize / 16 + 1] {
+         0,  0,  0,  1,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,
+         8,  8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 10, 11, 11, 11, 11,
+    };
+
+    static_assert(sizeof(Chunk) % 16 == 0, "Chunk header size must be a multiple of 16.");
+
+    struct SlabObject
+    {
+        SlabObject * Next;
+    };
+
+    struct Slab
+    {
+        static inline Slab * FromObject(void const * const ptr)
+        {
+            return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(ptr) & ~(SlabSize - 1));
+        }
+
+        static inline bool IsSlabObject(void const * const ptr)
+        {
+            return reinterpret_cast<uintptr_t>(ptr) % VALLOC_CACHE_LINE_SIZE != sizeof(Chunk);
+        }
+
+        Slab * Prev, * Next;
+        ThreadData * Owner;
+        SlabObject * FreeList;
+        uintptr_t Bump;
+        uint32_t Capacity, Busy;
+        uint16_t ObjectSize;
+        uint8_t Class;
+        bool Full;
+
+#ifdef VALLOC_CACHE_LINE_SIZE
+        uintptr_t Padding0[(VALLOC_CACHE_LINE_SIZE / sizeof(void *)) - 7];
+
+        //  Remote frees go on a separate cache line.
+#endif
+
+        AtomicPointer<SlabObject> RemoteFree;
+
+        inline Slab(ThreadData * const o, size_t const c)
+            : Prev( nullptr), Next(nullptr)
+            , Owner(o)
+            , FreeList(nullptr)
+            , Bump(reinterpret_cast<uintptr_t>(this) + GetFirstObjectOffset(c))
+            , Capacity((uint32_t)((SlabSize - GetFirstObjectOffset(c)) / SlabClassSizes[c]))
+            , Busy(0)
+            , ObjectSize(SlabClassSizes[c])
+            , Class((uint8_t)c)
+            , Full(false)
+#ifdef VALLOC_CACHE_LINE_SIZE
+            , Padding0()
+#endif
+            , RemoteFree(nullptr)
+        {
+
+        }
+
+        static inline constexpr size_t GetFirstObjectOffset(size_t const c)
+        {
+            return (SlabClassSizes[c] % VALLOC_CACHE_LINE_SIZE == 0)
+                ? (2 * VALLOC_CACHE_LINE_SIZE)
+                : (2 * VALLOC_CACHE_LINE_SIZE + (sizeof(Chunk) + VALLOC_CACHE_LINE_SIZE / 4) % (VALLOC_CACHE_LINE_SIZE / 2));
+            //  Classes which are a multiple of a cache line have all their
+            //  objects aligned to cache lines. The others alternate between two
+            //  offsets half a cache line apart, neither of which is the offset
+            //  of chunk contents.
+        }
+
+        inline bool IsEmpty() const { return this->Busy == 0; }
+    };
+
+    static_assert(sizeof(Slab) <= 2 * VALLOC_CACHE_LINE_SIZE, "Slab header exceeds two cache lines.");
+
     struct ThreadData
     {
         Arena * FirstArena = nullptr;
+        Arena * RetiredArenas = nullptr;
+        //  Full arenas, which are not considered for allocation until they
+        //  receive garbage.
+        size_t DenseStreak = 0;
+        //  Arenas filled up since one was last revived or found sparse.
+
+        Slab * PartialSlabs[SlabClassCount] = {};
+        Slab * FullSlabs[SlabClassCount] = {};
     };
 
     struct Aligner
@@ -49,8 +49,15 @@ using namespace Valloc;
 
 static __thread ThreadData TD;
 
-Lock GLock {}, PLock {};
-Arena * GList = nullptr;
+static size_t Footprint = 0;
+//  Bytes obtained from the platform.
+
+static constexpr size_t const HugeArenaThreshold = 2;
+//  Number of arenas a thread must fill up in a row (none of them revived or
+//  found sparse meanwhile) before its new arenas are backed by large pages.
+static constexpr uint16_t const PurgeDecay = 4;
+//  Number of garbage collections an arena must stay sparse for before its
+//  free pages are purged.
 
 /********************
     Arena Linkage
@@ -91,41 +98,47 @@ static Arena * RemoveFromMine(Arena * const arena)
         return UnlinkArena(arena);
 }
 
-static void RetireArena(Arena * arena)
+static Arena * AddToRetired(Arena * const arena)
 {
-    // Platform::ErrorMessage("Retiring arena " VF_PTR " of " VF_PTR, arena, &TD);
-
-    RemoveFromMine(arena);
-
     arena->Prev = nullptr;
+    arena->Retired = true;
 
-    GLock.Acquire();
+    if ((arena->Next = TD.RetiredArenas) != nullptr)
+        arena->Next->Prev = arena;
 
-    arena->Owner = nullptr;
+    return TD.RetiredArenas = arena;
+}
 
-    if ((arena->Next = GList) != nullptr)
-        GList->Prev = arena;
+static void RetireArena(Arena * arena)
+{
+    // Platform::ErrorMessage("Retiring arena " VF_PTR " of " VF_PTR, arena, &TD);
 
-    GList = arena;
+    RemoveFromMine(arena);
+    AddToRetired(arena);
 
-    GLock.Release();
+    ++TD.DenseStreak;
 
-    //  And such, the job is done.
+    //  It stays owned by this thread, so others can keep queuing frees on it
+    //  without any locking.
 }
 
-static Arena * PromoteArena(Arena * arena)
+static Arena * ReviveArena(Arena * arena)
 {
-    arena->Owner = &TD;
-
-    if (GList == arena)
+    if (TD.RetiredArenas == arena)
     {
-        if ((GList = arena->Next) != nullptr)
-            GList->Prev = nullptr;
-
-        return arena;
+        if ((TD.RetiredArenas = arena->Next) != nullptr)
+            TD.RetiredArenas->Prev = nullptr;
     }
     else
-        return UnlinkArena(arena);
+        UnlinkArena(arena);
+
+    arena->Prev = nullptr;
+    arena->Retired = false;
+
+    TD.DenseStreak = 0;
+    //  Arenas which fill up but get freed into again are churn, not density.
+
+    return AddToMine(arena);
 }
 
 /***************************
@@ -136,8 +149,21 @@ static Arena * AllocateArena()
 {
     void * addr = nullptr;
     size_t size = Platform::LargePageSize;
+    bool huge = false;
+
+    if (TD.DenseStreak >= HugeArenaThreshold)
+    {
+        Platform::AllocateLargeMemory(addr, size);
+
+        if (addr != nullptr)
+            huge = true;
+        else
+            size = Platform::LargePageSize;
+        //  Falls back to regular pages.
+    }
 
-    Platform::AllocateMemory(addr, size);
+    if (!huge)
+        Platform::AllocateMemory(addr, size);
 
     if (VALLOC_UNLIKELY(addr == nullptr))
         return nullptr;
@@ -148,7 +174,12 @@ static Arena * AllocateArena()
 
     // Platform::ErrorMessage("Allocated arena " VF_PTR " for " VF_PTR, addr, &TD);
 
-    return AddToMine(new (addr) Arena(&TD, size));
+    Platform::FetchAdd(&Footprint, size);
+
+    Arena * const arena = new (addr) Arena(&TD, size);
+    arena->Huge = huge;
+
+    return AddToMine(arena);
 }
 
 static bool ExtendArena(Arena * arena)
@@ -156,7 +187,20 @@ static bool ExtendArena(Arena * arena)
     void * end = const_cast<void *>(arena->GetEnd());
     size_t size = Platform::LargePageSize;
 
-    Platform::AllocateMemory(end, size);
+    if (arena->Huge)
+    {
+        Platform::AllocateLargeMemory(end, size);
+
+        if (end == nullptr)
+        {
+            end = const_cast<void *>(arena->GetEnd());
+            size = Platform::LargePageSize;
+
+            Platform::AllocateMemory(end, size);
+        }
+    }
+    else
+        Platform::AllocateMemory(end, size);
 
     if (VALLOC_UNLIKELY(end == nullptr))
         return false;
@@ -164,6 +208,8 @@ static bool ExtendArena(Arena * arena)
     arena->Size += size;
     arena->Free += size;
 
+    Platform::FetchAdd(&Footprint, size);
+
     if (arena->LastFree != nullptr && arena->LastFree->GetNext() == end)
     {
         //  Easiest case possible - just extend the last chunk.
@@ -193,9 +239,56 @@ static void DeallocateArena(Arena * const arena)
 
     // Platform::ErrorMessage("Deallocating arena " VF_PTR " of " VF_PTR, arena, &TD);
 
+    Platform::FetchAdd(&Footprint, -arena->Size);
+
     Platform::FreeMemory(arena, arena->Size);
 }
 
+static size_t PurgeArena(Arena * const arena)
+{
+    size_t purged = 0;
+
+    for (FreeChunk * c = arena->LastFree; c != nullptr; c = c->PrevFree)
+    {
+        uintptr_t const start = RoundUp(reinterpret_cast<uintptr_t>(c) + sizeof(FreeChunk), Platform::PageSize);
+        uintptr_t const end = reinterpret_cast<uintptr_t>(c->GetNext()) & ~(Platform::PageSize - 1);
+        //  The header of the free chunk must stay intact.
+
+        if (end > start)
+        {
+            Platform::PurgeMemory(reinterpret_cast<void *>(start), end - start);
+
+            purged += end - start;
+        }
+    }
+
+    return purged;
+}
+
+static void DecayArena(Arena * const arena)
+{
+    if (arena->Free >= arena->Size / 4)
+        TD.DenseStreak = 0;
+    //  A sparse arena means the heap is not dense, whether it gets purged or not.
+
+    if (arena->Huge || arena->Free < arena->Size / 4 || arena->Free == arena->PurgedFree)
+    {
+        arena->Decay = 0;
+
+        return;
+    }
+    //  Dense arenas are left alone, and so are arenas which did not change
+    //  since their last purge.
+
+    if (++arena->Decay < PurgeDecay)
+        return;
+
+    PurgeArena(arena);
+
+    arena->Decay = 0;
+    arena->PurgedFree = arena->Free;
+}
+
 /********************
     Chunk Freeing
 ********************/
@@ -403,21 +496,292 @@ static CollectionResult CollectGarbage(Arena * arena, size_t const target)
     return CollectGarbage(arena, target, sink);
 }
 
+/************
+    Slabs
+************/
+
+static Slab * LinkSlab(Slab * & list, Slab * const slab)
+{
+    slab->Prev = nullptr;
+
+    if ((slab->Next = list) != nullptr)
+        slab->Next->Prev = slab;
+
+    return list = slab;
+}
+
+static Slab * UnlinkSlab(Slab * & list, Slab * const slab)
+{
+    if (slab->Prev != nullptr)
+        slab->Prev->Next = slab->Next;
+    else
+        list = slab->Next;
+
+    if (slab->Next != nullptr)
+        slab->Next->Prev = slab->Prev;
+
+    return slab;
+}
+
+static Slab * AllocateSlab(size_t const c)
+{
+    void * addr = nullptr;
+    size_t size = SlabSize;
+
+    Platform::AllocateMemory(addr, size, SlabSize);
+
+    if (VALLOC_UNLIKELY(addr == nullptr))
+        return nullptr;
+
+    if (VALLOC_UNLIKELY(size < SlabSize))
+    {
+        Platform::FreeMemory(addr, size);
+
+        return nullptr;
+    }
+
+    VALLOC_ASSERT_MSG(reinterpret_cast<uintptr_t>(addr) % SlabSize == 0
+        , "Misaligned slab..? " VF_PTR, addr);
+
+    Platform::FetchAdd(&Footprint, SlabSize);
+
+    return LinkSlab(TD.PartialSlabs[c], new (addr) Slab(&TD, c));
+}
+
+static void DeallocateSlab(Slab * const slab)
+{
+    UnlinkSlab(slab->Full ? TD.FullSlabs[slab->Class] : TD.PartialSlabs[slab->Class], slab);
+
+    Platform::FetchAdd(&Footprint, -SlabSize);
+
+    Platform::FreeMemory(slab, SlabSize);
+}
+
+static size_t CollectSlabGarbage(Slab * const slab)
+{
+    if (slab->RemoteFree.Pointer == nullptr)
+        return 0;
+
+    SlabObject * const first = slab->RemoteFree.Swap(nullptr), * last = first;
+    size_t count = 1;
+
+    while (last->Next != nullptr)
+        last = last->Next, ++count;
+
+    last->Next = slab->FreeList;
+    slab->FreeList = first;
+    slab->Busy -= (uint32_t)count;
+    //  Objects freed by other threads are busy until they are collected.
+
+    return count;
+}
+
+static bool HasLocalFree(Slab const * const slab)
+{
+    return slab->FreeList != nullptr
+        || slab->Bump + slab->ObjectSize <= reinterpret_cast<uintptr_t>(slab) + SlabSize;
+}
+
+/**************
+    Orphans
+**************/
+
+static AtomicPointer<Arena> OrphanArenas {nullptr};
+static AtomicPointer<Slab> OrphanSlabs {nullptr};
+//  Arenas and slabs left behind by threads which exited, chained through their
+//  `Next` field. Their owner is null, so every free in them is queued. Any
+//  thread may adopt them, by detaching a whole chain with a single swap.
+
+template<typename T>
+static void AbandonChain(AtomicPointer<T> & orphans, T * const first)
+{
+    if (first == nullptr)
+        return;
+
+    T * last = first;
+
+    for (;;)
+    {
+        last->Owner = nullptr;
+
+        if (last->Next == nullptr)
+            break;
+
+        last = last->Next;
+    }
+
+    T * top = orphans.Pointer;
+
+    do last->Next = top; while (!orphans.CAS(top, first));
+}
+
+static bool AdoptArenas()
+{
+    if (VALLOC_LIKELY(OrphanArenas.Pointer == nullptr))
+        return false;
+
+    Arena * arena = OrphanArenas.Swap(nullptr), * next;
+
+    if (VALLOC_UNLIKELY(arena == nullptr))
+        return false;
+    //  Another thread got to them first.
+
+    do
+    {
+        next = arena->Next;
+
+        arena->Owner = &TD;
+        arena->Prev = nullptr;
+
+        if (arena->Retired)
+            AddToRetired(arena);
+        else
+            AddToMine(arena);
+    } while ((arena = next) != nullptr);
+
+    return true;
+}
+
+static bool AdoptSlabs()
+{
+    if (VALLOC_LIKELY(OrphanSlabs.Pointer == nullptr))
+        return false;
+
+    Slab * slab = OrphanSlabs.Swap(nullptr), * next;
+
+    if (VALLOC_UNLIKELY(slab == nullptr))
+        return false;
+
+    do
+    {
+        next = slab->Next;
+
+        slab->Owner = &TD;
+
+        CollectSlabGarbage(slab);
+        //  Objects freed since the previous owner left are taken back now.
+
+        if ((slab->Full = !HasLocalFree(slab)))
+            LinkSlab(TD.FullSlabs[slab->Class], slab);
+        else
+            LinkSlab(TD.PartialSlabs[slab->Class], slab);
+    } while ((slab = next) != nullptr);
+
+    return true;
+}
+
+/********************
+    Small Objects
+********************/
+
+static void * AllocateSmall(size_t const c)
+{
+    Slab * slab;
+
+    if (VALLOC_UNLIKELY((slab = TD.PartialSlabs[c]) == nullptr))
+    {
+        //  Before getting a new slab, see if other threads gave back objects
+        //  from the full ones.
+
+        for (slab = TD.FullSlabs[c]; slab != nullptr; slab = slab->Next)
+            if (CollectSlabGarbage(slab) > 0)
+            {
+                UnlinkSlab(TD.FullSlabs[c], slab);
+                LinkSlab(TD.PartialSlabs[c], slab);
+
+                slab->Full = false;
+
+                break;
+            }
+
+        if (slab == nullptr && AdoptSlabs())
+            slab = TD.PartialSlabs[c];
+        //  Slabs left behind by exited threads are taken over before new ones
+        //  are made.
+
+        if (slab == nullptr && (slab = AllocateSlab(c)) == nullptr)
+            return nullptr;
+    }
+
+    SlabObject * obj;
+
+    if ((obj = slab->FreeList) != nullptr)
+        slab->FreeList = obj->Next;
+    else
+    {
+        obj = reinterpret_cast<SlabObject *>(slab->Bump);
+        slab->Bump += slab->ObjectSize;
+        //  Untouched objects are carved lazily, so the pages behind them are
+        //  not touched either.
+    }
+
+    ++slab->Busy;
+
+    if (VALLOC_UNLIKELY(!HasLocalFree(slab)) && CollectSlabGarbage(slab) == 0)
+    {
+        UnlinkSlab(TD.PartialSlabs[c], slab);
+        LinkSlab(TD.FullSlabs[c], slab);
+
+        slab->Full = true;
+    }
+
+    return obj;
+}
+
+static void DeallocateSmall(void * const ptr)
+{
+    Slab * const slab = Slab::FromObject(ptr);
+    SlabObject * const obj = reinterpret_cast<SlabObject *>(ptr);
+
+    VALLOC_ASSERT_MSG((reinterpret_cast<uintptr_t>(ptr) & (SlabSize - 1)) >= Slab::GetFirstObjectOffset(slab->Class)
+        , "Pointer " VF_PTR " overlaps the header of slab " VF_PTR, ptr, slab);
+
+    if (VALLOC_LIKELY(slab->Owner == &TD))
+    {
+        obj->Next = slab->FreeList;
+        slab->FreeList = obj;
+
+        if (VALLOC_UNLIKELY(slab->Full))
+        {
+            UnlinkSlab(TD.FullSlabs[slab->Class], slab);
+            LinkSlab(TD.PartialSlabs[slab->Class], slab);
+
+            slab->Full = false;
+        }
+
+        if (VALLOC_UNLIKELY(--slab->Busy == 0)
+            && (slab->Prev != nullptr || slab->Next != nullptr))
+            DeallocateSlab(slab);
+        //  An empty slab is given back unless it's the only one of its class
+        //  with free objects. Nobody else can be freeing objects in it.
+    }
+    else
+    {
+        SlabObject * top = slab->RemoteFree.Pointer;
+
+        do obj->Next = top; while (!slab->RemoteFree.CAS(top, obj));
+    }
+}
+
 /*****************************
     Valloc::AllocateMemory    >-------------------------------------------------
 *****************************/
 
 void * Valloc::AllocateMemory(size_t size)
 {
+    if (VALLOC_LIKELY(size <= SlabMaximumObjectSize))
+        return AllocateSmall(SlabSizeToClass[(size + 15) >> 4]);
+
     size_t const roundSize = RoundUp(size + sizeof(Chunk), Platform::CacheLineSize);
 
     Arena * arena;
 
     if (VALLOC_UNLIKELY((arena = TD.FirstArena) == nullptr))
-        goto with_new_arena;
+        goto out_of_arenas;
 
     do
     {
+    try_arena:
         VALLOC_ASSERT_MSG(reinterpret_cast<uintptr_t>(arena) % Platform::PageSize == 0
             , "Misaligned arena..? " VF_PTR, arena);
 
@@ -503,7 +867,22 @@ void * Valloc::AllocateMemory(size_t size)
         //  Still won't fit. Maybe this needs retiring? TODO: Some heuristic?
     } while ((arena = arena->Next) != nullptr);
 
-with_new_arena:
+out_of_arenas:
+    if (AdoptArenas() && (arena = TD.FirstArena) != nullptr)
+        goto try_arena;
+    //  Arenas left behind by exited threads are given a go too. Retired ones
+    //  among them are checked below.
+
+    for (arena = TD.RetiredArenas; arena != nullptr; arena = arena->Next)
+        if (!arena->FreeListEmpty())
+        {
+            ReviveArena(arena);
+
+            goto try_arena;
+        }
+    //  Retired arenas which received garbage are given another chance before
+    //  a new arena is allocated.
+
     arena = AllocateArena();
 
     if (VALLOC_UNLIKELY(arena == nullptr))
@@ -533,6 +912,9 @@ with_new_arena:
 
 void Valloc::DeallocateMemory(void * ptr, bool crash)
 {
+    if (Slab::IsSlabObject(ptr))
+        return DeallocateSmall(ptr);
+
     Chunk * const c = Chunk::FromContents(ptr);
 
     VALLOC_ASSERT_MSG(reinterpret_cast<uintptr_t>(ptr) % Platform::CacheLineSize == sizeof(Chunk)
@@ -560,16 +942,16 @@ void Valloc::DeallocateMemory(void * ptr, bool crash)
         , "Arena " VF_PTR " is destroyed before freeing chunk " VF_PTR
         , arena, c);
 
-    ThreadData * owner = arena->Owner;
-
-    if (VALLOC_LIKELY(owner == &TD))
+    if (VALLOC_LIKELY(arena->Owner == &TD))
     {
         // Platform::ErrorMessage("Freeing " VF_PTR " from arena " VF_PTR " BY " VF_PTR
         //     , c, arena, owner);
 
-    free_my_own:
         //  Easiest case, freeing a chunk in an arena owned by this thread.
 
+        if (VALLOC_UNLIKELY(arena->Retired))
+            ReviveArena(arena);
+
         FreeThisChunk(arena, c, arena->GetEnd());
 
         // arena->Dump(Platform::ErrorMessage);
@@ -586,50 +968,19 @@ void Valloc::DeallocateMemory(void * ptr, bool crash)
         // Platform::ErrorMessage("Freeing " VF_PTR " from arena " VF_PTR " of " VF_PTR " BY " VF_PTR
         //     , c, arena, owner, &TD);
 
-        bool locked = false;
-
-    retry:
-
-        if (VALLOC_LIKELY(owner != nullptr))
-        {
-            if (VALLOC_UNLIKELY(locked))
-                GLock.Release();
-
-            c->Flags = ChunkFlags::Queued;
+        //  Another thread owns the arena, so the chunk is pushed on its
+        //  remote-free stack. The owner detaches the whole stack at once when
+        //  collecting, so there is no ABA hazard here.
 
-            Chunk * top = arena->FreeList.Pointer;
+        c->Flags = ChunkFlags::Queued;
 
-            do c->NextInList = top; while (!arena->FreeList.CAS(top, c));
+        Chunk * top = arena->FreeList.Pointer;
 
-            VALLOC_ASSERT_MSG(arena->Size > 0
-                , "Arena " VF_PTR " was destroyed after queuing chunk " VF_PTR
-                , arena, c);
-        }
-        else
-        {
-            if (VALLOC_LIKELY(locked))
-            {
-                PromoteArena(arena);
-
-                GLock.Release();
-
-                AddToMine(arena);
-                arena->Prev = nullptr;
+        do c->NextInList = top; while (!arena->FreeList.CAS(top, c));
 
-                // CollectGarbage(arena, 0);
-
-                goto free_my_own;
-            }
-            else
-            {
-                GLock.Acquire();
-                locked = true;
-
-                owner = arena->Owner;
-
-                goto retry;
-            }
-        }
+        VALLOC_ASSERT_MSG(arena->Size > 0
+            , "Arena " VF_PTR " was destroyed after queuing chunk " VF_PTR
+            , arena, c);
     }
 }
 
@@ -648,6 +999,27 @@ void * Valloc::AllocateAlignedMemory(size_t size, size_t mul, size_t off)
 
 void * Valloc::ResizeAllocation(void * ptr, size_t size, bool crash)
 {
+    if (Slab::IsSlabObject(ptr))
+    {
+        size_t const objectSize = Slab::FromObject(ptr)->ObjectSize;
+
+        if (size <= SlabMaximumObjectSize
+            && SlabClassSizes[SlabSizeToClass[(size + 15) >> 4]] == objectSize)
+            return ptr;
+        //  Same size class.
+
+        void * const other = Valloc::AllocateMemory(size);
+
+        if (VALLOC_UNLIKELY(other == nullptr))
+            return nullptr;
+
+        memcpy(other, ptr, Minimum(size, objectSize));
+
+        DeallocateSmall(ptr);
+
+        return other;
+    }
+
     Chunk * const c = Chunk::FromContents(ptr);
 
     VALLOC_ASSERT_MSG(reinterpret_cast<uintptr_t>(ptr) % Platform::CacheLineSize == sizeof(Chunk)
@@ -672,13 +1044,14 @@ void * Valloc::ResizeAllocation(void * ptr, size_t size, bool crash)
     }
 
     Arena * const arena = c->Owner;
-    ThreadData * owner = arena->Owner;
 
-    if (VALLOC_LIKELY(owner == &TD))
+    if (VALLOC_LIKELY(arena->Owner == &TD))
     {
-    resize_my_own:
         //  Hardest case, resizing a chunk in an arena owned by this thread.
 
+        if (VALLOC_UNLIKELY(arena->Retired))
+            ReviveArena(arena);
+
         Chunk * next = c->GetNext();
         void const * const arenaEnd = arena->GetEnd();
 
@@ -775,90 +1148,74 @@ void * Valloc::ResizeAllocation(void * ptr, size_t size, bool crash)
     }
     else
     {
-        bool locked = false;
+        //  It's owned by another thread, so the chunk must simply be queued for
+        //  freeing.
 
-    retry:
-        //  It's important to note, that after the lock is acquired, the possible
-        //  new owner cannot be this thread.
+        void * const other = Valloc::AllocateMemory(size);
+        //  Allocate a new one locally.
 
-        if (VALLOC_LIKELY(owner != nullptr))
-        {
-            //  It's owned by another thread, so the chunk must simply be queued for
-            //  freeing.
+        if (VALLOC_UNLIKELY(other == nullptr))
+            return nullptr;
 
-            if (VALLOC_UNLIKELY(locked))
-                GLock.Release();
-            //  If the lock is taken, and this arena was taken by another thread,
-            //  the lock is released and queuing proceeds normally.
+        memcpy(other, ptr, Minimum(size, c->Size - sizeof(Chunk)));
+        //  Transfer the needed data.
 
-            void * const other = Valloc::AllocateMemory(size);
-            //  Allocate a new one locally.
+        c->Flags = ChunkFlags::Queued;
 
-            if (VALLOC_UNLIKELY(other == nullptr))
-                return nullptr;
+        Chunk * top = arena->FreeList.Pointer;
 
-            memcpy(other, ptr, Minimum(size, c->Size - sizeof(Chunk)));
-            //  Transfer the needed data.
+        do c->NextInList = top; while (!arena->FreeList.CAS(top, c));
 
-            c->Flags = ChunkFlags::Queued;
+        //  Queue up the old one for deleteion.
 
-            Chunk * top = arena->FreeList.Pointer;
+        return other;
+    }
+}
 
-            do c->NextInList = top; while (!arena->FreeList.CAS(top, c));
+/*******************************
+    Valloc::CollectMyGarbage    >-----------------------------------------------
+*******************************/
 
-            //  Queue up the old one for deleteion.
+static void CollectLocalGarbage()
+{
+    for (size_t c = 0; c < SlabClassCount; ++c)
+    {
+        Slab * slab, * nextSlab;
 
-            return other;
-        }
-        else
+        for (slab = TD.FullSlabs[c]; slab != nullptr; slab = nextSlab)
         {
-            //  It's global, it needs synchronization. It might even change owner in
-            //  the meantime.
+            nextSlab = slab->Next;
 
-            if (VALLOC_LIKELY(locked))
+            if (CollectSlabGarbage(slab) > 0)
             {
-                //  It has already been locked and has no owner.
+                UnlinkSlab(TD.FullSlabs[c], slab);
+                LinkSlab(TD.PartialSlabs[c], slab);
 
-                PromoteArena(arena);
-
-                GLock.Release();
-
-                //  Now the arena is not in the global list anymore, and is owned
-                //  by the current thread.
-
-                AddToMine(arena);
-                arena->Prev = nullptr;
-                //  Now it's in this thread's list, officially.
-
-                // CollectGarbage(arena, 0);
-                //  Collect all the garbage that sneaked in.
-
-                goto resize_my_own;
+                slab->Full = false;
             }
-            else
-            {
-                //  Not locked: The lock needs to be acquired first.
+        }
 
-                GLock.Acquire();
-                locked = true;
+        for (slab = TD.PartialSlabs[c]; slab != nullptr; slab = nextSlab)
+        {
+            nextSlab = slab->Next;
 
-                owner = arena->Owner;
-                //  Get the new owner, which cannot change now.
+            CollectSlabGarbage(slab);
 
-                goto retry;
-            }
+            if (slab->IsEmpty())
+                DeallocateSlab(slab);
         }
     }
-}
-
-/*******************************
-    Valloc::CollectMyGarbage    >-----------------------------------------------
-*******************************/
 
-void Valloc::CollectMyGarbage()
-{
     Arena * arena, * next;
 
+    for (arena = TD.RetiredArenas; arena != nullptr; arena = next)
+    {
+        next = arena->Next;
+
+        if (!arena->FreeListEmpty())
+            ReviveArena(arena);
+    }
+
     if (VALLOC_UNLIKELY((arena = TD.FirstArena) == nullptr))
         return;
 
@@ -886,9 +1243,44 @@ void Valloc::CollectMyGarbage()
 
         if (arena->IsEmpty())
             DeallocateArena(arena);
+        else
+            DecayArena(arena);
     } while ((arena = next) != nullptr);
 }
 
+void Valloc::CollectMyGarbage()
+{
+    AdoptSlabs();
+    AdoptArenas();
+    //  Orphans are drained along with this thread's own memory.
+
+    CollectLocalGarbage();
+}
+
+/*******************************
+    Valloc::AbandonMyMemory    >------------------------------------------------
+*******************************/
+
+void Valloc::AbandonMyMemory()
+{
+    CollectLocalGarbage();
+    //  Whatever is empty goes back to the platform right away.
+
+    for (size_t c = 0; c < SlabClassCount; ++c)
+    {
+        AbandonChain(OrphanSlabs, TD.PartialSlabs[c]);
+        AbandonChain(OrphanSlabs, TD.FullSlabs[c]);
+
+        TD.PartialSlabs[c] = TD.FullSlabs[c] = nullptr;
+    }
+
+    AbandonChain(OrphanArenas, TD.FirstArena);
+    AbandonChain(OrphanArenas, TD.RetiredArenas);
+
+    TD.FirstArena = TD.RetiredArenas = nullptr;
+    TD.DenseStreak = 0;
+}
+
 /**************************
     Valloc::DumpMyState    >----------------------------------------------------
 **************************/
@@ -913,3 +1305,12 @@ void Valloc::DumpMyState()
         next = arena->Next;
     } while ((arena = next) != nullptr);
 }
+
+/***************************
+    Valloc::GetFootprint    >---------------------------------------------------
+***************************/
+
+size_t Valloc::GetFootprint()
+{
+    return Footprint;
+}
@@ -60,6 +60,8 @@
     ENUMINST(MemoryCopy    , SYSCALL_MEMORY_COPY    , 0x012, "Memory Copy"    ) \
     /*  Fills a chunk of memory with a specific byte value. */ \
     ENUMINST(MemoryFill    , SYSCALL_MEMORY_COPY    , 0x013, "Memory Fill"    ) \
+    /*  Maps a chunk of memory into another process, shared or copy-on-write. */ \
+    ENUMINST(MemoryShare   , SYSCALL_MEMORY_SHARE   , 0x014, "Memory Share"   ) \
     /*  Not an actual syscall; just the number of syscalls. */ \
     ENUMINST(COUNT         , SYSCALL_COUNT          , 0x020, "Syscall Count"  )
 
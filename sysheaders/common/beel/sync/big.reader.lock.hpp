@@ -0,0 +1,333 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#ifdef __BEELZEBUB_KERNEL
+
+#include <beel/sync/atomic.hpp>
+
+namespace Beelzebub { namespace Synchronization
+{
+    static constexpr size_t const BigReaderLockSlotCount = 16;
+    //  Cores past this many share slots with others. That is still correct,
+    //  but their readers contend again.
+
+    /**
+     *  The reader counter of a group of cores, alone on its cache line.
+     */
+    struct BigReaderLockSlot
+    {
+        uint32_t Value;
+        uint8_t Padding[60];
+    };
+
+    static_assert(sizeof(BigReaderLockSlot) == 64, "");
+
+    /**
+     *  Reader-writer lock whose readers only touch the slot of their own core,
+     *  while the writer claims all the slots in turn.
+     *  Reading is cheap and scales; writing is expensive.
+     */
+    struct BigReaderLock
+    {
+        /*  Constants  */
+
+        static constexpr uint32_t const WriterBit = 1U << 31;
+
+        /*  Statics  */
+
+        /**
+         *  <summary>Gets the slot used by the readers of the current core.</summary>
+         */
+        static __hot size_t GetSlot();
+
+        /*  Constructor(s)  */
+
+        BigReaderLock() = default;
+
+        BigReaderLock(BigReaderLock const &) = delete;
+        BigReaderLock & operator =(BigReaderLock const &) = delete;
+        BigReaderLock(BigReaderLock &&) = delete;
+        BigReaderLock & operator =(BigReaderLock &&) = delete;
+
+#ifdef __BEELZEBUB_SETTINGS_SMP
+
+        /*  Acquisition Operations  */
+
+        /**
+         *  <summary>Attempts to acquire the lock as a reader.</summary>
+         *  <param name="slot">Receives the slot to give back upon release.</param>
+         *  <return>True if the acquisition succeeded; false otherwise.</return>
+         */
+        inline __must_check bool TryAcquireAsReader(size_t & slot) volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            slot = GetSlot();
+
+            uint32_t volatile * const val = &(this->Slots[slot].Value);
+
+            if (0 != (__atomic_fetch_add(val, 1, __ATOMIC_ACQUIRE) & WriterBit))
+            {
+                __atomic_fetch_sub(val, 1, __ATOMIC_RELAXED);
+                //  The writer owns this slot.
+
+                return false;
+            }
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+
+            return true;
+        }
+
+        /**
+         *  <summary>Acquires the lock as a reader.</summary>
+         *  <return>The slot to give back upon release.</return>
+         *  <remarks>
+         *  The thread may move to another core before releasing the lock, so
+         *  the slot is handed back explicitly.
+         *  </remarks>
+         */
+        inline __must_check size_t AcquireAsReader() volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            size_t const slot = GetSlot();
+
+            uint32_t volatile * const val = &(this->Slots[slot].Value);
+
+            while (0 != (__atomic_fetch_add(val, 1, __ATOMIC_ACQUIRE) & WriterBit))
+            {
+                __atomic_fetch_sub(val, 1, __ATOMIC_RELAXED);
+                //  Step back, so the writer isn't held up.
+
+                do DO_NOTHING(); while (0 != (*val & WriterBit));
+            }
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+
+            return slot;
+        }
+
+        /**
+         *  <summary>Attempts to acquire the lock as the writer.</summary>
+         *  <return>True if the acquisition succeeded; false otherwise.</return>
+         */
+        inline __must_check bool TryAcquireAsWriter() volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            for (size_t i = 0; i < BigReaderLockSlotCount; ++i)
+            {
+                uint32_t cmp = 0;
+
+                if (!__atomic_compare_exchange_n(&(this->Slots[i].Value), &cmp, WriterBit
+                    , false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                {
+                    while (i-- > 0)
+                        __atomic_fetch_sub(&(this->Slots[i].Value), WriterBit, __ATOMIC_RELEASE);
+                    //  Give back the slots claimed so far.
+
+                    return false;
+                }
+            }
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+
+            return true;
+        }
+
+        /**
+         *  <summary>Acquires the lock as the writer.</summary>
+         */
+        inline void AcquireAsWriter() volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            for (size_t i = 0; i < BigReaderLockSlotCount; ++i)
+            {
+                uint32_t cmp = 0;
+
+                while (!__atomic_compare_exchange_n(&(this->Slots[i].Value), &cmp, WriterBit
+                    , false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                {
+                    do DO_NOTHING(); while (this->Slots[i].Value != 0);
+
+                    cmp = 0;
+                }
+                //  A slot is claimed once its readers are gone. Claiming the
+                //  slots in the same order keeps writers from deadlocking each
+                //  other: the first slot lets only one through.
+            }
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+        }
+
+        /*  Release Operations  */
+
+        /**
+         *  <summary>Releases the lock as a reader.</summary>
+         *  <param name="slot">The slot obtained upon acquisition.</param>
+         */
+        inline void ReleaseAsReader(size_t const slot) volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            __atomic_fetch_sub(&(this->Slots[slot].Value), 1, __ATOMIC_RELEASE);
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_REL;
+        }
+
+        /**
+         *  <summary>Releases the lock as the writer.</summary>
+         */
+        inline void ReleaseAsWriter() volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            for (size_t i = BigReaderLockSlotCount; i > 0; --i)
+                __atomic_fetch_sub(&(this->Slots[i - 1].Value), WriterBit, __ATOMIC_RELEASE);
+            //  Not a plain store, because readers which are stepping back may
+            //  still have their increments in there.
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_REL;
+        }
+
+        /**
+         *  <summary>Resets the lock.</summary>
+         */
+        inline void Reset() volatile
+        {
+            for (size_t i = 0; i < BigReaderLockSlotCount; ++i)
+                this->Slots[i].Value = 0;
+        }
+
+        /*  Properties  */
+
+        /**
+         *  <summary>Determines whether there is an active writer or an awaiting writer.</summary>
+         *  <return>True if there is an active/awaiting writer; otherwise false.</return>
+         */
+        __forceinline __must_check bool HasWriter() const volatile
+        {
+            return 0 != (this->Slots[0].Value & WriterBit);
+            //  Every writer starts with the first slot.
+        }
+
+        /**
+         *  <summary>Gets the number of active readers.</summary>
+         *  <return>The number of active readers.</return>
+         *  <remarks>Readers which are stepping back for a writer are counted as well.</remarks>
+         */
+        inline __must_check size_t GetReaderCount() const volatile
+        {
+            size_t res = 0;
+
+            for (size_t i = 0; i < BigReaderLockSlotCount; ++i)
+                res += this->Slots[i].Value & ~WriterBit;
+
+            return res;
+        }
+
+    private:
+        /*  Fields  */
+
+        BigReaderLockSlot Slots[BigReaderLockSlotCount];
+#else
+
+        /*  Acquisition Operations  */
+
+        __forceinline __must_check bool TryAcquireAsReader(size_t & slot) volatile
+        { slot = 0; ++this->ReaderCount; return true; }
+
+        __forceinline __must_check size_t AcquireAsReader() volatile
+        { ++this->ReaderCount; return 0; }
+
+        __forceinline __must_check bool TryAcquireAsWriter() volatile
+        { return true; }
+
+        __forceinline void AcquireAsWriter() volatile { }
+
+        /*  Release Operations  */
+
+        __forceinline void ReleaseAsReader(size_t const slot) volatile
+        { (void)slot; --this->ReaderCount; }
+
+        __forceinline void ReleaseAsWriter() volatile { }
+
+        __forceinline void Reset() volatile
+        { this->ReaderCount = 0; }
+
+        /*  Properties  */
+
+        __forceinline __must_check bool HasWriter() const volatile
+        { return false; }
+
+        __forceinline __must_check size_t GetReaderCount() const volatile
+        { return this->ReaderCount; }
+
+        /*  Fields  */
+
+    private:
+
+        size_t ReaderCount;
+#endif
+    };
+}}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#ifdef __BEELZEBUB_KERNEL
+
+#include <beel/sync/mutex.hpp>
+
+namespace Beelzebub { namespace Synchronization
+{
+    /**
+     *  Lets threads sleep until signalled, releasing a mutex meanwhile.
+     */
+    class ConditionVariable
+    {
+    public:
+        /*  Constructor(s)  */
+
+        inline ConditionVariable() : Sequence(0), Waiters() { }
+
+        ConditionVariable(ConditionVariable const &) = delete;
+        ConditionVariable & operator =(ConditionVariable const &) = delete;
+        ConditionVariable(ConditionVariable &&) = delete;
+        ConditionVariable & operator =(ConditionVariable &&) = delete;
+
+        /*  Operations  */
+
+        /**
+         *  Releases the mutex and sleeps until signalled or until the timeout
+         *  expires, then re-acquires the mutex. Spurious wakeups are possible.
+         */
+        Handle Wait(Mutex & mutex, TimeSpanLite timeout = WaitQueue::Forever);
+
+        inline void Signal()
+        {
+            ++this->Sequence;
+            this->Waiters.WakeOne();
+        }
+
+        inline void Broadcast()
+        {
+            ++this->Sequence;
+            this->Waiters.WakeAll();
+        }
+
+    private:
+        /*  Fields  */
+
+        Atomic<uint32_t> Sequence;
+        //  Changes on every signal, so none is lost between releasing the mutex
+        //  and going to sleep.
+        WaitQueue Waiters;
+    };
+}}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#include <beel/metaprogramming.h>
+
+#if defined(__BEELZEBUB_KERNEL) && defined(__BEELZEBUB__CONF_LOCKSTAT)
+
+#include <beel/handles.h>
+
+namespace Beelzebub
+{
+    namespace Terminals
+    {
+        class TerminalBase;
+    }
+
+    namespace Synchronization
+    {
+        static constexpr size_t const LockStatSiteCount = 256;
+        //  Distinct acquisition sites tracked per core.
+        static constexpr size_t const LockStatHeldDepth = 16;
+        //  Locks held at once per core whose hold time can be measured.
+        static constexpr size_t const LockStatHistogramBuckets = 16;
+        //  Hold times are bucketed by powers of two; the first bucket takes
+        //  everything under 128 cycles.
+        static constexpr uint64_t const LockStatContentionThreshold = 256;
+        //  Acquisitions which waited longer than this many cycles were contended.
+
+        /**
+         *  <summary>Statistics of one lock acquisition site.</summary>
+         */
+        struct LockSiteStatistics
+        {
+            void const * Site;
+
+            uint64_t Acquisitions;
+            uint64_t Contentions;
+            uint64_t SpinCycles;
+            uint64_t MaximumWait;
+            uint64_t HoldCycles;
+
+            uint32_t HoldHistogram[LockStatHistogramBuckets];
+        };
+
+        /**
+         *  <summary>
+         *  Measures how often and how long each lock acquisition site waits,
+         *  and how long it holds the lock, in per-core buckets.
+         *  </summary>
+         */
+        class LockStat
+        {
+        protected:
+            /*  Constructor(s)  */
+
+            LockStat() = default;
+
+        public:
+            LockStat(LockStat const &) = delete;
+            LockStat & operator =(LockStat const &) = delete;
+
+            /*  Initialization  */
+
+            static __startup Handle Initialize(size_t const coreCount);
+            static bool ArmPeriodicDump();
+
+            /*  Recording  */
+
+            static __hot uint64_t Begin();
+            static __hot void Acquired(void const volatile * lock, void const * site, uint64_t const start);
+            static __hot void Released(void const volatile * lock);
+
+            /*  Reporting  */
+
+            static void Dump(Terminals::TerminalBase * term);
+            static void DumpIfDue(Terminals::TerminalBase * term);
+            //  Performs the periodic dump, if its time came. Meant for the idle
+            //  loop, as the timer cannot take the locks which dumping needs.
+            static void Reset();
+        };
+    }
+}
+
+    #define LOCKSTAT_BEGIN \
+        uint64_t const _lockstat_start = Beelzebub::Synchronization::LockStat::Begin()
+    #define LOCKSTAT_ACQUIRED \
+        Beelzebub::Synchronization::LockStat::Acquired(this, &&op_start, _lockstat_start)
+    #define LOCKSTAT_RELEASED \
+        Beelzebub::Synchronization::LockStat::Released(this)
+    //  The address of the operation's label tells apart the sites into which it
+    //  is inlined.
+#else
+    #define LOCKSTAT_BEGIN      do { } while (false)
+    #define LOCKSTAT_ACQUIRED   do { } while (false)
+    #define LOCKSTAT_RELEASED   do { } while (false)
+#endif
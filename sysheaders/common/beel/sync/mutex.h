@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#ifndef _BEEL_SYNC_MUTEX_H
+#define _BEEL_SYNC_MUTEX_H
+
+#include <beel/sync/ticket.lock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __BEELZEBUB_KERNEL
+    /**
+     *  C view of `Beelzebub::Synchronization::Mutex`; the layouts must match.
+     */
+    typedef struct mutex_t
+    {
+        uint32_t State;
+
+        struct
+        {
+            TicketLock Lock;
+            void * First, * Last;
+        } Waiters;
+    } Mutex;
+
+    #define MUTEX_INITIALIZER {0, {{0}, NULL, NULL}}
+
+    /**
+     *  Acquire the mutex, sleeping if necessary.
+     */
+    __solid void MutexAcquire(Mutex * const mutex);
+
+    /**
+     *  Acquire the mutex, if possible.
+     */
+    __solid __must_check bool MutexTryAcquire(Mutex * const mutex);
+
+    /**
+     *  Release the mutex, waking up a waiter if there is any.
+     */
+    __solid void MutexRelease(Mutex * const mutex);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#ifdef __BEELZEBUB_KERNEL
+
+#include <beel/sync/wait.queue.hpp>
+#include <beel/sync/atomic.hpp>
+
+namespace Beelzebub { namespace Synchronization
+{
+    /**
+     *  Mutual exclusion lock which puts contending threads to sleep.
+     *  When blocking is impossible (interrupt handlers, interrupts disabled,
+     *  before the scheduler is engaged), it spins instead.
+     */
+    class Mutex
+    {
+    public:
+        typedef void Cookie;
+
+        static constexpr size_t const SpinCount = 128;
+        //  Attempts made before sleeping, in case the owner is about to release it.
+
+        /*  Constructor(s)  */
+
+        inline Mutex() : State(0), Waiters() { }
+
+        Mutex(Mutex const &) = delete;
+        Mutex & operator =(Mutex const &) = delete;
+        Mutex(Mutex &&) = delete;
+        Mutex & operator =(Mutex &&) = delete;
+
+        /*  Operations  */
+
+        __forceinline __must_check bool TryAcquire()
+        {
+            uint32_t expected = 0;
+
+            return this->State.CmpXchgStrong(expected, 1);
+        }
+
+        __forceinline void Acquire()
+        {
+            if unlikely(!this->TryAcquire())
+                this->AcquireSlow();
+        }
+
+        __forceinline void Release()
+        {
+            if unlikely(this->State.Xchg(0U) == 2)
+                this->Waiters.WakeOne();
+            //  Only contended mutexes touch the wait queue.
+        }
+
+        /*  Properties  */
+
+        inline bool Check() const volatile { return this->State.Load() == 0; }
+
+    private:
+        __cold void AcquireSlow();
+
+        /*  Fields  */
+
+        Atomic<uint32_t> State;
+        //  0 = free, 1 = taken, 2 = taken and possibly contended.
+        WaitQueue Waiters;
+    };
+}}
+
+#endif
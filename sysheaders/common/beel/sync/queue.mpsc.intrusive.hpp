@@ -48,9 +48,99 @@ http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-ba
 
 namespace Beelzebub::Synchronization
 {
+    /**
+     *  <summary>
+     *  Unbounded lock-free queue with multiple producers and a single consumer,
+     *  which links the nodes through their <c>Next</c> field.
+     *  </summary>
+     *  <remarks>
+     *  A zeroed queue is empty and ready to use.
+     *  Producers must not be interrupted while pushing, because the consumer
+     *  waits for a push which is half-done to finish.
+     *  </remarks>
+     */
     template<typename T>
     struct MpscQueueIntrusive
     {
+        /*  Constructor(s)  */
 
+        inline constexpr MpscQueueIntrusive() : Head(nullptr), Tail(nullptr), Stub() { }
+
+        MpscQueueIntrusive(MpscQueueIntrusive const &) = delete;
+        MpscQueueIntrusive & operator =(MpscQueueIntrusive const &) = delete;
+
+        /*  Operations  */
+
+        /**
+         *  <summary>Adds a node at the end of the queue.</summary>
+         *  <param name="node">The node to add.</param>
+         *  <return>True if the queue was empty before the node was added.</return>
+         */
+        inline bool Push(T * node)
+        {
+            __atomic_store_n(&(node->Next), nullptr, __ATOMIC_RELAXED);
+
+            T * prev = __atomic_exchange_n(&(this->Head), node, __ATOMIC_ACQ_REL);
+
+            if (prev == nullptr)
+                prev = &(this->Stub);
+
+            __atomic_store_n(&(prev->Next), node, __ATOMIC_RELEASE);
+            //  Until this point, the consumer cannot get past the previous node.
+
+            return prev == &(this->Stub);
+        }
+
+        /**
+         *  <summary>Removes the node at the start of the queue.</summary>
+         *  <remarks>Only the consumer may call this.</remarks>
+         *  <return>The removed node, or null if the queue is empty.</return>
+         */
+        inline T * Pop()
+        {
+            T * tail = this->Tail;
+
+            if (tail == nullptr)
+                tail = this->Tail = &(this->Stub);
+
+            T * next = __atomic_load_n(&(tail->Next), __ATOMIC_ACQUIRE);
+
+            if (tail == &(this->Stub))
+            {
+                if (next == nullptr)
+                    return nullptr;
+
+                this->Tail = tail = next;
+                next = __atomic_load_n(&(next->Next), __ATOMIC_ACQUIRE);
+            }
+
+            if likely(next != nullptr)
+            {
+                this->Tail = next;
+
+                return tail;
+            }
+
+            if (tail == __atomic_load_n(&(this->Head), __ATOMIC_ACQUIRE))
+                this->Push(&(this->Stub));
+            //  The last node can only be removed once another one follows it.
+
+            while ((next = __atomic_load_n(&(tail->Next), __ATOMIC_ACQUIRE)) == nullptr)
+                DO_NOTHING();
+            //  A producer is between swapping the head and linking its node.
+
+            this->Tail = next;
+
+            return tail;
+        }
+
+        /*  Fields  */
+
+    private:
+        T * Head;
+        //  Last node, where producers add.
+        T * Tail;
+        //  First node, only touched by the consumer.
+        T Stub;
     };
 }
@@ -0,0 +1,394 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#ifdef __BEELZEBUB_KERNEL
+
+#include <beel/interrupt.state.hpp>
+#include <beel/sync/lock.stat.hpp>
+
+namespace Beelzebub { namespace Synchronization
+{
+    /**
+     *  The entry of a waiting core in the queue of a queued lock.
+     */
+    struct QueuedLockNode
+    {
+        QueuedLockNode * Next;
+        bool Waiting;
+    };
+
+    static constexpr size_t const QueuedLockNodeCount = 4;
+    //  A core may wait on a lock while an interrupt handler waits on another,
+    //  and so on, up to this many levels deep.
+
+    typedef union queuedlock_t
+    {
+        uint32_t Overall;
+
+        __extension__ struct
+        {
+            uint8_t Locked;
+            uint8_t Reserved;
+            uint16_t Tail;
+            //  Identifies the node of the last waiter; zero if there is none.
+        };
+
+        queuedlock_t() = default;
+        inline queuedlock_t(uint32_t o) : Overall(o) { }
+    } queuedlock_t;
+
+    static_assert(sizeof(queuedlock_t) == 4, "");
+
+    /**
+     *  Busy-waiting synchronization primitive whose waiters queue up and spin
+     *  on their own core's node, instead of all spinning on the lock.
+     */
+    struct QueuedLockBase
+    {
+    public:
+
+        /*  Constructor(s)  */
+
+        QueuedLockBase() = default;
+        QueuedLockBase(QueuedLockBase const &) = delete;
+        QueuedLockBase & operator =(QueuedLockBase const &) = delete;
+        QueuedLockBase(QueuedLockBase &&) = delete;
+        QueuedLockBase & operator =(QueuedLockBase &&) = delete;
+
+        /*  Operations  */
+
+        /**
+         *  Awaits for the queued lock to be freed.
+         *  Does not acquire the lock.
+         */
+        __forceinline void Spin() const volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            do DO_NOTHING(); while (this->Value.Overall != 0);
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_CHK;
+        }
+
+        /**
+         *  Checks if the queued lock is free. If not, it awaits.
+         *  Does not acquire the lock.
+         */
+        __forceinline void Await() const volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            while (this->Value.Overall != 0)
+                DO_NOTHING();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_CHK;
+        }
+
+        /**
+         *  Checks whether the queued lock is free or not.
+         */
+        __forceinline __must_check bool Check() const volatile
+        {
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            if (this->Value.Overall != 0)
+                return false;
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_CHK;
+
+            return true;
+        }
+
+        /**
+         *  Reset the queued lock.
+         */
+        __forceinline void Reset() volatile
+        {
+            this->Value.Overall = 0;
+        }
+
+    protected:
+
+        /**
+         *  Takes the lock if it is free and nobody is queued.
+         */
+        __forceinline bool TryLock() volatile
+        {
+            uint32_t cmp = 0;
+
+            return __atomic_compare_exchange_n(&(this->Value.Overall), &cmp, 1
+                , false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+        }
+
+        /**
+         *  Joins the queue and waits for the lock.
+         */
+        __cold void AcquireSlow() volatile;
+
+        __forceinline void Unlock() volatile
+        {
+            __atomic_store_n(&(this->Value.Locked), (uint8_t)0, __ATOMIC_RELEASE);
+        }
+
+        /*  Fields  */
+
+        queuedlock_t Value;
+    };
+
+    /**
+     *  Busy-waiting synchronization primitive whose waiters queue up and spin
+     *  on their own core's node, instead of all spinning on the lock.
+     */
+    struct QueuedLock : public QueuedLockBase
+    {
+    public:
+
+        typedef void Cookie;
+
+        /*  Constructor(s)  */
+
+        QueuedLock() = default;
+
+        /*  Operations  */
+
+        /**
+         *  Acquire the queued lock, if possible.
+         */
+        __forceinline __must_check bool TryAcquire() volatile
+        {
+            LOCKSTAT_BEGIN;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            if (!this->TryLock())
+                return false;
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
+
+            return true;
+        }
+
+        /**
+         *  Acquire the queued lock, waiting if necessary.
+         */
+        __forceinline void Acquire() volatile
+        {
+            LOCKSTAT_BEGIN;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            if unlikely(!this->TryLock())
+                this->AcquireSlow();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
+        }
+
+        /**
+         *  Release the queued lock.
+         */
+        __forceinline void Release() volatile
+        {
+            LOCKSTAT_RELEASED;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            this->Unlock();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_REL;
+        }
+
+        /**
+         *  Acquire the queued lock, waiting if necessary.
+         */
+        __forceinline void SimplyAcquire() volatile { this->Acquire(); }
+
+        /**
+         *  Release the queued lock.
+         */
+        __forceinline void SimplyRelease() volatile { this->Release(); }
+    };
+
+    /**
+     *  Busy-waiting synchronization primitive whose waiters queue up and spin
+     *  on their own core's node, and which prevents CPU interrupts on the
+     *  locking CPU.
+     */
+    struct QueuedLockUninterruptible : public QueuedLockBase
+    {
+    public:
+
+        typedef InterruptState Cookie;
+
+        /*  Constructor(s)  */
+
+        QueuedLockUninterruptible() = default;
+
+        /*  Operations  */
+
+        /**
+         *  Acquire the queued lock, if possible.
+         */
+        __forceinline __must_check bool TryAcquire(Cookie & cookie) volatile
+        {
+            cookie = InterruptState::Disable();
+
+            LOCKSTAT_BEGIN;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            if (!this->TryLock())
+            {
+                cookie.Restore();
+                //  If the lock was already taken, restore interrupt state.
+
+                return false;
+            }
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
+
+            return true;
+        }
+
+        /**
+         *  Acquire the queued lock, waiting if necessary.
+         */
+        __forceinline __must_check Cookie Acquire() volatile
+        {
+            Cookie const cookie = InterruptState::Disable();
+
+            LOCKSTAT_BEGIN;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            if unlikely(!this->TryLock())
+                this->AcquireSlow();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
+
+            return cookie;
+        }
+
+        /**
+         *  Acquire the queued lock, waiting if necessary.
+         */
+        __forceinline void SimplyAcquire() volatile
+        {
+            LOCKSTAT_BEGIN;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            if unlikely(!this->TryLock())
+                this->AcquireSlow();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
+        }
+
+        /**
+         *  Release the queued lock.
+         */
+        __forceinline void Release(Cookie const cookie) volatile
+        {
+            LOCKSTAT_RELEASED;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            this->Unlock();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_REL;
+
+            cookie.Restore();
+        }
+
+        /**
+         *  Release the queued lock.
+         */
+        __forceinline void SimplyRelease() volatile
+        {
+            LOCKSTAT_RELEASED;
+
+            COMPILER_MEMORY_BARRIER();
+
+        op_start:
+            this->Unlock();
+        op_end:
+
+            COMPILER_MEMORY_BARRIER();
+            ANNOTATE_LOCK_OPERATION_REL;
+        }
+    };
+}}
+
+#endif
@@ -0,0 +1,101 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#ifdef __BEELZEBUB_KERNEL
+
+#include <beel/sync/wait.queue.hpp>
+#include <beel/sync/atomic.hpp>
+
+namespace Beelzebub { namespace Synchronization
+{
+    /**
+     *  Counting semaphore which puts threads to sleep while the count is zero.
+     */
+    class Semaphore
+    {
+    public:
+        /*  Constructor(s)  */
+
+        inline explicit Semaphore(size_t const count = 0) : Count(count), Waiters() { }
+
+        Semaphore(Semaphore const &) = delete;
+        Semaphore & operator =(Semaphore const &) = delete;
+        Semaphore(Semaphore &&) = delete;
+        Semaphore & operator =(Semaphore &&) = delete;
+
+        /*  Operations  */
+
+        inline __must_check bool TryAcquire()
+        {
+            size_t cnt = this->Count.Load();
+
+            while (cnt > 0)
+                if (this->Count.CmpXchgWeak(cnt, cnt - 1))
+                    return true;
+
+            return false;
+        }
+
+        /**
+         *  Decrements the count, sleeping while it is zero or until the timeout
+         *  expires.
+         */
+        Handle Acquire(TimeSpanLite timeout = WaitQueue::Forever);
+
+        inline void Release(size_t const count = 1)
+        {
+            this->Count += count;
+            this->Waiters.Wake(count);
+        }
+
+        /*  Properties  */
+
+        inline size_t GetCount() const volatile { return this->Count.Load(); }
+
+    private:
+        /*  Fields  */
+
+        Atomic<size_t> Count;
+        WaitQueue Waiters;
+    };
+}}
+
+#endif
@@ -44,6 +44,7 @@
 //  TODO: Change lock types?
 #include <beel/sync/ticket.lock.hpp>
 #include <beel/sync/ticket.lock.unint.hpp>
+#include <beel/sync/queued.lock.hpp>
 
 namespace Beelzebub { namespace Synchronization
 {
@@ -51,4 +52,13 @@ namespace Beelzebub { namespace Synchronization
     typedef TicketLockUninterruptible<true> SmpLockUni;
     typedef TicketLock<false> NonSmpLock;
     typedef TicketLockUninterruptible<false> NonSmpLockUni;
+
+    //  For locks contended by many cores at once.
+#if defined(__BEELZEBUB_KERNEL) && defined(__BEELZEBUB_SETTINGS_SMP)
+    typedef QueuedLock SmpQueuedLock;
+    typedef QueuedLockUninterruptible SmpQueuedLockUni;
+#else
+    typedef SmpLock SmpQueuedLock;
+    typedef SmpLockUni SmpQueuedLockUni;
+#endif
 }}
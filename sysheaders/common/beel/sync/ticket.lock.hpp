@@ -40,6 +40,7 @@
 #pragma once
 
 #include <beel/metaprogramming.h>
+#include <beel/sync/lock.stat.hpp>
 
 namespace Beelzebub { namespace Synchronization
 {
@@ -146,6 +147,8 @@ namespace Beelzebub { namespace Synchronization
          */
         __forceinline __must_check bool TryAcquire() volatile
         {
+            LOCKSTAT_BEGIN;
+
             COMPILER_MEMORY_BARRIER();
             
         op_start:
@@ -162,6 +165,7 @@ namespace Beelzebub { namespace Synchronization
 
             COMPILER_MEMORY_BARRIER();
             ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
 
             return true;
         }
@@ -217,6 +221,8 @@ namespace Beelzebub { namespace Synchronization
          */
         __forceinline void Acquire() volatile
         {
+            LOCKSTAT_BEGIN;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
@@ -230,6 +236,7 @@ namespace Beelzebub { namespace Synchronization
 
             COMPILER_MEMORY_BARRIER();
             ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
         }
 
         /**
@@ -237,6 +244,8 @@ namespace Beelzebub { namespace Synchronization
          */
         __forceinline void Release() volatile
         {
+            LOCKSTAT_RELEASED;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
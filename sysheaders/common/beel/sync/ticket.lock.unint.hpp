@@ -45,6 +45,7 @@
 #pragma once
 
 #include <beel/interrupt.state.hpp>
+#include <beel/sync/lock.stat.hpp>
 
 namespace Beelzebub { namespace Synchronization
 {
@@ -164,6 +165,8 @@ namespace Beelzebub { namespace Synchronization
         {
             cookie = InterruptState::Disable();
 
+            LOCKSTAT_BEGIN;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
@@ -185,6 +188,7 @@ namespace Beelzebub { namespace Synchronization
 
             COMPILER_MEMORY_BARRIER();
             ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
 
             return true;
         }
@@ -242,6 +246,8 @@ namespace Beelzebub { namespace Synchronization
         {
             Cookie const cookie = InterruptState::Disable();
 
+            LOCKSTAT_BEGIN;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
@@ -255,6 +261,7 @@ namespace Beelzebub { namespace Synchronization
 
             COMPILER_MEMORY_BARRIER();
             ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
 
             return cookie;
         }
@@ -264,6 +271,8 @@ namespace Beelzebub { namespace Synchronization
          */
         __forceinline void SimplyAcquire() volatile
         {
+            LOCKSTAT_BEGIN;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
@@ -277,6 +286,7 @@ namespace Beelzebub { namespace Synchronization
 
             COMPILER_MEMORY_BARRIER();
             ANNOTATE_LOCK_OPERATION_ACQ;
+            LOCKSTAT_ACQUIRED;
         }
 
         /**
@@ -284,6 +294,8 @@ namespace Beelzebub { namespace Synchronization
          */
         __forceinline void Release(Cookie const cookie) volatile
         {
+            LOCKSTAT_RELEASED;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
@@ -301,6 +313,8 @@ namespace Beelzebub { namespace Synchronization
          */
         __forceinline void SimplyRelease() volatile
         {
+            LOCKSTAT_RELEASED;
+
             COMPILER_MEMORY_BARRIER();
 
         op_start:
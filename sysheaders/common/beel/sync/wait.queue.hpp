@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#ifdef __BEELZEBUB_KERNEL
+
+#include <beel/sync/smp.lock.hpp>
+#include <beel/timing.hpp>
+#include <beel/handles.h>
+
+namespace Beelzebub { namespace Execution
+{
+    struct ThreadSchedulerState;
+}}
+
+namespace Beelzebub { namespace Synchronization
+{
+    /**
+     *  Queue of threads blocked until an event occurs.
+     */
+    class WaitQueue
+    {
+    public:
+        /*  Types  */
+
+        typedef bool (* WaitPredicate)(void * cookie);
+
+        static constexpr TimeSpanLite const Forever { ~(uint64_t)0 };
+
+        /*  Constructor(s)  */
+
+        inline WaitQueue() : Lock(), First(nullptr), Last(nullptr) { }
+
+        WaitQueue(WaitQueue const &) = delete;
+        WaitQueue & operator =(WaitQueue const &) = delete;
+        WaitQueue(WaitQueue &&) = delete;
+        WaitQueue & operator =(WaitQueue &&) = delete;
+
+        /*  Operations  */
+
+        /**
+         *  Blocks the current thread until woken up or until the timeout expires.
+         *  If a predicate is given, the thread only blocks while it returns true.
+         *  The predicate is evaluated under the queue's lock, so wakers which
+         *  change its outcome before waking are never missed.
+         */
+        __hot Handle Wait(TimeSpanLite timeout = Forever
+                        , WaitPredicate pred = nullptr, void * cookie = nullptr);
+
+        /**
+         *  Wakes up the longest-waiting thread, if any.
+         */
+        __hot bool WakeOne();
+
+        /**
+         *  Wakes up to the given number of threads, returning how many were woken.
+         */
+        size_t Wake(size_t count);
+
+        /**
+         *  Wakes up all the waiting threads.
+         */
+        inline size_t WakeAll() { return this->Wake(SIZE_MAX); }
+
+        /*  Properties  */
+
+        inline bool IsEmpty() const volatile { return this->First == nullptr; }
+
+    private:
+        static void HandleTimeout(void * cookie);
+
+        void Link(Execution::ThreadSchedulerState * tsc);
+        void Unlink(Execution::ThreadSchedulerState * tsc);
+
+        /*  Fields  */
+
+        SmpLock Lock;
+        Execution::ThreadSchedulerState * First, * Last;
+    };
+}}
+
+#endif
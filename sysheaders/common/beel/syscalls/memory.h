@@ -55,10 +55,17 @@
     ENUMINST(None       , MEMREL_NONE        , 0x000, "None"        ) \
     ENUMINST(Decommit   , MEMREL_DECOMMIT    , 0x001, "Decommit"    )
 
+#define __ENUM_MEMSHAREOPTS(ENUMINST) \
+    ENUMINST(None       , MEMSHARE_NONE      , 0x000, "None"        ) \
+    ENUMINST(Duplicate  , MEMSHARE_DUPLICATE , 0x001, "Duplicate"   ) \
+    ENUMINST(ReadOnly   , MEMSHARE_READ_ONLY , 0x002, "Read Only"   )
+
 __PUB_ENUM(MemoryRequestOptions, __ENUM_MEMREQOPTS, FULL)
 __PUB_ENUM(MemoryReleaseOptions, __ENUM_MEMRELOPTS, FULL)
+__PUB_ENUM(MemoryShareOptions, __ENUM_MEMSHAREOPTS, FULL)
 
 __PUB_FUNC(BeHandle, MemoryRequest, uintptr_t addr, size_t    size, BeMemoryRequestOptions opts);
 __PUB_FUNC(BeHandle, MemoryRelease, uintptr_t addr, size_t    size, BeMemoryReleaseOptions opts);
 __PUB_FUNC(BeHandle, MemoryCopy   , uintptr_t dst , uintptr_t src , size_t                 len );
 __PUB_FUNC(BeHandle, MemoryFill   , uintptr_t dst , uint8_t   val , size_t                 len );
+__PUB_FUNC(BeHandle, MemoryShare  , uintptr_t addr, size_t    size, size_t process, BeMemoryShareOptions opts);
@@ -77,7 +77,8 @@ namespace Beelzebub { namespace Memory
         //  These should be creating an alignment of up to 16 if needed.
 
         ObjectPoolBase * Next;
-        //ObjectPoolBase * Previous;
+        ObjectPoolBase * Previous;
+        //  Only maintained by allocators with aligned pools.
 
         /*  Constructors  */
 
@@ -87,6 +88,7 @@ namespace Beelzebub { namespace Memory
             , FirstFreeObject(obj_ind_invalid)
             , LastFreeObject(obj_ind_invalid)
             , Next(nullptr)
+            , Previous(nullptr)
         {
 
         }
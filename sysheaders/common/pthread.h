@@ -62,7 +62,8 @@ typedef struct pthread_mutexattr_s
 
 #ifdef __BEELZEBUB_KERNEL
 
-    #include <beel/sync/smp.lock.h>
+    #include <beel/sync/mutex.h>
+    #include <errno.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,30 +71,40 @@ extern "C" {
 
     typedef struct pthread_mutex_s
     {
-        SmpLockUni Lock;
-        SmpLockUniCookie Cookie;
+        Mutex Lock;
     } pthread_mutex_t;
 
-    #define PTHREAD_MUTEX_INITIALIZER {{0}, {NULL}}
+    #define PTHREAD_MUTEX_INITIALIZER {MUTEX_INITIALIZER}
 
-    static inline void pthread_mutex_lock(pthread_mutex_t * const m)
+    static inline int pthread_mutex_lock(pthread_mutex_t * const m)
     {
-        SmpLockUniCookie const ck = SmpLockUniAcquire(&(m->Lock));
+        MutexAcquire(&(m->Lock));
 
-        m->Cookie = ck;
+        return 0;
     }
 
-    static inline void pthread_mutex_unlock(pthread_mutex_t * const m)
+    static inline int pthread_mutex_trylock(pthread_mutex_t * const m)
     {
-        SmpLockUniRelease(&(m->Lock), m->Cookie);
+        return MutexTryAcquire(&(m->Lock)) ? 0 : EBUSY;
+    }
+
+    static inline int pthread_mutex_unlock(pthread_mutex_t * const m)
+    {
+        MutexRelease(&(m->Lock));
+
+        return 0;
     }
 
     static inline int pthread_mutex_init(pthread_mutex_t * __restrict const m
                                         , pthread_mutexattr_t const * __restrict const attr)
     {
         (void)attr;
-        
-        SmpLockUniReset(&(m->Lock));
+
+        m->Lock.State = 0;
+        TicketLockReset(&(m->Lock.Waiters.Lock));
+        m->Lock.Waiters.First = m->Lock.Waiters.Last = NULL;
+
+        return 0;
     }
 
     static inline int pthread_mutexattr_init(pthread_mutexattr_t * attr)
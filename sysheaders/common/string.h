@@ -63,6 +63,9 @@ __shared_inline void * memset16(void * dst, int const val, size_t cnt);
 __shared_inline void * mempset16(void * dst, int const val, size_t cnt);
 __shared_inline void * memset32(void * dst, long const val, size_t cnt);
 __shared_inline void * mempset32(void * dst, long const val, size_t cnt);
+__shared_inline void * memclrnt(void * dst, size_t len);
+//  Zeroes any number of bytes; the aligned words in between are written around
+//  the caches.
 
 __shared_inline size_t strlen(char const * str);
 __shared_inline size_t strnlen(char const * str, size_t len);
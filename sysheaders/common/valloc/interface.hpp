@@ -49,5 +49,9 @@ namespace Valloc
     void DeallocateMemory(void * ptr, bool crash = true);
 
     void CollectMyGarbage();
+    void AbandonMyMemory();
+    //  To be called by exiting threads; their memory is adopted by others.
     void DumpMyState();
+
+    size_t GetFootprint();
 }
@@ -73,9 +73,15 @@ namespace Valloc
 
         /*  Memory  */
 
-        static void AllocateMemory(void * & addr, size_t & size);
+        static void AllocateMemory(void * & addr, size_t & size, size_t alignment = 0);
         static void FreeMemory(void * addr, size_t size);
 
+        //  Memory backed by large pages, aligned to their size. The size must
+        //  be a multiple of the large page size. Fails with a null address.
+        static void AllocateLargeMemory(void * & addr, size_t & size);
+        //  Discards the contents of the pages in the range, which stays reserved.
+        static void PurgeMemory(void * addr, size_t size);
+
         /*  Debug  */
 
         static void ErrorMessage(char const * fmt, ...);
@@ -93,6 +99,16 @@ namespace Valloc
 #endif
         }
 
+        template<typename T>
+        static inline T FetchAdd(T * const val, T const add)
+        {
+#ifdef VALLOC_PLAT_GCC
+            return __atomic_fetch_add(val, add, __ATOMIC_RELAXED);
+#else
+    #error "TODO!"
+#endif
+        }
+
         template<typename T>
         static inline bool CAS(T * const val, T & exp, T const des)
         {
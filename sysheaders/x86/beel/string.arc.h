@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2019 Alexandru-Mihai Maftei. All rights reserved.
+
+
+    Developed by: Alexandru-Mihai Maftei
+    aka Vercas
+    http://vercas.com | https://github.com/vercas/Beelzebub
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+    deal with the Software without restriction, including without limitation the
+    rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+      * Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimers.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimers in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the names of Alexandru-Mihai Maftei, Vercas, nor the names of
+        its contributors may be used to endorse or promote products derived from
+        this Software without specific prior written permission.
+
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    WITH THE SOFTWARE.
+
+    ---
+
+    You may also find the text of this license in "LICENSE.md", along with a more
+    thorough explanation regarding other files.
+*/
+
+#pragma once
+
+#include <beel/metaprogramming.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Processor features which the string functions can take advantage of.
+ */
+typedef enum StringFeature
+{
+    StringFeatureErms = 1 << 0,
+    //  Enhanced `rep movsb` and `rep stosb`, which beat word-sized strings.
+    StringFeatureFsrm = 1 << 1,
+    //  Fast short `rep movsb`, which beats loops even for tiny lengths.
+    StringFeatureSse2 = 1 << 2,
+    StringFeatureAvx2 = 1 << 3,
+} StringFeature;
+
+/**
+ *  A jump in a string function which is only worth taking on processors with
+ *  the given feature. The kernel turns it into no-ops at boot otherwise.
+ */
+typedef struct StringPatchSite
+{
+    uintptr_t Start;
+    uintptr_t End;
+    uintptr_t Feature;
+} StringPatchSite;
+
+/**
+ *  Returns the features of the current processor relevant to string functions,
+ *  including vector registers only if the operating system preserves them.
+ */
+__shared uint32_t StringDetectFeatures(void);
+
+/**
+ *  Allows the string functions to use the vector kernels for the given
+ *  features. Only meant for userland; the kernel does not preserve vector
+ *  registers across its own code.
+ */
+__shared void StringSelectVectorKernels(uint32_t features);
+
+/**
+ *  Runs the vector kernels of the given features, regardless of the selected
+ *  ones; SSE2 is the baseline. Copies and fills need at least 16 bytes, and
+ *  return the end of the destination. Meant for tests, whose thread must be
+ *  allowed to use vector registers.
+ */
+__shared void * StringCopyWith(uint32_t features, void * dst, void const * src, size_t len);
+__shared void * StringSetWith(uint32_t features, void * dst, int val, size_t len);
+__shared size_t StringMismatchWith(uint32_t features, void const * src1, void const * src2, size_t len);
+__shared size_t StringLengthWith(uint32_t features, char const * str);
+
+#ifdef __cplusplus
+}
+#endif
@@ -64,6 +64,14 @@ Configuration "profile" {
     Base = "release",
 }
 
+Configuration "lockstat" {
+    Data = {
+        Opts_GCC = List { },
+    },
+
+    Base = "profile",
+}
+
 --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --
 --  Architectures
 --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --
@@ -190,6 +198,9 @@ local availableTests = List {
     "VAS",
     "INTERRUPT_LATENCY",
     "MALLOC",
+    "SCHED",
+    "HANDLES",
+    "RCU",
 }
 
 local settSelTests, settUnitTests = List { }, true
@@ -222,6 +233,9 @@ local testDescriptions = {
     VAS =                    "Virtual Address Space",
     INTERRUPT_LATENCY =  "Profile interrupt latency",
     MALLOC =              "Dynamic memory allocator",
+    SCHED =                 "Scheduler run queues",
+    HANDLES =                       "Handle table",
+    RCU =                       "Read-copy-update",
 }
 
 CmdOpt "tests" "t" {
@@ -832,6 +846,7 @@ Project "Beelzebub" {
                     -fvisibility=hidden
                     -Wall -Wextra -Wpedantic -Wsystem-headers
                     -Wno-invalid-offsetof
+                    -fno-tree-loop-distribute-patterns
                     -D__BEELZEBUB_STATIC_LIBRARY
                 ]] + Opts_GCC_Common + Opts_Includes
                    + selArch.Data.Opts_GCC_Kernel